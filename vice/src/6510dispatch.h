@@ -0,0 +1,100 @@
+/*
+ * 6510dispatch.h - Opcode dispatch for the 6510 cores.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_6510DISPATCH_H
+#define VICE_6510DISPATCH_H
+
+/* The opcode handlers in 6510core.c and 6510dtvcore.c are written as
+
+        OPCODE_DISPATCH(p0) {
+            OPCODE(0xea):       (NOP)
+                NOP();
+                OPCODE_END;
+            ...
+        }
+        OPCODE_DISPATCH_END
+
+   By default this is a plain `switch'. When configured with
+   --enable-computed-goto, every opcode gets a label and the dispatch jumps
+   through a table of label addresses instead (a GCC/clang extension), which
+   saves the range check and lets the compiler lay out the handlers freely.
+   Every one of the 256 opcodes must have a handler in that case.  */
+
+#ifdef USE_COMPUTED_GOTO
+
+#define OPCODE_DISPATCH_TABLE \
+    &&opcode_0x00, &&opcode_0x01, &&opcode_0x02, &&opcode_0x03, &&opcode_0x04, &&opcode_0x05, &&opcode_0x06, &&opcode_0x07, \
+    &&opcode_0x08, &&opcode_0x09, &&opcode_0x0a, &&opcode_0x0b, &&opcode_0x0c, &&opcode_0x0d, &&opcode_0x0e, &&opcode_0x0f, \
+    &&opcode_0x10, &&opcode_0x11, &&opcode_0x12, &&opcode_0x13, &&opcode_0x14, &&opcode_0x15, &&opcode_0x16, &&opcode_0x17, \
+    &&opcode_0x18, &&opcode_0x19, &&opcode_0x1a, &&opcode_0x1b, &&opcode_0x1c, &&opcode_0x1d, &&opcode_0x1e, &&opcode_0x1f, \
+    &&opcode_0x20, &&opcode_0x21, &&opcode_0x22, &&opcode_0x23, &&opcode_0x24, &&opcode_0x25, &&opcode_0x26, &&opcode_0x27, \
+    &&opcode_0x28, &&opcode_0x29, &&opcode_0x2a, &&opcode_0x2b, &&opcode_0x2c, &&opcode_0x2d, &&opcode_0x2e, &&opcode_0x2f, \
+    &&opcode_0x30, &&opcode_0x31, &&opcode_0x32, &&opcode_0x33, &&opcode_0x34, &&opcode_0x35, &&opcode_0x36, &&opcode_0x37, \
+    &&opcode_0x38, &&opcode_0x39, &&opcode_0x3a, &&opcode_0x3b, &&opcode_0x3c, &&opcode_0x3d, &&opcode_0x3e, &&opcode_0x3f, \
+    &&opcode_0x40, &&opcode_0x41, &&opcode_0x42, &&opcode_0x43, &&opcode_0x44, &&opcode_0x45, &&opcode_0x46, &&opcode_0x47, \
+    &&opcode_0x48, &&opcode_0x49, &&opcode_0x4a, &&opcode_0x4b, &&opcode_0x4c, &&opcode_0x4d, &&opcode_0x4e, &&opcode_0x4f, \
+    &&opcode_0x50, &&opcode_0x51, &&opcode_0x52, &&opcode_0x53, &&opcode_0x54, &&opcode_0x55, &&opcode_0x56, &&opcode_0x57, \
+    &&opcode_0x58, &&opcode_0x59, &&opcode_0x5a, &&opcode_0x5b, &&opcode_0x5c, &&opcode_0x5d, &&opcode_0x5e, &&opcode_0x5f, \
+    &&opcode_0x60, &&opcode_0x61, &&opcode_0x62, &&opcode_0x63, &&opcode_0x64, &&opcode_0x65, &&opcode_0x66, &&opcode_0x67, \
+    &&opcode_0x68, &&opcode_0x69, &&opcode_0x6a, &&opcode_0x6b, &&opcode_0x6c, &&opcode_0x6d, &&opcode_0x6e, &&opcode_0x6f, \
+    &&opcode_0x70, &&opcode_0x71, &&opcode_0x72, &&opcode_0x73, &&opcode_0x74, &&opcode_0x75, &&opcode_0x76, &&opcode_0x77, \
+    &&opcode_0x78, &&opcode_0x79, &&opcode_0x7a, &&opcode_0x7b, &&opcode_0x7c, &&opcode_0x7d, &&opcode_0x7e, &&opcode_0x7f, \
+    &&opcode_0x80, &&opcode_0x81, &&opcode_0x82, &&opcode_0x83, &&opcode_0x84, &&opcode_0x85, &&opcode_0x86, &&opcode_0x87, \
+    &&opcode_0x88, &&opcode_0x89, &&opcode_0x8a, &&opcode_0x8b, &&opcode_0x8c, &&opcode_0x8d, &&opcode_0x8e, &&opcode_0x8f, \
+    &&opcode_0x90, &&opcode_0x91, &&opcode_0x92, &&opcode_0x93, &&opcode_0x94, &&opcode_0x95, &&opcode_0x96, &&opcode_0x97, \
+    &&opcode_0x98, &&opcode_0x99, &&opcode_0x9a, &&opcode_0x9b, &&opcode_0x9c, &&opcode_0x9d, &&opcode_0x9e, &&opcode_0x9f, \
+    &&opcode_0xa0, &&opcode_0xa1, &&opcode_0xa2, &&opcode_0xa3, &&opcode_0xa4, &&opcode_0xa5, &&opcode_0xa6, &&opcode_0xa7, \
+    &&opcode_0xa8, &&opcode_0xa9, &&opcode_0xaa, &&opcode_0xab, &&opcode_0xac, &&opcode_0xad, &&opcode_0xae, &&opcode_0xaf, \
+    &&opcode_0xb0, &&opcode_0xb1, &&opcode_0xb2, &&opcode_0xb3, &&opcode_0xb4, &&opcode_0xb5, &&opcode_0xb6, &&opcode_0xb7, \
+    &&opcode_0xb8, &&opcode_0xb9, &&opcode_0xba, &&opcode_0xbb, &&opcode_0xbc, &&opcode_0xbd, &&opcode_0xbe, &&opcode_0xbf, \
+    &&opcode_0xc0, &&opcode_0xc1, &&opcode_0xc2, &&opcode_0xc3, &&opcode_0xc4, &&opcode_0xc5, &&opcode_0xc6, &&opcode_0xc7, \
+    &&opcode_0xc8, &&opcode_0xc9, &&opcode_0xca, &&opcode_0xcb, &&opcode_0xcc, &&opcode_0xcd, &&opcode_0xce, &&opcode_0xcf, \
+    &&opcode_0xd0, &&opcode_0xd1, &&opcode_0xd2, &&opcode_0xd3, &&opcode_0xd4, &&opcode_0xd5, &&opcode_0xd6, &&opcode_0xd7, \
+    &&opcode_0xd8, &&opcode_0xd9, &&opcode_0xda, &&opcode_0xdb, &&opcode_0xdc, &&opcode_0xdd, &&opcode_0xde, &&opcode_0xdf, \
+    &&opcode_0xe0, &&opcode_0xe1, &&opcode_0xe2, &&opcode_0xe3, &&opcode_0xe4, &&opcode_0xe5, &&opcode_0xe6, &&opcode_0xe7, \
+    &&opcode_0xe8, &&opcode_0xe9, &&opcode_0xea, &&opcode_0xeb, &&opcode_0xec, &&opcode_0xed, &&opcode_0xee, &&opcode_0xef, \
+    &&opcode_0xf0, &&opcode_0xf1, &&opcode_0xf2, &&opcode_0xf3, &&opcode_0xf4, &&opcode_0xf5, &&opcode_0xf6, &&opcode_0xf7, \
+    &&opcode_0xf8, &&opcode_0xf9, &&opcode_0xfa, &&opcode_0xfb, &&opcode_0xfc, &&opcode_0xfd, &&opcode_0xfe, &&opcode_0xff
+
+#define OPCODE_DISPATCH(op)                                                 \
+    {                                                                       \
+        static const void *const opcode_dispatch_table[0x100] = {           \
+            OPCODE_DISPATCH_TABLE                                           \
+        };                                                                  \
+        goto *opcode_dispatch_table[(op) & 0xff];                           \
+    }
+
+#define OPCODE(n)               opcode_##n
+#define OPCODE_END              goto opcode_done
+#define OPCODE_DISPATCH_END     opcode_done: ;
+
+#else
+
+#define OPCODE_DISPATCH(op)     switch (op)
+#define OPCODE(n)               case n
+#define OPCODE_END              break
+#define OPCODE_DISPATCH_END
+
+#endif
+
+#endif
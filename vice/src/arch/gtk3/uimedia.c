@@ -799,7 +799,7 @@ static int driver_is_video(const char *name)
 {
     int result;
 
-    result = strcmp(name, "FFMPEG") == 0;
+    result = strcmp(name, "FFMPEG") == 0 || strcmp(name, "VCAP") == 0;
     return result;
 }
 
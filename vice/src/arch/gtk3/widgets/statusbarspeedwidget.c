@@ -355,6 +355,9 @@ GtkWidget *statusbar_speed_widget_create(statusbar_speed_widget_state_t *state)
 
     state->last_cpu_int = -1;
     state->last_fps_int = -1;
+    state->last_idle_int = -1;
+    state->last_latency_int = -1;
+    state->last_underruns = -1;
     state->last_paused = -1;
     state->last_warp = -1;
     state->last_shiftlock = -1;
@@ -478,7 +481,12 @@ void statusbar_speed_widget_update(GtkWidget *widget,
 
     double vsync_metric_cpu_percent;
     double vsync_metric_emulated_fps;
+    double vsync_metric_idle_percent;
+    double vsync_metric_sound_latency_ms;
+    int vsync_metric_sound_underruns;
     int vsync_metric_warp_enabled;
+    int this_idle_int;
+    int this_latency_int;
     tick_t now;
 
     /*
@@ -535,7 +543,8 @@ void statusbar_speed_widget_update(GtkWidget *widget,
         }
     }
 
-    vsyncarch_get_metrics(&vsync_metric_cpu_percent, &vsync_metric_emulated_fps, &vsync_metric_warp_enabled);
+    vsyncarch_get_metrics(&vsync_metric_cpu_percent, &vsync_metric_emulated_fps, &vsync_metric_idle_percent,
+                          &vsync_metric_sound_latency_ms, &vsync_metric_sound_underruns, &vsync_metric_warp_enabled);
 
     /*
      * Updating GTK labels is expensive and this is called each frame,
@@ -633,6 +642,44 @@ void statusbar_speed_widget_update(GtkWidget *widget,
         }
     }
 
+    /*
+     * The guest idle share and the sound latency are shown as tooltip,
+     * each only when it is measured.
+     */
+#ifdef FEATURE_IDLEDETECT
+    this_idle_int = (int)(vsync_metric_idle_percent + 0.5);
+#else
+    this_idle_int = -1;
+#endif
+    this_latency_int = (int)(vsync_metric_sound_latency_ms + 0.5);
+
+    if (state->last_idle_int != this_idle_int ||
+            state->last_latency_int != this_latency_int ||
+            state->last_underruns != vsync_metric_sound_underruns) {
+        size_t len = 0;
+
+        buffer[0] = '\0';
+        if (this_idle_int >= 0) {
+            len += g_snprintf(buffer + len,
+                              sizeof(buffer) - len,
+                              "Guest idle: %d%% of frames",
+                              this_idle_int);
+        }
+        if (this_latency_int > 0 || vsync_metric_sound_underruns > 0) {
+            len += g_snprintf(buffer + len,
+                              sizeof(buffer) - len,
+                              "%sSound latency: %d ms, %d underruns",
+                              len > 0 ? "\n" : "",
+                              this_latency_int,
+                              vsync_metric_sound_underruns);
+        }
+        gtk_widget_set_tooltip_text(widget, len > 0 ? buffer : NULL);
+
+        state->last_idle_int = this_idle_int;
+        state->last_latency_int = this_latency_int;
+        state->last_underruns = vsync_metric_sound_underruns;
+    }
+
 #   undef CPU_DECIMAL_PLACES
 #   undef FPS_DECIMAL_PLACES
 #   undef STR_
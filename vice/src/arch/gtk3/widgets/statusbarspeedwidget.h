@@ -39,6 +39,9 @@ typedef struct statusbar_speed_widget_state_s {
     tick_t last_render_tick;
     int last_cpu_int;
     int last_fps_int;
+    int last_idle_int;
+    int last_latency_int;
+    int last_underruns;
     int last_warp;
     int last_paused;
     int last_shiftlock;
@@ -30,8 +30,11 @@
 
 #include <stdio.h>
 
+#include "benchmark.h"
 #include "cmdline.h"
+#include "lib.h"
 #include "machine.h"
+#include "palette.h"
 #include "resources.h"
 #include "videoarch.h"
 #include "video.h"
@@ -110,6 +113,10 @@ void video_arch_resources_shutdown(void)
 }
 
 /** \brief Query whether a canvas is resizable.
+ *
+ * The canvas always takes the size of the emulated screen, which is what
+ * frames are rendered at during a benchmark.
+ *
  *  \param canvas The canvas to query
  *  \return TRUE if the canvas can be resized.
  */
@@ -117,7 +124,7 @@ char video_canvas_can_resize(video_canvas_t *canvas)
 {
     /* printf("%s\n", __func__); */
 
-    return 0;
+    return 1;
 }
 
 /** \brief Create a new video_canvas_s.
@@ -148,10 +155,18 @@ video_canvas_t *video_canvas_create(video_canvas_t *canvas,
 void video_canvas_destroy(struct video_canvas_s *canvas)
 {
     /* printf("%s\n", __func__); */
+
+    lib_free(canvas->render_buffer);
+    canvas->render_buffer = NULL;
 }
 
 /** \brief Update the display on a video canvas to reflect the machine
  *         state.
+ *
+ * There is no display, but while a benchmark runs the frame is rendered
+ * into memory like a real frontend would, so the cost of rendering shows
+ * in the results.
+ *
  * \param canvas The canvas to update.
  * \param xs     A parameter to forward to video_canvas_render()
  * \param ys     A parameter to forward to video_canvas_render()
@@ -165,7 +180,36 @@ void video_canvas_refresh(struct video_canvas_s *canvas,
                           unsigned int xi, unsigned int yi,
                           unsigned int w, unsigned int h)
 {
+    unsigned int width, height;
+
     /* printf("%s\n", __func__); */
+
+    if (!benchmark_is_running() || canvas->draw_buffer == NULL) {
+        return;
+    }
+
+    width = canvas->draw_buffer->canvas_physical_width;
+    height = canvas->draw_buffer->canvas_physical_height;
+    if (width == 0 || height == 0 || xi >= width || yi >= height) {
+        return;
+    }
+
+    if (canvas->render_width != width || canvas->render_height != height) {
+        lib_free(canvas->render_buffer);
+        canvas->render_buffer = lib_malloc(width * height * sizeof(uint32_t));
+        canvas->render_width = width;
+        canvas->render_height = height;
+    }
+
+    if (w > width - xi) {
+        w = width - xi;
+    }
+    if (h > height - yi) {
+        h = height - yi;
+    }
+
+    video_canvas_render(canvas, (uint8_t *)canvas->render_buffer, w, h,
+                        xs, ys, xi, yi, width * sizeof(uint32_t));
 }
 
 /** \brief Update canvas size to match the draw buffer size requested
@@ -187,9 +231,29 @@ void video_canvas_resize(struct video_canvas_s *canvas, char resize_canvas)
 int video_canvas_set_palette(struct video_canvas_s *canvas,
                              struct palette_s *palette)
 {
+    video_render_color_tables_t *color_tables;
+    unsigned int i;
+
     /* printf("%s\n", __func__); */
 
     canvas->palette = palette;
+    if (palette == NULL || canvas->videoconfig == NULL) {
+        return 0;
+    }
+
+    /* 32 bits per pixel, the byte order does not matter here */
+    color_tables = &canvas->videoconfig->color_tables;
+    for (i = 0; i < palette->num_entries; i++) {
+        palette_entry_t color = palette->entries[i];
+        uint32_t color_code = color.red | (color.green << 8) | (color.blue << 16) | (0xffU << 24);
+
+        video_render_setphysicalcolor(canvas->videoconfig, (int)i, color_code, 32);
+    }
+    for (i = 0; i < 256; i++) {
+        video_render_setrawrgb(color_tables, i, i, i << 8, i << 16);
+    }
+    video_render_setrawalpha(color_tables, 0xffU << 24);
+    video_render_initraw(canvas->videoconfig);
 
     return 0;
 }
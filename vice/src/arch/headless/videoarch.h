@@ -62,6 +62,14 @@ typedef struct video_canvas_s {
 
     /** \brief Used to limit frame rate under warp. */
     tick_t warp_next_render_tick;
+
+    /** \brief Frames are rendered here while a benchmark runs, 32 bits
+     *         per pixel. Nothing ever looks at them. */
+    uint32_t *render_buffer;
+
+    /** \brief Size of the render buffer in pixels. */
+    unsigned int render_width;
+    unsigned int render_height;
 } video_canvas_t;
 
 typedef struct vice_renderer_backend_s {
@@ -126,7 +126,8 @@ static void display_speed(void)
     double vsync_metric_emulated_fps;
     int vsync_metric_warp_enabled;
 
-    vsyncarch_get_metrics(&vsync_metric_cpu_percent, &vsync_metric_emulated_fps, &vsync_metric_warp_enabled);
+    /* no room for the idle share and sound latency in the status line */
+    vsyncarch_get_metrics(&vsync_metric_cpu_percent, &vsync_metric_emulated_fps, NULL, NULL, NULL, &vsync_metric_warp_enabled);
 
     sep = ui_pause_active() ? ('P' | 0x80) : vsync_metric_warp_enabled ? ('W' | 0x80) : '/';
 
@@ -61,6 +61,7 @@
 #include "archdep_default_rtc_file_name.h"
 #include "archdep_default_sysfile_pathlist.h"
 #include "archdep_dir.h"
+#include "archdep_dir_watch.h"
 #include "archdep_ethernet_available.h"
 #include "archdep_exit.h"
 #include "archdep_expand_path.h"
@@ -69,6 +70,7 @@
 #include "archdep_file_exists.h"
 #include "archdep_file_is_blockdev.h"
 #include "archdep_file_is_chardev.h"
+#include "archdep_file_map.h"
 #include "archdep_file_size.h"
 #include "archdep_filename_parameter.h"
 #include "archdep_fix_permissions.h"
@@ -76,6 +78,7 @@
 #include "archdep_fseeko.h"
 #include "archdep_ftello.h"
 #include "archdep_get_current_drive.h"
+#include "archdep_get_peak_rss.h"
 #include "archdep_get_runtime_info.h"
 #include "archdep_get_vice_datadir.h"
 #include "archdep_get_vice_docsdir.h"
@@ -0,0 +1,156 @@
+/** \file   archdep_dir_watch.c
+ * \brief   Detect changes to the contents of a host directory
+ *
+ * Used by code that keeps an in-memory copy of a host directory listing (for
+ * example the file system device) to find out cheaply whether that copy is
+ * still valid.
+ *
+ * On Linux inotify is used, so checking for changes is a single non-blocking
+ * read() on the inotify descriptor. On other systems the modification time
+ * of the directory is compared against the time recorded when the watch was
+ * created, which catches files being added, removed or renamed. That check
+ * only has a resolution of one second, so callers that modify the directory
+ * themselves should drop their copy explicitly as well.
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+#include "archdep_defs.h"
+
+#include <stdbool.h>
+
+#if defined(LINUX_COMPILE)
+# include <errno.h>
+# include <sys/inotify.h>
+# include <unistd.h>
+#endif
+
+#include "lib.h"
+
+#include "archdep_dir_watch.h"
+#include "archdep_file_map.h"
+
+
+/** \brief  Directory watch object
+ */
+struct archdep_dir_watch_s {
+    char *path;         /**< directory being watched */
+    archdep_file_stamp_t stamp; /**< stamp of \a path at creation */
+#if defined(LINUX_COMPILE)
+    int fd;             /**< inotify descriptor, -1 if unavailable */
+#endif
+};
+
+
+/** \brief  Start watching directory \a path for changes
+ *
+ * \param[in]   path    directory to watch
+ *
+ * \return  watch object or NULL when \a path can't be accessed
+ */
+archdep_dir_watch_t *archdep_dir_watch_new(const char *path)
+{
+    archdep_dir_watch_t *watch;
+    archdep_file_stamp_t stamp;
+
+    /* the stamp has nanoseconds where the host has them, st_mtime alone
+       would miss a second change within the same second */
+    if (!archdep_file_stamp(path, &stamp)) {
+        return NULL;
+    }
+
+    watch = lib_malloc(sizeof *watch);
+    watch->path = lib_strdup(path);
+    watch->stamp = stamp;
+
+#if defined(LINUX_COMPILE)
+    watch->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (watch->fd >= 0) {
+        if (inotify_add_watch(watch->fd, path,
+                              IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                              IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF) < 0) {
+            close(watch->fd);
+            watch->fd = -1;
+        }
+    }
+#endif
+    return watch;
+}
+
+
+/** \brief  Check if the watched directory changed
+ *
+ * Once this has returned true the watch should be freed and recreated, it
+ * does not reset itself.
+ *
+ * \param[in]   watch   watch object
+ *
+ * \return  true if the directory (may have) changed since the watch was
+ *          created
+ */
+bool archdep_dir_watch_changed(archdep_dir_watch_t *watch)
+{
+    archdep_file_stamp_t stamp;
+
+    if (watch == NULL) {
+        return true;
+    }
+
+#if defined(LINUX_COMPILE)
+    if (watch->fd >= 0) {
+        char buffer[sizeof(struct inotify_event) + 256];
+        ssize_t len;
+
+        len = read(watch->fd, buffer, sizeof buffer);
+        if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return false;
+        }
+        /* either an event arrived or the descriptor broke */
+        return true;
+    }
+#endif
+
+    if (!archdep_file_stamp(watch->path, &stamp)) {
+        return true;
+    }
+    return !archdep_file_stamp_equal(&stamp, &watch->stamp);
+}
+
+
+/** \brief  Stop watching and free \a watch
+ *
+ * \param[in]   watch   watch object (`NULL` is allowed)
+ */
+void archdep_dir_watch_free(archdep_dir_watch_t *watch)
+{
+    if (watch == NULL) {
+        return;
+    }
+#if defined(LINUX_COMPILE)
+    if (watch->fd >= 0) {
+        close(watch->fd);
+    }
+#endif
+    lib_free(watch->path);
+    lib_free(watch);
+}
@@ -0,0 +1,37 @@
+/** \file   archdep_dir_watch.h
+ * \brief   Detect changes to the contents of a host directory - header
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_ARCHDEP_DIR_WATCH_H
+#define VICE_ARCHDEP_DIR_WATCH_H
+
+#include <stdbool.h>
+
+typedef struct archdep_dir_watch_s archdep_dir_watch_t;
+
+archdep_dir_watch_t *archdep_dir_watch_new(const char *path);
+bool                 archdep_dir_watch_changed(archdep_dir_watch_t *watch);
+void                 archdep_dir_watch_free(archdep_dir_watch_t *watch);
+
+#endif
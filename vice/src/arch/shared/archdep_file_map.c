@@ -0,0 +1,202 @@
+/** \file   archdep_file_map.c
+ * \brief   Read-only mapping of a whole file into memory
+ *
+ * Used by the ROM cache to share the contents of ROM and cartridge images
+ * between reloads, and by zfile to keep track of its extraction cache. On Unix the file is mmap()ed, elsewhere it is read into
+ * an allocated buffer. The file stamp (size, modification time and inode) is
+ * used to find out whether a mapping still matches the file on disk.
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+#include "archdep_defs.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if defined(UNIX_COMPILE)
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <unistd.h>
+# include <utime.h>
+#elif defined(WINDOWS_COMPILE)
+# include <sys/utime.h>
+#endif
+
+#include "lib.h"
+
+#include "archdep_file_map.h"
+
+
+/** \brief  Get the identity of \a path
+ *
+ * \param[in]   path    pathname
+ * \param[out]  stamp   size, modification time and inode of \a path
+ *
+ * \return  true on success
+ */
+bool archdep_file_stamp(const char *path, archdep_file_stamp_t *stamp)
+{
+    struct stat statbuf;
+
+    memset(stamp, 0, sizeof *stamp);
+    if (stat(path, &statbuf) < 0) {
+        return false;
+    }
+
+    stamp->size = (uint64_t)statbuf.st_size;
+    stamp->mtime_ns = (int64_t)statbuf.st_mtime * 1000000000;
+#if defined(LINUX_COMPILE)
+    stamp->mtime_ns += statbuf.st_mtim.tv_nsec;
+#elif defined(MACOS_COMPILE)
+    stamp->mtime_ns += statbuf.st_mtimespec.tv_nsec;
+#endif
+#if defined(UNIX_COMPILE)
+    stamp->inode = (uint64_t)statbuf.st_ino;
+#endif
+    return true;
+}
+
+
+/** \brief  Compare two file stamps
+ *
+ * \param[in]   a   stamp
+ * \param[in]   b   stamp
+ *
+ * \return  true if both stamps describe the same, unmodified, file
+ */
+bool archdep_file_stamp_equal(const archdep_file_stamp_t *a,
+                              const archdep_file_stamp_t *b)
+{
+    return a->size == b->size
+        && a->mtime_ns == b->mtime_ns
+        && a->inode == b->inode;
+}
+
+
+/** \brief  Set the modification time of \a path to the current time
+ *
+ * Used to keep track of when a cached file was used last.
+ *
+ * \param[in]   path    pathname
+ *
+ * \return  true on success
+ */
+bool archdep_file_touch(const char *path)
+{
+#if defined(UNIX_COMPILE)
+    return utime(path, NULL) == 0;
+#elif defined(WINDOWS_COMPILE)
+    return _utime(path, NULL) == 0;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+
+/** \brief  Map the contents of \a path into memory, read-only
+ *
+ * On Unix the file is mmap()ed, so the data is shared with the host's page
+ * cache. Elsewhere the file is read into a heap buffer.
+ *
+ * The file must not be truncated while it is mapped, so writers of files
+ * that may be mapped should have the mapping released first.
+ *
+ * \param[in]   path    pathname
+ * \param[out]  size    size of the mapping
+ *
+ * \return  pointer to the data, or NULL on error or for an empty file
+ */
+void *archdep_file_map(const char *path, size_t *size)
+{
+#if defined(UNIX_COMPILE)
+    struct stat statbuf;
+    void *data;
+    int fd;
+
+    *size = 0;
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    if (fstat(fd, &statbuf) < 0 || !S_ISREG(statbuf.st_mode)
+            || statbuf.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+    data = mmap(NULL, (size_t)statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return NULL;
+    }
+    *size = (size_t)statbuf.st_size;
+    return data;
+#else
+    FILE *fp;
+    long len;
+    void *data;
+
+    *size = 0;
+    fp = fopen(path, MODE_READ);
+    if (fp == NULL) {
+        return NULL;
+    }
+    if (fseek(fp, 0, SEEK_END) != 0 || (len = ftell(fp)) <= 0
+            || fseek(fp, 0, SEEK_SET) != 0) {
+        fclose(fp);
+        return NULL;
+    }
+    data = lib_malloc((size_t)len);
+    if (fread(data, 1, (size_t)len, fp) != (size_t)len) {
+        lib_free(data);
+        fclose(fp);
+        return NULL;
+    }
+    fclose(fp);
+    *size = (size_t)len;
+    return data;
+#endif
+}
+
+
+/** \brief  Release a mapping obtained with archdep_file_map()
+ *
+ * \param[in]   data    pointer returned by archdep_file_map()
+ * \param[in]   size    size returned by archdep_file_map()
+ */
+void archdep_file_unmap(void *data, size_t size)
+{
+    if (data == NULL) {
+        return;
+    }
+#if defined(UNIX_COMPILE)
+    munmap(data, size);
+#else
+    (void)size;
+    lib_free(data);
+#endif
+}
@@ -0,0 +1,49 @@
+/** \file   archdep_file_map.h
+ * \brief   Read-only mapping of a whole file into memory - header
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+#ifndef VICE_ARCHDEP_FILE_MAP_H
+#define VICE_ARCHDEP_FILE_MAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** \brief  Identity of a file, used to detect that it was replaced or
+ *          modified
+ */
+typedef struct archdep_file_stamp_s {
+    uint64_t size;      /**< size in bytes */
+    int64_t mtime_ns;   /**< modification time in nanoseconds (resolution
+                             depends on the host) */
+    uint64_t inode;     /**< inode or file index, 0 if not available */
+} archdep_file_stamp_t;
+
+bool  archdep_file_stamp(const char *path, archdep_file_stamp_t *stamp);
+bool  archdep_file_stamp_equal(const archdep_file_stamp_t *a,
+                               const archdep_file_stamp_t *b);
+bool  archdep_file_touch(const char *path);
+void *archdep_file_map(const char *path, size_t *size);
+void  archdep_file_unmap(void *data, size_t size);
+
+#endif
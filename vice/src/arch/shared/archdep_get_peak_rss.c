@@ -0,0 +1,73 @@
+/** \file   archdep_get_peak_rss.c
+ * \brief   Get the peak memory use of the emulator
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+#include "archdep_defs.h"
+
+#include <stdint.h>
+
+#if defined(WINDOWS_COMPILE)
+# include <windows.h>
+/* use the kernel32 entry points, so there is no need to link psapi */
+# define PSAPI_VERSION 2
+# include <psapi.h>
+#elif defined(UNIX_COMPILE) || defined(MACOS_COMPILE)
+# include <sys/time.h>
+# include <sys/resource.h>
+#endif
+
+#include "archdep_get_peak_rss.h"
+
+
+/** \brief  Get the largest resident set size of the process so far
+ *
+ * \return  size in bytes, or -1 if the host can't tell
+ */
+int64_t archdep_get_peak_rss(void)
+{
+#if defined(WINDOWS_COMPILE)
+    PROCESS_MEMORY_COUNTERS pmc;
+
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        return -1;
+    }
+    return (int64_t)pmc.PeakWorkingSetSize;
+#elif defined(UNIX_COMPILE) || defined(MACOS_COMPILE)
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+# if defined(MACOS_COMPILE)
+    /* bytes on macOS ... */
+    return (int64_t)usage.ru_maxrss;
+# else
+    /* ... kilobytes everywhere else */
+    return (int64_t)usage.ru_maxrss * 1024;
+# endif
+#else
+    return -1;
+#endif
+}
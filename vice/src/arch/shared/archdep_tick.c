@@ -113,6 +113,48 @@ tick_t tick_now(void)
 }
 #endif
 
+/*
+ * tick_now() is only good to a microsecond, which is too coarse to time
+ * pieces of work that take a few hundred nanoseconds. This one keeps the
+ * full resolution of the host timer and does not wrap.
+ */
+#ifdef WINDOWS_COMPILE
+uint64_t tick_now_nano(void)
+{
+    LARGE_INTEGER time_now;
+    uint64_t counter, frequency;
+
+    QueryPerformanceCounter(&time_now);
+    counter = (uint64_t)time_now.QuadPart;
+    frequency = (uint64_t)timer_frequency.QuadPart;
+
+    return (counter / frequency) * NANO_PER_SECOND
+           + (counter % frequency) * NANO_PER_SECOND / frequency;
+}
+
+#elif defined(MACOS_COMPILE)
+uint64_t tick_now_nano(void)
+{
+    return mach_absolute_time() * timebase_info.numer / timebase_info.denom;
+}
+
+#else
+uint64_t tick_now_nano(void)
+{
+    struct timespec now;
+
+#if defined(LINUX_COMPILE)
+    clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+#elif defined(FREEBSD_COMPILE)
+    clock_gettime(CLOCK_MONOTONIC_PRECISE, &now);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &now);
+#endif
+
+    return ((uint64_t)NANO_PER_SECOND * now.tv_sec) + now.tv_nsec;
+}
+#endif
+
 #ifdef WINDOWS_COMPILE
 static inline void sleep_impl(tick_t sleep_ticks)
 {
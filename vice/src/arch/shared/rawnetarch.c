@@ -112,6 +112,9 @@ static int set_ethernet_driver(const char *name, void *param)
         rawnet_arch_driver = &rawnet_arch_driver_tuntap;
     }
 #endif
+    if (strcmp(name, rawnet_arch_driver_loopback.name) == 0) {
+        rawnet_arch_driver = &rawnet_arch_driver_loopback;
+    }
 
     if (rawnet_arch_driver != NULL) {
         util_string_set(&rawnet_arch_driver_name, rawnet_arch_driver->name);
@@ -190,7 +193,7 @@ static const cmdline_option_t cmdline_options[] =
 {
     { "-ethernetiodriver", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
       NULL, NULL, "ETHERNET_DRIVER", NULL,
-      "<Name>", "Set the low-level driver for Ethernet emulation (tuntap, pcap)." },
+      "<Name>", "Set the low-level driver for Ethernet emulation (tuntap, pcap, loopback)." },
     CMDLINE_LIST_END
 };
 
@@ -400,6 +403,9 @@ static char *rawnetdrivernames[] = {
 #endif
 #ifdef HAVE_PCAP
     "pcap",
+#endif
+#ifdef UNIX_COMPILE
+    "loopback",
 #endif
     NULL
 };
@@ -411,6 +417,9 @@ static char *rawnetdriverdescs[] = {
 #endif
 #ifdef HAVE_PCAP
     "PCAP",
+#endif
+#ifdef UNIX_COMPILE
+    "loopback (testing)",
 #endif
     NULL
 };
@@ -421,13 +430,17 @@ int rawnet_arch_enumdriver_open(void)
     /* HACK! remove pcap from the list when its not available */
 #ifdef HAVE_PCAP
     if (!archdep_rawnet_capability()) {
-#ifdef HAVE_TUNTAP
-        rawnetdrivernames[2] = NULL;
-        rawnetdriverdescs[2] = NULL;
-#else
-        rawnetdrivernames[1] = NULL;
-        rawnetdriverdescs[1] = NULL;
-#endif
+        int i;
+
+        for (i = 0; rawnetdrivernames[i] != NULL; i++) {
+            if (strcmp(rawnetdrivernames[i], "pcap") == 0) {
+                break;
+            }
+        }
+        for (; rawnetdrivernames[i] != NULL; i++) {
+            rawnetdrivernames[i] = rawnetdrivernames[i + 1];
+            rawnetdriverdescs[i] = rawnetdriverdescs[i + 1];
+        }
     }
 #endif
     return 1;
@@ -118,6 +118,7 @@ extern rawnet_arch_driver_t rawnet_arch_driver_pcap;
 #ifdef HAVE_TUNTAP
 extern rawnet_arch_driver_t rawnet_arch_driver_tuntap;
 #endif
+extern rawnet_arch_driver_t rawnet_arch_driver_loopback;
 
 #endif /* ifdef UNIX_COMPILE */
 
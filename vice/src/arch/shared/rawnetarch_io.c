@@ -0,0 +1,397 @@
+/** \file   rawnetarch_io.c
+ * \brief   I/O thread and frame queues for the Unix rawnet drivers
+ *
+ * The CS8900 emulation asks for received frames on register reads and hands
+ * over frames to send on register writes, so a driver doing a system call
+ * for each of those slows down the emulation and, when the emulation is
+ * busy elsewhere, makes the host drop frames.
+ *
+ * Here a thread moves frames between the host and two single producer,
+ * single consumer rings, one for each direction. The emulation side only
+ * copies a frame in or out of a ring. The thread sleeps in poll() on the
+ * host file descriptor and a pipe; the emulation only writes to the pipe
+ * when the thread told it so, which is after the thread has seen no
+ * traffic for RAWNET_IO_SPIN_US, or when the receive ring ran full. Until
+ * then the thread keeps checking the rings and the host without blocking,
+ * so that a busy connection costs no system call on the emulation side.
+ * While the receive ring is full the host descriptor is not read, so
+ * frames wait in the host queue instead of being thrown away.
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+
+#ifdef HAVE_RAWNET
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "archdep_tick.h"
+#include "lib.h"
+#include "log.h"
+#include "rawnetarch.h"
+#include "rawnetarch_io.h"
+
+/* How long the thread keeps watching the rings on its own after the last
+   frame, before it sleeps and asks to be woken up.  */
+#define RAWNET_IO_SPIN_US       200
+
+typedef struct rawnet_ring_s {
+    atomic_uint head;       /* next slot to fill, only the producer writes it */
+    atomic_uint tail;       /* next slot to empty, only the consumer writes it */
+    int len[RAWNET_IO_SLOTS];
+    uint8_t frame[RAWNET_IO_SLOTS][RAWNET_IO_FRAME_SIZE];
+} rawnet_ring_t;
+
+static rawnet_ring_t *rx_ring = NULL;
+static rawnet_ring_t *tx_ring = NULL;
+
+static rawnet_arch_io_backend_t io_backend;
+static pthread_t io_thread;
+static int io_running = 0;
+static int wake_pipe[2] = { -1, -1 };
+static atomic_int io_stop;
+
+/* Set by the thread before it sleeps without watching a ring, cleared by
+   whoever wakes it up.  */
+static atomic_int tx_wait;
+static atomic_int rx_wait;
+
+/* The thread must not log, errors are reported when it is stopped.  */
+static unsigned long stat_rx, stat_tx, stat_errors;
+static int stat_errno;
+
+/* Only touched by the emulation.  */
+static unsigned long stat_tx_dropped, stat_wakeups;
+
+/* ------------------------------------------------------------------------- */
+
+/* The head and tail updates and the reads of the wait flags use sequential
+   consistency, so that either the thread sees a frame queued while it was
+   going to sleep or the emulation sees the flag.  */
+
+static uint8_t *ring_slot_in(rawnet_ring_t *r)
+{
+    unsigned int head = atomic_load_explicit(&r->head, memory_order_relaxed);
+
+    if (head - atomic_load(&r->tail) >= RAWNET_IO_SLOTS) {
+        return NULL;
+    }
+    return r->frame[head % RAWNET_IO_SLOTS];
+}
+
+static void ring_push(rawnet_ring_t *r, int len)
+{
+    unsigned int head = atomic_load_explicit(&r->head, memory_order_relaxed);
+
+    r->len[head % RAWNET_IO_SLOTS] = len;
+    atomic_store(&r->head, head + 1);
+}
+
+static const uint8_t *ring_slot_out(rawnet_ring_t *r, int *plen)
+{
+    unsigned int tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+    if (atomic_load(&r->head) == tail) {
+        return NULL;
+    }
+    *plen = r->len[tail % RAWNET_IO_SLOTS];
+    return r->frame[tail % RAWNET_IO_SLOTS];
+}
+
+static void ring_pop(rawnet_ring_t *r)
+{
+    unsigned int tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+
+    atomic_store(&r->tail, tail + 1);
+}
+
+static int ring_is_full(rawnet_ring_t *r)
+{
+    return atomic_load(&r->head) - atomic_load(&r->tail) >= RAWNET_IO_SLOTS;
+}
+
+static int ring_is_empty(rawnet_ring_t *r)
+{
+    return atomic_load(&r->head) == atomic_load(&r->tail);
+}
+
+static void io_wake(void)
+{
+    char c = 0;
+
+    /* the pipe does not block, if it is full the thread is awake anyway */
+    if (write(wake_pipe[1], &c, 1) < 0) {
+        return;
+    }
+    stat_wakeups++;
+}
+
+static void io_error(void)
+{
+    stat_errors++;
+    stat_errno = errno;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Send everything in the transmit ring that can be sent, returns the
+   number of frames taken from it.  */
+static int io_thread_transmit(void)
+{
+    const uint8_t *out;
+    uint8_t *in;
+    int len, count = 0;
+
+    while ((out = ring_slot_out(tx_ring, &len)) != NULL) {
+        if (io_backend.write == NULL) {
+            in = ring_slot_in(rx_ring);
+            if (in == NULL) {
+                /* keep it until the emulation made room */
+                break;
+            }
+            memcpy(in, out, len);
+            ring_push(rx_ring, len);
+            stat_rx++;
+        } else if (io_backend.write(out, len) < 0) {
+            io_error();
+        }
+        ring_pop(tx_ring);
+        stat_tx++;
+        count++;
+    }
+    return count;
+}
+
+static int io_thread_can_transmit(void)
+{
+    return !ring_is_empty(tx_ring)
+           && (io_backend.write != NULL || !ring_is_full(rx_ring));
+}
+
+static void *io_thread_main(void *unused)
+{
+    struct pollfd pfd[2];
+    char drain[64];
+    uint8_t *in;
+    int nfds, timeout, len;
+    tick_t spin = (tick_t)((uint64_t)RAWNET_IO_SPIN_US * tick_per_second() / MICRO_PER_SECOND);
+    tick_t last_frame = tick_now();
+
+    while (!atomic_load(&io_stop)) {
+        if (io_thread_transmit() > 0) {
+            last_frame = tick_now();
+        }
+
+        if (ring_is_full(rx_ring)) {
+            atomic_store(&rx_wait, 1);
+            if (!ring_is_full(rx_ring)) {
+                atomic_store(&rx_wait, 0);
+                continue;
+            }
+        }
+
+        if (tick_now_delta(last_frame) < spin) {
+            timeout = 0;
+        } else {
+            atomic_store(&tx_wait, 1);
+            if (io_thread_can_transmit()) {
+                atomic_store(&tx_wait, 0);
+                continue;
+            }
+            timeout = -1;
+        }
+
+        pfd[0].fd = wake_pipe[0];
+        pfd[0].events = POLLIN;
+        pfd[0].revents = 0;
+        nfds = 1;
+        if (io_backend.fd >= 0 && !ring_is_full(rx_ring)) {
+            pfd[1].fd = io_backend.fd;
+            pfd[1].events = POLLIN;
+            pfd[1].revents = 0;
+            nfds = 2;
+        }
+
+        switch (poll(pfd, nfds, timeout)) {
+            case -1:
+                if (errno != EINTR) {
+                    io_error();
+                }
+                continue;
+            case 0:
+                if (timeout == 0) {
+                    sched_yield();
+                }
+                continue;
+            default:
+                break;
+        }
+        atomic_store(&tx_wait, 0);
+        atomic_store(&rx_wait, 0);
+
+        if (pfd[0].revents & POLLIN) {
+            if (read(wake_pipe[0], drain, sizeof(drain)) < 0) {
+                io_error();
+            }
+        }
+
+        if (nfds == 2 && pfd[1].revents) {
+            if (pfd[1].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                /* the interface went away, stop reading it */
+                io_error();
+                io_backend.fd = -1;
+            } else if ((in = ring_slot_in(rx_ring)) != NULL) {
+                len = io_backend.read(in, RAWNET_IO_FRAME_SIZE);
+                if (len < 0) {
+                    io_error();
+                } else if (len > 0) {
+                    ring_push(rx_ring, len);
+                    stat_rx++;
+                    last_frame = tick_now();
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int rawnet_arch_io_start(const rawnet_arch_io_backend_t *backend)
+{
+    rawnet_arch_io_stop();
+
+    if (pipe(wake_pipe) < 0) {
+        log_message(rawnet_arch_log, "ERROR creating the wakeup pipe: '%s'", strerror(errno));
+        return -1;
+    }
+    fcntl(wake_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK);
+
+    rx_ring = lib_calloc(1, sizeof(rawnet_ring_t));
+    tx_ring = lib_calloc(1, sizeof(rawnet_ring_t));
+    io_backend = *backend;
+
+    atomic_store(&io_stop, 0);
+    atomic_store(&tx_wait, 0);
+    atomic_store(&rx_wait, 0);
+    stat_rx = stat_tx = stat_errors = stat_tx_dropped = stat_wakeups = 0;
+    stat_errno = 0;
+
+    if (pthread_create(&io_thread, NULL, io_thread_main, NULL) != 0) {
+        log_message(rawnet_arch_log, "ERROR starting the I/O thread.");
+        close(wake_pipe[0]);
+        close(wake_pipe[1]);
+        lib_free(rx_ring);
+        lib_free(tx_ring);
+        rx_ring = tx_ring = NULL;
+        return -1;
+    }
+    io_running = 1;
+    return 0;
+}
+
+void rawnet_arch_io_stop(void)
+{
+    if (!io_running) {
+        return;
+    }
+
+    atomic_store(&io_stop, 1);
+    io_wake();
+    pthread_join(io_thread, NULL);
+    io_running = 0;
+
+    log_message(rawnet_arch_log,
+                "%s: %lu frames received, %lu sent, %lu dropped (transmit queue full), %lu wakeups.",
+                io_backend.name, stat_rx, stat_tx, stat_tx_dropped, stat_wakeups);
+    if (stat_errors > 0) {
+        log_message(rawnet_arch_log, "%s: %lu I/O errors, the last one was '%s'",
+                    io_backend.name, stat_errors, strerror(stat_errno));
+    }
+
+    close(wake_pipe[0]);
+    close(wake_pipe[1]);
+    wake_pipe[0] = wake_pipe[1] = -1;
+    lib_free(rx_ring);
+    lib_free(tx_ring);
+    rx_ring = tx_ring = NULL;
+}
+
+/* The CS8900 has no way to hold back a frame, so one that does not fit is
+   lost just like on a congested wire.  */
+void rawnet_arch_io_transmit(const uint8_t *frame, int len)
+{
+    uint8_t *slot;
+
+    if (!io_running) {
+        return;
+    }
+    slot = ring_slot_in(tx_ring);
+    if (slot == NULL) {
+        stat_tx_dropped++;
+        return;
+    }
+    if (len > RAWNET_IO_FRAME_SIZE) {
+        len = RAWNET_IO_FRAME_SIZE;
+    }
+    memcpy(slot, frame, len);
+    ring_push(tx_ring, len);
+
+    if (atomic_load(&tx_wait) && atomic_exchange(&tx_wait, 0)) {
+        io_wake();
+    }
+}
+
+/* Like the receive function of the drivers, *plen is the size of the buffer
+   on entry and the length of the frame on return, which may be larger.  */
+int rawnet_arch_io_receive(uint8_t *buffer, int *plen)
+{
+    const uint8_t *slot;
+    int len;
+
+    if (!io_running) {
+        return 0;
+    }
+    slot = ring_slot_out(rx_ring, &len);
+    if (slot == NULL) {
+        return 0;
+    }
+    memcpy(buffer, slot, (len < *plen) ? len : *plen);
+    *plen = len;
+    ring_pop(rx_ring);
+
+    if (atomic_load(&rx_wait) && atomic_exchange(&rx_wait, 0)) {
+        io_wake();
+    }
+    return 1;
+}
+
+#endif /* #ifdef HAVE_RAWNET */
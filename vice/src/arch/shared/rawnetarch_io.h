@@ -0,0 +1,57 @@
+/** \file   rawnetarch_io.h
+ * \brief   I/O thread and frame queues for the Unix rawnet drivers
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_RAWNETARCH_IO_H
+#define VICE_RAWNETARCH_IO_H
+
+#include "types.h"
+
+/* Frames queued in each direction */
+#define RAWNET_IO_SLOTS         64
+
+/* Largest frame kept, an Ethernet frame with a VLAN tag fits */
+#define RAWNET_IO_FRAME_SIZE    1536
+
+/** \brief  Host side of a driver using the I/O thread
+ *
+ * The callbacks run on the I/O thread only. \a read is called when \a fd
+ * is readable and returns the length of the frame read, or -1 on error.
+ * \a write returns -1 on error. A backend without \a write sends every
+ * transmitted frame straight back to the receive queue.
+ */
+typedef struct rawnet_arch_io_backend_s {
+    const char *name;
+    int fd;
+    int (*read)(uint8_t *buffer, int len);
+    int (*write)(const uint8_t *frame, int len);
+} rawnet_arch_io_backend_t;
+
+int rawnet_arch_io_start(const rawnet_arch_io_backend_t *backend);
+void rawnet_arch_io_stop(void);
+
+void rawnet_arch_io_transmit(const uint8_t *frame, int len);
+int rawnet_arch_io_receive(uint8_t *buffer, int *plen);
+
+#endif
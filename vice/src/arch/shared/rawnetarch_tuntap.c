@@ -36,7 +36,6 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <net/if.h>
-#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -48,6 +47,7 @@
 #include "lib.h"
 #include "log.h"
 #include "rawnetarch.h"
+#include "rawnetarch_io.h"
 #include "resources.h"
 #include "util.h"
 
@@ -123,7 +123,8 @@ static int rawnet_tuntap_open_adapter(const char *interface_name)
     const char *tundev = "/dev/net/tun";
 
     /* Here it would be nice to use O_NONBLOCK, but this seems to cause
-     * a massive loss of frames (at least on Linux). So, we'll use poll()
+     * a massive loss of frames (at least on Linux). So, the I/O thread
+     * uses poll()
      */
     rawnet_arch_tuntap_tun_fd = open(tundev, O_RDWR);
     if (rawnet_arch_tuntap_tun_fd < 0) {
@@ -144,6 +145,18 @@ static int rawnet_tuntap_open_adapter(const char *interface_name)
     return 1;
 }
 
+/* Called on the I/O thread, see rawnetarch_io.c */
+static int rawnet_tuntap_read(uint8_t *buffer, int len)
+{
+    return (int)read(rawnet_arch_tuntap_tun_fd, buffer, len);
+}
+
+static int rawnet_tuntap_write(const uint8_t *frame, int len)
+{
+    /* a tap device takes a frame with one write or not at all */
+    return (write(rawnet_arch_tuntap_tun_fd, frame, len) == len) ? 0 : -1;
+}
+
 /* ------------------------------------------------------------------------- */
 /*    the architecture-dependend functions                                   */
 
@@ -157,14 +170,27 @@ static void rawnet_arch_tuntap_post_reset(void)
 
 static int rawnet_arch_tuntap_activate(const char *interface_name)
 {
+    rawnet_arch_io_backend_t backend;
+
     if (!rawnet_tuntap_open_adapter(interface_name)) {
         return 0;
     }
+
+    backend.name = "tuntap";
+    backend.fd = rawnet_arch_tuntap_tun_fd;
+    backend.read = rawnet_tuntap_read;
+    backend.write = rawnet_tuntap_write;
+    if (rawnet_arch_io_start(&backend) < 0) {
+        close(rawnet_arch_tuntap_tun_fd);
+        rawnet_arch_tuntap_tun_fd = -1;
+        return 0;
+    }
     return 1;
 }
 
 static void rawnet_arch_tuntap_deactivate(void)
 {
+    rawnet_arch_io_stop();
     close(rawnet_arch_tuntap_tun_fd);
     rawnet_arch_tuntap_tun_fd = -1;
 }
@@ -204,15 +230,7 @@ static void rawnet_arch_tuntap_line_ctl(int bEnableTransmitter, int bEnableRecei
 static void rawnet_arch_tuntap_transmit(int force, int onecoll, int inhibit_crc,
                                  int tx_pad_dis, int txlength, uint8_t *txframe)
 {
-    ssize_t res = write(rawnet_arch_tuntap_tun_fd, txframe, txlength);
-    if (res < 0) {
-        log_message(rawnet_arch_log, "ERROR transmitting frame: '%s'", strerror(errno));
-    } else if (res != txlength) {
-        /* We should never break a frame */
-        log_message(rawnet_arch_log,
-                "ERROR transmitting frame: only %" PRI_SSIZE_T " of %d bytes sent",
-                res, txlength);
-    }
+    rawnet_arch_io_transmit(txframe, txlength);
 }
 
 /**
@@ -257,29 +275,11 @@ static int rawnet_arch_tuntap_receive(uint8_t *pbuffer, int *plen, int  *phashed
         int *phash_index, int *prx_ok, int *pcorrect_mac, int *pbroadcast,
         int *pcrc_error)
 {
-    struct pollfd pfd[1] = {{rawnet_arch_tuntap_tun_fd, POLLIN, 0}};
-    ssize_t len;
-    int pollres;
+    int len = *plen;
 
     assert((*plen & 1) == 0);
 
-    pollres = poll(pfd, 1, 0);
-
-    if (pollres == 0) {
-        return 0;
-    } else if (pollres < 0) {
-        log_message(rawnet_arch_log, "ERROR polling for new frames: '%s'", strerror(errno));
-        return 0;
-    }
-
-    if ((pfd[0].revents & (POLLERR | POLLHUP | POLLNVAL)) != 0) {
-        log_message(rawnet_arch_log, "WARNING: unexpected event while polling for new frames");
-        return 0;
-    }
-
-    len = read(rawnet_arch_tuntap_tun_fd, pbuffer, *plen);
-    if (len == -1) {
-        log_message(rawnet_arch_log, "ERROR receiving frame: '%s'", strerror(errno));
+    if (!rawnet_arch_io_receive(pbuffer, &len)) {
         return 0;
     }
 
@@ -291,7 +291,7 @@ static int rawnet_arch_tuntap_receive(uint8_t *pbuffer, int *plen, int  *phashed
         /* This is needed by cs8900.c */
         ++len;
     }
-    *plen = (int)len;
+    *plen = len;
 
     /* We don't decide if this frame fits the needs;
      * by setting all zero, we let tfe.c do the work for us
@@ -0,0 +1,378 @@
+/*
+ * benchmark.c - Replay a recorded history and measure the emulation speed.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * A recorded history (see event.c) is a workload that does exactly the same
+ * thing every time it is played back: same input at the same cycles, same
+ * attached images. With `-benchmark <file>', playback runs in warp mode and,
+ * once the history ends, one line of JSON with the results is appended to
+ * the file and the emulator exits. Nothing depends on host timing: frames
+ * are either all rendered or all skipped (`-benchmarkvideo' and
+ * `+benchmarkvideo'), and sound is computed whenever it is enabled. The
+ * snapshots of a history bring back the `Sound' setting of the recording,
+ * `-benchmarksound' and `+benchmarksound' override it.
+ *
+ * Time spent per subsystem is measured by sampling: the emulation code marks
+ * what it is busy with in `benchmark_subsystem', which costs a store at each
+ * boundary, and a thread looks at it a thousand times per second while the
+ * benchmark runs. The cycle based VIC-II of x64sc only marks its work when
+ * perfstats is enabled; otherwise its time is counted as CPU time.
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(UNIX_COMPILE) || defined(MACOS_COMPILE)
+# define BENCHMARK_SAMPLER
+# include <pthread.h>
+#endif
+
+#include "archdep.h"
+#include "benchmark.h"
+#include "cmdline.h"
+#include "lib.h"
+#include "log.h"
+#include "machine.h"
+#include "maincpu.h"
+#include "resources.h"
+#include "types.h"
+#include "version.h"
+#include "vsync.h"
+#ifdef USE_SVN_REVISION
+# include "svnversion.h"
+#endif
+
+/* samples taken per second of host time */
+#define BENCHMARK_SAMPLE_RATE   1000
+
+atomic_int benchmark_subsystem = BENCHMARK_CPU;
+
+static const char * const subsystem_names[BENCHMARK_NUM] = {
+    "cpu", "vicii", "sid", "drives", "render", "ui", "idle", "other"
+};
+
+/* where to put the results, NULL if no benchmark was asked for */
+static char *benchmark_file = NULL;
+
+static int benchmark_video = 1;
+
+/* value to keep the Sound resource at, -1 to leave it alone */
+static int benchmark_sound = -1;
+
+static int benchmark_running = 0;
+
+/* measurements, updated every frame */
+static uint64_t benchmark_frames;
+static uint64_t benchmark_cycles;
+static uint64_t benchmark_ticks;
+static CLOCK benchmark_last_clk;
+static tick_t benchmark_last_tick;
+
+#ifdef BENCHMARK_SAMPLER
+static pthread_t sampler_thread;
+static int sampler_started = 0;
+static atomic_int sampler_stop;
+
+/* only touched by the sampler until it has been joined */
+static uint64_t sampler_counts[BENCHMARK_NUM];
+
+static void *sampler_main(void *unused)
+{
+    tick_t interval = tick_per_second() / BENCHMARK_SAMPLE_RATE;
+
+    while (!atomic_load_explicit(&sampler_stop, memory_order_relaxed)) {
+        int subsystem;
+
+        tick_sleep(interval);
+        subsystem = atomic_load_explicit(&benchmark_subsystem,
+                                         memory_order_relaxed);
+        if (subsystem >= 0 && subsystem < BENCHMARK_NUM) {
+            sampler_counts[subsystem]++;
+        }
+    }
+    return NULL;
+}
+
+static void sampler_start(void)
+{
+    memset(sampler_counts, 0, sizeof(sampler_counts));
+    atomic_store(&sampler_stop, 0);
+    if (pthread_create(&sampler_thread, NULL, sampler_main, NULL) != 0) {
+        log_warning(LOG_DEFAULT, "Benchmark: cannot start sampling thread, "
+                    "no time per subsystem.");
+        return;
+    }
+    sampler_started = 1;
+}
+
+static void sampler_end(void)
+{
+    if (sampler_started) {
+        atomic_store(&sampler_stop, 1);
+        pthread_join(sampler_thread, NULL);
+        sampler_started = 0;
+    }
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+
+const char *benchmark_subsystem_name(int subsystem)
+{
+    if (subsystem < 0 || subsystem >= BENCHMARK_NUM) {
+        return "unknown";
+    }
+    return subsystem_names[subsystem];
+}
+
+int benchmark_is_running(void)
+{
+    return benchmark_running;
+}
+
+/* Warp mode only renders a frame now and then, depending on the host time;
+   a benchmark renders all of them or none.  */
+int benchmark_should_skip_frame(void)
+{
+    return !benchmark_video;
+}
+
+static void benchmark_account(void)
+{
+    tick_t now = tick_now();
+
+    /* the clock goes back on a reset or snapshot load */
+    if (maincpu_clk > benchmark_last_clk) {
+        benchmark_cycles += maincpu_clk - benchmark_last_clk;
+    }
+    benchmark_last_clk = maincpu_clk;
+
+    /* tick_t wraps after a bit more than an hour, add up the frames instead */
+    benchmark_ticks += tick_now_delta(benchmark_last_tick);
+    benchmark_last_tick = now;
+}
+
+static void benchmark_apply_sound(void)
+{
+    int sound;
+
+    if (benchmark_sound >= 0
+        && resources_get_int("Sound", &sound) == 0 && sound != benchmark_sound) {
+        resources_set_int("Sound", benchmark_sound);
+    }
+}
+
+void benchmark_vsync(void)
+{
+    if (benchmark_running) {
+        benchmark_frames++;
+        benchmark_account();
+        /* loading a milestone snapshot sets it back */
+        benchmark_apply_sound();
+    }
+}
+
+/** \brief  Begin measuring, called when playback has started
+ */
+void benchmark_playback_start(void)
+{
+    if (benchmark_file == NULL || benchmark_running) {
+        return;
+    }
+
+    benchmark_frames = 0;
+    benchmark_cycles = 0;
+    benchmark_ticks = 0;
+    benchmark_last_clk = maincpu_clk;
+    benchmark_last_tick = tick_now();
+    benchmark_running = 1;
+
+    vsync_set_warp_mode(1);
+    benchmark_apply_sound();
+
+#ifdef BENCHMARK_SAMPLER
+    sampler_start();
+#endif
+
+    log_message(LOG_DEFAULT, "Benchmark: playback started.");
+}
+
+static void benchmark_write_results(FILE *f, double seconds)
+{
+    int sound = 0;
+    int64_t rss = archdep_get_peak_rss();
+    double cycles_per_second = (seconds > 0.0) ? benchmark_cycles / seconds : 0.0;
+    int i;
+
+    resources_get_int("Sound", &sound);
+
+    fprintf(f, "{\"machine\":\"%s\",\"version\":\"%s\"",
+            machine_get_name(), VERSION);
+#ifdef USE_SVN_REVISION
+    fprintf(f, ",\"revision\":\"%s\"", VICE_SVN_REV_STRING);
+#endif
+    fprintf(f, ",\"sound\":%s,\"video\":%s",
+            sound ? "true" : "false", benchmark_video ? "true" : "false");
+    fprintf(f, ",\"frames\":%"PRIu64",\"cycles\":%"PRIu64",\"seconds\":%.6f",
+            benchmark_frames, benchmark_cycles, seconds);
+    fprintf(f, ",\"cycles_per_second\":%.0f,\"speed_percent\":%.2f",
+            cycles_per_second,
+            cycles_per_second * 100.0 / machine_get_cycles_per_second());
+    if (rss >= 0) {
+        fprintf(f, ",\"peak_rss_bytes\":%"PRId64, rss);
+    } else {
+        fprintf(f, ",\"peak_rss_bytes\":null");
+    }
+
+#ifdef BENCHMARK_SAMPLER
+    {
+        uint64_t total = 0;
+
+        for (i = 0; i < BENCHMARK_NUM; i++) {
+            total += sampler_counts[i];
+        }
+        fprintf(f, ",\"samples\":%"PRIu64",\"subsystem_seconds\":{", total);
+        for (i = 0; i < BENCHMARK_NUM; i++) {
+            fprintf(f, "%s\"%s\":%.6f", (i > 0) ? "," : "", benchmark_subsystem_name(i),
+                    total ? seconds * sampler_counts[i] / total : 0.0);
+        }
+        fprintf(f, "}");
+    }
+#else
+    (void)i;
+    fprintf(f, ",\"samples\":0,\"subsystem_seconds\":null");
+#endif
+
+    fprintf(f, "}\n");
+}
+
+/** \brief  Stop measuring, write out the results and quit
+ *
+ * \param[in]   error   playback could not be started or broke down
+ */
+void benchmark_playback_stop(int error)
+{
+    FILE *f;
+    double seconds;
+    int rc = error ? 1 : 0;
+
+    if (benchmark_file == NULL) {
+        return;
+    }
+
+    if (!benchmark_running) {
+        if (error) {
+            log_error(LOG_DEFAULT, "Benchmark: playback could not be started.");
+            archdep_vice_exit(1);
+        }
+        return;
+    }
+
+    benchmark_account();
+    benchmark_running = 0;
+#ifdef BENCHMARK_SAMPLER
+    sampler_end();
+#endif
+    seconds = (double)benchmark_ticks / tick_per_second();
+
+    log_message(LOG_DEFAULT,
+                "Benchmark: %"PRIu64" cycles, %"PRIu64" frames in %.3f seconds:"
+                " %.0f cycles per second.",
+                benchmark_cycles, benchmark_frames, seconds,
+                (seconds > 0.0) ? benchmark_cycles / seconds : 0.0);
+
+    if (strcmp(benchmark_file, "-") == 0) {
+        benchmark_write_results(stdout, seconds);
+        fflush(stdout);
+    } else {
+        f = fopen(benchmark_file, "a");
+        if (f == NULL) {
+            log_error(LOG_DEFAULT, "Benchmark: cannot open `%s'.", benchmark_file);
+            rc = 1;
+        } else {
+            benchmark_write_results(f, seconds);
+            if (fclose(f) != 0) {
+                rc = 1;
+            }
+        }
+    }
+
+    archdep_vice_exit(rc);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int cmdline_benchmark(const char *param, void *extra_param)
+{
+    lib_free(benchmark_file);
+    benchmark_file = lib_strdup(param);
+    return 0;
+}
+
+static int cmdline_benchmark_video(const char *param, void *extra_param)
+{
+    benchmark_video = vice_ptr_to_int(extra_param);
+    return 0;
+}
+
+static int cmdline_benchmark_sound(const char *param, void *extra_param)
+{
+    benchmark_sound = vice_ptr_to_int(extra_param);
+    return 0;
+}
+
+static const cmdline_option_t cmdline_options[] =
+{
+    { "-benchmark", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      cmdline_benchmark, NULL, NULL, NULL,
+      "<Name>", "Measure the speed of the history playback, then append the results to <Name> (\"-\" for stdout) and quit" },
+    { "-benchmarkvideo", CALL_FUNCTION, CMDLINE_ATTRIB_NONE,
+      cmdline_benchmark_video, int_to_void_ptr(1), NULL, NULL,
+      NULL, "Render every frame during a benchmark (default)" },
+    { "+benchmarkvideo", CALL_FUNCTION, CMDLINE_ATTRIB_NONE,
+      cmdline_benchmark_video, int_to_void_ptr(0), NULL, NULL,
+      NULL, "Do not render any frames during a benchmark" },
+    { "-benchmarksound", CALL_FUNCTION, CMDLINE_ATTRIB_NONE,
+      cmdline_benchmark_sound, int_to_void_ptr(1), NULL, NULL,
+      NULL, "Enable sound during a benchmark, whatever the recording used" },
+    { "+benchmarksound", CALL_FUNCTION, CMDLINE_ATTRIB_NONE,
+      cmdline_benchmark_sound, int_to_void_ptr(0), NULL, NULL,
+      NULL, "Disable sound during a benchmark, whatever the recording used" },
+    CMDLINE_LIST_END
+};
+
+int benchmark_cmdline_options_init(void)
+{
+    return cmdline_register_options(cmdline_options);
+}
+
+void benchmark_shutdown(void)
+{
+#ifdef BENCHMARK_SAMPLER
+    sampler_end();
+#endif
+    lib_free(benchmark_file);
+    benchmark_file = NULL;
+}
@@ -0,0 +1,82 @@
+/*
+ * benchmark.h - Replay a recorded history and measure the emulation speed.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_BENCHMARK_H
+#define VICE_BENCHMARK_H
+
+#include <stdatomic.h>
+
+/* What the emulation thread is busy with */
+enum {
+    BENCHMARK_CPU = 0,      /* main CPU and everything not listed below */
+    BENCHMARK_VICII,
+    BENCHMARK_SID,
+    BENCHMARK_DRIVES,
+    BENCHMARK_RENDER,
+    BENCHMARK_UI,           /* handing the main lock over to the UI thread */
+    BENCHMARK_IDLE,         /* sleeping, or blocked on the sound device */
+    BENCHMARK_OTHER,        /* rest of the end of frame work */
+    BENCHMARK_NUM
+};
+
+extern atomic_int benchmark_subsystem;
+
+#ifdef USE_PERFSTATS
+/* in perfstats.c, times each piece of work */
+void perfstats_switch(int subsystem);
+#endif
+
+/* Mark the start of a piece of work, returns what to pass to
+   benchmark_leave() at its end. Pieces may nest.  */
+static inline int benchmark_enter(int subsystem)
+{
+    int prev = atomic_load_explicit(&benchmark_subsystem, memory_order_relaxed);
+
+    atomic_store_explicit(&benchmark_subsystem, subsystem, memory_order_relaxed);
+#ifdef USE_PERFSTATS
+    perfstats_switch(subsystem);
+#endif
+    return prev;
+}
+
+static inline void benchmark_leave(int prev)
+{
+    atomic_store_explicit(&benchmark_subsystem, prev, memory_order_relaxed);
+#ifdef USE_PERFSTATS
+    perfstats_switch(prev);
+#endif
+}
+
+const char *benchmark_subsystem_name(int subsystem);
+
+int benchmark_cmdline_options_init(void);
+void benchmark_shutdown(void);
+
+int benchmark_is_running(void);
+int benchmark_should_skip_frame(void);
+void benchmark_vsync(void);
+
+void benchmark_playback_start(void);
+void benchmark_playback_stop(int error);
+
+#endif
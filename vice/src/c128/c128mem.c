@@ -228,81 +228,181 @@ static uint8_t c128_mem_mmu_page_1_target_ram = 1;
 
 static uint8_t c128_mem_mmu_zp_sp_shared = 0;
 
+/* Where accesses to each page end up when the page 0/1 relocation sends them
+   elsewhere, NULL for pages that are left alone. At most 4 pages (0, 1 and
+   the two pages they are swapped with) are relocated at any time. The map is
+   rebuilt whenever one of the settings above changes, that is on writes to
+   the MMU that change them, so the zero page and stack accessors only need
+   a lookup.  */
+static uint8_t *c128_mem_mmu_page_map[0x100];
+
+/* The same for the zero page accessors, which send every access to page 0
+   of the relocation target and do not look at the page 1 settings.  */
+static uint8_t *c128_mem_mmu_zero_map = NULL;
+
+/* The chain of rules the MMU applies to a page. Returns 1 and sets the
+   target page and bank if the page is relocated.  */
+static int c128_mem_mmu_translate_page(uint8_t page, uint8_t *target_page, uint8_t *target_bank)
+{
+    *target_bank = 0;
+
+    /* check if the address page is page 1 and in shared memory then bank does not change */
+    if (c128_mem_mmu_zp_sp_shared && page == 1) {
+        *target_page = c128_mem_mmu_page_1;
+    /* check if the address page is page 0 and in shared memory then bank does not change */
+    } else if (c128_mem_mmu_zp_sp_shared && page == 0) {
+        *target_page = c128_mem_mmu_page_0;
+    /* check if the address page is page 1 and replace addr with mmu given page and bank */
+    } else if (page == 1) {
+        *target_page = c128_mem_mmu_page_1;
+        *target_bank = c128_mem_mmu_page_1_bank;
+    /* check if the address page is page 1 target and if it is current RAM, ifso replace addr with page 1 and bank 0 */
+    } else if (page == c128_mem_mmu_page_1 && c128_mem_mmu_page_1_target_ram) {
+        *target_page = 1;
+        *target_bank = c128_mem_mmu_page_1_bank;
+    /* check if the address page is page 0 and replace addr with mmu given page and bank */
+    } else if (page == 0) {
+        *target_page = c128_mem_mmu_page_0;
+        *target_bank = c128_mem_mmu_page_0_bank;
+    /* check if the address page is page 0 target and if it is current RAM, ifso replace addr with page 0 and bank 0 */
+    } else if (page == c128_mem_mmu_page_0 && c128_mem_mmu_page_0_target_ram) {
+        *target_page = 0;
+        *target_bank = c128_mem_mmu_page_0_bank;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+static uint8_t *c128_mem_mmu_page_ptr(uint8_t page, uint8_t bank)
+{
+    return mem_ram + ((unsigned int)bank << 16) + ((unsigned int)page << 8);
+}
+
+static void c128_mem_mmu_update_map(void)
+{
+    static uint8_t mapped[4];
+    static int num_mapped = 0;
+    uint8_t candidates[4];
+    uint8_t target_page, target_bank;
+    int i;
+
+    for (i = 0; i < num_mapped; i++) {
+        c128_mem_mmu_page_map[mapped[i]] = NULL;
+    }
+    num_mapped = 0;
+    c128_mem_mmu_zero_map = NULL;
+
+    /* Check if there is no translation that needs to be done */
+    if (c128_mem_mmu_page_0 == 0 && c128_mem_mmu_page_1 == 1 && c128_mem_mmu_page_0_bank == 0 && c128_mem_mmu_page_1_bank == 0) {
+        return;
+    }
+
+    /* only these pages can match one of the rules */
+    candidates[0] = 0;
+    candidates[1] = 1;
+    candidates[2] = c128_mem_mmu_page_1;
+    candidates[3] = c128_mem_mmu_page_0;
+
+    for (i = 0; i < 4; i++) {
+        uint8_t page = candidates[i];
+
+        if (c128_mem_mmu_page_map[page] == NULL
+            && c128_mem_mmu_translate_page(page, &target_page, &target_bank)) {
+            c128_mem_mmu_page_map[page] = c128_mem_mmu_page_ptr(target_page, target_bank);
+            mapped[num_mapped++] = page;
+        }
+    }
+
+    /* the zero page accessors have a check of their own */
+    if (c128_mem_mmu_page_0 != 0 || c128_mem_mmu_page_0_bank != 0) {
+        c128_mem_mmu_zero_map = c128_mem_mmu_page_ptr(c128_mem_mmu_page_0,
+                                                      c128_mem_mmu_zp_sp_shared ? 0 : c128_mem_mmu_page_0_bank);
+    }
+}
+
 void c128_mem_set_mmu_page_0(uint8_t val)
 {
-    c128_mem_mmu_page_0 = val;
+    if (c128_mem_mmu_page_0 != val) {
+        c128_mem_mmu_page_0 = val;
+        c128_mem_mmu_update_map();
+    }
 }
 
 void c128_mem_set_mmu_page_1(uint8_t val)
 {
-    c128_mem_mmu_page_1 = val;
+    if (c128_mem_mmu_page_1 != val) {
+        c128_mem_mmu_page_1 = val;
+        c128_mem_mmu_update_map();
+    }
 }
 
 void c128_mem_set_mmu_page_0_bank(uint8_t val)
 {
-    c128_mem_mmu_page_0_bank = val;
+    if (c128_mem_mmu_page_0_bank != val) {
+        c128_mem_mmu_page_0_bank = val;
+        c128_mem_mmu_update_map();
+    }
 }
 
 void c128_mem_set_mmu_page_1_bank(uint8_t val)
 {
-    c128_mem_mmu_page_1_bank = val;
+    if (c128_mem_mmu_page_1_bank != val) {
+        c128_mem_mmu_page_1_bank = val;
+        c128_mem_mmu_update_map();
+    }
 }
 
 void c128_mem_set_mmu_page_0_target_ram(uint8_t val)
 {
-    c128_mem_mmu_page_0_target_ram = val;
+    if (c128_mem_mmu_page_0_target_ram != val) {
+        c128_mem_mmu_page_0_target_ram = val;
+        c128_mem_mmu_update_map();
+    }
 }
 
 void c128_mem_set_mmu_page_1_target_ram(uint8_t val)
 {
-    c128_mem_mmu_page_1_target_ram = val;
+    if (c128_mem_mmu_page_1_target_ram != val) {
+        c128_mem_mmu_page_1_target_ram = val;
+        c128_mem_mmu_update_map();
+    }
 }
 
 void c128_mem_set_mmu_zp_sp_shared(uint8_t val)
 {
-    c128_mem_mmu_zp_sp_shared = val;
+    if (c128_mem_mmu_zp_sp_shared != val) {
+        c128_mem_mmu_zp_sp_shared = val;
+        c128_mem_mmu_update_map();
+    }
 }
 
-/* returns 0x100 if normal read needs to be done, or <0x100 if the read was remapped */
-static uint16_t z80_mem_mmu_wrap_read_zero(uint16_t address)
+/* returns non-zero if accesses to the given page may be redirected by the
+   page 0/1 relocation, i.e. if the page cannot be read from ram_bank directly */
+int c128_mem_mmu_page_is_remapped(uint8_t page)
 {
-    uint8_t addr_pos = (address & 0xff);
-    uint8_t addr_page = 0;
-    uint8_t addr_bank = 0;
-    uint16_t addr;
-    int use_ram_only = 0;
-
-    /* Check if there is no translation that needs to be done */
-    if (c128_mem_mmu_page_0 == 0 && c128_mem_mmu_page_0_bank == 0) {
-        return 0x100;
+    if (page == 0 || page == 1) {
+        return 1;
     }
 
-    /* check if the address page is page 0 and in shared memory then bank does not change */
-    if (c128_mem_mmu_zp_sp_shared && addr_page == 0) {
-        addr_page = c128_mem_mmu_page_0;
-        use_ram_only = 1;
-    /* check if the address page is page 0 and replace addr with mmu given page and bank */
-    } else if (addr_page == 0) {
-        addr_page = c128_mem_mmu_page_0;
-        addr_bank = c128_mem_mmu_page_0_bank;
-        use_ram_only = 1;
-    /* check if the address page is page 0 target and if it is current RAM, ifso replace addr with page 0 and bank 0 */
-    } else if (addr_page == c128_mem_mmu_page_0 && c128_mem_mmu_page_0_target_ram) {
-        addr_page = 0;
-        addr_bank = c128_mem_mmu_page_0_bank;
-        use_ram_only = 1;
+    if (c128_mem_mmu_page_0 == 0 && c128_mem_mmu_page_1 == 1 && c128_mem_mmu_page_0_bank == 0 && c128_mem_mmu_page_1_bank == 0) {
+        return 0;
     }
 
-    if (use_ram_only) {
-        addr = (addr_page << 8) | addr_pos;
-        return mem_ram[addr | (addr_bank << 16)];
-    }
+    return page == c128_mem_mmu_page_0 || page == c128_mem_mmu_page_1;
+}
 
-    return 0x100;
+/* returns 0x100 if normal read needs to be done, or <0x100 if the read was remapped */
+inline static uint16_t z80_mem_mmu_wrap_read_zero(uint16_t address)
+{
+    if (c128_mem_mmu_zero_map == NULL) {
+        return 0x100;
+    }
+    return c128_mem_mmu_zero_map[address & 0xff];
 }
 
 /* returns 0x100 if normal read needs to be done, or <0x100 if the read was remapped */
-static uint16_t c128_mem_mmu_wrap_read_zero(uint16_t address)
+inline static uint16_t c128_mem_mmu_wrap_read_zero(uint16_t address)
 {
     /* Make sure the internal cpu port is always used for address 0 and 1 */
     if (address == 0 || address == 1) {
@@ -313,119 +413,33 @@ static uint16_t c128_mem_mmu_wrap_read_zero(uint16_t address)
 }
 
 /* returns 0x100 if normal read needs to be done, or <0x100 if the read was remapped */
-static uint16_t c128_mem_mmu_wrap_read(uint16_t address)
+inline static uint16_t c128_mem_mmu_wrap_read(uint16_t address)
 {
-    uint8_t addr_pos = (address & 0xff);
-    uint8_t addr_page = (address >> 8);
-    uint8_t addr_bank = 0;
-    uint16_t addr;
-    int use_ram_only = 0;
-
-    /* Check if there is no translation that needs to be done */
-    if (c128_mem_mmu_page_0 == 0 && c128_mem_mmu_page_1 == 1 && c128_mem_mmu_page_0_bank == 0 && c128_mem_mmu_page_1_bank == 0) {
-        return 0x100;
-    }
+    uint8_t *target = c128_mem_mmu_page_map[address >> 8];
 
     /* Make sure the internal cpu port is always used for address 0 and 1 */
-    if (address == 0 || address == 1) {
+    if (target == NULL || address == 0 || address == 1) {
         return 0x100;
     }
 
-    /* check if the address page is page 1 and in shared memory then bank does not change */
-    if (c128_mem_mmu_zp_sp_shared && addr_page == 1) {
-        addr_page = c128_mem_mmu_page_1;
-        use_ram_only = 1;
-    /* check if the address page is page 0 and in shared memory then bank does not change */
-    } else if (c128_mem_mmu_zp_sp_shared && addr_page == 0) {
-        addr_page = c128_mem_mmu_page_0;
-        use_ram_only = 1;
-    /* check if the address page is page 1 and replace addr with mmu given page and bank */
-    } else if (addr_page == 1) {
-        addr_page = c128_mem_mmu_page_1;
-        addr_bank = c128_mem_mmu_page_1_bank;
-        use_ram_only = 1;
-    /* check if the address page is page 1 target and if it is current RAM, ifso replace addr with page 1 and bank 0 */
-    } else if (addr_page == c128_mem_mmu_page_1 && c128_mem_mmu_page_1_target_ram) {
-        addr_page = 1;
-        addr_bank = c128_mem_mmu_page_1_bank;
-        use_ram_only = 1;
-    /* check if the address page is page 0 and replace addr with mmu given page and bank */
-    } else if (addr_page == 0) {
-        addr_page = c128_mem_mmu_page_0;
-        addr_bank = c128_mem_mmu_page_0_bank;
-        use_ram_only = 1;
-    /* check if the address page is page 0 target and if it is current RAM, ifso replace addr with page 0 and bank 0 */
-    } else if (addr_page == c128_mem_mmu_page_0 && c128_mem_mmu_page_0_target_ram) {
-        addr_page = 0;
-        addr_bank = c128_mem_mmu_page_0_bank;
-        use_ram_only = 1;
-    }
-
-    addr = (addr_page << 8) | addr_pos;
-
-    if (use_ram_only) {
-        return (uint16_t)mem_ram[addr | (addr_bank << 16)];
-    }
-
-    return 0x100;
+    return target[address & 0xff];
 }
 
 /* returns 1 if normal write needs to be done, or 0 if write was remapped and done */
-static uint8_t z80_mem_mmu_wrap_store(uint16_t address, uint8_t value)
+inline static uint8_t z80_mem_mmu_wrap_store(uint16_t address, uint8_t value)
 {
-    uint8_t addr_pos = (address & 0xff);
-    uint8_t addr_page = (address >> 8);
-    uint8_t addr_bank = 0;
-    uint16_t addr;
-    int use_ram_only = 0;
+    uint8_t *target = c128_mem_mmu_page_map[address >> 8];
 
-    /* Check if there is no translation that needs to be done */
-    if (c128_mem_mmu_page_0 == 0 && c128_mem_mmu_page_1 == 1 && c128_mem_mmu_page_0_bank == 0 && c128_mem_mmu_page_1_bank == 0) {
+    if (target == NULL) {
         return 1;
     }
 
-    /* check if the address page is page 1 and in shared memory then bank does not change */
-    if (c128_mem_mmu_zp_sp_shared && addr_page == 1) {
-        addr_page = c128_mem_mmu_page_1;
-        use_ram_only = 1;
-    /* check if the address page is page 0 and in shared memory then bank does not change */
-    } else if (c128_mem_mmu_zp_sp_shared && addr_page == 0) {
-        addr_page = c128_mem_mmu_page_0;
-        use_ram_only = 1;
-    /* check if the address page is page 1 and replace addr with mmu given page and bank */
-    } else if (addr_page == 1) {
-        addr_page = c128_mem_mmu_page_1;
-        addr_bank = c128_mem_mmu_page_1_bank;
-        use_ram_only = 1;
-    /* check if the address page is page 1 target and if it is current RAM, ifso replace addr with page 1 and bank 0 */
-    } else if (addr_page == c128_mem_mmu_page_1 && c128_mem_mmu_page_1_target_ram) {
-        addr_page = 1;
-        addr_bank = c128_mem_mmu_page_1_bank;
-        use_ram_only = 1;
-    /* check if the address page is page 0 and replace addr with mmu given page and bank */
-    } else if (addr_page == 0) {
-        addr_page = c128_mem_mmu_page_0;
-        addr_bank = c128_mem_mmu_page_0_bank;
-        use_ram_only = 1;
-    /* check if the address page is page 0 target and if it is current RAM, ifso replace addr with page 0 and bank 0 */
-    } else if (addr_page == c128_mem_mmu_page_0 && c128_mem_mmu_page_0_target_ram) {
-        addr_page = 0;
-        addr_bank = c128_mem_mmu_page_0_bank;
-        use_ram_only = 1;
-    }
-
-    addr = (addr_page << 8) | addr_pos;
-
-    if (use_ram_only) {
-        mem_ram[addr | (addr_bank << 16)] = value;
-        return 0;
-    } else {
-        return 1;
-    }
+    target[address & 0xff] = value;
+    return 0;
 }
 
 /* returns 1 if normal write needs to be done, or 0 if write was remapped and done */
-static uint8_t c128_mem_mmu_wrap_store(uint16_t address, uint8_t value)
+inline static uint8_t c128_mem_mmu_wrap_store(uint16_t address, uint8_t value)
 {
     /* Make sure the internal cpu port is always used for address 0 and 1 */
     if (address == 0 || address == 1) {
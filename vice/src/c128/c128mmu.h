@@ -58,4 +58,6 @@ void c128_mem_set_mmu_page_1_target_ram(uint8_t val);
 
 void c128_mem_set_mmu_zp_sp_shared(uint8_t val);
 
+int c128_mem_mmu_page_is_remapped(uint8_t page);
+
 #endif
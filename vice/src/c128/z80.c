@@ -37,6 +37,7 @@
 #include "maincpu.h"
 #include "monitor.h"
 #include "types.h"
+#include "viciitypes.h"
 #include "z80.h"
 #include "z80mem.h"
 #include "z80regs.h"
@@ -47,9 +48,6 @@
 
 static int dma_request = 0;
 
-static uint8_t *z80_bank_base;
-static int z80_bank_limit;
-
 static void z80core_reset(void);
 
 void z80_trigger_dma(void)
@@ -62,31 +60,47 @@ void z80_reset(void)
     z80core_reset();
 }
 
-inline static uint8_t *z80mem_read_base(int addr)
+/* Plain RAM pages are read through the direct pointer table, everything
+   else through the read function of the page.  The direct read leaves the
+   value on the bus like ram_read() does.  */
+inline static uint8_t z80mem_fast_read(uint16_t addr)
 {
     uint8_t *p = _z80mem_read_base_tab_ptr[addr >> 8];
 
-    if (p == 0) {
-        return p;
+    if (p != NULL) {
+        vicii.last_cpu_val = p[addr & 0xff];
+        return vicii.last_cpu_val;
     }
 
-    return p - (addr & 0xff00);
-}
-
-inline static int z80mem_read_limit(int addr)
-{
-    return z80mem_read_limit_tab_ptr[addr >> 8];
+    return _z80mem_read_tab_ptr[addr >> 8](addr);
 }
 
-#define JUMP(addr)                                      \
-    do {                                                \
-        z80_reg_pc = (addr);                            \
-        z80_bank_base = z80mem_read_base(z80_reg_pc);   \
-        z80_bank_limit = z80mem_read_limit(z80_reg_pc); \
+#define JUMP(addr) (z80_reg_pc = (addr))
+
+#define LOAD(addr) ((uint32_t)z80mem_fast_read((uint16_t)(addr)))
+
+/* The opcode and its operands usually sit in a single direct page, fetch
+   all four bytes from it at once in that case. The PC is not always
+   wrapped at $ffff, hence the masking.  */
+#define FETCH_OPCODE(o)                                                            \
+    do {                                                                           \
+        uint8_t *fetch_page = _z80mem_read_base_tab_ptr[(z80_reg_pc >> 8) & 0xff]; \
+                                                                                   \
+        if (fetch_page != NULL && (z80_reg_pc & 0xff) <= 0xfc) {                   \
+            fetch_page += z80_reg_pc & 0xff;                                       \
+            (o) = fetch_page[0]                                                    \
+                  | (fetch_page[1] << 8)                                           \
+                  | (fetch_page[2] << 16)                                          \
+                  | ((uint32_t)fetch_page[3] << 24);                               \
+            vicii.last_cpu_val = fetch_page[3];                                    \
+        } else {                                                                   \
+            (o) = LOAD(z80_reg_pc)                                                 \
+                  | (LOAD(z80_reg_pc + 1) << 8)                                    \
+                  | (LOAD(z80_reg_pc + 2) << 16)                                   \
+                  | (LOAD(z80_reg_pc + 3) << 24);                                  \
+        }                                                                          \
     } while (0)
 
-#define LOAD(addr) ((uint32_t)(*_z80mem_read_tab_ptr[(addr) >> 8])((uint16_t)(addr)))
-
 #define STORE(addr, value) (*_z80mem_write_tab_ptr[(addr) >> 8])((uint16_t)(addr), (uint8_t)(value))
 
 /* undefine IN and OUT first for platforms that have them already defined as something else */
@@ -131,12 +145,6 @@ void z80_clock_stretch(void)
 
 #include "z80core.c"
 
-void z80_resync_limits(void)
-{
-    z80_bank_base = z80mem_read_base(z80_reg_pc);
-    z80_bank_limit = z80mem_read_limit(z80_reg_pc);
-}
-
 void z80_mainloop(interrupt_cpu_status_t *cpu_int_status, alarm_context_t *cpu_alarm_context)
 {
     z80_maincpu_loop(cpu_int_status, cpu_alarm_context);
@@ -56,15 +56,17 @@ static log_t z80mem_log = LOG_ERR;
 read_func_ptr_t *_z80mem_read_tab_ptr;
 store_func_ptr_t *_z80mem_write_tab_ptr;
 uint8_t **_z80mem_read_base_tab_ptr;
-int *z80mem_read_limit_tab_ptr;
 
 #define NUM_CONFIGS 8
 
 /* Memory read and write tables.  */
 static store_func_ptr_t mem_write_tab[NUM_CONFIGS][0x101];
 static read_func_ptr_t mem_read_tab[NUM_CONFIGS][0x101];
-static uint8_t *mem_read_base_tab[NUM_CONFIGS][0x101];
-static int mem_read_limit_tab[NUM_CONFIGS][0x101];
+
+/* Direct read pointers for the current configuration, one per page.  Unlike
+   the function tables these depend on the RAM bank and the page 0/1
+   relocation, so they are rebuilt whenever the MMU changes.  */
+static uint8_t *mem_read_base_tab[0x101];
 
 store_func_ptr_t io_write_tab[0x101];
 read_func_ptr_t io_read_tab[0x101];
@@ -303,11 +305,8 @@ void z80mem_initialize(void)
 
     /* Memory addess space.  */
 
-    for (j = 0; j < NUM_CONFIGS; j++) {
-        for (i = 0; i <= 0x100; i++) {
-            mem_read_base_tab[j][i] = NULL;
-            mem_read_limit_tab[j][i] = -1;
-        }
+    for (i = 0; i <= 0x100; i++) {
+        mem_read_base_tab[i] = NULL;
     }
 
     mem_read_tab[0][0] = bios_read;
@@ -524,14 +523,32 @@ void z80mem_initialize(void)
 }
 
 
+/* Point the pages that are plain banked RAM straight at their backing
+   memory, everything else keeps going through the read functions.  Readers
+   of a direct page must set vicii.last_cpu_val like ram_read() does.  */
+static void z80mem_update_read_base(int config)
+{
+    int i;
+
+    for (i = 0; i < 0x100; i++) {
+        read_func_ptr_t func = mem_read_tab[config][i];
+
+        if (func == ram_read && !c128_mem_mmu_page_is_remapped((uint8_t)i)) {
+            mem_read_base_tab[i] = ram_bank + (i << 8);
+        } else {
+            mem_read_base_tab[i] = NULL;
+        }
+    }
+    mem_read_base_tab[0x100] = mem_read_base_tab[0];
+}
+
 void z80mem_update_config(int config)
 {
     _z80mem_read_tab_ptr = mem_read_tab[config];
     _z80mem_write_tab_ptr = mem_write_tab[config];
-    _z80mem_read_base_tab_ptr = mem_read_base_tab[config];
-    z80mem_read_limit_tab_ptr = mem_read_limit_tab[config];
+    _z80mem_read_base_tab_ptr = mem_read_base_tab;
 
-    z80_resync_limits();
+    z80mem_update_read_base(config);
 }
 
 int z80mem_load(void)
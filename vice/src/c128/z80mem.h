@@ -41,8 +41,9 @@ void z80mem_initialize(void);
 /* Pointers to the currently used memory read and write tables.  */
 extern read_func_ptr_t *_z80mem_read_tab_ptr;
 extern store_func_ptr_t *_z80mem_write_tab_ptr;
+/* Direct read pointer for every plain RAM page, or NULL if the page must be
+   read through _z80mem_read_tab_ptr.  */
 extern uint8_t **_z80mem_read_base_tab_ptr;
-extern int *z80mem_read_limit_tab_ptr;
 
 uint8_t bios_read(uint16_t addr);
 void bios_store(uint16_t addr, uint8_t value);
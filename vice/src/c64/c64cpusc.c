@@ -28,6 +28,7 @@
 
 #include <stdio.h>
 
+#include "c64mem.h"
 #include "cpmcart.h"
 #include "monitor.h"
 #include "vicii-cycle.h"
@@ -62,6 +62,19 @@ void mem_set_tape_motor_in(int val);
 
 extern uint8_t mem_chargen_rom[C64_CHARGEN_ROM_SIZE];
 
+/* One page of a memory configuration as the x64sc CPU sees it.  A page
+   with a base pointer is plain RAM or ROM: base[addr] is the byte at addr,
+   and the CPU accesses it without calling the function.  */
+typedef struct mem_page_s {
+    read_func_ptr_t read;
+    store_func_ptr_t store;
+    uint8_t *read_base;
+    uint8_t *store_base;
+} mem_page_t;
+
+/* Pages of the current configuration, or watchpoint handlers.  */
+extern mem_page_t *mem_page_tab_ptr;
+
 void mem_set_write_hook(int config, int page, store_func_t *f);
 void mem_read_tab_set(unsigned int base, unsigned int index, read_func_ptr_t read_func);
 void mem_read_base_set(unsigned int base, unsigned int index, uint8_t *mem_ptr);
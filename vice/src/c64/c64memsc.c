@@ -109,6 +109,14 @@ static uint32_t mem_read_limit_tab[NUM_CONFIGS][0x101];
 static store_func_ptr_t mem_write_tab_watch[0x101];
 static read_func_ptr_t mem_read_tab_watch[0x101];
 
+/* The same tables as page descriptors, which the CPU uses for its loads
+   and stores. A descriptor takes 32 bytes, so with the alignment no page
+   spans two cache lines. See mem_update_page_tab().  */
+static mem_page_t mem_page_tab[NUM_CONFIGS][0x101] VICE_ATTR_ALIGNED(64);
+static mem_page_t mem_page_tab_watch[0x101] VICE_ATTR_ALIGNED(64);
+
+mem_page_t *mem_page_tab_ptr;
+
 /* Current video bank (0, 1, 2 or 3).  */
 static int vbank;
 
@@ -162,6 +170,7 @@ static void mem_update_tab_ptrs(int flag)
     if (flag) {
         _mem_read_tab_ptr = mem_read_tab_watch;
         _mem_write_tab_ptr = mem_write_tab_watch;
+        mem_page_tab_ptr = mem_page_tab_watch;
         if (flag > 1) {
             /* enable watchpoints on dummy accesses */
             _mem_read_tab_ptr_dummy = mem_read_tab_watch;
@@ -174,6 +183,7 @@ static void mem_update_tab_ptrs(int flag)
         /* all watchpoints disabled */
         _mem_read_tab_ptr = mem_read_tab[mem_config];
         _mem_write_tab_ptr = mem_write_tab[mem_config];
+        mem_page_tab_ptr = mem_page_tab[mem_config];
         _mem_read_tab_ptr_dummy = mem_read_tab[mem_config];
         _mem_write_tab_ptr_dummy = mem_write_tab[mem_config];
     }
@@ -632,6 +642,59 @@ void mem_read_base_set(unsigned int base, unsigned int index, uint8_t *mem_ptr)
     mem_read_base_tab[base][index] = mem_ptr;
 }
 
+/* Pointer that makes base[addr] the same as array[addr & mask] within
+   the page.  */
+static uint8_t *mem_page_base(uint8_t *array, unsigned int mask, unsigned int page)
+{
+    unsigned int addr = page << 8;
+
+    return array + (addr & mask) - addr;
+}
+
+/* Only functions that do nothing but read or write an array are replaced
+   by a base pointer, anything with side effects (I/O, the processor port
+   at $00/$01, cartridges, RAM expansions) keeps being called. The write
+   to $ff00 that starts the REU is caught by the CPU, not by the store
+   function, so $ff00-$ffff can be written directly as well.  */
+static void mem_update_page_tab(void)
+{
+    int i, j;
+
+    for (i = 0; i < NUM_CONFIGS; i++) {
+        for (j = 0; j <= 0x100; j++) {
+            mem_page_t *page = &mem_page_tab[i][j];
+
+            page->read = mem_read_tab[i][j];
+            page->store = mem_write_tab[i][j];
+
+            if (page->read == ram_read) {
+                page->read_base = mem_page_base(mem_ram, 0xffff, j);
+            } else if (page->read == chargen_read) {
+                page->read_base = mem_page_base(mem_chargen_rom, 0x0fff, j);
+            } else if (page->read == c64memrom_basic64_read) {
+                page->read_base = mem_page_base(c64memrom_basic64_rom, 0x1fff, j);
+            } else if (page->read == c64memrom_kernal64_read) {
+                page->read_base = mem_page_base(c64memrom_kernal64_rom, 0x1fff, j);
+            } else {
+                page->read_base = NULL;
+            }
+
+            if (page->store == ram_store || page->store == ram_hi_store) {
+                page->store_base = mem_page_base(mem_ram, 0xffff, j);
+            } else {
+                page->store_base = NULL;
+            }
+        }
+    }
+
+    for (j = 0; j <= 0x100; j++) {
+        mem_page_tab_watch[j].read = mem_read_tab_watch[j];
+        mem_page_tab_watch[j].store = mem_write_tab_watch[j];
+        mem_page_tab_watch[j].read_base = NULL;
+        mem_page_tab_watch[j].store_base = NULL;
+    }
+}
+
 void mem_initialize_memory(void)
 {
     int i, j;
@@ -738,6 +801,8 @@ void mem_initialize_memory(void)
     if (board == 1) {
         mem_limit_max_init(mem_read_limit_tab);
     }
+
+    mem_update_page_tab();
 }
 
 void mem_mmu_translate(unsigned int addr, uint8_t **base, int *start, int *limit)
@@ -3040,6 +3040,20 @@ int cartridge_snapshot_write_modules(struct snapshot_s *s)
         }
     }
 
+    /* Loading a snapshot detaches and attaches all carts again, and the disk
+       carts reopen their images when they do. That is far too slow for the
+       in-memory snapshots that run-ahead and the netplay rollback load every
+       frame, and the disk contents would not be rolled back anyway. */
+    if (snapshot_is_memory(s)) {
+        for (i = 0; i < number_of_carts; i++) {
+            if (cart_ids[i] == CARTRIDGE_IDE64 || cart_ids[i] == CARTRIDGE_LT_KERNAL) {
+                log_error(LOG_ERR, "Cartridge ID %d does not support in-memory snapshots"
+                          " (run-ahead, netplay rollback).\n", cart_ids[i]);
+                return -1;
+            }
+        }
+    }
+
     m = snapshot_module_create(s, SNAP_MODULE_NAME,
                                C64CART_DUMP_VER_MAJOR, C64CART_DUMP_VER_MINOR);
     if (m == NULL) {
@@ -522,10 +522,8 @@ static void ltk_imageopenall(void)
 {
     int32_t i;
 
-    /* purge out any old or stall file handles */
-    for (i = 0; i < 56; i++) {
-        ltk_scsi.file[i] = NULL;
-    }
+    /* close the old images, this writes back their cached sectors */
+    scsi_image_detach_all(&ltk_scsi);
 
     /* setup new ones */
     for (i = 0; i < 7; i++) {
@@ -0,0 +1,433 @@
+/*
+ * blockdev.c - Cached block access to disk images.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+
+/* required for off_t on some platforms */
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+#include "archdep.h"
+#include "blockdev.h"
+#include "lib.h"
+#include "types.h"
+
+/* Sectors of a line are read only as needed, so a random access costs no
+   more than the sector it asks for; whole lines are read once the accesses
+   move on from one line to the next. */
+#define BLOCKDEV_LINE_SECTORS   (BLOCKDEV_LINE_SIZE / BLOCKDEV_SECTOR_SIZE)
+
+typedef struct blockdev_line_s {
+    off_t base;             /* image offset of the first byte, -1 if unused */
+    uint8_t *data;
+    uint32_t valid;         /* one bit per sector that holds image data */
+    uint32_t dirty;         /* one bit per sector that needs a write back */
+    unsigned int used;      /* for LRU replacement */
+} blockdev_line_t;
+
+struct blockdev_s {
+    FILE *fd;
+    int owned;              /* fd is closed by blockdev_close() */
+    int readonly;
+    int uncached;           /* someone else owns fd and may change the file */
+    uint8_t *map;           /* whole image, if it was mapped */
+    size_t map_size;
+    off_t size;
+    off_t stream;           /* base of the line a sequential read goes to next */
+    unsigned int clock;
+    blockdev_line_t *last;
+    blockdev_line_t line[BLOCKDEV_LINES];
+};
+
+static blockdev_t *blockdev_alloc(FILE *fd)
+{
+    blockdev_t *dev;
+    int i;
+
+    dev = lib_calloc(1, sizeof(blockdev_t));
+    dev->fd = fd;
+    dev->stream = -1;
+    for (i = 0; i < BLOCKDEV_LINES; i++) {
+        dev->line[i].base = -1;
+    }
+    if (fd != NULL) {
+        dev->size = archdep_file_size(fd);
+        if (dev->size < 0) {
+            dev->size = 0;
+        }
+    }
+    return dev;
+}
+
+blockdev_t *blockdev_open(const char *filename, int mode)
+{
+    blockdev_t *dev;
+    FILE *fd;
+
+    fd = fopen(filename, (mode & BLOCKDEV_READ_WRITE) ? MODE_READ_WRITE : MODE_READ);
+    if (fd == NULL) {
+        return NULL;
+    }
+
+    /* the cache does the buffering, stdio would only add a copy */
+    setbuf(fd, NULL);
+
+    dev = blockdev_alloc(fd);
+    dev->owned = 1;
+    dev->readonly = !(mode & BLOCKDEV_READ_WRITE);
+
+    if (dev->readonly && (mode & BLOCKDEV_MAP)
+        && dev->size > 0 && dev->size <= BLOCKDEV_MAP_MAX) {
+        dev->map = archdep_file_map(filename, &dev->map_size);
+        if (dev->map != NULL) {
+            dev->size = (off_t)dev->map_size;
+            fclose(dev->fd);
+            dev->fd = NULL;
+        }
+    }
+    return dev;
+}
+
+/* Wrap a stream owned by someone else. Its owner may read and write the
+   file through the stream at any time, so nothing is cached: reads and
+   writes go straight to the file. The stream is left open by
+   blockdev_close(). */
+blockdev_t *blockdev_wrap(FILE *fd)
+{
+    blockdev_t *dev;
+
+    if (fd == NULL) {
+        return NULL;
+    }
+    dev = blockdev_alloc(fd);
+    dev->uncached = 1;
+    return dev;
+}
+
+/* sectors first to last, inclusive */
+static uint32_t blockdev_sector_mask(unsigned int first, unsigned int last)
+{
+    return (uint32_t)((((uint64_t)2 << last) - 1) & ~(((uint64_t)1 << first) - 1));
+}
+
+/* Each run of consecutive dirty sectors goes out with a single write. A run
+   stays dirty until its write succeeded, so a failed write-back can be
+   retried later. */
+static int blockdev_line_writeback(blockdev_t *dev, blockdev_line_t *line)
+{
+    uint32_t dirty = line->dirty;
+    unsigned int first = 0, last;
+    size_t len;
+
+    while (dirty) {
+        while (!(dirty & (1U << first))) {
+            first++;
+        }
+        last = first;
+        while (last + 1 < BLOCKDEV_LINE_SECTORS && (dirty & (1U << (last + 1)))) {
+            last++;
+        }
+        dirty &= ~blockdev_sector_mask(first, last);
+
+        len = (last - first + 1) * BLOCKDEV_SECTOR_SIZE;
+        if (archdep_fseeko(dev->fd, line->base + first * BLOCKDEV_SECTOR_SIZE, SEEK_SET) < 0
+            || fwrite(line->data + first * BLOCKDEV_SECTOR_SIZE, 1, len, dev->fd) != len) {
+            return -1;
+        }
+        line->dirty &= ~blockdev_sector_mask(first, last);
+        first = last + 1;
+    }
+    return 0;
+}
+
+/* Read the sectors first to last of a line which are not valid yet. */
+static int blockdev_line_fill(blockdev_t *dev, blockdev_line_t *line,
+                              unsigned int first, unsigned int last)
+{
+    unsigned int end;
+    off_t offset;
+    size_t len, got;
+
+    while (first <= last) {
+        if (line->valid & (1U << first)) {
+            first++;
+            continue;
+        }
+        end = first;
+        while (end < last && !(line->valid & (1U << (end + 1)))) {
+            end++;
+        }
+
+        offset = line->base + first * BLOCKDEV_SECTOR_SIZE;
+        len = (end - first + 1) * BLOCKDEV_SECTOR_SIZE;
+        got = 0;
+        if (offset < dev->size) {
+            if (archdep_fseeko(dev->fd, offset, SEEK_SET) < 0) {
+                return -1;
+            }
+            clearerr(dev->fd);
+            got = fread(line->data + first * BLOCKDEV_SECTOR_SIZE, 1, len, dev->fd);
+            if (ferror(dev->fd)) {
+                return -1;
+            }
+        }
+        /* anything past the end of the image reads as zero */
+        memset(line->data + first * BLOCKDEV_SECTOR_SIZE + got, 0, len - got);
+
+        line->valid |= blockdev_sector_mask(first, end);
+        first = end + 1;
+    }
+    return 0;
+}
+
+/* Find the line for base, evicting the least recently used line of its set
+   if it is not cached yet. */
+static blockdev_line_t *blockdev_line_get(blockdev_t *dev, off_t base)
+{
+    blockdev_line_t *set, *line, *victim;
+    int i;
+
+    if (dev->last != NULL && dev->last->base == base) {
+        line = dev->last;
+        line->used = ++dev->clock;
+        return line;
+    }
+
+    /* consecutive lines land in different sets */
+    set = &dev->line[((base / BLOCKDEV_LINE_SIZE) & (BLOCKDEV_SETS - 1)) * BLOCKDEV_WAYS];
+    victim = set;
+    for (i = 0; i < BLOCKDEV_WAYS; i++) {
+        line = &set[i];
+        if (line->base == base) {
+            line->used = ++dev->clock;
+            dev->last = line;
+            return line;
+        }
+        if (line->used < victim->used) {
+            victim = line;
+        }
+    }
+
+    /* a victim whose dirty sectors could not be written keeps its data,
+       the access fails instead */
+    line = victim;
+    if (line->data == NULL) {
+        line->data = lib_malloc(BLOCKDEV_LINE_SIZE);
+    } else if (blockdev_line_writeback(dev, line) < 0) {
+        return NULL;
+    }
+    line->base = base;
+    line->valid = 0;
+    line->used = ++dev->clock;
+    dev->last = line;
+    return line;
+}
+
+/* Read straight from the file, anything past its end reads as zero. */
+static int blockdev_read_uncached(blockdev_t *dev, off_t offset, uint8_t *buf, size_t len)
+{
+    size_t got;
+
+    if (archdep_fseeko(dev->fd, offset, SEEK_SET) < 0) {
+        return -1;
+    }
+    clearerr(dev->fd);
+    got = fread(buf, 1, len, dev->fd);
+    if (ferror(dev->fd)) {
+        return -1;
+    }
+    memset(buf + got, 0, len - got);
+    return 0;
+}
+
+int blockdev_read(blockdev_t *dev, off_t offset, uint8_t *buf, size_t len)
+{
+    blockdev_line_t *line;
+    unsigned int pos, first, last;
+    size_t chunk;
+
+    if (offset < 0) {
+        return -1;
+    }
+
+    if (dev->uncached) {
+        return blockdev_read_uncached(dev, offset, buf, len);
+    }
+
+    if (dev->map != NULL) {
+        chunk = 0;
+        if (offset < dev->size) {
+            chunk = (size_t)(dev->size - offset);
+            if (chunk > len) {
+                chunk = len;
+            }
+            memcpy(buf, dev->map + offset, chunk);
+        }
+        memset(buf + chunk, 0, len - chunk);
+        return 0;
+    }
+
+    while (len) {
+        pos = (unsigned int)(offset & (BLOCKDEV_LINE_SIZE - 1));
+        chunk = BLOCKDEV_LINE_SIZE - pos;
+        if (chunk > len) {
+            chunk = len;
+        }
+        line = blockdev_line_get(dev, offset - pos);
+        if (line == NULL) {
+            return -1;
+        }
+        if (line->base == dev->stream) {
+            first = 0;
+            last = BLOCKDEV_LINE_SECTORS - 1;
+        } else {
+            first = pos / BLOCKDEV_SECTOR_SIZE;
+            last = (unsigned int)((pos + chunk - 1) / BLOCKDEV_SECTOR_SIZE);
+        }
+        if (blockdev_line_fill(dev, line, first, last) < 0) {
+            return -1;
+        }
+        dev->stream = line->base + BLOCKDEV_LINE_SIZE;
+
+        memcpy(buf, line->data + pos, chunk);
+        buf += chunk;
+        offset += chunk;
+        len -= chunk;
+    }
+    return 0;
+}
+
+int blockdev_write(blockdev_t *dev, off_t offset, const uint8_t *buf, size_t len)
+{
+    blockdev_line_t *line;
+    unsigned int pos, first, last;
+    uint32_t mask;
+    size_t chunk;
+
+    if (dev->readonly || offset < 0) {
+        return -1;
+    }
+
+    if (dev->uncached) {
+        if (archdep_fseeko(dev->fd, offset, SEEK_SET) < 0
+            || fwrite(buf, 1, len, dev->fd) != len
+            || fflush(dev->fd)) {
+            return -1;
+        }
+        if (offset + (off_t)len > dev->size) {
+            dev->size = offset + (off_t)len;
+        }
+        return 0;
+    }
+
+    while (len) {
+        pos = (unsigned int)(offset & (BLOCKDEV_LINE_SIZE - 1));
+        chunk = BLOCKDEV_LINE_SIZE - pos;
+        if (chunk > len) {
+            chunk = len;
+        }
+        line = blockdev_line_get(dev, offset - pos);
+        if (line == NULL) {
+            return -1;
+        }
+        first = pos / BLOCKDEV_SECTOR_SIZE;
+        last = (unsigned int)((pos + chunk - 1) / BLOCKDEV_SECTOR_SIZE);
+
+        /* only sectors written in part need to be read first */
+        if (((pos & (BLOCKDEV_SECTOR_SIZE - 1))
+             && blockdev_line_fill(dev, line, first, first) < 0)
+            || (((pos + chunk) & (BLOCKDEV_SECTOR_SIZE - 1))
+                && blockdev_line_fill(dev, line, last, last) < 0)) {
+            return -1;
+        }
+
+        memcpy(line->data + pos, buf, chunk);
+        mask = blockdev_sector_mask(first, last);
+        line->valid |= mask;
+        line->dirty |= mask;
+        buf += chunk;
+        offset += chunk;
+        len -= chunk;
+    }
+
+    if (offset > dev->size) {
+        dev->size = offset;
+    }
+    return 0;
+}
+
+int blockdev_flush(blockdev_t *dev)
+{
+    int i, result = 0;
+
+    /* a wrapped stream may already be closed by its owner, there is
+       nothing pending for it anyway */
+    if (dev->fd == NULL || dev->readonly || dev->uncached) {
+        return 0;
+    }
+    for (i = 0; i < BLOCKDEV_LINES; i++) {
+        if (dev->line[i].dirty && blockdev_line_writeback(dev, &dev->line[i]) < 0) {
+            result = -1;
+        }
+    }
+    if (fflush(dev->fd)) {
+        result = -1;
+    }
+    return result;
+}
+
+void blockdev_close(blockdev_t *dev)
+{
+    int i;
+
+    if (dev == NULL) {
+        return;
+    }
+
+    blockdev_flush(dev);
+
+    if (dev->map != NULL) {
+        archdep_file_unmap(dev->map, dev->map_size);
+    }
+    if (dev->fd != NULL && dev->owned) {
+        fclose(dev->fd);
+    }
+    for (i = 0; i < BLOCKDEV_LINES; i++) {
+        lib_free(dev->line[i].data);
+    }
+    lib_free(dev);
+}
+
+off_t blockdev_size(blockdev_t *dev)
+{
+    return dev->size;
+}
+
+int blockdev_is_readonly(blockdev_t *dev)
+{
+    return dev->readonly;
+}
@@ -0,0 +1,69 @@
+/*
+ * blockdev.h - Cached block access to disk images.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_BLOCKDEV_H
+#define VICE_BLOCKDEV_H
+
+/* required for off_t on some platforms */
+#ifdef HAVE_SYS_TYPES_H
+#include <sys/types.h>
+#endif
+
+#include <stdio.h>
+
+#include "types.h"
+
+/* Modes for blockdev_open() */
+#define BLOCKDEV_READ           0x00    /* read only */
+#define BLOCKDEV_READ_WRITE     0x01    /* read and write, fails if the file is write protected */
+#define BLOCKDEV_MAP            0x02    /* map read only images into memory instead of caching them */
+
+/* The image is cached in lines of BLOCKDEV_LINE_SIZE bytes, kept in
+   BLOCKDEV_SETS sets of BLOCKDEV_WAYS lines each. Writes go to the cache and
+   only reach the file when a dirty line is evicted, on blockdev_flush() or
+   on blockdev_close(). A line holds at most 32 sectors. Devices made with
+   blockdev_wrap() share their stream with its owner and are not cached. */
+#define BLOCKDEV_SECTOR_SIZE    512
+#define BLOCKDEV_LINE_SIZE      0x4000
+#define BLOCKDEV_SETS           32
+#define BLOCKDEV_WAYS           4
+#define BLOCKDEV_LINES          (BLOCKDEV_SETS * BLOCKDEV_WAYS)
+
+/* Images larger than this are cached even if BLOCKDEV_MAP was given, as
+   the fallback of archdep_file_map() reads the whole file into memory. */
+#define BLOCKDEV_MAP_MAX        (1024 * 1024 * 1024)
+
+typedef struct blockdev_s blockdev_t;
+
+blockdev_t *blockdev_open(const char *filename, int mode);
+blockdev_t *blockdev_wrap(FILE *fd);
+void blockdev_close(blockdev_t *dev);
+
+int blockdev_read(blockdev_t *dev, off_t offset, uint8_t *buf, size_t len);
+int blockdev_write(blockdev_t *dev, off_t offset, const uint8_t *buf, size_t len);
+int blockdev_flush(blockdev_t *dev);
+
+off_t blockdev_size(blockdev_t *dev);
+int blockdev_is_readonly(blockdev_t *dev);
+
+#endif
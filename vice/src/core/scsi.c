@@ -33,7 +33,7 @@
 #include <stdio.h>
 #include <string.h>
 
-#include "archdep.h"
+#include "blockdev.h"
 #include "lib.h"
 #include "log.h"
 #include "types.h"
@@ -80,10 +80,10 @@ static off_t scsi_getmaxsize(struct scsi_context_s *context)
     }
 
     /* make sure there is a file associated with the target and lun */
-    if (context->file[(context->target << 3) | context->lun]) {
+    if (context->image[(context->target << 3) | context->lun]) {
         if (!context->max_imagesize) {
             /* if the max length setting is zero, return the image length */
-            work = archdep_file_size(context->file[(context->target << 3) | context->lun]);
+            work = blockdev_size(context->image[(context->target << 3) | context->lun]);
             /* turn the file size into 512 byte sectors */
             work = (work >> 9) + (work & 511 ? 1 : 0);
             return work;
@@ -103,7 +103,7 @@ static int32_t scsi_imagecheck(struct scsi_context_s *context)
         return 1;
     }
 
-    if (!context->file[(context->target << 3) | context->lun]) {
+    if (!context->image[(context->target << 3) | context->lun]) {
         if ( context->target == 0 && context->lun == 0 &&
             !(context->log & SCSI_LOG_NODISK0) ) {
             CRIT((ERR, "SCSI: no image attached to disk 0;"
@@ -122,9 +122,9 @@ int scsi_image_detach(struct scsi_context_s *context, int disk)
         return 2;
     }
 
-    if (context->file[disk]) {
-        fclose(context->file[disk]);
-        context->file[disk] = NULL;
+    if (context->image[disk]) {
+        blockdev_close(context->image[disk]);
+        context->image[disk] = NULL;
         return 0;
     }
 
@@ -149,45 +149,52 @@ int scsi_image_attach(struct scsi_context_s *context, int disk, char *filename)
     }
 
     scsi_image_detach(context, disk);
-    context->file[disk] = fopen(filename, "rb+");
+    context->image[disk] = blockdev_open(filename, BLOCKDEV_READ_WRITE);
 
-    if (context->file[disk]) {
-        setbuf(context->file[disk], NULL);
-        return 0;
-    } else {
-        return 1;
+    return context->image[disk] ? 0 : 1;
+}
+
+/* attach an already opened image, the context takes ownership of it */
+int scsi_image_attach_blockdev(struct scsi_context_s *context, int disk, blockdev_t *image)
+{
+    if (disk < 0 || disk > 55) {
+        return 2;
     }
+
+    scsi_image_detach(context, disk);
+    context->image[disk] = image;
+
+    return image ? 0 : 1;
 }
 
-int32_t scsi_image_read(struct scsi_context_s *context)
+int scsi_image_flush_all(struct scsi_context_s *context)
 {
     int32_t i;
-    FILE *fhd;
+    int result = 0;
 
-    if (scsi_imagecheck(context)) {
-        return -1;
+    for (i = 0; i < 56; i++) {
+        if (context->image[i] && blockdev_flush(context->image[i]) < 0) {
+            CRIT((ERR, "SCSI: error flushing disk %d", i >> 3));
+            result = -1;
+        }
     }
 
-    fhd = context->file[(context->target << 3) | context->lun];
+    return result;
+}
+
+int32_t scsi_image_read(struct scsi_context_s *context)
+{
 
-    if (archdep_fseeko(fhd, (off_t)context->address * 512, SEEK_SET) < 0) {
-        CRIT((ERR, "SCSI: error seeking disk %d at sector 0x%x",
-            context->target, context->address));
-        return -3;
+    if (scsi_imagecheck(context)) {
+        return -1;
     }
 
-    if (fread(context->data_buf, 512, 1, fhd) < 1) {
-        if (!feof(fhd)) {
-            CRIT((ERR, "SCSI: error reading disk %d at sector 0x%x",
-                context->target, context->address));
-            return -4;
-        }
-
-        /* if there is a read beyond the EOF, fill it with zeros and say it
-            is good */
-        for ( i = 0; i < 512; i++) {
-            context->data_buf[i] = 0;
-        }
+    /* a read beyond the EOF is filled with zeros and said to be good */
+    if (blockdev_read(context->image[(context->target << 3) | context->lun],
+                      (off_t)context->address * 512, context->data_buf, 512) < 0) {
+        CRIT((ERR, "SCSI: error reading disk %d at sector 0x%x",
+            context->target, context->address));
+        return -4;
     }
 
     LOG2((LOG, "SCSI: read disk %d at sector 0x%x", context->target,
@@ -204,8 +211,6 @@ int32_t scsi_image_read(struct scsi_context_s *context)
 
 int32_t scsi_image_write(struct scsi_context_s *context)
 {
-    FILE *fhd;
-
     if (scsi_imagecheck(context)) {
         return -1;
     }
@@ -216,20 +221,12 @@ int32_t scsi_image_write(struct scsi_context_s *context)
         context->user_write(context);
     }
 
-    fhd = context->file[(context->target << 3) | context->lun];
-
-    if (archdep_fseeko(fhd, (off_t)context->address * 512, SEEK_SET) < 0) {
-        CRIT((ERR, "SCSI: error seeking disk %d at sector 0x%x",
-            context->target, context->address));
-        return -3;
-    }
-
-    if (fwrite(context->data_buf, 512, 1, fhd) < 1) {
+    if (blockdev_write(context->image[(context->target << 3) | context->lun],
+                       (off_t)context->address * 512, context->data_buf, 512) < 0) {
         CRIT((ERR, "SCSI: error writing disk %d at sector 0x%x",
             context->target, context->address));
         return -4;
     }
-    fflush(fhd);
 
     LOG2((LOG, "SCSI: write disk %d at sector 0x%x", context->target,
         context->address));
@@ -922,6 +919,9 @@ int scsi_snapshot_write_module(struct scsi_context_s *context, snapshot_t *s)
 {
     snapshot_module_t *m;
 
+    /* write back cached sectors so the images match the snapshot */
+    scsi_image_flush_all(context);
+
     m = snapshot_module_create(s, context->myname, SNAP_MAJOR, SNAP_MINOR);
 
     if (m == NULL) {
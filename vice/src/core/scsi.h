@@ -27,6 +27,7 @@
 #ifndef VICE_SCSI_H
 #define VICE_SCSI_H
 
+#include "blockdev.h"
 #include "types.h"
 
 struct scsi_context_s;
@@ -63,7 +64,7 @@ typedef struct scsi_context_s {
     uint32_t max_imagesize; /* in 512 byte sectors */
     uint32_t limit_imagesize; /* in 512 byte sectors */
     uint32_t log;
-    FILE *file[56];
+    blockdev_t *image[56];
     void *p;
     void (*user_format)(struct scsi_context_s *);
     void (*user_read)(struct scsi_context_s *);
@@ -211,6 +212,8 @@ MSG C/D I/O   Phase Name          Direction Of Transfer         Comment
 int scsi_image_detach(struct scsi_context_s *context, int disk);
 void scsi_image_detach_all(struct scsi_context_s *context);
 int scsi_image_attach(struct scsi_context_s *context, int disk, char *filename);
+int scsi_image_attach_blockdev(struct scsi_context_s *context, int disk, blockdev_t *image);
+int scsi_image_flush_all(struct scsi_context_s *context);
 int32_t scsi_image_read(struct scsi_context_s *context);
 int32_t scsi_image_write(struct scsi_context_s *context);
 uint8_t scsi_get_bus(struct scsi_context_s *context);
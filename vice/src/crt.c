@@ -36,6 +36,7 @@
 #include "log.h"
 #include "machine.h"
 #include "resources.h"
+#include "romcache.h"
 #include "types.h"
 #include "c64cart.h"  /* FIXME: for C64CART_IMAGE_LIMIT */
 #include "util.h"
@@ -71,7 +72,7 @@ FILE *crt_open(const char *filename, crt_header_t *header)
     uint32_t skip;
     FILE *fd;
 
-    fd = fopen(filename, MODE_READ);
+    fd = romcache_fopen(filename);
 
     if (fd == NULL) {
         return NULL;
@@ -269,6 +270,8 @@ FILE *crt_create(const char *filename, int type, int exrom, int game, const char
         return NULL;
     }
 
+    /* a cached mapping of the old file must not survive the truncation */
+    romcache_invalidate(filename);
     fd = fopen(filename, MODE_WRITE);
 
     if (fd == NULL) {
@@ -302,6 +305,8 @@ FILE *crt_create_v11(const char *filename, int type, int subtype, int exrom, int
         return NULL;
     }
 
+    /* a cached mapping of the old file must not survive the truncation */
+    romcache_invalidate(filename);
     fd = fopen(filename, MODE_WRITE);
 
     if (fd == NULL) {
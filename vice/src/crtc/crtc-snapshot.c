@@ -232,6 +232,7 @@ int crtc_snapshot_read_module(snapshot_t * s)
     }
 
     crtc.rl_start = maincpu_clk;        /* just to be sure */
+    crtc.frame_start = 0;               /* not saved, don't measure the first frame */
 
     /* read the registers */
     for (i = 0; (!ef) && (i < 20); i++) {
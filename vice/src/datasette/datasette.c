@@ -52,6 +52,7 @@
 #include "types.h"
 #include "uiapi.h"
 #include "vice-event.h"
+#include "vsync.h"
 
 #ifdef DEBUG_TAPE
 #define DBG(x)  log_debug x
@@ -712,6 +713,8 @@ static void datasette_read_bit(CLOCK offset, void *data)
         return;
     }
 
+    vsync_idle_io_activity();
+
     if (current_image[port] == NULL) {
         switch (notape_mode[port]) {
             case DATASETTE_CONTROL_START:
@@ -48,6 +48,7 @@
 
 #include "attach.h"
 #include "archdep.h"
+#include "benchmark.h"
 #include "diskconstants.h"
 #include "diskimage.h"
 #include "drive-check.h"
@@ -984,12 +985,16 @@ int drive_num_leds(unsigned int dnr)
 
 void drive_cpu_execute_one(diskunit_context_t *drv, CLOCK clk_value)
 {
+    int benchmark_prev = benchmark_enter(BENCHMARK_DRIVES);
+
     if (drv->type == DRIVE_TYPE_2000 || drv->type == DRIVE_TYPE_4000 ||
         drv->type == DRIVE_TYPE_CMDHD) {
         drivecpu65c02_execute(drv, clk_value);
     } else {
         drivecpu_execute(drv, clk_value);
     }
+
+    benchmark_leave(benchmark_prev);
 }
 
 void drive_cpu_execute_all(CLOCK clk_value)
@@ -1027,6 +1032,10 @@ void drive_vsync_hook(void)
         drive_t *drive = unit->drives[0];
 
         if (unit->enable) {
+            /* a guest waiting for a busy drive is not idle */
+            if (drive->led_status || (drive->byte_ready_active & BRA_MOTOR_ON)) {
+                vsync_idle_io_activity();
+            }
             if (unit->idling_method != DRIVE_IDLE_SKIP_CYCLES) {
                 drive_cpu_execute_one(diskunit_context[dnr], maincpu_clk);
             }
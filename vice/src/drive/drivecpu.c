@@ -653,7 +653,9 @@ int drivecpu_snapshot_read_module(diskunit_context_t *drv, snapshot_t *s)
     MOS6510_REGS_SET_PC(&(cpu->cpu_regs), pc);
     MOS6510_REGS_SET_STATUS(&(cpu->cpu_regs), status);
 
-    log_message(drv->log, "RESET (For undump).");
+    if (!snapshot_is_memory(s)) {
+        log_message(drv->log, "RESET (For undump).");
+    }
 
     interrupt_cpu_status_reset(cpu->int_status);
 
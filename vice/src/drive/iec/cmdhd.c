@@ -1166,6 +1166,8 @@ void cmdhd_shutdown(cmdhd_context_t *hd)
 /*    alarm_destroy(hd->reset_alarm); */
     viacore_shutdown(hd->via9);
     viacore_shutdown(hd->via10);
+    /* write back and close any images still attached */
+    scsi_image_detach_all(hd->scsi);
     lib_free(hd->scsi->myname);
     lib_free(hd->scsi);
     lib_free(hd->i8255a);
@@ -1289,7 +1291,7 @@ void cmdhd_reset(cmdhd_context_t *hd)
     /* count the number of connected drives */
     unit = 0;
     for (i = 0; i < 56; i++) {
-        if (hd->scsi->file[i]) {
+        if (hd->scsi->image[i]) {
             unit++;
         }
     }
@@ -1308,7 +1310,7 @@ void cmdhd_reset(cmdhd_context_t *hd)
             }
         } else {
             /* remove scsi ID 0 */
-            hd->scsi->file[0] = NULL;
+            scsi_image_detach(hd->scsi, 0);
         }
     }
 
@@ -1329,7 +1331,7 @@ int cmdhd_attach_image(disk_image_t *image, unsigned int unit)
     cmdhd_context_t *hd;
     char *basename, *testname;
     size_t i, j;
-    FILE *test;
+    blockdev_t *test;
     off_t filelength;
 
     CLOG((LOG, "CMDHD: attach_image"));
@@ -1365,8 +1367,8 @@ int cmdhd_attach_image(disk_image_t *image, unsigned int unit)
         return -1;
     }
 
-    /* copy file FD to the scsi module */
-    hd->scsi->file[0] = image->media.fsimage->fd;
+    /* share the file FD with the scsi module, it stays owned by the image */
+    scsi_image_attach_blockdev(hd->scsi, 0, blockdev_wrap(image->media.fsimage->fd));
 
     /* find the base lba */
     cmdhd_findbaselba(hd);
@@ -1395,18 +1397,18 @@ int cmdhd_attach_image(disk_image_t *image, unsigned int unit)
                testname = lib_msprintf("%s%" PRI_SIZE_T" %1" PRI_SIZE_T,
                                        basename, i, j);
                /* open the file */
-               test = fopen(testname, "rb+");
+               test = blockdev_open(testname, BLOCKDEV_READ_WRITE);
                if (test) {
                    /* if it is there, check the length */
-                   filelength = archdep_file_size(test);
+                   filelength = blockdev_size(test);
                    /* must be multiple of 512 */
                    if ((filelength % 512) == 0) {
-                       /* set the FILE pointer */
-                       hd->scsi->file[(i << 3) | j] = test;
+                       /* hand the image to the scsi module */
+                       scsi_image_attach_blockdev(hd->scsi, (int)((i << 3) | j), test);
                    } else {
                        /* otherwise make sure it is zero */
-                       hd->scsi->file[(i << 3) | j] = NULL;
-                       fclose(test);
+                       scsi_image_detach(hd->scsi, (int)((i << 3) | j));
+                       blockdev_close(test);
                    }
                }
                /* release any memory */
@@ -1416,7 +1418,7 @@ int cmdhd_attach_image(disk_image_t *image, unsigned int unit)
     } else {
         /* otherwise clear out SCSI resources just in case */
         for (i = 1; i < 56; i++) {
-            hd->scsi->file[i] = NULL;
+            scsi_image_detach(hd->scsi, (int)i);
         }
     }
 
@@ -1444,7 +1446,6 @@ int cmdhd_attach_image(disk_image_t *image, unsigned int unit)
 int cmdhd_detach_image(disk_image_t *image, unsigned int unit)
 {
     cmdhd_context_t *hd;
-    int32_t i;
 
     CLOG((LOG, "CMDHD: detach_image"));
 
@@ -1474,17 +1475,8 @@ int cmdhd_detach_image(disk_image_t *image, unsigned int unit)
     hd->image = NULL;
     hd->imagesize = 0;
     hd->baselba = UINT32_MAX;
-    hd->scsi->file[0] = NULL;
-
-    /* close all additional SCSI ID files */
-    for (i = 1; i < 56; i++) {
-        /* if it isn't NULL, it must be a file */
-        if (hd->scsi->file[i]) {
-            /* close it and set to NULL */
-            fclose(hd->scsi->file[i]);
-            hd->scsi->file[i] = NULL;
-        }
-    }
+    /* close all SCSI ID files, ID 0 only drops the shared FD */
+    scsi_image_detach_all(hd->scsi);
 
     /* make sure the cmdbus isn't held down */
     cmdbus.drv_data[unit - 8] = 0xff;
@@ -38,10 +38,12 @@
 #include "archdep.h"
 #include "attach.h"
 #include "autostart.h"
+#include "benchmark.h"
 #include "cmdline.h"
 #include "crc32.h"
 #include "datasette.h"
 #include "debug.h"
+#include "eventlog.h"
 #include "interrupt.h"
 #include "joystick.h"
 #include "keyboard.h"
@@ -68,7 +70,11 @@
 
 #define EVENT_START_SNAPSHOT "start.vsf"
 #define EVENT_END_SNAPSHOT "end.vsf"
-#define EVENT_MILESTONE_SNAPSHOT "milestone.vsf"
+#define EVENT_MILESTONE_SNAPSHOT "milestone%05u.vsf"
+
+/* added to the name of the end snapshot for the file the events go to while
+   recording */
+#define EVENT_JOURNAL_EXT ".events"
 
 
 /** \brief  Size of the CRC32 entries
@@ -85,10 +91,29 @@ struct event_image_list_s {
 };
 typedef struct event_image_list_s event_image_list_t;
 
-static event_list_state_t *event_list = NULL;
+/* A snapshot written while recording, with where to carry on in the history
+   and with the timestamps after loading it.  */
+typedef struct event_milestone_s {
+    unsigned int second;
+    eventlog_pos_t pos;
+    CLOCK next_timestamp_clk;
+} event_milestone_t;
+
+static eventlog_t *event_history = NULL;
 static event_image_list_t *event_image_list_base = NULL;
 static int image_number;
 
+static event_milestone_t *milestone_index = NULL;
+static unsigned int milestone_count = 0, milestone_size = 0;
+
+/* playback: the next event and where it and the one after start */
+static eventlog_record_t playback_rec;
+static eventlog_pos_t playback_rec_pos, playback_pos;
+static int playback_timestamp_due;
+
+/* event data is handed out from here, the log does not keep it aligned */
+static uint32_t playback_data[64];
+
 static alarm_t *event_alarm = NULL;
 
 static log_t event_log = LOG_DEFAULT;
@@ -99,6 +124,13 @@ static unsigned int current_timestamp, milestone_timestamp, playback_time;
 static CLOCK next_timestamp_clk;
 static CLOCK milestone_timestamp_alarm;
 
+/* second to seek to once playback has started, -1 for none */
+static int playback_seek_second = -1;
+
+/* playback asked for on the command line waits for the power-up reset */
+static int playback_start_on_reset = 0;
+static unsigned int milestone_pending_second;
+
 /* the VICE version an event history was made with */
 static char event_version[16];
 
@@ -108,6 +140,9 @@ static char *event_end_snapshot = NULL;
 static char *event_snapshot_path_str = NULL;
 static int event_start_mode;
 static int event_image_include;
+static int event_milestone_interval;
+
+static void event_record_milestone_trap(uint16_t addr, void *data);
 
 static char *event_snapshot_path(const char *snapshot_file)
 {
@@ -157,22 +192,21 @@ static int event_image_append(const char *filename, char **mapped_name, int appe
 }
 
 
-void event_record_attach_in_list(event_list_state_t *list, unsigned int unit,
-                                 unsigned int drive,
-                                 const char *filename, unsigned int read_only)
+/* Builds the data of an EVENT_ATTACHIMAGE event: unit, drive, read-only
+   flag, then either the full name and the image itself, or an empty name,
+   the CRC32 of the image and its name without the path.  */
+static char *event_attach_data(unsigned int unit, unsigned int drive,
+                               const char *filename, unsigned int read_only,
+                               unsigned int *psize)
 {
     char *event_data;
     unsigned int size;
     char *strdir, *strfile;
 
-    list->current->type = EVENT_ATTACHIMAGE;
-    list->current->clk = maincpu_clk;
-    list->current->next = lib_calloc(1, sizeof(event_list_t));
-
     util_fname_split(filename, &strdir, &strfile);
 
     if (event_image_include) {
-        size = (unsigned int)strlen(filename) + 3;
+        size = (unsigned int)strlen(filename) + 4;
     } else {
         size = (unsigned int)strlen(strfile) + CRC32_SIZE + 4;
     }
@@ -218,22 +252,66 @@ void event_record_attach_in_list(event_list_state_t *list, unsigned int unit,
     lib_free(strdir);
     lib_free(strfile);
 
+    *psize = size;
+    return event_data;
+}
+
+void event_record_attach_in_list(event_list_state_t *list, unsigned int unit,
+                                 unsigned int drive,
+                                 const char *filename, unsigned int read_only)
+{
+    unsigned int size;
+
+    list->current->type = EVENT_ATTACHIMAGE;
+    list->current->clk = maincpu_clk;
+    list->current->next = lib_calloc(1, sizeof(event_list_t));
+    list->current->data = event_attach_data(unit, drive, filename, read_only, &size);
     list->current->size = size;
-    list->current->data = event_data;
     list->current = list->current->next;
 }
 
 void event_record_attach_image(unsigned int unit, unsigned int drive, const char *filename,
                                unsigned int read_only)
 {
+    char *event_data;
+    unsigned int size;
+
     if (record_active == 0) {
         return;
     }
 
-    event_record_attach_in_list(event_list, unit, drive, filename, read_only);
+    event_data = event_attach_data(unit, drive, filename, read_only, &size);
+    eventlog_append(event_history, EVENT_ATTACHIMAGE, maincpu_clk, event_data, size);
+    lib_free(event_data);
 }
 
 
+/* Writes an image that was included in the history to a temporary file
+   and maps the original name to it.  */
+static int event_extract_image(const char *orig_filename, const void *image,
+                               size_t file_len, char **filename)
+{
+    FILE *fd;
+
+    fd = archdep_mkstemp_fd(filename, MODE_WRITE);
+
+    if (fd == NULL) {
+        ui_error("Cannot create image file '%s'!", *filename);
+        return -1;
+    }
+
+    if (fwrite(image, file_len, 1, fd) != 1) {
+        ui_error("Cannot write image file %s", *filename);
+        fclose(fd);
+        return -1;
+    }
+
+    fclose(fd);
+    event_image_append(orig_filename, filename, 1);
+
+    return 0;
+}
+
 static void event_playback_attach_image(void *data, unsigned int size)
 {
     unsigned int unit, drive, read_only;
@@ -290,22 +368,11 @@ static void event_playback_attach_image(void *data, unsigned int size)
         file_len = size - strlen(orig_filename) - 4;
 
         if (file_len > 0) {
-            FILE *fd;
-
-            fd = archdep_mkstemp_fd(&filename, MODE_WRITE);
-
-            if (fd == NULL) {
-                ui_error("Cannot create image file '%s'!", filename);
-                goto error;
-            }
-
-            if (fwrite((char*)data + strlen(orig_filename) + 4, file_len, 1, fd) != 1) {
-                ui_error("Cannot write image file %s", filename);
+            if (event_extract_image(orig_filename,
+                                    (char *)data + strlen(orig_filename) + 4,
+                                    file_len, &filename) < 0) {
                 goto error;
             }
-
-            fclose(fd);
-            event_image_append(orig_filename, &filename, 1);
         } else {
             if (event_image_append(orig_filename, &filename, 0) != 0) {
                 ui_error("Cannot find mapped name for %s", orig_filename);
@@ -326,6 +393,27 @@ error:
     lib_free(filename);
 }
 
+/* Only sets up the mapping of an included image, for seeking past the
+   event that attached it; later events refer to the image by name.  */
+static void event_playback_map_image(uint8_t *data, unsigned int size)
+{
+    const char *orig_filename = (const char *)&data[3];
+    char *filename = NULL;
+    size_t file_len;
+
+    if (*orig_filename == 0) {
+        /* not included, asked for when it is attached again */
+        return;
+    }
+
+    file_len = size - strlen(orig_filename) - 4;
+    if (file_len > 0 && event_image_append(orig_filename, &filename, 0) != 0) {
+        event_extract_image(orig_filename, data + strlen(orig_filename) + 4,
+                            file_len, &filename);
+    }
+    lib_free(filename);
+}
+
 
 void event_record_in_list(event_list_state_t *list, unsigned int type,
                           void *data, unsigned int size)
@@ -379,22 +467,53 @@ void event_record_in_list(event_list_state_t *list, unsigned int type,
 void event_record(unsigned int type, void *data, unsigned int size)
 {
     if (record_active == 1) {
-        event_record_in_list(event_list, type, data, size);
+        DBG(("event_record type:%u size:%u clock:%lu", type, size, maincpu_clk));
+
+        if (type == EVENT_RESETCPU) {
+            next_timestamp_clk -= maincpu_clk;
+        }
+        eventlog_append(event_history, type, maincpu_clk, data, size);
     }
 }
 
 
+/* The alarm goes off for the next timestamp if there is one before the
+   next event.  */
 static void next_alarm_set(void)
 {
-    CLOCK new_value;
-
-    new_value = event_list->current->clk;
+    playback_timestamp_due = (playback_rec.type != EVENT_INITIAL
+                              && next_timestamp_clk < playback_rec.clk);
 
-    alarm_set(event_alarm, new_value);
+    alarm_set(event_alarm, playback_timestamp_due ? next_timestamp_clk
+                                                  : playback_rec.clk);
 }
+
 static void next_current_list(void)
 {
-    event_list->current = event_list->current->next;
+    if (playback_rec.type == EVENT_RESETCPU) {
+        next_timestamp_clk -= playback_rec.clk;
+    }
+
+    playback_rec_pos = playback_pos;
+    if (eventlog_read(event_history, &playback_pos, &playback_rec) != 0) {
+        /* ends right away, like the last node of the event lists did */
+        playback_rec.type = EVENT_LIST_END;
+        playback_rec.clk = 0;
+        playback_rec.size = 0;
+        playback_rec.data = NULL;
+    }
+}
+
+static void *playback_rec_data(void)
+{
+    if (playback_rec.size == 0) {
+        return NULL;
+    }
+    if (playback_rec.size <= sizeof(playback_data)) {
+        memcpy(playback_data, playback_rec.data, playback_rec.size);
+        return playback_data;
+    }
+    return playback_rec.data;
 }
 
 static void event_alarm_handler(CLOCK offset, void *data)
@@ -406,28 +525,44 @@ static void event_alarm_handler(CLOCK offset, void *data)
         ui_display_event_time(current_timestamp++, 0);
         next_timestamp_clk = next_timestamp_clk + (CLOCK)machine_get_cycles_per_second();
         alarm_set(event_alarm, next_timestamp_clk);
+
+        if (eventlog_stream_flush(event_history) < 0) {
+            log_error(event_log, "Cannot write the recorded events to disk.");
+        }
+
+        if (event_milestone_interval > 0 && current_timestamp > 1
+            && (current_timestamp - 1) % (unsigned int)event_milestone_interval == 0) {
+            milestone_pending_second = current_timestamp - 1;
+            interrupt_maincpu_trigger_trap(event_record_milestone_trap, (void *)0);
+        }
+        return;
+    }
+
+    if (playback_timestamp_due) {
+        ui_display_event_time(current_timestamp++, playback_time);
+        next_timestamp_clk += (CLOCK)machine_get_cycles_per_second();
+        next_alarm_set();
         return;
     }
 
-    /*log_debug("EVENT PLAYBACK %i CLK %i", event_list_current->type,
-              event_list_current->clk);*/
+    /*log_debug("EVENT PLAYBACK %i CLK %i", playback_rec.type,
+              playback_rec.clk);*/
 
-    switch (event_list->current->type) {
+    switch (playback_rec.type) {
         case EVENT_KEYBOARD_MATRIX:
-            keyboard_event_playback(offset, event_list->current->data);
+            keyboard_event_playback(offset, playback_rec_data());
             break;
         case EVENT_KEYBOARD_RESTORE:
-            keyboard_restore_event_playback(offset, event_list->current->data);
+            keyboard_restore_event_playback(offset, playback_rec_data());
             break;
         case EVENT_JOYSTICK_VALUE:
-            joystick_event_playback(offset, event_list->current->data);
+            joystick_event_playback(offset, playback_rec_data());
             break;
         case EVENT_DATASETTE:
-            datasette_event_playback_port1(offset, event_list->current->data);
+            datasette_event_playback_port1(offset, playback_rec_data());
             break;
         case EVENT_ATTACHIMAGE:
-            event_playback_attach_image(event_list->current->data,
-                                        event_list->current->size);
+            event_playback_attach_image(playback_rec.data, playback_rec.size);
             break;
         case EVENT_ATTACHDISK:
         case EVENT_ATTACHTAPE:
@@ -436,8 +571,8 @@ static void event_alarm_handler(CLOCK offset, void *data)
                 unsigned int unit;
                 const char *filename;
 
-                unit = (unsigned int)((char*)event_list->current->data)[0];
-                filename = &((char*)event_list->current->data)[1];
+                unit = (unsigned int)((char*)playback_rec.data)[0];
+                filename = &((char*)playback_rec.data)[1];
 
                 if (unit == 1 || unit == 2) {
                     tape_image_event_playback(unit, filename);
@@ -448,21 +583,17 @@ static void event_alarm_handler(CLOCK offset, void *data)
             }
             break;
         case EVENT_RESETCPU:
-            machine_reset_event_playback(offset, event_list->current->data);
-            break;
-        case EVENT_TIMESTAMP:
-            ui_display_event_time(current_timestamp++, playback_time);
+            machine_reset_event_playback(offset, playback_rec_data());
             break;
         case EVENT_LIST_END:
             event_playback_stop();
             break;
         default:
-            log_error(event_log, "Unknow event type %u.",
-                    event_list->current->type);
+            log_error(event_log, "Unknow event type %u.", playback_rec.type);
     }
 
-    if (event_list->current->type != EVENT_LIST_END
-        && event_list->current->type != EVENT_RESETCPU) {
+    if (playback_rec.type != EVENT_LIST_END
+        && playback_rec.type != EVENT_RESETCPU) {
         next_current_list();
         next_alarm_set();
     }
@@ -548,10 +679,10 @@ void event_init_image_list(void)
     image_number = 0;
 }
 
-static void create_list(void)
+static void create_history(void)
 {
-    event_list = lib_malloc(sizeof(event_list_state_t));
-    event_register_event_list(event_list);
+    event_history = eventlog_new();
+    milestone_count = 0;
     event_init_image_list();
 }
 
@@ -595,96 +726,175 @@ void event_clear_list(event_list_state_t *list)
     }
 }
 
-static void destroy_list(void)
+static void destroy_history(void)
 {
-    event_clear_list(event_list);
-    lib_free(event_list);
+    eventlog_free(event_history);
+    event_history = NULL;
     event_destroy_image_list();
 }
 
-static void warp_end_list(void)
+/*-----------------------------------------------------------------------*/
+
+static void event_milestone_append(const event_milestone_t *milestone)
 {
-    event_list_t *curr;
+    if (milestone_count == milestone_size) {
+        milestone_size = milestone_size ? milestone_size * 2 : 16;
+        milestone_index = lib_realloc(milestone_index,
+                                      milestone_size * sizeof(event_milestone_t));
+    }
+    milestone_index[milestone_count++] = *milestone;
+}
 
-    curr = event_list->base;
+/* forget the milestones past the end of a shortened history */
+static void event_milestone_drop(size_t offset)
+{
+    while (milestone_count > 0
+           && milestone_index[milestone_count - 1].pos.offset > offset) {
+        milestone_count--;
+    }
+}
 
-    while (curr->type != EVENT_LIST_END) {
-        if (curr->type == EVENT_ATTACHIMAGE) {
-            event_image_append(&((char*)curr->data)[3], NULL, 0);
-        }
+static void event_record_milestone_trap(uint16_t addr, void *data)
+{
+    event_milestone_t milestone;
+    char *name;
 
-        curr = curr->next;
+    if (record_active == 0) {
+        return;
+    }
+
+    name = lib_msprintf(EVENT_MILESTONE_SNAPSHOT, milestone_pending_second);
+    if (machine_write_snapshot(event_snapshot_path(name), 0, 1, 0) < 0) {
+        log_error(event_log, "Could not create milestone snapshot file %s.",
+                  event_snapshot_path(name));
+    } else {
+        milestone.second = milestone_pending_second;
+        eventlog_tell(event_history, &milestone.pos);
+        milestone.next_timestamp_clk = next_timestamp_clk;
+        event_milestone_append(&milestone);
     }
+    lib_free(name);
+}
+
+/* Writes the history to a file next to the end snapshot from now on, so
+   that only the events of the last moments are kept in memory.  */
+static void event_history_stream_start(void)
+{
+    char *path;
 
-    memset(curr, 0, sizeof(event_list_t));
-    event_list->current = curr;
+    path = util_concat(event_snapshot_dir, event_end_snapshot, EVENT_JOURNAL_EXT, NULL);
+    if (eventlog_stream_open(event_history, path) < 0) {
+        log_warning(event_log, "Cannot write %s, keeping the recording in memory.", path);
+    }
+    lib_free(path);
+}
+
+/* Continue recording at the end of the history that was read with the end
+   snapshot. */
+static void warp_end_history(void)
+{
+    eventlog_pos_t pos, end;
+    eventlog_record_t rec;
+
+    memset(&pos, 0, sizeof(pos));
+    end = pos;
+
+    while (eventlog_read(event_history, &pos, &rec) == 0
+           && rec.type != EVENT_LIST_END) {
+        if (rec.type == EVENT_ATTACHIMAGE) {
+            event_image_append((char *)&rec.data[3], NULL, 0);
+        }
+        end = pos;
+    }
+
+    eventlog_truncate(event_history, &end);
+    event_milestone_drop(end.offset);
 }
 /*-----------------------------------------------------------------------*/
-/* writes or replaces version string in the initial event                */
-static void event_write_version(void)
+/* data of the initial event, with the version string at the end         */
+static uint8_t *event_initial_data(int mode, const char *snapshot, unsigned int *psize)
 {
-    uint8_t *new_data;
     uint8_t *data;
     unsigned int ver_idx;
 
-    if (event_list->base->type != EVENT_INITIAL) {
-        /* EVENT_INITIAL is missing (bug in 1.14.xx); fix it */
-        event_list_t *new_event;
-
-        new_event = lib_calloc(1, sizeof(event_list_t));
-        new_event->clk = event_list->base->clk;
-        new_event->size = (unsigned int)strlen(event_start_snapshot) + 2;
-        new_event->type = EVENT_INITIAL;
-        data = lib_malloc(new_event->size);
-        data[0] = EVENT_START_MODE_FILE_SAVE;
-        strcpy((char *)&data[1], event_start_snapshot);
-        new_event->data = data;
-        new_event->next = event_list->base;
-        event_list->base = new_event;
+    ver_idx = 1;
+    if (mode == EVENT_START_MODE_FILE_SAVE) {
+        ver_idx += (unsigned int)strlen(snapshot) + 1;
     }
 
-    data = event_list->base->data;
+    *psize = ver_idx + (unsigned int)strlen(VERSION) + 1;
+    data = lib_malloc(*psize);
 
-    ver_idx = 1;
-    if (data[0] == EVENT_START_MODE_FILE_SAVE) {
-        ver_idx += (unsigned int)strlen((char *)&data[1]) + 1;
+    data[0] = (uint8_t)mode;
+    if (mode == EVENT_START_MODE_FILE_SAVE) {
+        strcpy((char *)&data[1], snapshot);
     }
+    strcpy((char *)&data[ver_idx], VERSION);
 
-    event_list->base->size = ver_idx + (unsigned int)strlen(VERSION) + 1;
-    new_data = lib_malloc(event_list->base->size);
+    return data;
+}
 
-    memcpy(new_data, data, ver_idx);
+static void event_initial_write(void)
+{
+    uint8_t *data;
+    unsigned int size;
 
-    strcpy((char *)&new_data[ver_idx], VERSION);
+    data = event_initial_data(event_start_mode, event_start_snapshot, &size);
+
+    event_record(EVENT_INITIAL, (void *)data, size);
 
-    event_list->base->data = new_data;
     lib_free(data);
 }
 
-static void event_initial_write(void)
+/* Cuts the history off at the event playback stopped at and writes the
+   version of this VICE into the initial event.  */
+static void event_history_restart(const eventlog_pos_t *end)
 {
-    uint8_t *data = NULL;
-    size_t len = 0;
+    eventlog_t *old = event_history;
+    eventlog_pos_t pos, before;
+    eventlog_record_t rec;
+    unsigned int i = 0;
 
-    switch (event_start_mode) {
-        case EVENT_START_MODE_FILE_SAVE:
-            len = 1 + strlen(event_start_snapshot) + 1;
-            data = lib_malloc(len);
-            data[0] = EVENT_START_MODE_FILE_SAVE;
-            strcpy((char *)&data[1], event_start_snapshot);
-            break;
-        case EVENT_START_MODE_RESET:
-            len = 1;
-            data = lib_malloc(len);
-            data[0] = EVENT_START_MODE_RESET;
+    event_history = eventlog_new();
+    memset(&pos, 0, sizeof(pos));
+
+    while (1) {
+        before = pos;
+
+        /* the offsets of the milestones change with the initial event */
+        while (i < milestone_count && milestone_index[i].pos.offset == before.offset) {
+            eventlog_tell(event_history, &milestone_index[i].pos);
+            i++;
+        }
+
+        if (before.offset >= end->offset || eventlog_read(old, &pos, &rec) != 0) {
             break;
-    }
+        }
 
-    event_record(EVENT_INITIAL, (void *)data, (unsigned int)len);
+        if (before.offset == 0) {
+            uint8_t *data;
+            unsigned int size;
 
-    event_write_version();
+            if (rec.type == EVENT_INITIAL) {
+                data = event_initial_data(rec.data[0], (char *)&rec.data[1], &size);
+            } else {
+                /* EVENT_INITIAL is missing (bug in 1.14.xx); fix it */
+                data = event_initial_data(EVENT_START_MODE_FILE_SAVE,
+                                          event_start_snapshot, &size);
+            }
+            eventlog_append(event_history, EVENT_INITIAL, rec.clk, data, size);
+            lib_free(data);
 
-    lib_free(data);
+            if (rec.type == EVENT_INITIAL) {
+                continue;
+            }
+        }
+
+        eventlog_append(event_history, rec.type, rec.clk, rec.data, rec.size);
+    }
+
+    milestone_count = i;
+    eventlog_free(old);
 }
 
 /*-----------------------------------------------------------------------*/
@@ -701,8 +911,8 @@ static void event_record_start_trap(uint16_t addr, void *data)
                 ui_display_recording(0);
                 return;
             }
-            destroy_list();
-            create_list();
+            destroy_history();
+            create_history();
             record_active = 1;
             event_initial_write();
             next_timestamp_clk = maincpu_clk;
@@ -715,26 +925,24 @@ static void event_record_start_trap(uint16_t addr, void *data)
                         event_snapshot_path(event_end_snapshot));
                 return;
             }
-            warp_end_list();
+            warp_end_history();
             record_active = 1;
             next_timestamp_clk = maincpu_clk;
             current_timestamp = playback_time;
             break;
         case EVENT_START_MODE_RESET:
             machine_trigger_reset(MACHINE_RESET_MODE_HARD);
-            destroy_list();
-            create_list();
+            destroy_history();
+            create_history();
             record_active = 1;
             event_initial_write();
             next_timestamp_clk = 0;
             current_timestamp = 0;
             break;
         case EVENT_START_MODE_PLAYBACK:
-            cut_list(event_list->current->next);
-            event_list->current->next = NULL;
-            event_list->current->type = EVENT_LIST_END;
+            event_history_restart(&playback_rec_pos);
             event_destroy_image_list();
-            event_write_version();
+            event_init_image_list();
             record_active = 1;
             next_timestamp_clk = maincpu_clk;
             break;
@@ -743,6 +951,8 @@ static void event_record_start_trap(uint16_t addr, void *data)
             return;
     }
 
+    event_history_stream_start();
+
 #ifdef  DEBUG
     debug_start_recording();
 #endif
@@ -782,6 +992,9 @@ static void event_record_stop_trap(uint16_t addr, void *data)
     }
     record_active = 0;
 
+    /* the end snapshot has it all now */
+    eventlog_stream_close(event_history, 1);
+
 #ifdef  DEBUG
     debug_stop_recording();
 #endif
@@ -808,18 +1021,116 @@ int event_record_stop(void)
 
 static unsigned int playback_reset_ack = 0;
 
+/* Loads the last milestone snapshot written up to the second to seek to
+   and carries on playing back from there.  */
+static void event_playback_seek_now(void)
+{
+    event_milestone_t *milestone = NULL;
+    eventlog_pos_t pos;
+    eventlog_record_t rec;
+    eventlog_record_t keyboard, restore, joystick;
+    unsigned int i;
+    char *name;
+    int rc;
+
+    for (i = 0; i < milestone_count; i++) {
+        if (milestone_index[i].second > (unsigned int)playback_seek_second) {
+            break;
+        }
+        milestone = &milestone_index[i];
+    }
+    playback_seek_second = -1;
+
+    if (milestone == NULL) {
+        /* nothing to skip, just go on */
+        next_alarm_set();
+        return;
+    }
+
+    /* images included before the milestone are referred to by name later,
+       and the snapshot does not have the state of keyboard and joysticks */
+    keyboard.size = restore.size = joystick.size = 0;
+    memset(&pos, 0, sizeof(pos));
+    while (pos.offset < milestone->pos.offset
+           && eventlog_read(event_history, &pos, &rec) == 0) {
+        switch (rec.type) {
+            case EVENT_ATTACHIMAGE:
+                event_playback_map_image(rec.data, rec.size);
+                break;
+            case EVENT_KEYBOARD_MATRIX:
+                keyboard = rec;
+                break;
+            case EVENT_KEYBOARD_RESTORE:
+                restore = rec;
+                break;
+            case EVENT_JOYSTICK_VALUE:
+                joystick = rec;
+                break;
+            default:
+                break;
+        }
+    }
+
+    name = lib_msprintf(EVENT_MILESTONE_SNAPSHOT, milestone->second);
+    rc = machine_read_snapshot(event_snapshot_path(name), 0);
+    if (rc < 0) {
+        ui_error("Error reading milestone snapshot file %s.", event_snapshot_path(name));
+    }
+    lib_free(name);
+    if (rc < 0) {
+        next_alarm_set();
+        return;
+    }
+
+    if (keyboard.size > 0) {
+        playback_rec = keyboard;
+        keyboard_event_playback(0, playback_rec_data());
+    }
+    if (restore.size > 0) {
+        playback_rec = restore;
+        keyboard_restore_event_playback(0, playback_rec_data());
+    }
+    if (joystick.size > 0) {
+        playback_rec = joystick;
+        joystick_event_playback(0, playback_rec_data());
+    }
+
+    playback_pos = milestone->pos;
+    playback_rec.type = EVENT_LIST_END;
+    next_current_list();
+    next_timestamp_clk = milestone->next_timestamp_clk;
+    current_timestamp = milestone->second + 1;
+    next_alarm_set();
+}
+
+static void event_playback_seek_trap(uint16_t addr, void *data)
+{
+    if (playback_active != 0) {
+        event_playback_seek_now();
+    }
+}
+
 void event_reset_ack(void)
 {
-    if (event_list == NULL) {
+    if (event_history == NULL) {
         return;
     }
 
+    if (playback_start_on_reset) {
+        playback_start_on_reset = 0;
+        event_playback_start();
+    }
+
     if (playback_reset_ack) {
         playback_reset_ack = 0;
-        next_alarm_set();
+        if (playback_seek_second >= 0) {
+            interrupt_maincpu_trigger_trap(event_playback_seek_trap, (void *)0);
+        } else {
+            next_alarm_set();
+        }
     }
 
-    if (event_list->current && event_list->current->type == EVENT_RESETCPU) {
+    if (playback_active && playback_rec.type == EVENT_RESETCPU) {
         next_current_list();
         next_alarm_set();
     }
@@ -830,6 +1141,12 @@ void event_reset_ack(void)
     }
 }
 
+static void event_playback_start_failed(void)
+{
+    ui_display_playback(0, NULL);
+    benchmark_playback_stop(1);
+}
+
 /* XXX: the 'unused' (prev. 'data') param is only passed from one function:
  *      interrupt_maincpu_trigger_trap(), and that one passes (void*)0, ie NULL.
  *      So fixing the shadowing of 'data' should be fine.
@@ -846,26 +1163,31 @@ static void event_playback_start_trap(uint16_t addr, void *unused)
 
     if (s == NULL) {
         ui_error("Could not open end snapshot file %s.", event_snapshot_path(event_end_snapshot));
-        ui_display_playback(0, NULL);
+        event_playback_start_failed();
         return;
     }
 
-    destroy_list();
-    create_list();
+    destroy_history();
+    create_history();
 
     if (event_snapshot_read_module(s, 1) < 0) {
         snapshot_close(s);
         ui_error("Could not find event section in end snapshot file.");
-        ui_display_playback(0, NULL);
+        event_playback_start_failed();
         return;
     }
 
     snapshot_close(s);
 
-    event_list->current = event_list->base;
+    memset(&playback_pos, 0, sizeof(playback_pos));
+    playback_rec.type = EVENT_LIST_END;
+    next_current_list();
+    next_timestamp_clk = playback_rec.clk;
+
+    if (playback_rec.type == EVENT_INITIAL) {
+        uint8_t *data = playback_rec.data;
+        unsigned int size = playback_rec.size;
 
-    if (event_list->current->type == EVENT_INITIAL) {
-        uint8_t *data = (uint8_t *)(event_list->current->data);
         switch (data[0]) {
             case EVENT_START_MODE_FILE_SAVE:
                 /*log_debug("READING %s", (char *)(&data[1]));*/
@@ -876,11 +1198,11 @@ static void event_playback_start_trap(uint16_t addr, void *unused)
                     char *st = lib_strdup(event_snapshot_path((char *)(&data[1])));
                     ui_error("Error reading start snapshot file. Tried %s and %s", st, event_snapshot_path(event_start_snapshot));
                     lib_free(st);
-                    ui_display_playback(0, NULL);
+                    event_playback_start_failed();
                     return;
                 }
 
-                if (event_list->current->size > strlen((char *)&data[1]) + 2) {
+                if (size > strlen((char *)&data[1]) + 2) {
                     strncpy(event_version, (char *)(&data[strlen((char *)&data[1]) + 2]), 15);
                 }
 
@@ -890,7 +1212,8 @@ static void event_playback_start_trap(uint16_t addr, void *unused)
             case EVENT_START_MODE_RESET:
                 /*log_debug("RESET MODE!");*/
                 machine_trigger_reset(MACHINE_RESET_MODE_HARD);
-                if (event_list->current->size > 1) {
+                next_timestamp_clk = 0;
+                if (size > 1) {
                     strncpy(event_version, (char *)(&data[1]), 15);
                 }
                 next_current_list();
@@ -901,7 +1224,7 @@ static void event_playback_start_trap(uint16_t addr, void *unused)
     } else {
         if (machine_read_snapshot(event_snapshot_path(event_start_snapshot), 0) < 0) {
             ui_error("Error reading start snapshot file.");
-            ui_display_playback(0, NULL);
+            event_playback_start_failed();
             return;
         }
         next_alarm_set();
@@ -911,10 +1234,16 @@ static void event_playback_start_trap(uint16_t addr, void *unused)
     current_timestamp = 0;
 
     ui_display_playback(1, event_version);
+    benchmark_playback_start();
 
 #ifdef  DEBUG
     debug_start_playback();
 #endif
+
+    /* after a reset this waits for the reset to happen */
+    if (playback_seek_second >= 0 && !playback_reset_ack) {
+        event_playback_seek_now();
+    }
 }
 
 
@@ -936,6 +1265,7 @@ int event_playback_stop(void)
     }
 
     playback_active = 0;
+    playback_rec.type = EVENT_LIST_END;
 
     alarm_unset(event_alarm);
 
@@ -945,6 +1275,27 @@ int event_playback_stop(void)
     debug_stop_playback();
 #endif
 
+    benchmark_playback_stop(0);
+
+    return 0;
+}
+
+/** \brief  Skip to a point of the playback
+ *
+ * Playback continues from the last milestone snapshot written up to
+ * \a second while recording, see the EventMilestoneInterval resource.
+ *
+ * \return  0 on success, -1 if no playback is active
+ */
+int event_playback_seek(unsigned int second)
+{
+    if (playback_active == 0) {
+        return -1;
+    }
+
+    playback_seek_second = (int)second;
+    interrupt_maincpu_trigger_trap(event_playback_seek_trap, (void *)0);
+
     return 0;
 }
 
@@ -983,7 +1334,8 @@ static void event_record_reset_milestone_trap(uint16_t addr, void *data)
         ui_error("Error reading end snapshot file %s.", event_snapshot_path(event_end_snapshot));
         return;
     }
-    warp_end_list();
+    warp_end_history();
+    event_history_stream_start();
     record_active = 1;
     if (milestone_timestamp_alarm > 0) {
         alarm_set(event_alarm, milestone_timestamp_alarm);
@@ -1025,151 +1377,255 @@ int event_playback_active(void)
 
 /*-----------------------------------------------------------------------*/
 
-int event_snapshot_read_module(struct snapshot_s *s, int event_mode)
+/* EVENT snapshot module format:
+
+   type  | name      | description
+   ------------------------------
+   DWORD | size      | size of the encoded events, see eventlog.c
+   ARRAY | events    | encoded events
+   DWORD | milestones| number of milestone snapshots
+   then for each milestone snapshot:
+   DWORD | second    | time it was written
+   DWORD | offset    | where playback carries on in the events
+   CLOCK | clk       | clock of the event before that
+   DWORD | count     | number of events before that
+   CLOCK | next      | clock of the next timestamp
+
+   Version 0.1 had a list of DWORD type, CLOCK clk, DWORD size and the data
+   of each event, ending with an EVENT_LIST_END event.
+ */
+
+static const char snap_module_name[] = "EVENT";
+#define SNAP_MAJOR 1
+#define SNAP_MINOR 0
+
+/* Counts the timestamps made up on playback for the total playback time,
+   the same way as next_alarm_set() does.  */
+static void event_count_timestamps(void)
 {
-    snapshot_module_t *m;
-    uint8_t major_version, minor_version;
-    event_list_t *curr;
-    unsigned int num_of_timestamps;
+    eventlog_pos_t pos;
+    eventlog_record_t rec;
+    unsigned int num_of_timestamps = 0;
+    CLOCK cycles_per_second = (CLOCK)machine_get_cycles_per_second();
 
-    if (event_mode == 0) {
-        return 0;
-    }
+    memset(&pos, 0, sizeof(pos));
+    playback_time = 0;
+    next_timestamp_clk = CLOCK_MAX;
 
-    m = snapshot_module_open(s, "EVENT", &major_version, &minor_version);
+    while (eventlog_read(event_history, &pos, &rec) == 0) {
+        if (next_timestamp_clk == CLOCK_MAX) { /* if EVENT_INITIAL is missing */
+            next_timestamp_clk = rec.clk;
+        }
 
-    /* This module is not mandatory.  */
-    if (m == NULL) {
-        return 0;
+        if (rec.type == EVENT_INITIAL) {
+            if (rec.size > 0 && rec.data[0] == EVENT_START_MODE_RESET) {
+                next_timestamp_clk = 0;
+            } else {
+                next_timestamp_clk = rec.clk;
+            }
+        } else if (next_timestamp_clk < rec.clk) {
+            CLOCK n = (rec.clk - next_timestamp_clk + cycles_per_second - 1)
+                      / cycles_per_second;
+
+            next_timestamp_clk += n * cycles_per_second;
+            num_of_timestamps += (unsigned int)n;
+        }
+
+        if (rec.type == EVENT_LIST_END) {
+            break;
+        }
+
+        if (rec.type == EVENT_RESETCPU) {
+            next_timestamp_clk -= rec.clk;
+        }
     }
 
-    destroy_list();
-    create_list();
+    if (num_of_timestamps > 0) {
+        playback_time = num_of_timestamps - 1;
+    }
+}
 
-    curr = event_list->base;
-    num_of_timestamps = 0;
-    playback_time = 0;
-    next_timestamp_clk = CLOCK_MAX;
+/* Histories made before the compact format are read into it.  */
+static int event_snapshot_read_list(snapshot_module_t *m)
+{
+    uint8_t *data = NULL;
+    unsigned int data_size = 0;
 
     while (1) {
         unsigned int type, size;
         CLOCK clk;
-        uint8_t *data = NULL;
+
+        if (0
+            || SMR_DW_UINT(m, &type) < 0
+            || SMR_CLOCK(m, &clk) < 0
+            || SMR_DW_UINT(m, &size) < 0) {
+            goto fail;
+        }
+
+        if (size > data_size) {
+            data = lib_realloc(data, size);
+            data_size = size;
+        }
+        if (size > 0 && SMR_BA(m, data, size) < 0) {
+            goto fail;
+        }
 
         /*
             throw away recorded timestamp (recording them  was introduced in
             1.14.x so there might exist history files with TIMESTAMP events)
         */
-        do {
-            if (SMR_DW_UINT(m, &(type)) < 0) {
-                snapshot_module_close(m);
-                return -1;
-            }
-
-            if (SMR_CLOCK(m, &(clk)) < 0) {
-                snapshot_module_close(m);
-                return -1;
-            }
+        if (type == EVENT_TIMESTAMP) {
+            continue;
+        }
 
-            if (SMR_DW_UINT(m, &(size)) < 0) {
-                snapshot_module_close(m);
-                return -1;
-            }
-        } while (type == EVENT_TIMESTAMP);
+        eventlog_append(event_history, type, clk, data, size);
 
-        if (size > 0) {
-            data = lib_malloc(size);
-            if (SMR_BA(m, data, size) < 0) {
-                snapshot_module_close(m);
-                return -1;
-            }
+        if (type == EVENT_LIST_END) {
+            break;
         }
+    }
 
-        if (next_timestamp_clk == CLOCK_MAX) { /* if EVENT_INITIAL is missing */
-            next_timestamp_clk = clk;
-        }
+    lib_free(data);
+    return 0;
 
-        if (type == EVENT_INITIAL) {
-            if (data[0] == EVENT_START_MODE_RESET) {
-                next_timestamp_clk = 0;
-            } else {
-                next_timestamp_clk = clk;
-            }
-        } else {
-            /* insert timestamps each second */
-            while (next_timestamp_clk < clk)
-            {
-                curr->type = EVENT_TIMESTAMP;
-                curr->clk = next_timestamp_clk;
-                curr->size = 0;
-                curr->next = lib_calloc(1, sizeof(event_list_t));
-                curr = curr->next;
-                next_timestamp_clk += machine_get_cycles_per_second();
-                num_of_timestamps++;
-            }
-        }
+fail:
+    lib_free(data);
+    return -1;
+}
+
+static int event_snapshot_read_log(snapshot_module_t *m)
+{
+    uint32_t size, count, i;
+    uint8_t *data;
 
-        curr->type = type;
-        curr->clk = clk;
-        curr->size = size;
-        curr->data = (size > 0 ? data : NULL);
+    if (SMR_DW(m, &size) < 0) {
+        return -1;
+    }
 
-        if (type == EVENT_LIST_END) {
-            break;
+    data = lib_malloc(size > 0 ? size : 1);
+    if (SMR_BA(m, data, size) < 0) {
+        lib_free(data);
+        return -1;
+    }
+    if (eventlog_adopt(event_history, data, size) < 0) {
+        log_error(event_log, "The recorded events are damaged.");
+        return -1;
+    }
+
+    if (SMR_DW(m, &count) < 0) {
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        event_milestone_t milestone;
+        uint32_t offset;
+
+        if (0
+            || SMR_DW_UINT(m, &milestone.second) < 0
+            || SMR_DW(m, &offset) < 0
+            || SMR_CLOCK(m, &milestone.pos.clk) < 0
+            || SMR_DW_UINT(m, &milestone.pos.count) < 0
+            || SMR_CLOCK(m, &milestone.next_timestamp_clk) < 0) {
+            return -1;
         }
+        milestone.pos.offset = offset;
 
-        if (type == EVENT_RESETCPU) {
-            next_timestamp_clk -= clk;
+        if (offset <= size) {
+            event_milestone_append(&milestone);
         }
+    }
 
-        curr->next = lib_calloc(1, sizeof(event_list_t));
-        curr = curr->next;
+    return 0;
+}
+
+int event_snapshot_read_module(struct snapshot_s *s, int event_mode)
+{
+    snapshot_module_t *m;
+    uint8_t major_version, minor_version;
+    int rc;
+
+    if (event_mode == 0) {
+        return 0;
     }
 
-    if (num_of_timestamps > 0) {
-        playback_time = num_of_timestamps - 1;
+    m = snapshot_module_open(s, snap_module_name, &major_version, &minor_version);
+
+    /* This module is not mandatory.  */
+    if (m == NULL) {
+        return 0;
+    }
+
+    if (snapshot_version_is_bigger(major_version, minor_version, SNAP_MAJOR, SNAP_MINOR)) {
+        snapshot_set_error(SNAPSHOT_MODULE_HIGHER_VERSION);
+        snapshot_module_close(m);
+        return -1;
+    }
+
+    destroy_history();
+    create_history();
+
+    if (major_version == 0) {
+        rc = event_snapshot_read_list(m);
+    } else {
+        rc = event_snapshot_read_log(m);
     }
 
     snapshot_module_close(m);
 
+    if (rc < 0) {
+        return -1;
+    }
+
+    event_count_timestamps();
+
     return 0;
 }
 
+static int event_snapshot_write_events(void *param, const uint8_t *data, size_t len)
+{
+    return SMW_BA((snapshot_module_t *)param, data, (unsigned int)len);
+}
+
 int event_snapshot_write_module(struct snapshot_s *s, int event_mode)
 {
     snapshot_module_t *m;
-    event_list_t *curr;
+    unsigned int i;
 
     if (event_mode == 0) {
         return 0;
     }
 
-    m = snapshot_module_create(s, "EVENT", 0, 1);
+    m = snapshot_module_create(s, snap_module_name, SNAP_MAJOR, SNAP_MINOR);
 
     if (m == NULL) {
         return -1;
     }
 
-    curr = event_list->base;
+    if (0
+        || SMW_DW(m, (uint32_t)eventlog_size(event_history)) < 0
+        || eventlog_write(event_history, event_snapshot_write_events, m) < 0
+        || SMW_DW(m, (uint32_t)milestone_count) < 0) {
+        goto fail;
+    }
+
+    for (i = 0; i < milestone_count; i++) {
+        event_milestone_t *milestone = &milestone_index[i];
 
-    while (curr != NULL) {
-        if (curr->type != EVENT_TIMESTAMP
-            && (0
-                || SMW_DW(m, (uint32_t)curr->type) < 0
-                || SMW_CLOCK(m, curr->clk) < 0
-                || SMW_DW(m, (uint32_t)curr->size) < 0
-                || SMW_BA(m, curr->data, curr->size) < 0)) {
-            snapshot_module_close(m);
-            return -1;
+        if (0
+            || SMW_DW(m, (uint32_t)milestone->second) < 0
+            || SMW_DW(m, (uint32_t)milestone->pos.offset) < 0
+            || SMW_CLOCK(m, milestone->pos.clk) < 0
+            || SMW_DW(m, (uint32_t)milestone->pos.count) < 0
+            || SMW_CLOCK(m, milestone->next_timestamp_clk) < 0) {
+            goto fail;
         }
-        curr = curr->next;
     }
 
-    if (snapshot_module_close(m) < 0) {
-        return -1;
-    }
+    return snapshot_module_close(m);
 
-    return 0;
+fail:
+    snapshot_module_close(m);
+    return -1;
 }
 
 /*-----------------------------------------------------------------------*/
@@ -1231,6 +1687,17 @@ static int set_event_image_include(int enable, void *param)
     return 0;
 }
 
+static int set_event_milestone_interval(int seconds, void *param)
+{
+    if (seconds < 0) {
+        return -1;
+    }
+
+    event_milestone_interval = seconds;
+
+    return 0;
+}
+
 static const resource_string_t resources_string[] = {
     { "EventSnapshotDir",
       ARCHDEP_FSDEVICE_DEFAULT_DIR ARCHDEP_DIR_SEP_STR, RES_EVENT_NO, NULL,
@@ -1247,6 +1714,8 @@ static const resource_int_t resources_int[] = {
       &event_start_mode, set_event_start_mode, NULL },
     { "EventImageInclude", 1, RES_EVENT_NO, NULL,
       &event_image_include, set_event_image_include, NULL },
+    { "EventMilestoneInterval", 0, RES_EVENT_NO, NULL,
+      &event_milestone_interval, set_event_milestone_interval, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -1266,14 +1735,33 @@ void event_shutdown(void)
     lib_free(event_snapshot_dir);
     lib_free(event_snapshot_path_str);
     event_snapshot_path_str = NULL;
-    destroy_list();
+    destroy_history();
+    lib_free(milestone_index);
+    milestone_index = NULL;
+    milestone_size = 0;
 }
 
 /*-----------------------------------------------------------------------*/
 
 static int cmdline_help(const char *param, void *extra_param)
 {
-    return event_playback_start();
+    playback_start_on_reset = 1;
+
+    return 0;
+}
+
+static int cmdline_playback_from(const char *param, void *extra_param)
+{
+    int second = atoi(param);
+
+    if (second < 0) {
+        return -1;
+    }
+
+    playback_seek_second = second;
+    playback_start_on_reset = 1;
+
+    return 0;
 }
 
 static const cmdline_option_t cmdline_options[] =
@@ -1281,6 +1769,9 @@ static const cmdline_option_t cmdline_options[] =
     { "-playback", CALL_FUNCTION, CMDLINE_ATTRIB_NONE,
       cmdline_help, NULL, NULL, NULL,
       NULL, "Playback recorded events" },
+    { "-playbackfrom", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
+      cmdline_playback_from, NULL, NULL, NULL,
+      "<Seconds>", "Playback recorded events, starting at the last milestone snapshot before the given time" },
     { "-eventsnapshotdir", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
       NULL, NULL, "EventSnapshotDir", NULL,
       "<Name>", "Set event snapshot directory" },
@@ -1299,6 +1790,9 @@ static const cmdline_option_t cmdline_options[] =
     { "+eventimageinc", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
       NULL, NULL, "EventImageInclude", (resource_value_t)0,
       NULL, "Disable including disk images" },
+    { "-eventmilestoneinterval", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "EventMilestoneInterval", NULL,
+      "<Seconds>", "Write a milestone snapshot for seeking every <Seconds> seconds while recording (0: off)" },
     CMDLINE_LIST_END
 };
 
@@ -1315,4 +1809,6 @@ void event_init(void)
 
     event_alarm = alarm_new(maincpu_alarm_context, "Event",
                             event_alarm_handler, NULL);
+
+    create_history();
 }
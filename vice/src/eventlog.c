@@ -0,0 +1,407 @@
+/** \file   eventlog.c
+ * \brief   Compact encoding of recorded events
+ *
+ * Events are packed one after the other into a single growing buffer, so
+ * recording one does not allocate anything once the buffer is big enough.
+ * Each record is
+ *
+ *  - the event type as a varint,
+ *  - the clock difference to the record before as a zigzag varint (the
+ *    clock goes back to zero when the machine is reset),
+ *  - the size of the event data as a varint,
+ *  - the event data.
+ *
+ * Varints are stored little endian, 7 bits to a byte with bit 7 set on all
+ * bytes but the last. A keyboard or joystick event costs a few bytes on top
+ * of its data, instead of a list node and a heap block of its own.
+ *
+ * A log can be streamed to a file while it is being recorded: every time
+ * the buffer has grown past EVENTLOG_SPILL_SIZE it is written out and
+ * emptied, so a long recording only keeps a small tail in memory.
+ * Records written out that way can no longer be read with eventlog_read(),
+ * eventlog_write() still returns the whole log.
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "archdep.h"
+#include "eventlog.h"
+#include "lib.h"
+#include "types.h"
+
+/* Initial size of the buffer */
+#define EVENTLOG_MIN_SIZE       4096
+
+/* Amount of buffered data that is written to the stream in one go */
+#define EVENTLOG_SPILL_SIZE     0x10000
+
+/* Longest record header: type and size take 5 bytes, the clock 10 */
+#define EVENTLOG_HEADER_MAX     20
+
+struct eventlog_s {
+    uint8_t *buffer;        /* records not written to the stream yet */
+    size_t used;
+    size_t capacity;
+
+    size_t spilled;         /* bytes written to the stream before buffer[0] */
+    CLOCK clk;              /* clock of the last record */
+    unsigned int count;
+
+    FILE *stream;
+    char *stream_path;
+    int stream_error;
+};
+
+eventlog_t *eventlog_new(void)
+{
+    return lib_calloc(1, sizeof(eventlog_t));
+}
+
+void eventlog_free(eventlog_t *log)
+{
+    if (log == NULL) {
+        return;
+    }
+    eventlog_stream_close(log, 0);
+    lib_free(log->buffer);
+    lib_free(log);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static uint8_t *eventlog_put_varint(uint8_t *p, uint64_t value)
+{
+    while (value >= 0x80) {
+        *p++ = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *p++ = (uint8_t)value;
+    return p;
+}
+
+/* Returns NULL if the varint runs past \a end or does not fit.  */
+static const uint8_t *eventlog_get_varint(const uint8_t *p, const uint8_t *end,
+                                          uint64_t *value)
+{
+    uint64_t v = 0;
+    unsigned int shift = 0;
+
+    while (p < end && shift < 64) {
+        uint8_t b = *p++;
+
+        v |= (uint64_t)(b & 0x7f) << shift;
+        if ((b & 0x80) == 0) {
+            *value = v;
+            return p;
+        }
+        shift += 7;
+    }
+    return NULL;
+}
+
+static uint64_t eventlog_zigzag(CLOCK clk, CLOCK prev)
+{
+    int64_t delta = (int64_t)(clk - prev);
+
+    return ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+}
+
+static CLOCK eventlog_unzigzag(uint64_t value, CLOCK prev)
+{
+    int64_t delta = (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+
+    return prev + (CLOCK)delta;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Write out the buffered records, if there is a stream to write to.  */
+static int eventlog_spill(eventlog_t *log)
+{
+    if (log->stream == NULL || log->stream_error || log->used == 0) {
+        return 0;
+    }
+    if (fwrite(log->buffer, 1, log->used, log->stream) != log->used) {
+        /* keep the rest in memory */
+        log->stream_error = 1;
+        return -1;
+    }
+    log->spilled += log->used;
+    log->used = 0;
+
+    /* a loaded log may have left a big buffer behind */
+    if (log->capacity > 2 * EVENTLOG_SPILL_SIZE) {
+        lib_free(log->buffer);
+        log->buffer = NULL;
+        log->capacity = 0;
+    }
+    return 0;
+}
+
+int eventlog_append(eventlog_t *log, unsigned int type, CLOCK clk,
+                    const void *data, unsigned int size)
+{
+    size_t need = log->used + EVENTLOG_HEADER_MAX + size;
+    uint8_t *p;
+
+    if (need > log->capacity) {
+        size_t capacity = log->capacity ? log->capacity : EVENTLOG_MIN_SIZE;
+
+        while (capacity < need) {
+            capacity *= 2;
+        }
+        log->buffer = lib_realloc(log->buffer, capacity);
+        log->capacity = capacity;
+    }
+
+    p = log->buffer + log->used;
+    p = eventlog_put_varint(p, type);
+    p = eventlog_put_varint(p, eventlog_zigzag(clk, log->clk));
+    p = eventlog_put_varint(p, size);
+    if (size > 0) {
+        memcpy(p, data, size);
+        p += size;
+    }
+    log->used = (size_t)(p - log->buffer);
+    log->clk = clk;
+    log->count++;
+
+    if (log->used >= EVENTLOG_SPILL_SIZE) {
+        return eventlog_spill(log);
+    }
+    return 0;
+}
+
+/** \brief  Get the end of the log, where the next record goes
+ */
+void eventlog_tell(eventlog_t *log, eventlog_pos_t *pos)
+{
+    pos->offset = log->spilled + log->used;
+    pos->clk = log->clk;
+    pos->count = log->count;
+}
+
+size_t eventlog_size(eventlog_t *log)
+{
+    return log->spilled + log->used;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/** \brief  Decode the record at \a pos and move \a pos past it
+ *
+ * \return  0 on success, 1 at the end of the log, -1 if the log is damaged
+ *          or the record was streamed out already
+ */
+int eventlog_read(eventlog_t *log, eventlog_pos_t *pos, eventlog_record_t *rec)
+{
+    const uint8_t *p, *end;
+    uint64_t type, delta, size;
+
+    if (pos->offset < log->spilled) {
+        return -1;
+    }
+    if (pos->offset == log->spilled + log->used) {
+        return 1;
+    }
+
+    p = log->buffer + (pos->offset - log->spilled);
+    end = log->buffer + log->used;
+
+    p = eventlog_get_varint(p, end, &type);
+    if (p != NULL) {
+        p = eventlog_get_varint(p, end, &delta);
+    }
+    if (p != NULL) {
+        p = eventlog_get_varint(p, end, &size);
+    }
+    if (p == NULL || type > 0xffffffff || size > (uint64_t)(end - p)) {
+        return -1;
+    }
+
+    rec->type = (unsigned int)type;
+    rec->clk = eventlog_unzigzag(delta, pos->clk);
+    rec->size = (unsigned int)size;
+    rec->data = (size > 0) ? (uint8_t *)p : NULL;
+
+    pos->offset = log->spilled + (size_t)(p + size - log->buffer);
+    pos->clk = rec->clk;
+    pos->count++;
+
+    return 0;
+}
+
+/** \brief  Replace the contents of a log
+ *
+ * The log takes over \a data, which must come from lib_malloc(), and
+ * checks that it holds whole records.
+ */
+int eventlog_adopt(eventlog_t *log, uint8_t *data, size_t len)
+{
+    eventlog_pos_t pos;
+    eventlog_record_t rec;
+    int rc;
+
+    eventlog_stream_close(log, 0);
+    lib_free(log->buffer);
+    log->buffer = data;
+    log->used = len;
+    log->capacity = len;
+    log->spilled = 0;
+    log->clk = 0;
+    log->count = 0;
+
+    memset(&pos, 0, sizeof(pos));
+    while ((rc = eventlog_read(log, &pos, &rec)) == 0) {
+    }
+    if (rc < 0) {
+        log->used = 0;
+        return -1;
+    }
+    log->clk = pos.clk;
+    log->count = pos.count;
+    return 0;
+}
+
+/** \brief  Drop all records from \a pos on
+ */
+int eventlog_truncate(eventlog_t *log, const eventlog_pos_t *pos)
+{
+    if (pos->offset < log->spilled || pos->offset > log->spilled + log->used) {
+        return -1;
+    }
+    log->used = pos->offset - log->spilled;
+    log->clk = pos->clk;
+    log->count = pos->count;
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/** \brief  Start writing the log to \a path as it grows
+ *
+ * The records recorded so far are written right away.
+ */
+int eventlog_stream_open(eventlog_t *log, const char *path)
+{
+    if (log->stream != NULL || log->spilled > 0) {
+        return -1;
+    }
+
+    log->stream = fopen(path, "w+b");
+    if (log->stream == NULL) {
+        return -1;
+    }
+    log->stream_path = lib_strdup(path);
+    log->stream_error = 0;
+
+    if (eventlog_spill(log) < 0) {
+        eventlog_stream_close(log, 1);
+        return -1;
+    }
+    return 0;
+}
+
+/** \brief  Make sure everything recorded so far is on disk
+ */
+int eventlog_stream_flush(eventlog_t *log)
+{
+    if (log->stream == NULL) {
+        return 0;
+    }
+    if (eventlog_spill(log) < 0 || fflush(log->stream) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+/** \brief  Stop streaming
+ *
+ * Records already written to the stream are dropped from the log, which is
+ * empty afterwards if anything had been written.
+ */
+void eventlog_stream_close(eventlog_t *log, int remove_file)
+{
+    if (log->stream == NULL) {
+        return;
+    }
+    fclose(log->stream);
+    log->stream = NULL;
+    if (remove_file) {
+        archdep_remove(log->stream_path);
+    }
+    lib_free(log->stream_path);
+    log->stream_path = NULL;
+
+    if (log->spilled > 0) {
+        log->spilled = 0;
+        log->used = 0;
+        log->clk = 0;
+        log->count = 0;
+    }
+}
+
+/** \brief  Pass the whole encoded log to \a write, piece by piece
+ */
+int eventlog_write(eventlog_t *log,
+                   int (*write)(void *param, const uint8_t *data, size_t len),
+                   void *param)
+{
+    if (log->spilled > 0) {
+        uint8_t *chunk;
+        size_t left = log->spilled;
+        int rc = 0;
+
+        if (fflush(log->stream) != 0
+            || archdep_fseeko(log->stream, 0, SEEK_SET) != 0) {
+            return -1;
+        }
+        chunk = lib_malloc(EVENTLOG_SPILL_SIZE);
+        while (left > 0 && rc == 0) {
+            size_t len = (left < EVENTLOG_SPILL_SIZE) ? left : EVENTLOG_SPILL_SIZE;
+
+            if (fread(chunk, 1, len, log->stream) != len) {
+                rc = -1;
+            } else {
+                rc = write(param, chunk, len);
+                left -= len;
+            }
+        }
+        lib_free(chunk);
+        if (archdep_fseeko(log->stream, 0, SEEK_END) != 0) {
+            rc = -1;
+        }
+        if (rc < 0) {
+            return -1;
+        }
+    }
+
+    if (log->used > 0) {
+        return write(param, log->buffer, log->used);
+    }
+    return 0;
+}
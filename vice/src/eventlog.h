@@ -0,0 +1,76 @@
+/** \file   eventlog.h
+ * \brief   Compact encoding of recorded events
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_EVENTLOG_H
+#define VICE_EVENTLOG_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+/** \brief  One decoded event
+ *
+ * \a data points into the log and stays valid until the log is changed.
+ */
+typedef struct eventlog_record_s {
+    unsigned int type;
+    CLOCK clk;
+    unsigned int size;
+    uint8_t *data;
+} eventlog_record_t;
+
+/** \brief  Position in a log
+ *
+ * Also what is needed to carry on appending at that position.
+ */
+typedef struct eventlog_pos_s {
+    size_t offset;
+    CLOCK clk;              /* clock of the record before the position */
+    unsigned int count;     /* records before the position */
+} eventlog_pos_t;
+
+typedef struct eventlog_s eventlog_t;
+
+eventlog_t *eventlog_new(void);
+void eventlog_free(eventlog_t *log);
+
+int eventlog_append(eventlog_t *log, unsigned int type, CLOCK clk,
+                    const void *data, unsigned int size);
+void eventlog_tell(eventlog_t *log, eventlog_pos_t *pos);
+size_t eventlog_size(eventlog_t *log);
+
+int eventlog_adopt(eventlog_t *log, uint8_t *data, size_t len);
+int eventlog_read(eventlog_t *log, eventlog_pos_t *pos, eventlog_record_t *rec);
+int eventlog_truncate(eventlog_t *log, const eventlog_pos_t *pos);
+
+int eventlog_stream_open(eventlog_t *log, const char *path);
+int eventlog_stream_flush(eventlog_t *log);
+void eventlog_stream_close(eventlog_t *log, int remove_file);
+
+int eventlog_write(eventlog_t *log,
+                   int (*write)(void *param, const uint8_t *data, size_t len),
+                   void *param);
+
+#endif
@@ -39,6 +39,7 @@
 #include "cbmdos.h"
 #include "fileio.h"
 #include "fsdevice-close.h"
+#include "fsdevice-dircache.h"
 #include "fsdevice-read.h"
 #include "fsdevicetypes.h"
 #include "archdep.h"
@@ -62,8 +63,11 @@ int fsdevice_close(vdrive_t *vdrive, unsigned int secondary)
             fsdevice_relative_pad_record(bufinfo);
             /* fall through */
         case Write:
-        case Read:
         case Append:
+            /* the file may have been created */
+            fsdevice_dircache_invalidate(vdrive->unit);
+            /* fall through */
+        case Read:
             if (bufinfo->tape->name) {
                 tape_image_close(bufinfo->tape);
             } else {
@@ -76,6 +80,11 @@ int fsdevice_close(vdrive_t *vdrive, unsigned int secondary)
             }
             break;
         case Directory:
+            if (bufinfo->dircache != NULL) {
+                fsdevice_dircache_release(bufinfo->dircache);
+                bufinfo->dircache = NULL;
+                break;
+            }
             if (bufinfo->host_dir == NULL) {
                 return FLOPPY_ERROR;
             }
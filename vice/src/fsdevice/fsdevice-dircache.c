@@ -0,0 +1,429 @@
+/*
+ * fsdevice-dircache.c - File system device, cached host directory index.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* #define DEBUGDIRCACHE */
+
+#include "vice.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "archdep.h"
+#include "cbmdos.h"
+#include "charset.h"
+#include "fsdevicetypes.h"
+#include "lib.h"
+#include "log.h"
+
+#include "fsdevice-dircache.h"
+
+
+#ifdef DEBUGDIRCACHE
+#define DBG(x)  log_debug x
+#else
+#define DBG(x)
+#endif
+
+/* The index below replaces the directory scans that used to be done for every
+   single filename lookup. It keeps, per unit, the list of entries of the host
+   directory in the order archdep_readdir() returns them, together with the
+   short (16 character) names that are shown in the directory listing, and
+   sorted key arrays for looking up long and short names in both ASCII and
+   PETSCII.
+
+   The short name generation follows the algorithm described in
+   fsdevice-filename.c: all entries whose first 14 characters are the same are
+   numbered in directory order, and names longer than 16 characters get that
+   number plus a marker appended after the 14th character.
+
+   The index is rebuilt whenever the host directory changes (see
+   archdep_dir_watch.c), the directory of the unit is changed, or the fsdevice
+   code itself modified the directory. Users that keep iterating over the
+   index (directory listings) hold a reference, so a rebuild in the middle of
+   a listing does not pull the entries away under them.
+*/
+
+/* character to be used as a marker for long names. this must be a valid character
+   in a petscii filename, but an invalid character in the host filesystem. in
+   practise that means we have to use the forward slash, as this is the only
+   invalid character in filenames on linux. */
+#define LONGNAMEMARKER '/'
+
+#define MAXDIRPOSMARK (10+26+26)
+
+/* number of characters that are kept from a long name */
+#define SHORTNAME_PREFIX 14
+
+/* index into the name arrays */
+#define NAME_ASCII      0
+#define NAME_PETSCII    1
+
+typedef struct dircache_entry_s {
+    char *name[2];          /* host name, ASCII and PETSCII */
+    char *shortname[2];     /* name as listed, ASCII and PETSCII */
+    uint8_t *slot;          /* CBM DOS directory slot for wildcard matching */
+} dircache_entry_t;
+
+typedef struct dircache_key_s {
+    const char *key;
+    int index;
+} dircache_key_t;
+
+struct fsdevice_dircache_s {
+    int refcount;
+    char *path;             /* host directory this index was built from */
+    char *cwd;              /* current dir at build time if path is relative */
+    archdep_dir_watch_t *watch;
+    dircache_entry_t *entries;
+    int count;
+    dircache_key_t *by_name[2];
+    dircache_key_t *by_short[2];
+};
+
+static fsdevice_dircache_t *dircache[FSDEVICE_DEVICE_MAX];
+
+static const char *dirposmark[2] = {
+    "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ",
+    "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+};
+
+/* ------------------------------------------------------------------------- */
+
+static int compare_key(const void *a, const void *b)
+{
+    const dircache_key_t *ka = a;
+    const dircache_key_t *kb = b;
+    int rc;
+
+    rc = strcmp(ka->key, kb->key);
+    if (rc == 0) {
+        rc = ka->index - kb->index;
+    }
+    return rc;
+}
+
+static int compare_prefix(const void *a, const void *b)
+{
+    const dircache_key_t *ka = a;
+    const dircache_key_t *kb = b;
+    int rc;
+
+    rc = strncmp(ka->key, kb->key, SHORTNAME_PREFIX);
+    if (rc == 0) {
+        rc = ka->index - kb->index;
+    }
+    return rc;
+}
+
+/* returns the index of the first entry (in directory order) matching key,
+   or -1 if there is none */
+static int find_key(const dircache_key_t *keys, int count, const char *key)
+{
+    int lo = 0;
+    int hi = count;
+
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+
+        if (strcmp(keys[mid].key, key) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo < count && !strcmp(keys[lo].key, key)) {
+        return keys[lo].index;
+    }
+    return -1;
+}
+
+static dircache_key_t *make_keys(fsdevice_dircache_t *cache, int shortname, int mode)
+{
+    dircache_key_t *keys;
+    int i;
+
+    keys = lib_malloc(sizeof(dircache_key_t) * (cache->count + 1));
+    for (i = 0; i < cache->count; i++) {
+        keys[i].key = shortname ? cache->entries[i].shortname[mode]
+                                : cache->entries[i].name[mode];
+        keys[i].index = i;
+    }
+    return keys;
+}
+
+static void make_shortnames(fsdevice_dircache_t *cache, int mode)
+{
+    dircache_key_t *keys;
+    int i, j, k;
+
+    /* group all entries by their first 14 characters, directory order inside
+       each group gives the number used for the marker */
+    keys = make_keys(cache, 0, mode);
+    qsort(keys, cache->count, sizeof(dircache_key_t), compare_prefix);
+
+    for (i = 0; i < cache->count; i = j) {
+        for (j = i + 1; j < cache->count; j++) {
+            if (strncmp(keys[j].key, keys[i].key, SHORTNAME_PREFIX)) {
+                break;
+            }
+        }
+        for (k = i; k < j; k++) {
+            dircache_entry_t *entry = &cache->entries[keys[k].index];
+            const char *name = entry->name[mode];
+            int dirpos = k - i + 1;
+
+            if (strlen(name) <= 16) {
+                entry->shortname[mode] = lib_strdup(name);
+            } else if (dirpos >= MAXDIRPOSMARK) {
+                log_error(LOG_DEFAULT, "could not make a unique short name for '%s'", name);
+                entry->shortname[mode] = lib_strdup(name);
+            } else {
+                entry->shortname[mode] = lib_malloc(17);
+                memcpy(entry->shortname[mode], name, SHORTNAME_PREFIX);
+                entry->shortname[mode][14] = dirposmark[mode][dirpos];
+                entry->shortname[mode][15] = LONGNAMEMARKER;
+                entry->shortname[mode][16] = 0;
+            }
+        }
+    }
+
+    /* the same array serves as the long name lookup table */
+    qsort(keys, cache->count, sizeof(dircache_key_t), compare_key);
+    cache->by_name[mode] = keys;
+
+    keys = make_keys(cache, 1, mode);
+    qsort(keys, cache->count, sizeof(dircache_key_t), compare_key);
+    cache->by_short[mode] = keys;
+}
+
+static void dircache_free(fsdevice_dircache_t *cache)
+{
+    int i, mode;
+
+    for (i = 0; i < cache->count; i++) {
+        for (mode = 0; mode < 2; mode++) {
+            lib_free(cache->entries[i].name[mode]);
+            lib_free(cache->entries[i].shortname[mode]);
+        }
+        lib_free(cache->entries[i].slot);
+    }
+    for (mode = 0; mode < 2; mode++) {
+        lib_free(cache->by_name[mode]);
+        lib_free(cache->by_short[mode]);
+    }
+    lib_free(cache->entries);
+    archdep_dir_watch_free(cache->watch);
+    lib_free(cache->path);
+    lib_free(cache->cwd);
+    lib_free(cache);
+}
+
+static fsdevice_dircache_t *dircache_build(const char *path)
+{
+    fsdevice_dircache_t *cache;
+    archdep_dir_t *host_dir;
+    int i;
+
+    /* start watching before scanning, so changes made while scanning are not
+       missed */
+    cache = lib_calloc(1, sizeof(fsdevice_dircache_t));
+    cache->refcount = 1;
+    cache->path = lib_strdup(path);
+    if (archdep_path_is_relative(path)) {
+        cache->cwd = archdep_current_dir();
+    }
+    cache->watch = archdep_dir_watch_new(path);
+
+    host_dir = archdep_opendir(path, ARCHDEP_OPENDIR_ALL_FILES);
+    if (host_dir == NULL) {
+        dircache_free(cache);
+        return NULL;
+    }
+
+    cache->count = archdep_readdir_num_entries(host_dir);
+    cache->entries = lib_calloc(cache->count + 1, sizeof(dircache_entry_t));
+
+    for (i = 0; i < cache->count; i++) {
+        dircache_entry_t *entry = &cache->entries[i];
+        const char *direntry = archdep_readdir_get_entry(host_dir, i);
+
+        entry->name[NAME_ASCII] = lib_strdup(direntry);
+        entry->name[NAME_PETSCII] = lib_strdup(direntry);
+        charset_petconvstring((uint8_t *)entry->name[NAME_PETSCII], CONVERT_TO_PETSCII);
+        entry->slot = cbmdos_dir_slot_create(direntry, (unsigned int)strlen(direntry));
+    }
+    archdep_closedir(host_dir);
+
+    make_shortnames(cache, NAME_ASCII);
+    make_shortnames(cache, NAME_PETSCII);
+
+    DBG(("fsdevice dircache: indexed %d entries of '%s'", cache->count, path));
+
+    return cache;
+}
+
+static int dircache_is_valid(const fsdevice_dircache_t *cache, const char *path)
+{
+    if (strcmp(cache->path, path)) {
+        return 0;
+    }
+    if (cache->cwd != NULL) {
+        char *cwd = archdep_current_dir();
+        int same = (cwd != NULL) && !strcmp(cache->cwd, cwd);
+
+        lib_free(cwd);
+        if (!same) {
+            return 0;
+        }
+    }
+    return !archdep_dir_watch_changed(cache->watch);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* get the directory index for unit, rebuilding it if the host directory has
+   changed. the returned index must be given back with
+   fsdevice_dircache_release(). */
+fsdevice_dircache_t *fsdevice_dircache_get(unsigned int unit)
+{
+    unsigned int dnr = unit - 8;
+    const char *path;
+
+    if (dnr >= FSDEVICE_DEVICE_MAX) {
+        return NULL;
+    }
+
+    path = fsdevice_get_path(unit);
+    if (path == NULL) {
+        return NULL;
+    }
+
+    if (dircache[dnr] != NULL && !dircache_is_valid(dircache[dnr], path)) {
+        fsdevice_dircache_invalidate(unit);
+    }
+
+    if (dircache[dnr] == NULL) {
+        dircache[dnr] = dircache_build(path);
+        if (dircache[dnr] == NULL) {
+            return NULL;
+        }
+    }
+
+    dircache[dnr]->refcount++;
+    return dircache[dnr];
+}
+
+void fsdevice_dircache_release(fsdevice_dircache_t *cache)
+{
+    if (cache != NULL && --cache->refcount == 0) {
+        dircache_free(cache);
+    }
+}
+
+/* drop the index of unit, used after the fsdevice itself changed the
+   contents of the directory */
+void fsdevice_dircache_invalidate(unsigned int unit)
+{
+    unsigned int dnr = unit - 8;
+
+    if (dnr < FSDEVICE_DEVICE_MAX && dircache[dnr] != NULL) {
+        fsdevice_dircache_release(dircache[dnr]);
+        dircache[dnr] = NULL;
+    }
+}
+
+void fsdevice_dircache_shutdown(void)
+{
+    unsigned int dnr;
+
+    for (dnr = 0; dnr < FSDEVICE_DEVICE_MAX; dnr++) {
+        fsdevice_dircache_invalidate(dnr + 8);
+    }
+}
+
+/* get the (ASCII) host name at position pos, in archdep_readdir() order */
+const char *fsdevice_dircache_get_entry(const fsdevice_dircache_t *cache, int pos)
+{
+    if (pos < 0 || pos >= cache->count) {
+        return NULL;
+    }
+    return cache->entries[pos].name[NAME_ASCII];
+}
+
+/* replace name in-place by its short name, returns -1 if no unique short name
+   could be created */
+int fsdevice_dircache_limit_name(fsdevice_dircache_t *cache, char *name, int petscii)
+{
+    int mode = petscii ? NAME_PETSCII : NAME_ASCII;
+    int index;
+
+    if (strlen(name) <= 16) {
+        return 0;
+    }
+
+    index = find_key(cache->by_name[mode], cache->count, name);
+    if (index >= 0) {
+        const char *shortname = cache->entries[index].shortname[mode];
+
+        if (strlen(shortname) > 16) {
+            return -1;
+        }
+        strcpy(name, shortname);
+    }
+    return 0;
+}
+
+/* get the long name for a short name, returns a copy of shortname if no
+   entry matches. the result must be freed with lib_free(). */
+char *fsdevice_dircache_expand_name(fsdevice_dircache_t *cache, const char *shortname, int petscii)
+{
+    int mode = petscii ? NAME_PETSCII : NAME_ASCII;
+    int index;
+
+    index = find_key(cache->by_short[mode], cache->count, shortname);
+    if (index >= 0) {
+        return lib_strdup(cache->entries[index].name[mode]);
+    }
+    return lib_strdup(shortname);
+}
+
+/* find the first entry matching the (ASCII) wildcard pattern, using the same
+   rules as cbmfile_find_file(). the result must be freed with lib_free(). */
+char *fsdevice_dircache_find_pattern(fsdevice_dircache_t *cache, const char *pattern)
+{
+    uint8_t *slot;
+    char *found = NULL;
+    int i;
+
+    slot = cbmdos_dir_slot_create(pattern, (unsigned int)strlen(pattern));
+
+    for (i = 0; i < cache->count; i++) {
+        if (cbmdos_parse_wildcard_compare(slot, cache->entries[i].slot) > 0) {
+            found = lib_strdup(cache->entries[i].name[NAME_ASCII]);
+            break;
+        }
+    }
+
+    lib_free(slot);
+    return found;
+}
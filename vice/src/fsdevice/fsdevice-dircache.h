@@ -0,0 +1,41 @@
+/*
+ * fsdevice-dircache.h - File system device, cached host directory index.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_FSDEVICE_DIRCACHE_H
+#define VICE_FSDEVICE_DIRCACHE_H
+
+struct fsdevice_dircache_s;
+typedef struct fsdevice_dircache_s fsdevice_dircache_t;
+
+fsdevice_dircache_t *fsdevice_dircache_get(unsigned int unit);
+void fsdevice_dircache_release(fsdevice_dircache_t *cache);
+void fsdevice_dircache_invalidate(unsigned int unit);
+void fsdevice_dircache_shutdown(void);
+
+const char *fsdevice_dircache_get_entry(const fsdevice_dircache_t *cache, int pos);
+
+int fsdevice_dircache_limit_name(fsdevice_dircache_t *cache, char *name, int petscii);
+char *fsdevice_dircache_expand_name(fsdevice_dircache_t *cache, const char *shortname, int petscii);
+char *fsdevice_dircache_find_pattern(fsdevice_dircache_t *cache, const char *pattern);
+
+#endif
@@ -30,8 +30,7 @@
 
 #include <string.h>
 
-#include "archdep.h"
-#include "charset.h"
+#include "fsdevice-dircache.h"
 #include "fsdevicetypes.h"
 #include "lib.h"
 #include "log.h"
@@ -69,21 +68,19 @@
         testfoobartestest.prg   becomes     testfoobartest0/
         testfoobartestAB.prg    becomes     testfoobartest1/
 
-   - when opening an existing file, we iterate through the current work
-     directory, convert each filename to a short name using the algorithm above,
-     and then compare if the result matches the filename we want to open. if so,
-     we can use the long name of the file to open it.
+   - when opening an existing file, we look up the name we want to open in
+     the short names created with the algorithm above for each file in the
+     current work directory. if one matches, we can use the long name of the
+     file to open it.
 
     all functions below should be completely transparent (ie not change the
     provided names in any way) when "FSDeviceLongNames" is set to "1".
 
 */
 
-/* character to be used as a marker for long names. this must be a valid character
-   in a petscii filename, but an invalid character in the host filesystem. in
-   practise that means we have to use the forward slash, as this is the only
-   invalid character in filenames on linux. */
-#define LONGNAMEMARKER '/'
+/* the short names are generated, and looked up, by the directory index in
+   fsdevice-dircache.c, which keeps them in memory so the host directory does
+   not have to be scanned again for every single name. */
 
 /*
     convert real (long) name into shortened representation
@@ -92,79 +89,27 @@
             1 - name is PETSCII
 */
 
-#define MAXDIRPOSMARK (10+26+26)
-
-static int _limit_longname(archdep_dir_t *archdep_dir, vdrive_t *vdrive, char *longname, int mode)
+static int limit_longname(vdrive_t *vdrive, char *longname, int mode)
 {
-    const char *direntry;
-    char newname[ARCHDEP_PATH_MAX];
+    fsdevice_dircache_t *cache;
     int longnames;
-    int dirpos = 0;
-    int tmppos;
-    char *dirposmark[2] = {
-        "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ",
-        "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"};
+    int ret = -1;
 
     DBG(("limit_longname enter '%s' mode: %d\n", longname, mode));
     if (resources_get_int("FSDeviceLongNames", &longnames) < 0) {
         return -1;
     }
 
-    if (!longnames) {
-        if (strlen(longname) > 16) {
-            tmppos = archdep_telldir(archdep_dir);
-            archdep_rewinddir(archdep_dir);
-
-            while(1) {
-                direntry = archdep_readdir(archdep_dir);
-                if (direntry == NULL) {
-                    break;
-                }
-                strcpy(newname, direntry);
-                if (mode) {
-                    charset_petconvstring((uint8_t *)newname, CONVERT_TO_PETSCII);   /* ASCII name to PETSCII */
-                }
-                if (!strncmp(newname, longname, 14)) {
-                    dirpos++;
-                    /* handle max count */
-                    if (dirpos == MAXDIRPOSMARK) {
-                        log_error(LOG_DEFAULT, "could not make a unique short name for '%s'", longname);
-                        archdep_seekdir(archdep_dir, tmppos);
-                        return -1;
-                    }
-                    DBG(("limit_longname found partial '%s'\n", longname));
-                }
-                DBG(("limit_longname>%d '%s'->'%s' (%s)\n", dirpos, direntry, newname, longname));
-                if (!strcmp(newname, longname)) {
-                    DBG(("limit_longname found full '%s'\n", longname));
-                    longname[14] = dirposmark[mode][dirpos];
-                    longname[15] = LONGNAMEMARKER;
-                    longname[16] = 0;
-                    break;
-                }
-            }
-            archdep_seekdir(archdep_dir, tmppos);
-        }
+    if (longnames) {
+        return 0;
     }
-    DBG(("limit_longname return '%s'\n", longname));
 
-    return 0;
-}
-
-static int limit_longname(vdrive_t *vdrive, char *longname, int mode)
-{
-    archdep_dir_t *archdep_dir;
-    char *prefix;
-    int ret = -1;
-
-    prefix = fsdevice_get_path(vdrive->unit);
-    DBG(("limit_longname path '%s'\n", prefix));
-
-    archdep_dir = archdep_opendir(prefix, ARCHDEP_OPENDIR_ALL_FILES);
-    if (archdep_dir != NULL) {
-        ret = _limit_longname(archdep_dir, vdrive, longname, mode);
-        archdep_closedir(archdep_dir);
+    cache = fsdevice_dircache_get(vdrive->unit);
+    if (cache != NULL) {
+        ret = fsdevice_dircache_limit_name(cache, longname, mode);
+        fsdevice_dircache_release(cache);
     }
+    DBG(("limit_longname return '%s'\n", longname));
     return ret;
 }
 
@@ -177,55 +122,31 @@ static int limit_longname(vdrive_t *vdrive, char *longname, int mode)
 
 static char *expand_shortname(vdrive_t *vdrive, char *shortname, int mode)
 {
-    archdep_dir_t *host_dir;
-    const char *direntry;
-    char *prefix;
+    fsdevice_dircache_t *cache;
     char *longname;
     int longnames;
 
+    if (shortname == NULL) {
+        return NULL;
+    }
+
     if (resources_get_int("FSDeviceLongNames", &longnames) < 0) {
         longnames = 0;
     }
 
     DBG(("expand_shortname shortname '%s' mode: %d\n", shortname, mode));
 
-    /* get a buffer for the new name */
-    longname = lib_malloc(ARCHDEP_PATH_MAX);
-
     if (!longnames) {
-        prefix = fsdevice_get_path(vdrive->unit);
-        DBG(("expand_shortname path '%s'\n", prefix));
-
-        host_dir = archdep_opendir(prefix, ARCHDEP_OPENDIR_ALL_FILES);
-        if (host_dir == NULL) {
+        cache = fsdevice_dircache_get(vdrive->unit);
+        if (cache == NULL) {
             return NULL;
         }
-
-        while(1) {
-            direntry = archdep_readdir(host_dir);
-            if (direntry == NULL) {
-                break;
-            }
-            /* create the short name for this entry and see if it matches */
-            strcpy(longname, direntry);
-            _limit_longname(host_dir, vdrive, longname, 0);
-            if (mode) {
-                charset_petconvstring((uint8_t *)longname, CONVERT_TO_PETSCII);   /* ASCII name to PETSCII */
-            }
-            DBG(("expand_shortname>'%s'->'%s'('%s')\n", direntry, longname, shortname));
-            if (!strcmp(longname, shortname)) {
-                strcpy(longname, direntry);
-                if (mode) {
-                    charset_petconvstring((uint8_t *)longname, CONVERT_TO_PETSCII);   /* ASCII name to PETSCII */
-                }
-                archdep_closedir(host_dir);
-                return longname;
-            }
-        }
-        archdep_closedir(host_dir);
+        longname = fsdevice_dircache_expand_name(cache, shortname, mode);
+        fsdevice_dircache_release(cache);
+    } else {
+        /* copy original string to the new name */
+        longname = lib_strdup(shortname);
     }
-    /* copy original string to the new name */
-    strcpy(longname, shortname);
     DBG(("expand_shortname return '%s'\n", longname));
     return longname;
 }
@@ -46,6 +46,7 @@
 #include "cbmdos.h"
 #include "charset.h"
 #include "fileio.h"
+#include "fsdevice-dircache.h"
 #include "fsdevice-flush.h"
 #include "fsdevice-filename.h"
 #include "fsdevice-read.h"
@@ -132,6 +133,7 @@ static int fsdevice_flush_mkdir(vdrive_t *vdrive, char *arg)
     path = util_concat(prefix, ARCHDEP_DIR_SEP_STR, arg, NULL);
 
     er = CBMDOS_IPE_OK;
+    fsdevice_dircache_invalidate(vdrive->unit);
     if (archdep_mkdir(path, ARCHDEP_MKDIR_RWXUG)) {
         er = CBMDOS_IPE_INVAL;
         if (errno == EEXIST) {
@@ -196,6 +198,7 @@ static int fsdevice_flush_rmdir(vdrive_t *vdrive, char *arg)
     /* FIXME: rmdir() can set a lot of different errors codes, so this probably
      *        is a little naive
      */
+    fsdevice_dircache_invalidate(vdrive->unit);
     if (archdep_rmdir(path) != 0) {
         er = CBMDOS_IPE_NOT_EMPTY;
         if (errno == EPERM) {
@@ -245,6 +248,7 @@ static int fsdevice_flush_rename(vdrive_t *vdrive, char *realarg)
 
     DBG(("fsdevice_flush_rename '%s' to '%s'\n", realsrc, dest));
     rc = fileio_rename(realsrc, dest, fsdevice_get_path(vdrive->unit), format);
+    fsdevice_dircache_invalidate(vdrive->unit);
 
     lib_free(realsrc);
 
@@ -279,6 +283,7 @@ static int fsdevice_flush_scratch(vdrive_t *vdrive, char *realarg)
     }
 
     rc = fileio_scratch(realarg, fsdevice_get_path(vdrive->unit), format);
+    fsdevice_dircache_invalidate(vdrive->unit);
 
     switch (rc) {
         case FILEIO_FILE_PERMISSION:
@@ -45,6 +45,7 @@
 #include "cbmdos.h"
 #include "charset.h"
 #include "fileio.h"
+#include "fsdevice-dircache.h"
 #include "fsdevice-filename.h"
 #include "fsdevice-read.h"
 #include "fsdevice-resources.h"
@@ -106,6 +107,7 @@ static int fsdevice_open_directory(vdrive_t *vdrive, unsigned int secondary,
                                    cbmdos_cmd_parse_t *cmd_parse, char *rname)
 {
     archdep_dir_t *host_dir;
+    fsdevice_dircache_t *dircache;
     char *mask;
     uint8_t *p;
     int i;
@@ -137,9 +139,18 @@ static int fsdevice_open_directory(vdrive_t *vdrive, unsigned int secondary,
         }
     }
 
+    /* the directory of the unit itself is listed from the directory index */
+    host_dir = NULL;
+    dircache = NULL;
+    if (!strcmp(cmd_parse->parsecmd, fsdevice_get_path(vdrive->unit))) {
+        dircache = fsdevice_dircache_get(vdrive->unit);
+    }
+
     /* trying to open */
-    host_dir = archdep_opendir((char *)(cmd_parse->parsecmd), ARCHDEP_OPENDIR_ALL_FILES);
-    if (host_dir == NULL) {
+    if (dircache == NULL) {
+        host_dir = archdep_opendir((char *)(cmd_parse->parsecmd), ARCHDEP_OPENDIR_ALL_FILES);
+    }
+    if (host_dir == NULL && dircache == NULL) {
         for (p = (uint8_t *)(cmd_parse->parsecmd); *p; p++) {
             if (isupper((int)*p)) {
                 *p = tolower((int)*p);
@@ -205,6 +216,8 @@ static int fsdevice_open_directory(vdrive_t *vdrive, unsigned int secondary,
     bufinfo[secondary].bufp = bufinfo[secondary].name;
     bufinfo[secondary].mode = Directory;
     bufinfo[secondary].host_dir = host_dir;
+    bufinfo[secondary].dircache = dircache;
+    bufinfo[secondary].dircache_pos = 0;
     bufinfo[secondary].eof = 0;
 
     return FLOPPY_COMMAND_OK;
@@ -277,6 +290,7 @@ static int fsdevice_open_file(vdrive_t *vdrive, unsigned int secondary,
 
         if (finfo != NULL) {
             bufinfo[secondary].fileio_info = finfo;
+            fsdevice_dircache_invalidate(vdrive->unit);
             fsdevice_error(vdrive, CBMDOS_IPE_OK);
             return FLOPPY_COMMAND_OK;
         } else {
@@ -347,6 +361,29 @@ static int fsdevice_open_file(vdrive_t *vdrive, unsigned int secondary,
         bufinfo[secondary].mode == Relative ? FILEIO_COMMAND_READ_WRITE
                                             : FILEIO_COMMAND_READ;
 
+    /* resolve wildcards using the directory index instead of letting the
+       fileio layer scan the directory again. P00 files are matched by the
+       name in their header, so leave those to the fileio layer. */
+    if (format == FILEIO_FORMAT_RAW && newrname != NULL
+        && cbmdos_parse_wildcard_check(cmd_parse->parsecmd,
+                                       (unsigned int)strlen(cmd_parse->parsecmd))) {
+        fsdevice_dircache_t *dircache = fsdevice_dircache_get(vdrive->unit);
+
+        if (dircache != NULL) {
+            char *found = fsdevice_dircache_find_pattern(dircache, cmd_parse->parsecmd);
+
+            fsdevice_dircache_release(dircache);
+            if (found == NULL) {
+                lib_free(newrname);
+                fsdevice_error(vdrive, CBMDOS_IPE_NOT_FOUND);
+                return FLOPPY_ERROR;
+            }
+            lib_free(newrname);
+            newrname = found;
+            fileio_command |= FILEIO_COMMAND_FSNAME;
+        }
+    }
+
     finfo = fileio_open(newrname, fsdevice_get_path(vdrive->unit), format,
                         fileio_command, bufinfo[secondary].type,
                         &bufinfo[secondary].reclen);
@@ -41,6 +41,7 @@
 #include "archdep.h"
 #include "cbmdos.h"
 #include "fileio.h"
+#include "fsdevice-dircache.h"
 #include "fsdevice-filename.h"
 #include "fsdevice-resources.h"
 #include "fsdevicetypes.h"
@@ -410,7 +411,12 @@ static void command_directory_get(vdrive_t *vdrive, bufinfo_t *bufinfo,
         uint8_t *p;
         finfo = NULL;
 
-        direntry = archdep_readdir(bufinfo->host_dir);
+        if (bufinfo->dircache != NULL) {
+            direntry = fsdevice_dircache_get_entry(bufinfo->dircache,
+                                                   bufinfo->dircache_pos++);
+        } else {
+            direntry = archdep_readdir(bufinfo->host_dir);
+        }
 
         if (direntry == NULL) {
             break;
@@ -596,7 +602,7 @@ static void command_directory_get(vdrive_t *vdrive, bufinfo_t *bufinfo,
 static int command_directory(vdrive_t *vdrive, bufinfo_t *bufinfo,
                              uint8_t *data, unsigned int secondary)
 {
-    if (bufinfo->host_dir == NULL) {
+    if (bufinfo->host_dir == NULL && bufinfo->dircache == NULL) {
         return FLOPPY_ERROR;
     }
 
@@ -46,6 +46,7 @@
 #include "cbmdos.h"
 #include "fileio.h"
 #include "fsdevice-close.h"
+#include "fsdevice-dircache.h"
 #include "fsdevice-flush.h"
 #include "fsdevice-open.h"
 #include "fsdevice-read.h"
@@ -232,6 +233,8 @@ void fsdevice_shutdown(void)
 {
     unsigned int i, j;
 
+    fsdevice_dircache_shutdown();
+
     for (i = 0; i < FSDEVICE_DEVICE_MAX; i++) {
         bufinfo_t *bufinfo;
 
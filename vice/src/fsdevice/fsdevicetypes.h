@@ -41,11 +41,15 @@ enum fsmode {
 };
 
 struct fileio_info_s;
+struct fsdevice_dircache_s;
 struct tape_image_s;
 
 struct bufinfo_s {
     struct fileio_info_s *fileio_info;
     archdep_dir_t *host_dir;
+    struct fsdevice_dircache_s *dircache;   /* used instead of host_dir when
+                                               listing the unit's directory */
+    int dircache_pos;
     struct tape_image_s *tape;
     enum fsmode mode;
     char *dir;
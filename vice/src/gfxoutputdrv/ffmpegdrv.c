@@ -36,6 +36,10 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifdef USE_VICE_THREAD
+#include <pthread.h>
+#endif
+
 #include "archdep.h"
 #include "cmdline.h"
 #include "ffmpegdrv.h"
@@ -157,6 +161,47 @@ static unsigned int framecounter;
 static struct SwsContext *sws_ctx;
 #endif
 
+/* encoder queue
+
+   The emulation thread only copies the palette-indexed picture (or the raw
+   audio samples) into a slot of this queue. Colourspace conversion, encoding
+   and muxing are done by the encoder thread, in queue order, so the streams
+   stay interleaved the same way as without the thread. Without
+   USE_VICE_THREAD every job is encoded right away when it is committed. */
+#define FFMPEGDRV_QUEUE_SIZE    16
+
+#define FFMPEGDRV_JOB_VIDEO     0
+#define FFMPEGDRV_JOB_AUDIO     1
+
+typedef struct ffmpegdrv_job_s {
+    int type;
+    int64_t pts;                /* video: presentation timestamp */
+    uint8_t *data;              /* video: palette indices, audio: S16 samples */
+    size_t data_size;           /* allocated size of data */
+    uint8_t palette[256 * 3];   /* video: RGB triplets of the palette */
+} ffmpegdrv_job_t;
+
+static ffmpegdrv_job_t job_queue[FFMPEGDRV_QUEUE_SIZE];
+static unsigned int job_head;   /* next job to encode */
+static unsigned int job_tail;   /* next free slot */
+static unsigned int job_count;
+static volatile int encoder_error;
+
+#ifdef USE_VICE_THREAD
+static pthread_t encoder_thread;
+static pthread_mutex_t job_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_queued_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t job_done_cond = PTHREAD_COND_INITIALIZER;
+static int encoder_running;
+static int encoder_stop;
+#endif
+
+/* statistics, logged when the recording is closed */
+static unsigned int stats_frames_encoded;
+static unsigned int stats_frames_dropped;
+static unsigned int stats_queue_max;
+static unsigned int stats_audio_stalls;
+
 /* resources */
 static char *ffmpeg_format = NULL;
 static int format_index;
@@ -167,6 +212,8 @@ static int video_codec;
 static int video_halve_framerate;
 
 static int ffmpegdrv_init_file(void);
+static ffmpegdrv_job_t *ffmpegdrv_job_get(int wait);
+static void ffmpegdrv_job_commit(void);
 
 static int set_container_format(const char *val, void *param)
 {
@@ -381,8 +428,10 @@ static int ffmpegdrv_open_audio(AVFormatContext *oc, AVStream *st)
         return -1;
     }
 
+    /* the samples are collected in a buffer of our own, as tmp_frame
+       belongs to the encoder thread */
     ffmpegdrv_audio_in.size = audio_inbuf_samples * c->channels;
-    ffmpegdrv_audio_in.buffer = (int16_t *)audio_st.tmp_frame->data[0];
+    ffmpegdrv_audio_in.buffer = lib_malloc(ffmpegdrv_audio_in.size * sizeof(int16_t));
     return 0;
 }
 
@@ -397,6 +446,9 @@ static void ffmpegdrv_close_audio(void)
     }
 
     audio_is_open = 0;
+    if (ffmpegdrv_audio_in.buffer != NULL) {
+        lib_free(ffmpegdrv_audio_in.buffer);
+    }
     ffmpegdrv_audio_in.buffer = NULL;
     ffmpegdrv_audio_in.size = 0;
 #ifndef HAVE_FFMPEG_AVRESAMPLE
@@ -512,8 +564,8 @@ static int ffmpegmovie_init_audio(int speed, int channels, soundmovie_buffer_t *
     return 0;
 }
 
-/* triggered by soundffmpegaudio->write */
-static int ffmpegmovie_encode_audio(soundmovie_buffer_t *audio_in)
+/* encoder thread: convert and encode one block of audio samples */
+static int ffmpegdrv_encode_audio_job(ffmpegdrv_job_t *job)
 {
     int got_packet;
     int dst_nb_samples;
@@ -523,15 +575,14 @@ static int ffmpegmovie_encode_audio(soundmovie_buffer_t *audio_in)
     int ret;
 
     if (audio_st.st) {
-        audio_st.frame->pts = audio_st.next_pts;
-        audio_st.next_pts += audio_in->size;
-
         VICE_P_AV_INIT_PACKET(&pkt);
         c = audio_st.st->codec;
 
         frame = audio_st.tmp_frame;
 
         if (frame) {
+            memcpy(frame->data[0], job->data, ffmpegdrv_audio_in.size * sizeof(int16_t));
+
             /* convert samples from native format to destination codec format, using the resampler */
             /* compute destination number of samples */
 #ifndef HAVE_FFMPEG_AVRESAMPLE
@@ -572,6 +623,30 @@ static int ffmpegmovie_encode_audio(soundmovie_buffer_t *audio_in)
         }
     }
 
+    return 0;
+}
+
+/* triggered by soundffmpegaudio->write */
+static int ffmpegmovie_encode_audio(soundmovie_buffer_t *audio_in)
+{
+    ffmpegdrv_job_t *job;
+    size_t size;
+
+    if (audio_st.st && file_init_done) {
+        audio_st.next_pts += audio_in->size;
+
+        /* audio is never dropped; if the encoder fell behind, wait for it */
+        job = ffmpegdrv_job_get(1);
+        size = audio_in->size * sizeof(int16_t);
+        if (job->data_size < size) {
+            job->data = lib_realloc(job->data, size);
+            job->data_size = size;
+        }
+        job->type = FFMPEGDRV_JOB_AUDIO;
+        memcpy(job->data, audio_in->buffer, size);
+        ffmpegdrv_job_commit();
+    }
+
     audio_in->used = 0;
     return 0;
 }
@@ -591,33 +666,62 @@ static soundmovie_funcs_t ffmpegdrv_soundmovie_funcs = {
 /*-----------------------*/
 /* video stream encoding */
 /*-----------------------*/
-static int ffmpegdrv_fill_rgb_image(screenshot_t *screenshot, AVFrame *pic)
+/* emulation thread: copy the visible part of the screen and the palette */
+static void ffmpegdrv_copy_image(screenshot_t *screenshot, ffmpegdrv_job_t *job)
 {
-    int x, y;
+    int y;
     int dx, dy;
-    int colnum;
     int bufferoffset;
+    unsigned int i;
     int x_dim = screenshot->width;
     int y_dim = screenshot->height;
-    int pix = 0;
+    size_t size = (size_t)video_width * video_height;
+    uint8_t *dst;
+
+    if (job->data_size < size) {
+        job->data = lib_realloc(job->data, size);
+        job->data_size = size;
+    }
+
     /* center the screenshot in the video */
     dx = (video_width - x_dim) / 2;
     dy = (video_height - y_dim) / 2;
     bufferoffset = screenshot->x_offset + (dx < 0 ? -dx : 0)
         + (screenshot->y_offset + (dy < 0 ? -dy : 0)) * screenshot->draw_buffer_line_size;
 
+    dst = job->data;
     for (y = 0; y < video_height; y++) {
-        for (x = 0; x < video_width; x++) {
-            colnum = screenshot->draw_buffer[bufferoffset + x];
-            pic->data[0][pix + 3*x] = screenshot->palette->entries[colnum].red;
-            pic->data[0][pix + 3*x + 1] = screenshot->palette->entries[colnum].green;
-            pic->data[0][pix + 3*x + 2] = screenshot->palette->entries[colnum].blue;
-        }
+        memcpy(dst, screenshot->draw_buffer + bufferoffset, video_width);
         bufferoffset += screenshot->draw_buffer_line_size;
-        pix += pic->linesize[0];
+        dst += video_width;
     }
 
-    return 0;
+    memset(job->palette, 0, sizeof(job->palette));
+    for (i = 0; i < screenshot->palette->num_entries && i < 256; i++) {
+        job->palette[i * 3] = screenshot->palette->entries[i].red;
+        job->palette[i * 3 + 1] = screenshot->palette->entries[i].green;
+        job->palette[i * 3 + 2] = screenshot->palette->entries[i].blue;
+    }
+}
+
+/* encoder thread: expand the palette indices to RGB24 */
+static void ffmpegdrv_fill_rgb_image(ffmpegdrv_job_t *job, AVFrame *pic)
+{
+    int x, y;
+    const uint8_t *src = job->data;
+    const uint8_t *rgb;
+    uint8_t *dst = pic->data[0];
+
+    for (y = 0; y < video_height; y++) {
+        for (x = 0; x < video_width; x++) {
+            rgb = &job->palette[src[x] * 3];
+            dst[3*x] = rgb[0];
+            dst[3*x + 1] = rgb[1];
+            dst[3*x + 2] = rgb[2];
+        }
+        src += video_width;
+        dst += pic->linesize[0];
+    }
 }
 
 static AVFrame* ffmpegdrv_alloc_picture(enum AVPixelFormat pix_fmt, int width, int height)
@@ -797,6 +901,215 @@ static void ffmpegdrv_init_video(screenshot_t *screenshot)
     }
 }
 
+/* encoder thread: convert and encode one frame */
+static int ffmpegdrv_encode_video_job(ffmpegdrv_job_t *job)
+{
+    AVCodecContext *c;
+    int ret;
+
+    c = video_st.st->codec;
+
+    if (c->pix_fmt != VICE_AV_PIX_FMT_RGB24) {
+        ffmpegdrv_fill_rgb_image(job, video_st.tmp_frame);
+
+        if (sws_ctx != NULL) {
+            VICE_P_SWS_SCALE(sws_ctx,
+                video_st.tmp_frame->data,
+                video_st.tmp_frame->linesize, 0, c->height,
+                video_st.frame->data, video_st.frame->linesize);
+        }
+    } else {
+        ffmpegdrv_fill_rgb_image(job, video_st.frame);
+    }
+
+    video_st.frame->pts = job->pts;
+
+#ifdef AVFMT_RAWPICTURE
+    if (ffmpegdrv_oc->oformat->flags & AVFMT_RAWPICTURE) {
+        AVPacket pkt;
+        VICE_P_AV_INIT_PACKET(&pkt);
+        pkt.flags |= AV_PKT_FLAG_KEY;
+        pkt.stream_index = video_st.st->index;
+        pkt.data = (uint8_t*)video_st.frame;
+        pkt.size = sizeof(AVPicture);
+        pkt.pts = pkt.dts = video_st.frame->pts;
+
+        ret = VICE_P_AV_INTERLEAVED_WRITE_FRAME(ffmpegdrv_oc, &pkt);
+    } else
+#endif
+    {
+        AVPacket pkt = { 0 };
+        int got_packet;
+
+        VICE_P_AV_INIT_PACKET(&pkt);
+
+        /* encode the image */
+        ret = VICE_P_AVCODEC_ENCODE_VIDEO2(c, &pkt, video_st.frame, &got_packet);
+        if (ret < 0) {
+            log_debug("Error while encoding video frame");
+            return -1;
+        }
+        /* if zero size, it means the image was buffered */
+        if (got_packet) {
+            if (write_frame(ffmpegdrv_oc, &c->time_base, video_st.st, &pkt)<0)
+            {
+                log_debug("ffmpegdrv_encode_video: Error while writing video frame");
+            }
+        } else {
+            ret = 0;
+        }
+    }
+    if (ret < 0) {
+        log_debug("Error while writing video frame");
+        return -1;
+    }
+
+    stats_frames_encoded++;
+
+    return 0;
+}
+
+static void ffmpegdrv_encode_job(ffmpegdrv_job_t *job)
+{
+    int ret;
+
+    if (job->type == FFMPEGDRV_JOB_VIDEO) {
+        ret = ffmpegdrv_encode_video_job(job);
+        if (ret < 0) {
+            /* reported to the emulation thread by the next ffmpegdrv_record */
+            encoder_error = 1;
+        }
+    } else {
+        ffmpegdrv_encode_audio_job(job);
+    }
+}
+
+#ifdef USE_VICE_THREAD
+static void *ffmpegdrv_encoder_thread(void *unused)
+{
+    ffmpegdrv_job_t *job;
+
+    pthread_mutex_lock(&job_lock);
+    for (;;) {
+        while (job_count == 0 && !encoder_stop) {
+            pthread_cond_wait(&job_queued_cond, &job_lock);
+        }
+        if (job_count == 0) {
+            /* stop requested and the queue is drained */
+            break;
+        }
+        job = &job_queue[job_head];
+        pthread_mutex_unlock(&job_lock);
+
+        ffmpegdrv_encode_job(job);
+
+        pthread_mutex_lock(&job_lock);
+        job_head = (job_head + 1) % FFMPEGDRV_QUEUE_SIZE;
+        job_count--;
+        pthread_cond_signal(&job_done_cond);
+    }
+    pthread_mutex_unlock(&job_lock);
+
+    return NULL;
+}
+#endif
+
+/* Return the free slot at the tail of the queue. If the queue is full, either
+   wait for the encoder thread to catch up or return NULL. */
+static ffmpegdrv_job_t *ffmpegdrv_job_get(int wait)
+{
+#ifdef USE_VICE_THREAD
+    if (encoder_running) {
+        pthread_mutex_lock(&job_lock);
+        if (job_count == FFMPEGDRV_QUEUE_SIZE) {
+            if (!wait) {
+                pthread_mutex_unlock(&job_lock);
+                return NULL;
+            }
+            stats_audio_stalls++;
+            while (job_count == FFMPEGDRV_QUEUE_SIZE) {
+                pthread_cond_wait(&job_done_cond, &job_lock);
+            }
+        }
+        pthread_mutex_unlock(&job_lock);
+    }
+#endif
+    return &job_queue[job_tail];
+}
+
+/* Hand the slot returned by ffmpegdrv_job_get over to the encoder. */
+static void ffmpegdrv_job_commit(void)
+{
+#ifdef USE_VICE_THREAD
+    if (encoder_running) {
+        pthread_mutex_lock(&job_lock);
+        job_tail = (job_tail + 1) % FFMPEGDRV_QUEUE_SIZE;
+        job_count++;
+        if (job_count > stats_queue_max) {
+            stats_queue_max = job_count;
+        }
+        pthread_cond_signal(&job_queued_cond);
+        pthread_mutex_unlock(&job_lock);
+        return;
+    }
+#endif
+    ffmpegdrv_encode_job(&job_queue[job_tail]);
+}
+
+static void ffmpegdrv_encoder_start(void)
+{
+    job_head = 0;
+    job_tail = 0;
+    job_count = 0;
+    encoder_error = 0;
+
+    stats_frames_encoded = 0;
+    stats_frames_dropped = 0;
+    stats_queue_max = 0;
+    stats_audio_stalls = 0;
+
+#ifdef USE_VICE_THREAD
+    encoder_stop = 0;
+    if (pthread_create(&encoder_thread, NULL, ffmpegdrv_encoder_thread, NULL) == 0) {
+        encoder_running = 1;
+    } else {
+        log_debug("ffmpegdrv: Could not start encoder thread, encoding synchronously");
+    }
+#endif
+}
+
+/* Encode whatever is still queued, stop the encoder thread and free the
+   queue. Must be called before the trailer is written. */
+static void ffmpegdrv_encoder_stop(void)
+{
+    unsigned int i;
+
+#ifdef USE_VICE_THREAD
+    if (encoder_running) {
+        pthread_mutex_lock(&job_lock);
+        encoder_stop = 1;
+        pthread_cond_signal(&job_queued_cond);
+        pthread_mutex_unlock(&job_lock);
+
+        pthread_join(encoder_thread, NULL);
+        encoder_running = 0;
+    }
+#endif
+
+    for (i = 0; i < FFMPEGDRV_QUEUE_SIZE; i++) {
+        if (job_queue[i].data != NULL) {
+            lib_free(job_queue[i].data);
+            job_queue[i].data = NULL;
+        }
+        job_queue[i].data_size = 0;
+    }
+
+    log_message(LOG_DEFAULT,
+                "ffmpegdrv: %u frames encoded, %u dropped, max queue depth %u of %d, %u audio stalls.",
+                stats_frames_encoded, stats_frames_dropped,
+                stats_queue_max, FFMPEGDRV_QUEUE_SIZE, stats_audio_stalls);
+}
+
 static int ffmpegdrv_init_file(void)
 {
     if (!video_init_done || !audio_init_done) {
@@ -830,6 +1143,7 @@ static int ffmpegdrv_init_file(void)
 
     log_debug("ffmpegdrv: Initialized file successfully");
 
+    ffmpegdrv_encoder_start();
     file_init_done = 1;
 
     return 0;
@@ -892,6 +1206,7 @@ static int ffmpegdrv_close(screenshot_t *screenshot)
 
     /* write the trailer, if any */
     if (file_init_done) {
+        ffmpegdrv_encoder_stop();
         VICE_P_AV_WRITE_TRAILER(ffmpegdrv_oc);
     }
 
@@ -926,8 +1241,7 @@ static int ffmpegdrv_close(screenshot_t *screenshot)
 /* triggered by screenshot_record */
 static int ffmpegdrv_record(screenshot_t *screenshot)
 {
-    AVCodecContext *c;
-    int ret;
+    ffmpegdrv_job_t *job;
 
     if (audio_init_done && video_init_done && !file_init_done) {
         ffmpegdrv_init_file();
@@ -937,6 +1251,10 @@ static int ffmpegdrv_record(screenshot_t *screenshot)
         return 0;
     }
 
+    if (encoder_error) {
+        return -1;
+    }
+
    if (audio_st.st && video_st.next_pts > audio_st.next_pts) {
         /* drop this frame */
         return 0;
@@ -948,64 +1266,20 @@ static int ffmpegdrv_record(screenshot_t *screenshot)
         return 0;
     }
 
-    c = video_st.st->codec;
-
-    if (c->pix_fmt != VICE_AV_PIX_FMT_RGB24) {
-        ffmpegdrv_fill_rgb_image(screenshot, video_st.tmp_frame);
-
-        if (sws_ctx != NULL) {
-            VICE_P_SWS_SCALE(sws_ctx,
-                video_st.tmp_frame->data,
-                video_st.tmp_frame->linesize, 0, c->height,
-                video_st.frame->data, video_st.frame->linesize);
-        }
-    } else {
-        ffmpegdrv_fill_rgb_image(screenshot, video_st.frame);
+    job = ffmpegdrv_job_get(0);
+    if (job == NULL) {
+        /* the encoder can't keep up, skip this frame but keep the timing */
+        video_st.next_pts++;
+        stats_frames_dropped++;
+        return 0;
     }
 
-    video_st.frame->pts = video_st.next_pts++;
+    job->type = FFMPEGDRV_JOB_VIDEO;
+    job->pts = video_st.next_pts++;
+    ffmpegdrv_copy_image(screenshot, job);
+    ffmpegdrv_job_commit();
 
-#ifdef AVFMT_RAWPICTURE
-    if (ffmpegdrv_oc->oformat->flags & AVFMT_RAWPICTURE) {
-        AVPacket pkt;
-        VICE_P_AV_INIT_PACKET(&pkt);
-        pkt.flags |= AV_PKT_FLAG_KEY;
-        pkt.stream_index = video_st.st->index;
-        pkt.data = (uint8_t*)video_st.frame;
-        pkt.size = sizeof(AVPicture);
-        pkt.pts = pkt.dts = video_st.frame->pts;
-
-        ret = VICE_P_AV_INTERLEAVED_WRITE_FRAME(ffmpegdrv_oc, &pkt);
-    } else
-#endif
-    {
-        AVPacket pkt = { 0 };
-        int got_packet;
-
-        VICE_P_AV_INIT_PACKET(&pkt);
-
-        /* encode the image */
-        ret = VICE_P_AVCODEC_ENCODE_VIDEO2(c, &pkt, video_st.frame, &got_packet);
-        if (ret < 0) {
-            log_debug("Error while encoding video frame");
-            return -1;
-        }
-        /* if zero size, it means the image was buffered */
-        if (got_packet) {
-            if (write_frame(ffmpegdrv_oc, &c->time_base, video_st.st, &pkt)<0)
-            {
-                log_debug("ffmpegdrv_encode_audio: Error while writing audio frame");
-            }
-        } else {
-            ret = 0;
-        }
-    }
-    if (ret < 0) {
-        log_debug("Error while writing video frame");
-        return -1;
-    }
-
-    return 0;
+    return encoder_error ? -1 : 0;
 }
 
 static int ffmpegdrv_write(screenshot_t *screenshot)
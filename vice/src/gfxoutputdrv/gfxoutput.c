@@ -42,6 +42,7 @@
 #include "pcxdrv.h"
 #include "ppmdrv.h"
 #include "godotdrv.h"
+#include "vcapdrv.h"
 
 #ifdef HAVE_PNG
 #include "pngdrv.h"
@@ -114,6 +115,7 @@ int gfxoutput_early_init(int help)
 #ifdef HAVE_FFMPEG
     gfxoutput_init_ffmpeg(help);
 #endif
+    gfxoutput_init_vcap(help);
     /* C64 formats */
     gfxoutput_init_godot(help);
     gfxoutput_init_artstudio(help);
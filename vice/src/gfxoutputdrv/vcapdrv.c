@@ -0,0 +1,539 @@
+/*
+ * vcapdrv.c - Lossless VICE capture (VCAP) movie driver.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* Records every emulated frame straight from the raster draw buffer, as
+   palette indices, together with the emulated audio. Frames are XORed
+   against the previous one and RLE packed, which keeps static screens down
+   to a few bytes per frame while staying exact. See vcapdrv.h for the file
+   layout and src/tools/vcaptool for extracting and comparing captures. */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "archdep.h"
+#include "gfxoutput.h"
+#include "lib.h"
+#include "log.h"
+#include "machine.h"
+#include "palette.h"
+#include "screenshot.h"
+#include "soundmovie.h"
+#include "types.h"
+#include "util.h"
+#include "vcapdrv.h"
+
+/* a keyframe is forced after this many delta frames */
+#define VCAP_KEYFRAME_INTERVAL  100
+
+/* samples per channel collected for each AUDI chunk */
+#define VCAP_AUDIO_FRAGMENT     1024
+
+static gfxoutputdrv_t vcap_drv;
+
+static log_t vcap_log = LOG_ERR;
+
+static FILE *vcap_fd = NULL;
+static int vcap_error;
+
+/* video */
+static unsigned int vcap_width;
+static unsigned int vcap_height;
+static uint8_t *vcap_frame = NULL;
+static uint8_t *vcap_prev = NULL;
+static uint8_t *vcap_rle = NULL;
+static uint8_t vcap_palette[256 * 3];
+static unsigned int vcap_palette_entries;
+static long vcap_palette_offset;
+static unsigned int vcap_frames;
+static unsigned int vcap_since_key;
+static int vcap_force_key;
+static uint64_t vcap_video_bytes;
+
+/* frame index, written at the end of the file */
+static uint8_t *vcap_index = NULL;
+static size_t vcap_index_size;
+
+/* audio */
+static soundmovie_buffer_t vcap_audio_in;
+static uint8_t *vcap_audio_bytes = NULL;
+static int vcap_audio_rate;
+static int vcap_audio_channels;
+
+static void vcap_qword_to_le_buf(uint8_t *buf, uint64_t data)
+{
+    util_dword_to_le_buf(buf, (uint32_t)(data & 0xffffffff));
+    util_dword_to_le_buf(buf + 4, (uint32_t)(data >> 32));
+}
+
+static int vcap_fwrite(const void *data, size_t size)
+{
+    if (size > 0 && fwrite(data, size, 1, vcap_fd) != 1) {
+        if (!vcap_error) {
+            log_error(vcap_log, "Write error, capture is incomplete.");
+        }
+        vcap_error = 1;
+        return -1;
+    }
+    return 0;
+}
+
+static int vcap_write_chunk_header(const char *id, size_t size)
+{
+    uint8_t buf[VCAP_CHUNK_HEADER_SIZE];
+
+    memcpy(buf, id, 4);
+    util_dword_to_le_buf(buf + 4, (uint32_t)size);
+
+    return vcap_fwrite(buf, sizeof(buf));
+}
+
+static int vcap_write_header(long index_offset)
+{
+    uint8_t buf[VCAP_HEADER_SIZE];
+    const char *name = machine_get_name();
+
+    memset(buf, 0, sizeof(buf));
+    memcpy(buf, VCAP_MAGIC, VCAP_MAGIC_LEN);
+    util_word_to_le_buf(buf + 8, VCAP_VERSION);
+    util_word_to_le_buf(buf + 10, VCAP_HEADER_SIZE);
+    util_word_to_le_buf(buf + 12, (uint16_t)vcap_width);
+    util_word_to_le_buf(buf + 14, (uint16_t)vcap_height);
+    util_dword_to_le_buf(buf + 16, (uint32_t)machine_get_cycles_per_frame());
+    util_dword_to_le_buf(buf + 20, (uint32_t)machine_get_cycles_per_second());
+    util_dword_to_le_buf(buf + 24, (uint32_t)vcap_audio_rate);
+    util_word_to_le_buf(buf + 28, (uint16_t)vcap_audio_channels);
+    util_word_to_le_buf(buf + 30, VCAP_KEYFRAME_INTERVAL);
+    util_dword_to_le_buf(buf + 32, vcap_frames);
+    vcap_qword_to_le_buf(buf + 40, (uint64_t)index_offset);
+    strncpy((char *)buf + 48, name, VCAP_MACHINE_NAME_LEN - 1);
+
+    return vcap_fwrite(buf, sizeof(buf));
+}
+
+/*-----------------------------------------------------------------------*/
+
+static size_t vcap_rle_literals(const uint8_t *src, size_t len, uint8_t *dst)
+{
+    size_t out = 0;
+    size_t n;
+
+    while (len > 0) {
+        n = len > VCAP_RLE_LITERAL_MAX ? VCAP_RLE_LITERAL_MAX : len;
+        dst[out++] = (uint8_t)(n - 1);
+        memcpy(dst + out, src, n);
+        out += n;
+        src += n;
+        len -= n;
+    }
+    return out;
+}
+
+/* Worst case output size is len + len / VCAP_RLE_LITERAL_MAX + 1. */
+static size_t vcap_rle_encode(const uint8_t *src, size_t len, uint8_t *dst)
+{
+    size_t pos = 0;
+    size_t lit = 0;
+    size_t out = 0;
+    size_t run;
+
+    while (pos < len) {
+        run = 1;
+        while (pos + run < len && src[pos + run] == src[pos]
+               && run < VCAP_RLE_LONG_RUN_MAX) {
+            run++;
+        }
+        if (run < VCAP_RLE_RUN_MIN) {
+            pos += run;
+            continue;
+        }
+
+        out += vcap_rle_literals(src + lit, pos - lit, dst + out);
+        if (run <= VCAP_RLE_RUN_MAX) {
+            dst[out++] = (uint8_t)(0x80 + run - VCAP_RLE_RUN_MIN);
+        } else {
+            dst[out++] = VCAP_RLE_LONG_RUN;
+            dst[out++] = (uint8_t)(run & 0xff);
+            dst[out++] = (uint8_t)(run >> 8);
+        }
+        dst[out++] = src[pos];
+        pos += run;
+        lit = pos;
+    }
+    out += vcap_rle_literals(src + lit, len - lit, dst + out);
+
+    return out;
+}
+
+/*-----------------------------------------------------------------------*/
+
+static int vcap_update_palette(const palette_t *palette)
+{
+    uint8_t rgb[256 * 3];
+    uint8_t buf[2];
+    unsigned int i;
+    unsigned int entries = palette->num_entries > 256 ? 256 : palette->num_entries;
+
+    for (i = 0; i < entries; i++) {
+        rgb[i * 3] = palette->entries[i].red;
+        rgb[i * 3 + 1] = palette->entries[i].green;
+        rgb[i * 3 + 2] = palette->entries[i].blue;
+    }
+
+    if (entries == vcap_palette_entries
+        && memcmp(rgb, vcap_palette, entries * 3) == 0) {
+        return 0;
+    }
+
+    memcpy(vcap_palette, rgb, entries * 3);
+    vcap_palette_entries = entries;
+    vcap_palette_offset = ftell(vcap_fd);
+    vcap_force_key = 1;
+
+    util_word_to_le_buf(buf, (uint16_t)entries);
+    if (vcap_write_chunk_header(VCAP_CHUNK_PALETTE, 2 + entries * 3) < 0
+        || vcap_fwrite(buf, 2) < 0
+        || vcap_fwrite(vcap_palette, entries * 3) < 0) {
+        return -1;
+    }
+    return 0;
+}
+
+/* Copy the visible area from the draw buffer, this is the same area a
+   screenshot would contain. */
+static void vcap_grab_frame(screenshot_t *screenshot)
+{
+    unsigned int y;
+    unsigned int w = screenshot->width < vcap_width ? screenshot->width : vcap_width;
+    unsigned int h = screenshot->height < vcap_height ? screenshot->height : vcap_height;
+    const uint8_t *src;
+
+    if (w < vcap_width || h < vcap_height) {
+        memset(vcap_frame, 0, vcap_width * vcap_height);
+    }
+
+    src = screenshot->draw_buffer + screenshot->x_offset
+        + screenshot->y_offset * screenshot->draw_buffer_line_size;
+
+    for (y = 0; y < h; y++) {
+        memcpy(vcap_frame + y * vcap_width, src, w);
+        src += screenshot->draw_buffer_line_size;
+    }
+}
+
+static void vcap_index_add(long offset, int type)
+{
+    uint8_t *entry;
+    size_t used = (size_t)vcap_frames * VCAP_INDEX_ENTRY_SIZE;
+
+    if (used + VCAP_INDEX_ENTRY_SIZE > vcap_index_size) {
+        vcap_index_size = vcap_index_size ? vcap_index_size * 2 : 1024 * VCAP_INDEX_ENTRY_SIZE;
+        vcap_index = lib_realloc(vcap_index, vcap_index_size);
+    }
+
+    entry = vcap_index + used;
+    memset(entry, 0, VCAP_INDEX_ENTRY_SIZE);
+    vcap_qword_to_le_buf(entry, (uint64_t)offset);
+    vcap_qword_to_le_buf(entry + 8, (uint64_t)vcap_palette_offset);
+    util_dword_to_le_buf(entry + 16, (uint32_t)type);
+}
+
+static int vcap_write_frame(void)
+{
+    size_t size = (size_t)vcap_width * vcap_height;
+    size_t len;
+    size_t i;
+    uint8_t buf[5];
+    uint8_t *tmp;
+    long offset;
+    int type;
+
+    if (vcap_force_key || vcap_since_key >= VCAP_KEYFRAME_INTERVAL) {
+        type = VCAP_FRAME_KEY;
+        len = vcap_rle_encode(vcap_frame, size, vcap_rle);
+        vcap_force_key = 0;
+        vcap_since_key = 0;
+    } else {
+        /* the previous frame is not needed anymore after this */
+        type = VCAP_FRAME_DELTA;
+        for (i = 0; i < size; i++) {
+            vcap_prev[i] ^= vcap_frame[i];
+        }
+        len = vcap_rle_encode(vcap_prev, size, vcap_rle);
+        vcap_since_key++;
+    }
+
+    /* the current frame becomes the reference for the next one */
+    tmp = vcap_prev;
+    vcap_prev = vcap_frame;
+    vcap_frame = tmp;
+
+    offset = ftell(vcap_fd);
+    util_dword_to_le_buf(buf, vcap_frames);
+    buf[4] = (uint8_t)type;
+
+    if (vcap_write_chunk_header(VCAP_CHUNK_FRAME, sizeof(buf) + len) < 0
+        || vcap_fwrite(buf, sizeof(buf)) < 0
+        || vcap_fwrite(vcap_rle, len) < 0) {
+        return -1;
+    }
+
+    vcap_index_add(offset, type);
+    vcap_frames++;
+    vcap_video_bytes += len;
+
+    return 0;
+}
+
+/*-----------------------------------------------------------------------*/
+
+static int vcap_write_audio(soundmovie_buffer_t *audio_in)
+{
+    int i;
+
+    for (i = 0; i < audio_in->used; i++) {
+        util_word_to_le_buf(vcap_audio_bytes + i * 2, (uint16_t)audio_in->buffer[i]);
+    }
+
+    if (vcap_write_chunk_header(VCAP_CHUNK_AUDIO, (size_t)audio_in->used * 2) < 0) {
+        return -1;
+    }
+    return vcap_fwrite(vcap_audio_bytes, (size_t)audio_in->used * 2);
+}
+
+static int vcapmovie_init_audio(int speed, int channels, soundmovie_buffer_t **audio_in)
+{
+    if (vcap_fd == NULL) {
+        return -1;
+    }
+
+    vcap_audio_rate = speed;
+    vcap_audio_channels = channels;
+
+    vcap_audio_in.size = VCAP_AUDIO_FRAGMENT * channels;
+    vcap_audio_in.used = 0;
+    vcap_audio_in.buffer = lib_malloc(vcap_audio_in.size * sizeof(int16_t));
+    vcap_audio_bytes = lib_malloc(vcap_audio_in.size * 2);
+
+    *audio_in = &vcap_audio_in;
+
+    return 0;
+}
+
+/* triggered by soundmovie_write */
+static int vcapmovie_encode_audio(soundmovie_buffer_t *audio_in)
+{
+    if (vcap_fd == NULL || vcap_error) {
+        return -1;
+    }
+
+    vcap_write_audio(audio_in);
+    audio_in->used = 0;
+
+    return 0;
+}
+
+static void vcapmovie_close(void)
+{
+    /* just stop the whole recording */
+    screenshot_stop_recording();
+}
+
+static soundmovie_funcs_t vcap_soundmovie_funcs = {
+    vcapmovie_init_audio,
+    vcapmovie_encode_audio,
+    vcapmovie_close
+};
+
+/*-----------------------------------------------------------------------*/
+
+static void vcap_free_buffers(void)
+{
+    lib_free(vcap_frame);
+    lib_free(vcap_prev);
+    lib_free(vcap_rle);
+    lib_free(vcap_index);
+    vcap_frame = NULL;
+    vcap_prev = NULL;
+    vcap_rle = NULL;
+    vcap_index = NULL;
+    vcap_index_size = 0;
+
+    if (vcap_audio_in.buffer != NULL) {
+        lib_free(vcap_audio_in.buffer);
+        lib_free(vcap_audio_bytes);
+    }
+    vcap_audio_in.buffer = NULL;
+    vcap_audio_in.size = 0;
+    vcap_audio_in.used = 0;
+    vcap_audio_bytes = NULL;
+}
+
+static int vcapdrv_save(screenshot_t *screenshot, const char *filename)
+{
+    char *ext_filename;
+    size_t size;
+
+    if (vcap_fd != NULL) {
+        return -1;
+    }
+
+    if (vcap_log == LOG_ERR) {
+        vcap_log = log_open("VCAP");
+    }
+
+    if (screenshot->width == 0 || screenshot->width > 0xffff
+        || screenshot->height == 0 || screenshot->height > 0xffff) {
+        log_error(vcap_log, "Invalid frame size %ux%u.",
+                  screenshot->width, screenshot->height);
+        return -1;
+    }
+
+    ext_filename = util_add_extension_const(filename, vcap_drv.default_extension);
+    vcap_fd = fopen(ext_filename, MODE_WRITE);
+    if (vcap_fd == NULL) {
+        log_error(vcap_log, "Cannot open `%s'.", ext_filename);
+        lib_free(ext_filename);
+        return -1;
+    }
+
+    vcap_width = screenshot->width;
+    vcap_height = screenshot->height;
+    vcap_error = 0;
+    vcap_frames = 0;
+    vcap_since_key = 0;
+    vcap_force_key = 1;
+    vcap_video_bytes = 0;
+    vcap_palette_entries = 0;
+    vcap_palette_offset = 0;
+    vcap_audio_rate = 0;
+    vcap_audio_channels = 0;
+
+    size = (size_t)vcap_width * vcap_height;
+    vcap_frame = lib_malloc(size);
+    vcap_prev = lib_calloc(1, size);
+    vcap_rle = lib_malloc(size + size / VCAP_RLE_LITERAL_MAX + 16);
+
+    if (vcap_write_header(0) < 0) {
+        fclose(vcap_fd);
+        vcap_fd = NULL;
+        vcap_free_buffers();
+        lib_free(ext_filename);
+        return -1;
+    }
+
+    log_message(vcap_log, "Capturing %ux%u frames to `%s'.",
+                vcap_width, vcap_height, ext_filename);
+    lib_free(ext_filename);
+
+    soundmovie_start(&vcap_soundmovie_funcs);
+
+    return 0;
+}
+
+/* triggered by screenshot_record */
+static int vcapdrv_record(screenshot_t *screenshot)
+{
+    if (vcap_fd == NULL || vcap_error) {
+        return -1;
+    }
+
+    if (vcap_update_palette(screenshot->palette) < 0) {
+        return -1;
+    }
+
+    vcap_grab_frame(screenshot);
+
+    return vcap_write_frame();
+}
+
+static int vcapdrv_close(screenshot_t *screenshot)
+{
+    uint8_t buf[4];
+    long index_offset;
+    uint64_t raw_bytes;
+
+    /* soundmovie_stop() below can get us here a second time */
+    if (vcap_fd == NULL) {
+        return 0;
+    }
+
+    if (vcap_audio_in.used > 0 && !vcap_error) {
+        vcap_write_audio(&vcap_audio_in);
+        vcap_audio_in.used = 0;
+    }
+
+    index_offset = ftell(vcap_fd);
+    util_dword_to_le_buf(buf, vcap_frames);
+    if (vcap_write_chunk_header(VCAP_CHUNK_INDEX, 4 + (size_t)vcap_frames * VCAP_INDEX_ENTRY_SIZE) == 0
+        && vcap_fwrite(buf, 4) == 0
+        && vcap_fwrite(vcap_index, (size_t)vcap_frames * VCAP_INDEX_ENTRY_SIZE) == 0) {
+        /* only point the header to a complete index */
+        if (fseek(vcap_fd, 0, SEEK_SET) == 0) {
+            vcap_write_header(index_offset);
+        }
+    }
+
+    fclose(vcap_fd);
+    vcap_fd = NULL;
+
+    raw_bytes = (uint64_t)vcap_frames * vcap_width * vcap_height;
+    log_message(vcap_log, "Captured %u frames, video %lu KiB (%u%% of raw).",
+                vcap_frames, (unsigned long)(vcap_video_bytes / 1024),
+                raw_bytes ? (unsigned int)((vcap_video_bytes * 100) / raw_bytes) : 0);
+
+    vcap_free_buffers();
+
+    soundmovie_stop();
+
+    return 0;
+}
+
+static gfxoutputdrv_t vcap_drv =
+{
+    "VCAP",
+    "VCAP lossless capture",
+    "vcap",
+    NULL, /* formatlist */
+    NULL, /* open */
+    vcapdrv_close,
+    NULL, /* write */
+    vcapdrv_save,
+    NULL,
+    vcapdrv_record,
+    NULL,
+    NULL,
+    NULL
+#ifdef FEATURE_CPUMEMHISTORY
+    , NULL
+#endif
+};
+
+void gfxoutput_init_vcap(int help)
+{
+    if (help) {
+        return;
+    }
+    gfxoutput_register(&vcap_drv);
+}
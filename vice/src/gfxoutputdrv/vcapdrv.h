@@ -0,0 +1,90 @@
+/*
+ * vcapdrv.h - Lossless VICE capture (VCAP) movie driver.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_VCAPDRV_H
+#define VICE_VCAPDRV_H
+
+/* File layout, all values little endian:
+
+   header (VCAP_HEADER_SIZE bytes)
+        0   magic "VICECAP\x1a"
+        8   word   version
+       10   word   header size
+       12   word   frame width
+       14   word   frame height
+       16   dword  cycles per frame
+       20   dword  cycles per second
+       24   dword  audio sample rate (0 = no audio)
+       28   word   audio channels
+       30   word   keyframe interval
+       32   dword  number of frames (0 if the capture was not closed)
+       36   dword  reserved
+       40   qword  offset of the index chunk (0 if the capture was not closed)
+       48   16 bytes machine name, NUL padded
+
+   followed by chunks of a 4 byte id, a dword payload size and the payload:
+
+   "PALT"  word number of entries, followed by RGB triplets. Written before
+           the first frame and whenever the palette changes; the next frame
+           is always a keyframe.
+   "FRAM"  dword frame number, byte frame type, RLE data. The RLE data
+           decodes to width * height palette indices (keyframe) or to the
+           XOR of this frame and the previous one (delta frame).
+   "AUDI"  signed 16 bit samples, channels interleaved.
+   "INDX"  dword number of frames, followed by one entry per frame of
+           VCAP_INDEX_ENTRY_SIZE bytes: qword offset of the FRAM chunk,
+           qword offset of the PALT chunk in effect, dword frame type,
+           dword reserved.
+
+   RLE data is a sequence of
+        0x00-0x7f  n = c + 1 literal bytes follow
+        0x80-0xfe  run of n = c - 0x80 + 3 times the following byte
+        0xff       word n, run of n times the following byte
+*/
+
+#define VCAP_MAGIC              "VICECAP\x1a"
+#define VCAP_MAGIC_LEN          8
+#define VCAP_VERSION            1
+#define VCAP_HEADER_SIZE        64
+#define VCAP_MACHINE_NAME_LEN   16
+
+#define VCAP_CHUNK_HEADER_SIZE  8
+#define VCAP_CHUNK_PALETTE      "PALT"
+#define VCAP_CHUNK_FRAME        "FRAM"
+#define VCAP_CHUNK_AUDIO        "AUDI"
+#define VCAP_CHUNK_INDEX        "INDX"
+
+#define VCAP_FRAME_KEY          0
+#define VCAP_FRAME_DELTA        1
+
+#define VCAP_INDEX_ENTRY_SIZE   24
+
+#define VCAP_RLE_LITERAL_MAX    128
+#define VCAP_RLE_RUN_MIN        3
+#define VCAP_RLE_RUN_MAX        129
+#define VCAP_RLE_LONG_RUN       0xff
+#define VCAP_RLE_LONG_RUN_MAX   0xffff
+
+void gfxoutput_init_vcap(int help);
+
+#endif
@@ -39,6 +39,7 @@
 #include "printer.h"
 #include "via.h"
 #include "types.h"
+#include "vsync.h"
 #include "serial.h"
 #include "drive/iec/cmdhd.h"
 
@@ -246,6 +247,7 @@ static void iecbus_cpu_write_conf1(uint8_t data, CLOCK clock)
 
     if (iec_old_atn != (iecbus.cpu_bus & 0x10)) {
         iec_old_atn = iecbus.cpu_bus & 0x10;
+        vsync_idle_io_activity();
         switch (unit->type) {
             case DRIVE_TYPE_1581:
                 if (!iec_old_atn) {
@@ -309,6 +311,7 @@ static void iecbus_cpu_write_conf2(uint8_t data, CLOCK clock)
 
     if (iec_old_atn != (iecbus.cpu_bus & 0x10)) {
         iec_old_atn = iecbus.cpu_bus & 0x10;
+        vsync_idle_io_activity();
         switch (unit->type) {
             case DRIVE_TYPE_1581:
                 if (!iec_old_atn) {
@@ -374,6 +377,7 @@ static void iecbus_cpu_write_conf3(uint8_t data, CLOCK clock)
 
     if (iec_old_atn != (iecbus.cpu_bus & 0x10)) {
         iec_old_atn = iecbus.cpu_bus & 0x10;
+        vsync_idle_io_activity();
 
         for (dnr = 0; dnr < NUM_DISK_UNITS; dnr++) {
             if (iecbus_device[8 + dnr] == IECBUS_DEVICE_TRUEDRIVE) {
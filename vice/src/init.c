@@ -29,6 +29,7 @@
 
 #include "archdep.h"
 #include "attach.h"
+#include "benchmark.h"
 #include "cmdline.h"
 #include "console.h"
 #include "debug.h"
@@ -49,6 +50,7 @@
 #include "ram.h"
 #include "resources.h"
 #include "romset.h"
+#include "runahead.h"
 #include "screenshot.h"
 #include "signals.h"
 #include "sysfile.h"
@@ -104,6 +106,12 @@ int init_resources(void)
         init_resource_fail("vsync");
         return -1;
     }
+    if (machine_class != VICE_MACHINE_VSID) {
+        if (runahead_resources_init() < 0) {
+            init_resource_fail("run-ahead");
+            return -1;
+        }
+    }
     if (sound_resources_init() < 0) {
         init_resource_fail("sound");
         return -1;
@@ -187,6 +195,16 @@ int init_cmdline_options(void)
         init_cmdline_options_fail("vsync");
         return -1;
     }
+    if (machine_class != VICE_MACHINE_VSID) {
+        if (runahead_cmdline_options_init() < 0) {
+            init_cmdline_options_fail("run-ahead");
+            return -1;
+        }
+        if (benchmark_cmdline_options_init() < 0) {
+            init_cmdline_options_fail("benchmark");
+            return -1;
+        }
+    }
     if (sound_cmdline_options_init() < 0) {
         init_cmdline_options_fail("sound");
         return -1;
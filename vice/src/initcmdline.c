@@ -276,6 +276,9 @@ static int cmdline_chdir(const char *param, void *extra_param)
     return archdep_chdir(param);
 }
 
+/* host time when -limitcycles was given, used for the report on exit */
+static tick_t limitcycles_start_tick;
+
 static int cmdline_limitcycles(const char *param, void *extra_param)
 {
     uint64_t clk_limit = strtoull(param, NULL, 0);
@@ -284,9 +287,40 @@ static int cmdline_limitcycles(const char *param, void *extra_param)
         return -1;
     }
     maincpu_clk_limit = (CLOCK)clk_limit;
+    limitcycles_start_tick = tick_now();
     return 0;
 }
 
+/** \brief  Get the host time since -limitcycles was given
+ *
+ * \return seconds
+ */
+double initcmdline_limitcycles_seconds(void)
+{
+    return (double)tick_now_delta(limitcycles_start_tick) / tick_per_second();
+}
+
+/** \brief  Log the emulation speed when the -limitcycles limit was reached
+ *
+ * Together with -warp this turns any program into a CPU benchmark: the number
+ * of emulated cycles per host second is logged before the emulator exits.
+ * The host time includes emulator startup.
+ */
+void initcmdline_limitcycles_report(void)
+{
+    double seconds = initcmdline_limitcycles_seconds();
+    long cycles_per_second = machine_get_cycles_per_second();
+
+    if (seconds <= 0.0) {
+        return;
+    }
+    log_message(LOG_DEFAULT,
+                "%"PRIu64" cycles in %.3f seconds: %.0f cycles per second"
+                " (%.1f%% of real time).",
+                (uint64_t)maincpu_clk, seconds, (double)maincpu_clk / seconds,
+                (double)maincpu_clk / seconds * 100.0 / cycles_per_second);
+}
+
 static int cmdline_autostart(const char *param, void *extra_param)
 {
     cmdline_free_autostart_string();
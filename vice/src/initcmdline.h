@@ -34,5 +34,7 @@ void initcmdline_check_attach(void);
 int cmdline_get_autostart_mode(void);
 void cmdline_set_autostart_mode(int mode);
 void initcmdline_shutdown(void);
+double initcmdline_limitcycles_seconds(void);
+void initcmdline_limitcycles_report(void);
 
 #endif
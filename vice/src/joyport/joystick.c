@@ -201,6 +201,12 @@ static void joystick_latch_matrix(CLOCK offset)
     }
 }
 
+/* Same for the joystick ports, see keyboard_resync_latch().  */
+void joystick_resync_latch(void)
+{
+    joystick_latch_matrix(0);
+}
+
 /*-----------------------------------------------------------------------*/
 
 static void joystick_event_record(void)
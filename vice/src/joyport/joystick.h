@@ -59,6 +59,7 @@ void joystick_clear_all(void);
 void joystick_event_playback(CLOCK offset, void *data);
 void joystick_event_delayed_playback(void *data);
 void joystick_register_delay(unsigned int delay);
+void joystick_resync_latch(void);
 
 void linux_joystick_init(void);
 void usb_joystick_init(void);
@@ -333,6 +333,13 @@ static void keyboard_latch_matrix(CLOCK offset)
     }
 }
 
+/* Run-ahead loads a machine state from before the latest key presses, make
+   the matrix show them again.  */
+void keyboard_resync_latch(void)
+{
+    keyboard_latch_matrix(0);
+}
+
 /* update keyboard latch, returns 0 on success, -1 on error */
 static int keyboard_set_latch_keyarr(int row, int col, int pressed)
 {
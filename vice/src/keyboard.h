@@ -109,6 +109,7 @@ void keyboard_set_keyarr(int row, int col, int value);
 void keyboard_set_keyarr_any(int row, int col, int value);
 
 void keyboard_clear_keymatrix(void);
+void keyboard_resync_latch(void);
 
 void keyboard_event_playback(CLOCK offset, void *data);
 void keyboard_restore_event_playback(CLOCK offset, void *data);
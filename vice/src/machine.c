@@ -34,6 +34,7 @@
 #include "archdep.h"
 #include "attach.h"
 #include "autostart.h"
+#include "benchmark.h"
 #include "cmdline.h"
 #include "console.h"
 #include "diskimage.h"
@@ -57,9 +58,12 @@
 #include "monitor_network.h"
 #include "monitor_binary.h"
 #include "network.h"
+#include "perfstats.h"
 #include "printer.h"
 #include "resources.h"
+#include "romcache.h"
 #include "romset.h"
+#include "runahead.h"
 #include "screenshot.h"
 #include "sound.h"
 #include "sysfile.h"
@@ -373,8 +377,13 @@ void machine_shutdown(void)
         ui_actions_shutdown();
     }
 
+    romcache_shutdown();
     sysfile_shutdown();
 
+    runahead_shutdown();
+    benchmark_shutdown();
+    perfstats_shutdown();
+
     log_close_all();
 
     event_shutdown();
@@ -35,6 +35,7 @@
 #include "archdep.h"
 #include "autostart.h"
 #include "debug.h"
+#include "initcmdline.h"
 #include "interrupt.h"
 #include "log.h"
 #include "machine.h"
@@ -44,6 +45,7 @@
 #include "snapshot.h"
 #include "traps.h"
 #include "types.h"
+#include "vsync.h"
 #include "wdc65816.h"
 
 #ifndef EXIT_FAILURE
@@ -109,6 +111,10 @@ static void maincpu_generic_dma(void)
 #define CPU_ADDITIONAL_INIT()
 #endif
 
+#ifndef CPU_ADDITIONAL_LIMIT_REPORT
+#define CPU_ADDITIONAL_LIMIT_REPORT()
+#endif
+
 /* ------------------------------------------------------------------------- */
 
 struct interrupt_cpu_status_s *maincpu_int_status = NULL;
@@ -348,10 +354,14 @@ void maincpu_mainloop(void)
 
 #include "65816core.c"
 
+        VSYNC_IDLE_TRACK((reg_pbr << 16) | reg_pc, LOCAL_INTERRUPT());
+
         maincpu_int_status->num_dma_per_opcode = 0;
 
         if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) {
             log_error(LOG_DEFAULT, "cycle limit reached.");
+            initcmdline_limitcycles_report();
+            CPU_ADDITIONAL_LIMIT_REPORT();
             archdep_vice_exit(EXIT_FAILURE);
         }
 
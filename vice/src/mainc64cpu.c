@@ -40,6 +40,7 @@
 #endif
 
 #include "debug.h"
+#include "initcmdline.h"
 #include "interrupt.h"
 #include "machine.h"
 #include "mainc64cpu.h"
@@ -52,6 +53,7 @@
 #include "snapshot.h"
 #include "traps.h"
 #include "types.h"
+#include "vsync.h"
 
 #ifndef EXIT_FAILURE
 #define EXIT_FAILURE 1
@@ -200,6 +202,31 @@ inline static void check_ba(void)
     }
 }
 
+/* Plain RAM and ROM pages are accessed through the base pointer of their
+   page descriptor, everything else through its function. Stealing cycles
+   can switch the memory configuration, so a read must look up the page
+   after check_ba().  */
+inline static uint8_t mem_page_read(unsigned int addr)
+{
+    const mem_page_t *page = &mem_page_tab_ptr[addr >> 8];
+
+    if (page->read_base != NULL) {
+        return page->read_base[addr];
+    }
+    return page->read((uint16_t)addr);
+}
+
+inline static void mem_page_store(unsigned int addr, uint8_t value)
+{
+    const mem_page_t *page = &mem_page_tab_ptr[addr >> 8];
+
+    if (page->store_base != NULL) {
+        page->store_base[addr] = value;
+    } else {
+        page->store((uint16_t)addr, value);
+    }
+}
+
 #ifdef FEATURE_CPUMEMHISTORY
 
 /* FIXME do proper ROM/RAM/IO tests */
@@ -248,7 +275,7 @@ inline static void memmap_mem_update(unsigned int addr, int write)
 static void memmap_mem_store(unsigned int addr, unsigned int value)
 {
     memmap_mem_update(addr, 1);
-    (*_mem_write_tab_ptr[(addr) >> 8])((uint16_t)(addr), (uint8_t)(value));
+    mem_page_store(addr, (uint8_t)value);
 }
 
 static void memmap_mem_store_dummy(unsigned int addr, unsigned int value)
@@ -262,7 +289,7 @@ static uint8_t memmap_mem_read(unsigned int addr)
 {
     check_ba();
     memmap_mem_update(addr, 0);
-    return (*_mem_read_tab_ptr[(addr) >> 8])((uint16_t)(addr));
+    return mem_page_read(addr);
 }
 
 static uint8_t memmap_mem_read_dummy(unsigned int addr)
@@ -346,7 +373,7 @@ static uint8_t memmap_mem_read_dummy(unsigned int addr)
 inline static uint8_t mem_read_check_ba(unsigned int addr)
 {
     check_ba();
-    return (*_mem_read_tab_ptr[(addr) >> 8])((uint16_t)(addr));
+    return mem_page_read(addr);
 }
 
 inline static uint8_t mem_read_check_ba_dummy(unsigned int addr)
@@ -358,7 +385,7 @@ inline static uint8_t mem_read_check_ba_dummy(unsigned int addr)
 #ifndef STORE
 #define STORE(addr, value) \
     if (reu_dma_triggered == 0) { \
-        (*_mem_write_tab_ptr[(addr) >> 8])((uint16_t)(addr), (uint8_t)(value)); \
+        mem_page_store(addr, (uint8_t)(value)); \
         if (addr == 0xff00) { \
             reu_dma(-1); \
         } \
@@ -421,7 +448,7 @@ inline static uint8_t mem_read_check_ba_dummy(unsigned int addr)
 /* Route stack operations through read/write handlers */
 
 #ifndef PUSH
-#define PUSH(val) (*_mem_write_tab_ptr[0x01])((uint16_t)(0x100 + (reg_sp--)), (uint8_t)(val))
+#define PUSH(val) mem_page_store(0x100 + (reg_sp--), (uint8_t)(val))
 #endif
 
 #ifndef PULL
@@ -733,10 +760,13 @@ void maincpu_mainloop(void)
 
 #include "6510dtvcore.c"
 
+        VSYNC_IDLE_TRACK(reg_pc, LOCAL_INTERRUPT());
+
         maincpu_int_status->num_dma_per_opcode = 0;
 
         if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) {
             log_error(LOG_DEFAULT, "cycle limit reached.");
+            initcmdline_limitcycles_report();
             archdep_vice_exit(EXIT_FAILURE);
         }
 
@@ -42,6 +42,7 @@
 #include <pthread.h>
 
 #include "archdep.h"
+#include "benchmark.h"
 #include "debug.h"
 #include "log.h"
 #include "machine.h"
@@ -149,8 +150,12 @@ void mainlock_initiate_shutdown(void)
  */
 void mainlock_yield(void)
 {
+    int benchmark_prev = benchmark_enter(BENCHMARK_UI);
+
     mainlock_yield_begin();
     mainlock_yield_end();
+
+    benchmark_leave(benchmark_prev);
 }
 
 
@@ -191,9 +196,15 @@ void mainlock_yield_end(void)
  */
 void mainlock_yield_and_sleep(tick_t ticks)
 {
+    int benchmark_prev = benchmark_enter(BENCHMARK_UI);
+
     mainlock_yield_begin();
+    benchmark_enter(BENCHMARK_IDLE);
     tick_sleep(ticks);
+    benchmark_enter(BENCHMARK_UI);
     mainlock_yield_end();
+
+    benchmark_leave(benchmark_prev);
 }
 
 /****/
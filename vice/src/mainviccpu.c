@@ -35,6 +35,7 @@
 #include "archdep.h"
 #include "autostart.h"
 #include "debug.h"
+#include "initcmdline.h"
 #include "interrupt.h"
 #include "machine.h"
 #include "maincpu.h"
@@ -44,6 +45,7 @@
 #include "snapshot.h"
 #include "traps.h"
 #include "types.h"
+#include "vsync.h"
 
 #ifndef EXIT_FAILURE
 #define EXIT_FAILURE 1
@@ -538,10 +540,13 @@ void maincpu_mainloop(void)
 
 #include "6510dtvcore.c"
 
+        VSYNC_IDLE_TRACK(reg_pc, LOCAL_INTERRUPT());
+
         maincpu_int_status->num_dma_per_opcode = 0;
 
         if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) {
             log_error(LOG_DEFAULT, "cycle limit reached.");
+            initcmdline_limitcycles_report();
             archdep_vice_exit(EXIT_FAILURE);
         }
 
@@ -336,7 +336,8 @@ static const mon_cmds_t mon_cmd_array[] = {
     { "memmapsave", "mmsave",
       "\"<filename>\" <Format>",
       "Save the memmap as a picture. Format is:\n"
-      "0 = BMP, 1 = PCX, 2 = PNG, 3 = GIF, 4 = IFF.",
+      "0 = BMP, 1 = PCX, 2 = PNG, 3 = GIF, 4 = IFF.\n"
+      "Format 5 (VCAP) only works with screenshot, here it saves a BMP.",
       FILENAME_ARG
     },
 
@@ -780,7 +781,9 @@ static const mon_cmds_t mon_cmd_array[] = {
     { "screenshot", "scrsh",
       "\"<filename>\" [<Format>]",
       "Take a screenshot. Format is:\n"
-      "default = BMP, 1 = PCX, 2 = PNG, 3 = GIF, 4 = IFF.",
+      "default = BMP, 1 = PCX, 2 = PNG, 3 = GIF, 4 = IFF.\n"
+      "Format 5 starts a lossless VCAP capture of every frame instead, which\n"
+      "is stopped by giving the command with format 5 again.",
       FILENAME_ARG
     },
 
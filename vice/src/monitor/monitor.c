@@ -1119,6 +1119,20 @@ void mon_screenshot_save(const char* filename, int format)
         case 4:
             drvname = "IFF";
             break;
+        case 5:
+            /* lossless capture, a second command stops it again */
+            if (screenshot_is_recording_with("VCAP")) {
+                screenshot_stop_recording();
+                mon_out("Capture stopped.\n");
+                return;
+            }
+            if (screenshot_is_recording()) {
+                /* leave a movie that is being recorded alone */
+                mon_out("Another recording is running, stop it first.\n");
+                return;
+            }
+            drvname = "VCAP";
+            break;
         default:
             drvname = "BMP";
             break;
@@ -41,6 +41,7 @@
 #include "monitor.h"
 #include "monitor_binary.h"
 #include "montypes.h"
+#include "perfstats.h"
 #include "resources.h"
 #include "uiapi.h"
 #include "util.h"
@@ -102,6 +103,7 @@ enum t_binary_command {
     e_MON_CMD_REGISTERS_AVAILABLE = 0x83,
     e_MON_CMD_DISPLAY_GET = 0x84,
     e_MON_CMD_VICE_INFO = 0x85,
+    e_MON_CMD_PERFSTATS_GET = 0x86,
 
     e_MON_CMD_PALETTE_GET = 0x91,
 
@@ -150,6 +152,7 @@ enum t_binary_response {
     e_MON_RESPONSE_REGISTERS_AVAILABLE = 0x83,
     e_MON_RESPONSE_DISPLAY_GET = 0x84,
     e_MON_RESPONSE_VICE_INFO = 0x85,
+    e_MON_RESPONSE_PERFSTATS_GET = 0x86,
 
     e_MON_RESPONSE_PALETTE_GET = 0x91,
 
@@ -1403,6 +1406,77 @@ static void monitor_binary_process_vice_info(binary_command_t *command)
     monitor_binary_response(sizeof(response), e_MON_RESPONSE_VICE_INFO, e_MON_ERR_OK, command->request_id, response);
 }
 
+#ifdef USE_PERFSTATS
+/*! \internal \brief Write uint64 to buffer and return pointer to byte after */
+static unsigned char *write_uint64(uint64_t input, unsigned char *output) {
+    write_uint32((uint32_t)input, output);
+    write_uint32((uint32_t)(input >> 32), output + 4);
+
+    return output + 8;
+}
+
+static unsigned char *write_perfstats_counter(const char *name, const perfstats_counter_t *counter, unsigned char *output)
+{
+    int i;
+
+    output = write_string((uint8_t)strlen(name), (unsigned char *)name, output);
+    output = write_uint64(counter->nanoseconds, output);
+    output = write_uint64(counter->switches, output);
+    for (i = 0; i < PERFSTATS_BUCKETS; i++) {
+        output = write_uint32(counter->histogram[i], output);
+    }
+
+    return output;
+}
+#endif
+
+static void monitor_binary_process_perfstats_get(binary_command_t *command)
+{
+#ifdef USE_PERFSTATS
+    perfstats_t stats;
+    unsigned char *response, *response_cursor;
+    uint32_t response_length;
+    int i;
+
+    if (command->length < 1) {
+        monitor_binary_error(e_MON_ERR_CMD_INVALID_LENGTH, command->request_id);
+        return;
+    }
+
+    perfstats_get(&stats);
+    if (command->body[0]) {
+        perfstats_reset();
+    }
+
+    response_length = 2 + 8 + 8 + 8;
+    for (i = 0; i < BENCHMARK_NUM; i++) {
+        response_length += 1 + strlen(benchmark_subsystem_name(i));
+    }
+    response_length += 1 + strlen("frame");
+    response_length += (BENCHMARK_NUM + 1) * (8 + 8 + PERFSTATS_BUCKETS * 4);
+
+    response = lib_malloc(response_length);
+    response_cursor = response;
+
+    *response_cursor++ = BENCHMARK_NUM + 1;
+    *response_cursor++ = PERFSTATS_BUCKETS;
+    response_cursor = write_uint64(stats.frames, response_cursor);
+    response_cursor = write_uint64(stats.cycles, response_cursor);
+    response_cursor = write_uint64(stats.overhead, response_cursor);
+    for (i = 0; i < BENCHMARK_NUM; i++) {
+        response_cursor = write_perfstats_counter(benchmark_subsystem_name(i), &stats.subsystem[i], response_cursor);
+    }
+    write_perfstats_counter("frame", &stats.frame, response_cursor);
+
+    monitor_binary_response(response_length, e_MON_RESPONSE_PERFSTATS_GET, e_MON_ERR_OK, command->request_id, response);
+
+    lib_free(response);
+#else
+    /* not compiled in */
+    monitor_binary_error(e_MON_ERR_CMD_FAILURE, command->request_id);
+#endif
+}
+
 static void monitor_binary_process_mem_get(binary_command_t *command)
 {
     unsigned char *response;
@@ -1614,6 +1688,8 @@ static void monitor_binary_process_command(unsigned char * pbuffer)
         monitor_binary_process_display_get(&command);
     } else if (command_type == e_MON_CMD_VICE_INFO) {
         monitor_binary_process_vice_info(&command);
+    } else if (command_type == e_MON_CMD_PERFSTATS_GET) {
+        monitor_binary_process_perfstats_get(&command);
 
     } else if (command_type == e_MON_CMD_EXIT) {
         monitor_binary_process_exit(&command);
@@ -50,6 +50,8 @@
 #include "mos6510.h"
 #include "network.h"
 #include "resources.h"
+#include "rollback.h"
+#include "snapshot.h"
 #include "types.h"
 #include "uiapi.h"
 #include "util.h"
@@ -90,6 +92,16 @@ static int current_frame, frame_to_play;
 static event_list_state_t *frame_event_list = NULL;
 static char *snapshotfilename;
 
+/* Rollback mode, used instead of the frame delay if the server asks for it */
+static int rollback_frames;
+static rollback_t *rollback = NULL;
+static snapshot_memory_t **rollback_state = NULL;
+static unsigned int rollback_slots;
+static int rollback_warp;
+static int rollback_resimulating;
+static unsigned int rollback_saves, rollback_loads;
+static tick_t rollback_save_ticks, rollback_load_ticks;
+
 static int set_server_name(const char *val, void *param)
 {
     util_string_set(&server_name, val);
@@ -115,6 +127,23 @@ static int set_server_port(int val, void *param)
     return 0;
 }
 
+static int set_rollback_frames(int val, void *param)
+{
+    if (val < 0 || val > ROLLBACK_WINDOW_MAX) {
+        return -1;
+    }
+    /* Going back to a snapshot would leave the VDC as it was, it is not part
+       of the x128 snapshot.  */
+    if (val > 0 && machine_class == VICE_MACHINE_C128) {
+        log_error(LOG_DEFAULT, "netplay: rollback is not available on the C128, the VDC is not saved in snapshots.");
+        return -1;
+    }
+
+    rollback_frames = val;
+
+    return 0;
+}
+
 static int set_network_control(int val, void *param)
 {
     network_control = val;
@@ -140,6 +169,8 @@ static const resource_int_t resources_int[] = {
       &res_server_port, set_server_port, NULL },
     { "NetworkControl", NETWORK_CONTROL_DEFAULT, RES_EVENT_SAME, NULL,
       &network_control, set_network_control, NULL },
+    { "NetworkRollbackFrames", 0, RES_EVENT_NO, NULL,
+      &rollback_frames, set_rollback_frames, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -224,6 +255,9 @@ static const cmdline_option_t cmdline_options[] =
     { "-netplayctrl", CALL_FUNCTION, CMDLINE_ATTRIB_NEED_ARGS,
       network_control_cmd, NULL, NULL, NULL,
       "<key,joy1,joy2,dev,rsrc>", "Set the netplay control elements (keyboard, joystick1, joystick2, devices and resources), each item takes a value (0: None, 1: Server, 2: Client, 3: Both)" },
+    { "-netplayrollback", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "NetworkRollbackFrames", NULL,
+      "<frames>", "Predict the remote input for up to <frames> frames and roll back on a wrong guess instead of delaying all input, the server setting is used (0: off)" },
     CMDLINE_LIST_END
 };
 
@@ -271,7 +305,10 @@ static void network_init_frame_event_list(void)
     frame_buffer_full = 0;
     event_register_event_list(&(frame_event_list[0]));
     event_init_image_list();
-    interrupt_maincpu_trigger_trap(network_event_record_sync_test, (void *)0);
+    /* in rollback mode the state summary travels with every packet */
+    if (rollback == NULL) {
+        interrupt_maincpu_trigger_trap(network_event_record_sync_test, (void *)0);
+    }
 }
 
 static void network_prepare_next_frame(void)
@@ -404,6 +441,302 @@ static int network_send_buffer(vice_network_socket_t * s, const uint8_t *buf, in
     return 0;
 }
 
+/*-------------------------------------------------------------------------*/
+/* Rollback mode: local input takes effect at once, remote input is guessed
+   and the machine is taken back to an in-memory snapshot when the guess was
+   wrong. The frames in between are run again in warp mode. Disk contents are
+   not part of the snapshots and are not rolled back.  */
+
+/* frame, frame of the state summary, state summary */
+#define ROLLBACK_HEADER_SIZE    ((2 + ROLLBACK_SYNC_WORDS) * 4)
+#define ROLLBACK_NO_SYNC        0xffffffff
+
+static int network_rollback_save(void *context, unsigned int slot, uint32_t *sync)
+{
+    tick_t t = tick_now();
+    int ret;
+
+    sync[0] = (uint32_t)maincpu_get_pc();
+    sync[1] = (uint32_t)maincpu_get_a();
+    sync[2] = (uint32_t)maincpu_get_x();
+    sync[3] = (uint32_t)maincpu_get_y();
+    sync[4] = (uint32_t)maincpu_get_sp();
+
+    snapshot_memory_select(rollback_state[slot]);
+    ret = machine_write_snapshot("", 0, 0, 0);
+    snapshot_memory_select(NULL);
+
+    rollback_save_ticks += tick_now_delta(t);
+    rollback_saves++;
+    return ret;
+}
+
+static int network_rollback_load(void *context, unsigned int slot)
+{
+    tick_t t = tick_now();
+    int ret;
+
+    snapshot_memory_select(rollback_state[slot]);
+    ret = machine_read_snapshot("", 0);
+    snapshot_memory_select(NULL);
+
+    rollback_load_ticks += tick_now_delta(t);
+    rollback_loads++;
+    return ret;
+}
+
+static void network_rollback_playback(const uint8_t *buf)
+{
+    event_list_state_t *list;
+
+    if (buf == NULL) {
+        return;
+    }
+    list = network_create_event_list((uint8_t *)buf);
+    event_playback_event_list(list);
+    event_clear_list(list);
+    lib_free(list);
+}
+
+static void network_rollback_apply(void *context,
+                                   const uint8_t *server, size_t server_len,
+                                   const uint8_t *client, size_t client_len)
+{
+    network_rollback_playback(server);
+    network_rollback_playback(client);
+}
+
+static void network_rollback_start(unsigned int window)
+{
+    rollback_ops_t ops;
+    unsigned int i;
+
+    if (window == 0) {
+        return;
+    }
+
+    ops.save = network_rollback_save;
+    ops.load = network_rollback_load;
+    ops.apply = network_rollback_apply;
+    ops.context = NULL;
+
+    rollback = rollback_new(window, network_mode == NETWORK_SERVER_CONNECTED, &ops);
+    if (rollback == NULL) {
+        log_error(LOG_DEFAULT, "netplay: invalid rollback window %u.", window);
+        return;
+    }
+    rollback_slots = rollback_get_slots(rollback);
+    rollback_state = lib_malloc(rollback_slots * sizeof(snapshot_memory_t *));
+    for (i = 0; i < rollback_slots; i++) {
+        rollback_state[i] = snapshot_memory_new();
+    }
+    rollback_warp = vsync_get_warp_mode();
+    rollback_resimulating = 0;
+    rollback_saves = rollback_loads = 0;
+    rollback_save_ticks = rollback_load_ticks = 0;
+
+    /* a single list collects the local input until the next frame */
+    frame_delta = 1;
+}
+
+static void network_rollback_stop(void)
+{
+    rollback_stats_t stats;
+    unsigned int i;
+    double ms = 1000.0 / (double)tick_per_second();
+
+    if (rollback == NULL) {
+        return;
+    }
+
+    rollback_get_stats(rollback, &stats);
+    log_message(LOG_DEFAULT, "netplay: %u frames, %u with predicted input, "
+                "%u rollbacks (at most %u frames), %u frames run again, %u stalls.",
+                stats.frames, stats.predicted, stats.rollbacks, stats.max_depth,
+                stats.resimulated, stats.stalls);
+    if (rollback_saves > 0) {
+        log_message(LOG_DEFAULT, "netplay: snapshot save %.3f ms, load %.3f ms, %lu bytes.",
+                    (double)rollback_save_ticks * ms / rollback_saves,
+                    rollback_loads ? (double)rollback_load_ticks * ms / rollback_loads : 0.0,
+                    (unsigned long)snapshot_memory_size(rollback_state[0]));
+    }
+
+    vsync_set_warp_mode(rollback_warp);
+    for (i = 0; i < rollback_slots; i++) {
+        snapshot_memory_free(rollback_state[i]);
+    }
+    lib_free(rollback_state);
+    rollback_state = NULL;
+    rollback_free(rollback);
+    rollback = NULL;
+}
+
+/* Read one packet from the peer. Returns -1 on error.  */
+static int network_rollback_receive(void)
+{
+    uint8_t recv_len4[4];
+    uint8_t *buf;
+    unsigned int recv_len, frame, sync_frame;
+    uint32_t sync[ROLLBACK_SYNC_WORDS];
+    int i, ret = 0;
+
+    if (network_recv_buffer(network_socket, recv_len4, 4) < 0) {
+        ui_display_statustext("Remote host disconnected.", 1);
+        return -1;
+    }
+    recv_len = util_le_buf4_to_int(recv_len4);
+    if (recv_len == 0) {
+        /* remote host suspended emulation */
+        if (suspended == 0) {
+            ui_display_statustext("Remote host suspending...", 0);
+            suspended = 1;
+            vsync_suspend_speed_eval();
+        }
+        return 0;
+    }
+    if (recv_len < ROLLBACK_HEADER_SIZE) {
+        ui_error("Invalid netplay packet - disconnecting.");
+        return -1;
+    }
+
+    buf = lib_malloc(recv_len);
+    if (network_recv_buffer(network_socket, buf, (int)recv_len) < 0) {
+        ui_display_statustext("Remote host disconnected.", 1);
+        lib_free(buf);
+        return -1;
+    }
+    if (suspended == 1) {
+        ui_display_statustext("", 0);
+        suspended = 0;
+    }
+
+    frame = util_le_buf_to_dword(&buf[0]);
+    sync_frame = util_le_buf_to_dword(&buf[4]);
+    for (i = 0; i < ROLLBACK_SYNC_WORDS; i++) {
+        sync[i] = util_le_buf_to_dword(&buf[8 + i * 4]);
+    }
+
+    if (rollback_add_remote_input(rollback, frame, buf + ROLLBACK_HEADER_SIZE,
+                                  recv_len - ROLLBACK_HEADER_SIZE) < 0) {
+        ui_error("Invalid netplay packet - disconnecting.");
+        ret = -1;
+    } else if (sync_frame != ROLLBACK_NO_SYNC
+               && rollback_check_sync(rollback, sync_frame, sync) < 0) {
+        ui_error("Network out of sync - disconnecting.");
+        ret = -1;
+    }
+    lib_free(buf);
+    return ret;
+}
+
+/* Send the input recorded since the last frame to the peer.  */
+static int network_rollback_send(void)
+{
+    uint8_t *event_buf = NULL;
+    uint8_t *buf;
+    unsigned int event_len = 0, send_len, sync_frame;
+    uint8_t send_len4[4];
+    uint32_t sync[ROLLBACK_SYNC_WORDS];
+    int i, frame, ret;
+
+    network_event_record(EVENT_LIST_END, NULL, 0);
+    if (frame_event_list[0].base->type != EVENT_LIST_END) {
+        event_len = network_create_event_buffer(&event_buf, &(frame_event_list[0]));
+    }
+    event_clear_list(&(frame_event_list[0]));
+    event_register_event_list(&(frame_event_list[0]));
+
+    frame = rollback_add_local_input(rollback, event_buf, event_len);
+    if (frame < 0) {
+        lib_free(event_buf);
+        return -1;
+    }
+
+    if (rollback_get_sync(rollback, &sync_frame, sync) < 0) {
+        sync_frame = ROLLBACK_NO_SYNC;
+        memset(sync, 0, sizeof(sync));
+    }
+
+    send_len = ROLLBACK_HEADER_SIZE + event_len;
+    buf = lib_malloc(send_len);
+    util_dword_to_le_buf(&buf[0], (uint32_t)frame);
+    util_dword_to_le_buf(&buf[4], (uint32_t)sync_frame);
+    for (i = 0; i < ROLLBACK_SYNC_WORDS; i++) {
+        util_dword_to_le_buf(&buf[8 + i * 4], sync[i]);
+    }
+    if (event_len > 0) {
+        memcpy(buf + ROLLBACK_HEADER_SIZE, event_buf, event_len);
+    }
+    lib_free(event_buf);
+
+    util_int_to_le_buf4(send_len4, (int)send_len);
+    ret = network_send_buffer(network_socket, send_len4, 4);
+    if (ret >= 0) {
+        ret = network_send_buffer(network_socket, buf, (int)send_len);
+    }
+    lib_free(buf);
+    if (ret < 0) {
+        ui_display_statustext("Remote host disconnected.", 1);
+    }
+    return ret;
+}
+
+static void network_rollback_trap(uint16_t addr, void *data)
+{
+    int resimulating;
+
+    if (rollback == NULL) {
+        return;
+    }
+    if (rollback_frame(rollback) < 0) {
+        ui_error("Network out of sync - disconnecting.");
+        network_disconnect();
+        return;
+    }
+    resimulating = rollback_is_resimulating(rollback);
+    if (resimulating != rollback_resimulating) {
+        rollback_resimulating = resimulating;
+        vsync_set_warp_mode(resimulating ? 1 : rollback_warp);
+        if (!resimulating) {
+            vsync_suspend_speed_eval();
+        }
+    }
+}
+
+static void network_hook_rollback(void)
+{
+    int stalled = 0;
+
+    /* while frames are run again the input is kept for the next new one */
+    if (!rollback_is_resimulating(rollback)) {
+        if (network_rollback_send() < 0) {
+            network_disconnect();
+            return;
+        }
+    }
+
+    while (vice_network_select_poll_one(network_socket) > 0) {
+        if (network_rollback_receive() < 0) {
+            network_disconnect();
+            return;
+        }
+    }
+
+    /* too far ahead of the peer, wait for its input */
+    while (rollback_must_wait(rollback)) {
+        stalled = 1;
+        if (network_rollback_receive() < 0) {
+            network_disconnect();
+            return;
+        }
+    }
+    if (stalled) {
+        vsync_suspend_speed_eval();
+    }
+
+    interrupt_maincpu_trigger_trap(network_rollback_trap, (void *)0);
+}
+
 #define NUM_OF_TESTPACKETS 50
 
 typedef struct {
@@ -415,6 +748,7 @@ static int network_test_delay(void)
 {
     int i, j, ret = -1;
     uint8_t new_frame_delta = 5; /* default to use on error */
+    uint8_t new_rollback_frames = 0;
     unsigned char *buf;
     testpacket pkt;
 
@@ -461,6 +795,10 @@ static int network_test_delay(void)
         if (network_send_buffer(network_socket, &new_frame_delta, sizeof(new_frame_delta)) < 0) {
             goto exiterror;
         }
+        new_rollback_frames = (uint8_t)rollback_frames;
+        if (network_send_buffer(network_socket, &new_rollback_frames, sizeof(new_rollback_frames)) < 0) {
+            goto exiterror;
+        }
     } else {
         DBG(("network_test_delay (client)"));
         /* network_mode == NETWORK_CLIENT */
@@ -473,14 +811,22 @@ static int network_test_delay(void)
         }
         network_recv_buffer(network_socket, &new_frame_delta,
                             sizeof(new_frame_delta));
+        network_recv_buffer(network_socket, &new_rollback_frames,
+                            sizeof(new_rollback_frames));
     }
     ret = 0;
 exiterror:
     network_free_frame_event_list();
     frame_delta = new_frame_delta;
+    network_rollback_start(new_rollback_frames);
     network_init_frame_event_list();
-    sprintf(st, "Using %d frames delay.", frame_delta);
-    log_debug("netplay connected with %d frames delta.", frame_delta);
+    if (rollback != NULL) {
+        sprintf(st, "Using up to %d frames rollback.", new_rollback_frames);
+        log_debug("netplay connected with %d frames rollback.", new_rollback_frames);
+    } else {
+        sprintf(st, "Using %d frames delay.", frame_delta);
+        log_debug("netplay connected with %d frames delta.", frame_delta);
+    }
     ui_display_statustext(st, 1);
     return ret;
 }
@@ -824,6 +1170,7 @@ int network_connect_client(void)
 void network_disconnect(void)
 {
     DBG(("network_disconnect (network_mode was:%u)", network_mode));
+    network_rollback_stop();
     vice_network_socket_close(network_socket);
     if (network_mode == NETWORK_SERVER_CONNECTED) {
         network_mode = NETWORK_SERVER;
@@ -988,7 +1335,9 @@ void network_hook(void)
         }
     }
 
-    if (network_connected()) {
+    if (network_connected() && rollback != NULL) {
+        network_hook_rollback();
+    } else if (network_connected()) {
         network_hook_connected_send();
         network_hook_connected_receive();
         DBGT(("network_hook timing: %5ld %5ld %5ld; total: %5ld",
@@ -0,0 +1,244 @@
+/** \file   perfstats.c
+ * \brief   Time spent per subsystem, counted as the emulation runs
+ *
+ * Built with --enable-perfstats only. The subsystem markers that drive the
+ * benchmark sampler (see benchmark.h) then also read the host clock at every
+ * boundary and add the time since the previous one to the subsystem that was
+ * busy. That costs a clock read per marker, a lot more than the sampler, but
+ * it works outside of benchmarks too.
+ *
+ * x64sc crosses a boundary several times per emulated cycle, and a clock read
+ * takes about as long as the work in between. What one read costs is
+ * measured once and taken out of every subsystem again, so the shares stay
+ * close to those of an uninstrumented build even though it runs a lot
+ * slower. The time taken out is reported as overhead.
+ *
+ * At the end of each frame the time every subsystem took during the frame
+ * goes into its histogram, so a frame that is slow now and then shows up
+ * even when the totals look fine. The counters can be read with the binary
+ * monitor and are written to the log when the emulator quits.
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#include "vice.h"
+
+#ifdef USE_PERFSTATS
+
+#include <string.h>
+
+#include "archdep.h"
+#include "benchmark.h"
+#include "log.h"
+#include "maincpu.h"
+#include "perfstats.h"
+#include "types.h"
+
+/* clock reads timed when calibrating, the fastest round counts */
+#define PERFSTATS_CALIBRATION_ROUNDS    20
+#define PERFSTATS_CALIBRATION_READS     1000
+
+static perfstats_t stats;
+
+/* time per subsystem including the clock reads, the subsystem counters
+   in stats get it without, one frame at a time */
+static uint64_t gross_ns[BENCHMARK_NUM];
+
+/* nanoseconds one clock read costs, 0 until calibrated */
+static uint64_t read_cost = 0;
+
+/* what is being timed right now, and since when */
+static int current = BENCHMARK_CPU;
+static uint64_t current_since = 0;
+
+/* counters at the start of the frame */
+static uint64_t frame_start = 0;
+static uint64_t frame_start_ns[BENCHMARK_NUM];
+static uint64_t frame_start_switches[BENCHMARK_NUM];
+static CLOCK frame_start_clk;
+
+/* An interrupted round takes longer, so the fastest one is closest to what
+   a read costs while emulating.  */
+static void perfstats_calibrate(void)
+{
+    uint64_t start, took;
+    int round, i;
+
+    read_cost = UINT64_MAX;
+    for (round = 0; round < PERFSTATS_CALIBRATION_ROUNDS; round++) {
+        start = tick_now_nano();
+        for (i = 0; i < PERFSTATS_CALIBRATION_READS; i++) {
+            tick_now_nano();
+        }
+        took = (tick_now_nano() - start) / PERFSTATS_CALIBRATION_READS;
+        if (took < read_cost) {
+            read_cost = took;
+        }
+    }
+    log_message(LOG_DEFAULT, "Perfstats: a clock read takes %"PRIu64" ns.", read_cost);
+}
+
+/* Only called on the emulation thread, like everything else here. */
+void perfstats_switch(int subsystem)
+{
+    uint64_t now = tick_now_nano();
+
+    if (current_since != 0) {
+        gross_ns[current] += now - current_since;
+    } else {
+        perfstats_calibrate();
+        now = tick_now_nano();
+    }
+    current = subsystem;
+    current_since = now;
+    stats.subsystem[subsystem].switches++;
+}
+
+static void perfstats_add_to_histogram(perfstats_counter_t *counter,
+                                       uint64_t nanoseconds)
+{
+    uint64_t us = nanoseconds / 1000;
+    int bucket = 0;
+
+    while (us != 0 && bucket < PERFSTATS_BUCKETS - 1) {
+        us >>= 1;
+        bucket++;
+    }
+    counter->histogram[bucket]++;
+}
+
+/** \brief  Close the books on a frame, called from vsync_do_vsync()
+ */
+void perfstats_frame(void)
+{
+    uint64_t now = tick_now_nano();
+    int i;
+
+    if (current_since == 0) {
+        /* nothing has been marked yet */
+        return;
+    }
+
+    /* charge the running piece of work up to here */
+    gross_ns[current] += now - current_since;
+    current_since = now;
+
+    if (frame_start != 0) {
+        for (i = 0; i < BENCHMARK_NUM; i++) {
+            perfstats_counter_t *counter = &stats.subsystem[i];
+            uint64_t gross = gross_ns[i] - frame_start_ns[i];
+            uint64_t cost = (counter->switches - frame_start_switches[i]) * read_cost;
+            uint64_t net = (gross > cost) ? gross - cost : 0;
+
+            counter->nanoseconds += net;
+            stats.overhead += gross - net;
+            perfstats_add_to_histogram(counter, net);
+        }
+        perfstats_add_to_histogram(&stats.frame, now - frame_start);
+        stats.frame.nanoseconds += now - frame_start;
+        stats.frame.switches++;
+        stats.frames++;
+
+        /* the clock goes back on a reset or snapshot load */
+        if (maincpu_clk > frame_start_clk) {
+            stats.cycles += maincpu_clk - frame_start_clk;
+        }
+    }
+
+    for (i = 0; i < BENCHMARK_NUM; i++) {
+        frame_start_ns[i] = gross_ns[i];
+        frame_start_switches[i] = stats.subsystem[i].switches;
+    }
+    frame_start = now;
+    frame_start_clk = maincpu_clk;
+}
+
+void perfstats_get(perfstats_t *dest)
+{
+    *dest = stats;
+}
+
+void perfstats_reset(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    memset(gross_ns, 0, sizeof(gross_ns));
+    memset(frame_start_ns, 0, sizeof(frame_start_ns));
+    memset(frame_start_switches, 0, sizeof(frame_start_switches));
+    frame_start = 0;
+}
+
+/* Upper end of the bucket that holds the given fraction of the frames. */
+static uint64_t perfstats_percentile_us(const perfstats_counter_t *counter,
+                                        uint64_t frames, double fraction)
+{
+    uint64_t wanted = (uint64_t)(frames * fraction);
+    uint64_t seen = 0;
+    int i;
+
+    for (i = 0; i < PERFSTATS_BUCKETS - 1; i++) {
+        seen += counter->histogram[i];
+        if (seen > wanted) {
+            break;
+        }
+    }
+    return (uint64_t)1 << i;
+}
+
+/* The share is of the time all subsystems took, without the overhead.  */
+static void perfstats_log_counter(const char *name, const perfstats_counter_t *counter,
+                                  uint64_t total)
+{
+    log_message(LOG_DEFAULT,
+                "Perfstats: %-7s %10.3f s %5.1f%% %12"PRIu64" times,"
+                " per frame: 50%% < %"PRIu64" us, 99%% < %"PRIu64" us",
+                name, counter->nanoseconds / 1e9,
+                total ? counter->nanoseconds * 100.0 / total : 0.0,
+                counter->switches,
+                perfstats_percentile_us(counter, stats.frames, 0.5),
+                perfstats_percentile_us(counter, stats.frames, 0.99));
+}
+
+void perfstats_shutdown(void)
+{
+    uint64_t total = 0;
+    int i;
+
+    if (stats.frames == 0) {
+        return;
+    }
+
+    for (i = 0; i < BENCHMARK_NUM; i++) {
+        total += stats.subsystem[i].nanoseconds;
+    }
+
+    log_message(LOG_DEFAULT,
+                "Perfstats: %"PRIu64" frames, %"PRIu64" cycles in %.3f seconds,"
+                " %.3f seconds of them spent timing.",
+                stats.frames, stats.cycles, stats.frame.nanoseconds / 1e9,
+                stats.overhead / 1e9);
+    for (i = 0; i < BENCHMARK_NUM; i++) {
+        perfstats_log_counter(benchmark_subsystem_name(i), &stats.subsystem[i], total);
+    }
+    perfstats_log_counter("frame", &stats.frame, stats.frame.nanoseconds);
+}
+
+#endif /* USE_PERFSTATS */
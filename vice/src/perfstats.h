@@ -0,0 +1,66 @@
+/** \file   perfstats.h
+ * \brief   Time spent per subsystem, counted as the emulation runs
+ */
+
+/*
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_PERFSTATS_H
+#define VICE_PERFSTATS_H
+
+#include "benchmark.h"
+#include "types.h"
+
+/** \brief  Number of buckets in a per frame histogram
+ *
+ * Bucket 0 counts the frames in which less than a microsecond was spent,
+ * bucket n those with 2^(n-1) up to 2^n microseconds, the last bucket
+ * everything above.
+ */
+#define PERFSTATS_BUCKETS   20
+
+/** \brief  Counters of one subsystem, or of whole frames */
+typedef struct perfstats_counter_s {
+    uint64_t nanoseconds;                   /**< host time spent */
+    uint64_t switches;                      /**< times the work started */
+    uint32_t histogram[PERFSTATS_BUCKETS];  /**< time spent per frame */
+} perfstats_counter_t;
+
+typedef struct perfstats_s {
+    uint64_t frames;
+    uint64_t cycles;                        /**< main CPU cycles */
+    uint64_t overhead;                      /**< nanoseconds spent timing */
+    perfstats_counter_t subsystem[BENCHMARK_NUM];
+    perfstats_counter_t frame;              /**< host time per frame */
+} perfstats_t;
+
+#ifdef USE_PERFSTATS
+void perfstats_frame(void);
+void perfstats_get(perfstats_t *stats);
+void perfstats_reset(void);
+void perfstats_shutdown(void);
+#else
+/* the counters are compiled in with --enable-perfstats only */
+#define perfstats_frame()
+#define perfstats_shutdown()
+#endif
+
+#endif
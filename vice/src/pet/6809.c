@@ -26,8 +26,11 @@
 
 #include "6809.h"
 #include "alarm.h"
+#include "archdep_exit.h"
 #include "h6809regs.h"
+#include "initcmdline.h"
 #include "interrupt.h"
+#include "log.h"
 #include "monitor.h"
 #include "petmem.h"
 #include "snapshot.h"
@@ -36,6 +39,10 @@
 static void request_nmi(unsigned int source);
 static void req_irq(unsigned int source);
 
+/* -limitcycles, from maincpu.c; maincpu.h is not included, since it
+   brings in a sync() that clashes with the one below. */
+extern CLOCK maincpu_clk_limit;
+
 #define CLK maincpu_clk
 #define CPU_INT_STATUS maincpu_int_status
 #define ALARM_CONTEXT maincpu_alarm_context
@@ -277,9 +284,26 @@ static void sim_error(const char *format, ...)
     va_end(ap);
 }
 
+/* Open-bus value in petmem.c, kept up to date by the direct reads below. */
+static uint8_t *last_access;
+
+/* Reads of plain RAM/ROM pages go straight to the page; the table is looked
+   up on every access, so bank switches and watchpoints need no extra
+   resync. Everything else goes through the read functions. */
+static inline uint8_t read8_direct(uint16_t addr)
+{
+    uint8_t *p = _mem6809_read_base_tab_ptr[addr >> 8];
+
+    if (p != NULL) {
+        *last_access = p[addr & 0xff];
+        return *last_access;
+    }
+    return read8(addr);
+}
+
 static inline uint8_t imm_byte(void)
 {
-    uint8_t val = read8(PC);
+    uint8_t val = read8_direct(PC);
 
     PC++;
     return val;
@@ -287,8 +311,15 @@ static inline uint8_t imm_byte(void)
 
 static inline uint16_t imm_word(void)
 {
-    uint16_t val = read16(PC);
+    uint8_t *p = _mem6809_read_base_tab_ptr[PC >> 8];
+    uint16_t val;
 
+    if (p != NULL && (PC & 0xff) != 0xff) {
+        *last_access = p[(PC & 0xff) + 1];
+        val = (uint16_t)((p[PC & 0xff] << 8) | *last_access);
+    } else {
+        val = read16(PC);
+    }
     PC += 2;
     return val;
 }
@@ -333,7 +364,7 @@ static void WRMEM32(uint16_t addr, uint32_t data)
 
 static uint8_t RDMEM(uint16_t addr)
 {
-    uint8_t val = read8(addr);
+    uint8_t val = read8_direct(addr);
 
     CLK++;
     return val;
@@ -341,10 +372,10 @@ static uint8_t RDMEM(uint16_t addr)
 
 static uint16_t RDMEM16(uint16_t addr)
 {
-    uint16_t val = read8(addr) << 8;
+    uint16_t val = read8_direct(addr) << 8;
 
     CLK++;
-    val |= read8((uint16_t)(addr + 1));
+    val |= read8_direct((uint16_t)(addr + 1));
     CLK++;
     return val;
 }
@@ -381,7 +412,7 @@ static void write_stack16(uint16_t addr, uint16_t data)
 
 static uint8_t read_stack(uint16_t addr)
 {
-    uint8_t val = read8(addr);
+    uint8_t val = read8_direct(addr);
 
     CLK++;
     return val;
@@ -389,10 +420,10 @@ static uint8_t read_stack(uint16_t addr)
 
 static uint16_t read_stack16(uint16_t addr)
 {
-    uint16_t val = read8(addr) << 8;
+    uint16_t val = read8_direct(addr) << 8;
 
     CLK++;
-    val |= read8((uint16_t)(addr + 1));
+    val |= read8_direct((uint16_t)(addr + 1));
     return val;
 }
 
@@ -2750,6 +2781,8 @@ void h6809_mainloop (struct interrupt_cpu_status_s *maincpu_intstatus, alarm_con
     uint8_t post_byte;
 #endif
 
+    last_access = petmem_last_access_ptr();
+
     do {
 #ifndef CYCLE_EXACT_ALARM
         while (CLK >= alarm_context_next_pending_clk(ALARM_CONTEXT)) {
@@ -5940,6 +5973,12 @@ void h6809_mainloop (struct interrupt_cpu_status_s *maincpu_intstatus, alarm_con
         if (cc_changed) {
             cc_modified();
         }
+
+        if (maincpu_clk_limit && (maincpu_clk > maincpu_clk_limit)) {
+            log_error(LOG_DEFAULT, "cycle limit reached.");
+            initcmdline_limitcycles_report();
+            archdep_vice_exit(1);
+        }
     } while (1);
 
 /* cpu_exit: */
@@ -137,6 +137,10 @@ static int mem6809_read_limit_tab[0x101];
 
 read_func_ptr_t *_mem6809_read_tab_ptr;
 store_func_ptr_t *_mem6809_write_tab_ptr;
+uint8_t **_mem6809_read_base_tab_ptr;
+
+/* No direct pages while watchpoints are active. */
+static uint8_t *_mem6809_read_base_tab_watch[0x101];
 
 static log_t pet_mem_log = LOG_ERR;
 
@@ -632,10 +636,7 @@ static void store_super_io(uint16_t addr, uint8_t value)
                        mem_ram[EXT_RAM + PC]
                   ); */
         }
-        /* else if (spet_bank_4k != old_spet_bank_4k) {
-         *      maincpu_resync_limits(); notyet: 6809 doesn't use bank_base yet.
-         * }
-         */
+        /* No resync on a 4k bank change: $9000-$9FFF has no base pointer. */
     } else {
         if (addr >= 0xeff8) {
             if (!spet_ctrlwp) {
@@ -720,6 +721,13 @@ void mem6809_store(uint16_t addr, uint8_t value)
     _mem6809_write_tab_ptr[addr >> 8](addr, value);
 }
 
+/* The 6809 core reads directly from the pages in _mem6809_read_base_tab_ptr
+   and keeps the open-bus value up to date through this pointer. */
+uint8_t *petmem_last_access_ptr(void)
+{
+    return &last_access;
+}
+
 uint8_t mem6809_read(uint16_t addr)
 {
 #if PRINT_6809_READ
@@ -728,6 +736,12 @@ uint8_t mem6809_read(uint16_t addr)
     printf("mem6809_read   %04x -> %02x\n", addr, v);
     return v;
 #else
+    uint8_t *p = _mem6809_read_base_tab_ptr[addr >> 8];
+
+    if (p != NULL) {
+        last_access = p[addr & 0xff];
+        return last_access;
+    }
     return _mem6809_read_tab_ptr[addr >> 8](addr);
 #endif
 }
@@ -746,6 +760,14 @@ void mem6809_store16(uint16_t addr, uint16_t value)
 uint16_t mem6809_read16(uint16_t addr)
 {
     uint16_t val;
+    uint8_t *p = _mem6809_read_base_tab_ptr[addr >> 8];
+
+    /* Both bytes in the same directly readable page. */
+    if (p != NULL && (addr & 0xff) != 0xff) {
+        last_access = p[(addr & 0xff) + 1];
+        return (uint16_t)((p[addr & 0xff] << 8) | last_access);
+    }
+
     val = _mem6809_read_tab_ptr[addr >> 8](addr) << 8;
     addr++;
     val |= _mem6809_read_tab_ptr[addr >> 8](addr);
@@ -1174,9 +1196,11 @@ void mem_toggle_watchpoints(int flag, void *context)
     if (flag) {
         _mem6809_read_tab_ptr = _mem6809_read_tab_watch;
         _mem6809_write_tab_ptr = _mem6809_write_tab_watch;
+        _mem6809_read_base_tab_ptr = _mem6809_read_base_tab_watch;
     } else {
         _mem6809_read_tab_ptr = _mem6809_read_tab;
         _mem6809_write_tab_ptr = _mem6809_write_tab;
+        _mem6809_read_base_tab_ptr = _mem6809_read_base_tab;
     }
 
     mem_update_tab_ptrs(flag);
@@ -1431,8 +1455,14 @@ static void mem_initialize_memory_6809_banked(void)
     for (i = 0x00; i < 0xa0; i++) {
         _mem6809_read_tab[i] = _mem_read_tab[i];
         _mem6809_write_tab[i] = _mem_write_tab[i];
-        _mem6809_read_base_tab[i] = _mem_read_base_tab[i];
-        mem6809_read_limit_tab[i] = mem_read_limit_tab[i];
+        /* The 6502 view has no base pointers; plain RAM can be read directly. */
+        if (_mem_read_tab[i] == ram_read || _mem_read_tab[i] == zero_read) {
+            _mem6809_read_base_tab[i] = mem_ram + (i << 8);
+            mem6809_read_limit_tab[i] = (i << 8) + 0xfc;
+        } else {
+            _mem6809_read_base_tab[i] = _mem_read_base_tab[i];
+            mem6809_read_limit_tab[i] = mem_read_limit_tab[i];
+        }
     }
     /*
      * Set up the ROMs.
@@ -1440,13 +1470,13 @@ static void mem_initialize_memory_6809_banked(void)
     for (i = 0xa0; i < 0xe8; i++) {
         _mem6809_read_tab[i] = rom6809_read;
         _mem6809_write_tab[i] = store_void;
-        _mem6809_read_base_tab[i] = mem_6809rom + i - (ROM6809_BASE >> 8);
+        _mem6809_read_base_tab[i] = mem_6809rom + (i << 8) - ROM6809_BASE;
         mem6809_read_limit_tab[i] = 0xe7fc;
     }
     for (i = 0xf0; i < 0x100; i++) {
         _mem6809_read_tab[i] = rom6809_read;
         _mem6809_write_tab[i] = store_void;
-        _mem6809_read_base_tab[i] = mem_6809rom + i - (ROM6809_BASE >> 8);
+        _mem6809_read_base_tab[i] = mem_6809rom + (i << 8) - ROM6809_BASE;
         mem6809_read_limit_tab[i] = 0xfffc;
     }
     /*
@@ -1463,8 +1493,6 @@ static void mem_initialize_memory_6809_banked(void)
     _mem6809_write_tab[0x100] = _mem6809_write_tab[0];
     _mem6809_read_base_tab[0x100] = _mem6809_read_base_tab[0];
     mem6809_read_limit_tab[0x100] = -1;
-
-    /* maincpu_resync_limits(); notyet: 6809 doesn't use bank_base yet. */
 }
 
 static void mem_initialize_memory_6809_flat(void)
@@ -1482,7 +1510,6 @@ static void mem_initialize_memory_6809_flat(void)
 
     _mem6809_read_base_tab[0x100] = _mem6809_read_base_tab[0];
     mem6809_read_limit_tab[0x100] = -1;
-    /* maincpu_resync_limits(); notyet: 6809 doesn't use bank_base yet. */
 }
 
 void mem_initialize_memory_6809(void)
@@ -1605,6 +1632,7 @@ void mem_initialize_memory(void)
 
         _mem6809_read_tab_ptr = _mem6809_read_tab;
         _mem6809_write_tab_ptr = _mem6809_write_tab;
+        _mem6809_read_base_tab_ptr = _mem6809_read_base_tab;
     }
 
     maincpu_resync_limits();
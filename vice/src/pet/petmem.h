@@ -89,8 +89,13 @@ extern uint8_t petmem_2001_buf_ef[];
 extern read_func_t mem6809_read;
 extern store_func_t mem6809_store;
 
+/* Per-page pointers for 6809 pages that are plain RAM/ROM, NULL otherwise.
+   Index with addr >> 8, then with addr & 0xff. */
+extern uint8_t **_mem6809_read_base_tab_ptr;
+
 void mem6809_store16(uint16_t addr, uint16_t value);
 uint16_t mem6809_read16(uint16_t addr);
+uint8_t *petmem_last_access_ptr(void);
 
 #ifdef H6309
 void mem6809_store32(uint16_t addr, uint32_t value);
@@ -33,6 +33,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "benchmark.h"
 #include "raster-cache.h"
 #include "raster-canvas.h"
 #include "raster-changes.h"
@@ -650,6 +651,8 @@ inline static void handle_visible_line(raster_t *raster)
 
 void raster_line_emulate(raster_t *raster)
 {
+    int benchmark_prev = benchmark_enter(BENCHMARK_RENDER);
+
     raster_draw_buffer_ptr_update(raster);
 
     /* Emulate the vertical blank flip-flops.  (Well, sort of.)  */
@@ -735,4 +738,6 @@ void raster_line_emulate(raster_t *raster)
     }
 
     raster->blank_this_line = 0;
+
+    benchmark_leave(benchmark_prev);
 }
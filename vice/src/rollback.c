@@ -0,0 +1,374 @@
+/*
+ * rollback.c - Input prediction and rollback for netplay.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * Every frame gets the input of both sides, which is applied at the end of
+ * the frame before it, right after the state was saved. The local input is
+ * always known; when the remote input of a frame has not arrived yet it is
+ * predicted to be empty, which leaves keys and joysticks as they were. Once
+ * the real input arrives and turns out not to be empty, the state saved for
+ * that frame is loaded and the frames since are run again.
+ *
+ * The local side never runs more than `window' frames past the last frame
+ * with known remote input. The peer is bound by the same window, so only
+ * frames between `window' behind and `window' ahead of the current one are
+ * ever looked at, and a ring of 2 * window + 2 entries is enough for the
+ * input as well as for the saved states.
+ */
+
+#include "vice.h"
+
+#include <string.h>
+
+#include "lib.h"
+#include "rollback.h"
+#include "types.h"
+
+typedef struct rollback_entry_s {
+    unsigned int frame;
+    int used;
+
+    uint8_t *local;
+    size_t local_len;
+
+    uint8_t *remote;
+    size_t remote_len;
+    int remote_known;
+
+    /* the last run of the frame had to guess the remote input */
+    int predicted;
+
+    /* summary of the state saved for the frame */
+    uint32_t sync[ROLLBACK_SYNC_WORDS];
+} rollback_entry_t;
+
+struct rollback_s {
+    rollback_ops_t ops;
+    int is_server;
+    unsigned int window;
+    unsigned int slots;
+    rollback_entry_t *entry;
+
+    unsigned int current;   /* frame whose input is applied next */
+    unsigned int live;      /* frames below were run at least once */
+    unsigned int local;     /* local input of frames below was added */
+    unsigned int confirmed; /* remote input of frames below is known */
+    int target;             /* frame to roll back to, -1 if none */
+    unsigned int stalled;   /* frame + 1 of the last stall */
+
+    /* newest frame whose state is final on this side */
+    int have_sync;
+    unsigned int sync_frame;
+    uint32_t sync[ROLLBACK_SYNC_WORDS];
+
+    /* summary sent by the peer for a frame not final here yet */
+    int remote_sync_pending;
+    unsigned int remote_sync_frame;
+    uint32_t remote_sync[ROLLBACK_SYNC_WORDS];
+
+    rollback_stats_t stats;
+};
+
+rollback_t *rollback_new(unsigned int window, int is_server, const rollback_ops_t *ops)
+{
+    rollback_t *rb;
+
+    if (window < 1 || window > ROLLBACK_WINDOW_MAX) {
+        return NULL;
+    }
+
+    rb = lib_calloc(1, sizeof(rollback_t));
+    rb->ops = *ops;
+    rb->is_server = is_server;
+    rb->window = window;
+    rb->slots = 2 * window + 2;
+    rb->entry = lib_calloc(rb->slots, sizeof(rollback_entry_t));
+    rb->target = -1;
+    return rb;
+}
+
+static void rollback_entry_clear(rollback_entry_t *e)
+{
+    lib_free(e->local);
+    lib_free(e->remote);
+    memset(e, 0, sizeof(rollback_entry_t));
+}
+
+void rollback_free(rollback_t *rb)
+{
+    unsigned int i;
+
+    if (rb == NULL) {
+        return;
+    }
+    for (i = 0; i < rb->slots; i++) {
+        rollback_entry_clear(&rb->entry[i]);
+    }
+    lib_free(rb->entry);
+    lib_free(rb);
+}
+
+unsigned int rollback_get_slots(rollback_t *rb)
+{
+    return rb->slots;
+}
+
+unsigned int rollback_get_frame(rollback_t *rb)
+{
+    return rb->current;
+}
+
+/* Entry of a frame, if it is still (or already) in the ring.  */
+static rollback_entry_t *rollback_peek(rollback_t *rb, unsigned int frame)
+{
+    rollback_entry_t *e = &rb->entry[frame % rb->slots];
+
+    return (e->used && e->frame == frame) ? e : NULL;
+}
+
+/* Entry of a frame, reusing the slot of an older one.  */
+static rollback_entry_t *rollback_get(rollback_t *rb, unsigned int frame)
+{
+    rollback_entry_t *e = &rb->entry[frame % rb->slots];
+
+    if (!e->used || e->frame != frame) {
+        rollback_entry_clear(e);
+        e->frame = frame;
+        e->used = 1;
+    }
+    return e;
+}
+
+/* Oldest frame that may still be looked at.  */
+static unsigned int rollback_low(rollback_t *rb)
+{
+    unsigned int low = (rb->confirmed < rb->current) ? rb->confirmed : rb->current;
+
+    if (rb->target >= 0 && (unsigned int)rb->target < low) {
+        low = (unsigned int)rb->target;
+    }
+    return low;
+}
+
+static uint8_t *rollback_copy(const uint8_t *buf, size_t len)
+{
+    uint8_t *copy;
+
+    if (len == 0) {
+        return NULL;
+    }
+    copy = lib_malloc(len);
+    memcpy(copy, buf, len);
+    return copy;
+}
+
+/* Returns the frame the input belongs to.  */
+int rollback_add_local_input(rollback_t *rb, const uint8_t *buf, size_t len)
+{
+    rollback_entry_t *e;
+
+    if (rb->local >= rollback_low(rb) + rb->slots) {
+        return -1;
+    }
+    e = rollback_get(rb, rb->local);
+    lib_free(e->local);
+    e->local = rollback_copy(buf, len);
+    e->local_len = len;
+    return (int)rb->local++;
+}
+
+int rollback_add_remote_input(rollback_t *rb, unsigned int frame, const uint8_t *buf, size_t len)
+{
+    rollback_entry_t *e;
+
+    if (frame < rb->confirmed) {
+        return 0;
+    }
+    /* a well-behaved peer never gets this far ahead */
+    if (frame >= rollback_low(rb) + rb->slots) {
+        return -1;
+    }
+
+    e = rollback_get(rb, frame);
+    if (e->remote_known) {
+        return 0;
+    }
+    e->remote = rollback_copy(buf, len);
+    e->remote_len = len;
+    e->remote_known = 1;
+
+    /* the guess was wrong, go back to the state before the frame */
+    if (frame < rb->current && e->predicted && len > 0) {
+        if (rb->target < 0 || frame < (unsigned int)rb->target) {
+            rb->target = (int)frame;
+        }
+    }
+
+    while ((e = rollback_peek(rb, rb->confirmed)) != NULL && e->remote_known) {
+        rb->confirmed++;
+    }
+    return 0;
+}
+
+/* Summary of the newest state that can no longer change, to be sent to the
+   peer for comparison.  */
+int rollback_get_sync(rollback_t *rb, unsigned int *frame, uint32_t *sync)
+{
+    if (!rb->have_sync) {
+        return -1;
+    }
+    *frame = rb->sync_frame;
+    memcpy(sync, rb->sync, sizeof(rb->sync));
+    return 0;
+}
+
+static int rollback_sync_compare(rollback_t *rb, unsigned int frame, const uint32_t *sync)
+{
+    rollback_entry_t *e;
+
+    e = rollback_peek(rb, frame);
+    if (e == NULL) {
+        /* too old to compare, assume all is well */
+        return 0;
+    }
+    return memcmp(e->sync, sync, sizeof(e->sync)) ? -1 : 0;
+}
+
+/* The state saved for a frame is final once the remote input of all frames
+   before it is known and no rollback to an earlier frame is pending.  */
+static int rollback_sync_is_final(rollback_t *rb, unsigned int frame)
+{
+    return rb->have_sync && frame <= rb->sync_frame
+           && (rb->target < 0 || frame <= (unsigned int)rb->target);
+}
+
+/* Returns -1 if the peer's state differs from the local one.  */
+int rollback_check_sync(rollback_t *rb, unsigned int frame, const uint32_t *sync)
+{
+    if (rollback_sync_is_final(rb, frame)) {
+        return rollback_sync_compare(rb, frame, sync);
+    }
+    rb->remote_sync_pending = 1;
+    rb->remote_sync_frame = frame;
+    memcpy(rb->remote_sync, sync, sizeof(rb->remote_sync));
+    return 0;
+}
+
+int rollback_must_wait(rollback_t *rb)
+{
+    if (rb->current < rb->live || rb->target >= 0) {
+        return 0;
+    }
+    if (rb->current >= rb->confirmed + rb->window) {
+        /* count each frame once, however often the caller asks */
+        if (rb->stalled != rb->current + 1) {
+            rb->stalled = rb->current + 1;
+            rb->stats.stalls++;
+        }
+        return 1;
+    }
+    return 0;
+}
+
+int rollback_is_resimulating(rollback_t *rb)
+{
+    return rb->current < rb->live || rb->target >= 0;
+}
+
+/* Run the end of a frame: roll back if needed, save the state and apply the
+   input of the next frame. Returns -1 on error or when the peer is out of
+   sync.  */
+int rollback_frame(rollback_t *rb)
+{
+    rollback_entry_t *e;
+    unsigned int frame, depth, final;
+    const uint8_t *remote;
+    size_t remote_len;
+
+    if (rb->target >= 0) {
+        frame = (unsigned int)rb->target;
+        if (rb->ops.load(rb->ops.context, frame % rb->slots) < 0) {
+            return -1;
+        }
+        depth = rb->current - frame;
+        rb->stats.rollbacks++;
+        rb->stats.resimulated += depth;
+        if (depth > rb->stats.max_depth) {
+            rb->stats.max_depth = depth;
+        }
+        rb->current = frame;
+        rb->target = -1;
+    }
+
+    frame = rb->current;
+    e = rollback_peek(rb, frame);
+    if (e == NULL || frame >= rb->local) {
+        return -1;
+    }
+
+    if (rb->ops.save(rb->ops.context, frame % rb->slots, e->sync) < 0) {
+        return -1;
+    }
+
+    final = (rb->confirmed < frame) ? rb->confirmed : frame;
+    if (!rb->have_sync || final > rb->sync_frame) {
+        rollback_entry_t *f = rollback_peek(rb, final);
+
+        if (f != NULL) {
+            rb->have_sync = 1;
+            rb->sync_frame = final;
+            memcpy(rb->sync, f->sync, sizeof(rb->sync));
+        }
+    }
+    if (rb->remote_sync_pending && rollback_sync_is_final(rb, rb->remote_sync_frame)) {
+        rb->remote_sync_pending = 0;
+        if (rollback_sync_compare(rb, rb->remote_sync_frame, rb->remote_sync) < 0) {
+            return -1;
+        }
+    }
+
+    remote = e->remote_known ? e->remote : NULL;
+    remote_len = e->remote_known ? e->remote_len : 0;
+    e->predicted = !e->remote_known;
+
+    if (rb->is_server) {
+        rb->ops.apply(rb->ops.context, e->local, e->local_len, remote, remote_len);
+    } else {
+        rb->ops.apply(rb->ops.context, remote, remote_len, e->local, e->local_len);
+    }
+
+    if (frame == rb->live) {
+        rb->stats.frames++;
+        if (e->predicted) {
+            rb->stats.predicted++;
+        }
+        rb->live++;
+    }
+    rb->current++;
+    return 0;
+}
+
+void rollback_get_stats(rollback_t *rb, rollback_stats_t *stats)
+{
+    *stats = rb->stats;
+}
@@ -0,0 +1,81 @@
+/*
+ * rollback.h - Input prediction and rollback for netplay.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_ROLLBACK_H
+#define VICE_ROLLBACK_H
+
+#include <stddef.h>
+
+#include "types.h"
+
+/* Number of words in the state summary used to detect a desync.  */
+#define ROLLBACK_SYNC_WORDS     5
+
+/* Largest number of frames the local side may run ahead of the last frame
+   for which the remote input is known.  */
+#define ROLLBACK_WINDOW_MAX     30
+
+/* The machine side of the rollback. Slots are numbered 0 to
+   rollback_get_slots() - 1; save() stores the current state in a slot and
+   fills in the summary, load() brings a saved state back and apply() feeds
+   the input of one frame to the machine, server input first. An empty
+   input is passed as NULL.  */
+typedef struct rollback_ops_s {
+    int (*save)(void *context, unsigned int slot, uint32_t *sync);
+    int (*load)(void *context, unsigned int slot);
+    void (*apply)(void *context,
+                  const uint8_t *server, size_t server_len,
+                  const uint8_t *client, size_t client_len);
+    void *context;
+} rollback_ops_t;
+
+typedef struct rollback_stats_s {
+    unsigned int frames;            /* frames run, not counting resimulation */
+    unsigned int predicted;         /* frames run with predicted remote input */
+    unsigned int rollbacks;
+    unsigned int resimulated;       /* frames run again after a rollback */
+    unsigned int max_depth;         /* most frames undone by one rollback */
+    unsigned int stalls;            /* frames that had to wait for the peer */
+} rollback_stats_t;
+
+typedef struct rollback_s rollback_t;
+
+rollback_t *rollback_new(unsigned int window, int is_server, const rollback_ops_t *ops);
+void rollback_free(rollback_t *rb);
+
+unsigned int rollback_get_slots(rollback_t *rb);
+unsigned int rollback_get_frame(rollback_t *rb);
+
+int rollback_add_local_input(rollback_t *rb, const uint8_t *buf, size_t len);
+int rollback_add_remote_input(rollback_t *rb, unsigned int frame, const uint8_t *buf, size_t len);
+
+int rollback_get_sync(rollback_t *rb, unsigned int *frame, uint32_t *sync);
+int rollback_check_sync(rollback_t *rb, unsigned int frame, const uint32_t *sync);
+
+int rollback_must_wait(rollback_t *rb);
+int rollback_is_resimulating(rollback_t *rb);
+int rollback_frame(rollback_t *rb);
+
+void rollback_get_stats(rollback_t *rb, rollback_stats_t *stats);
+
+#endif
@@ -0,0 +1,397 @@
+/*
+ * romcache.c - Process wide cache of memory mapped ROM and cartridge images.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* #define DEBUGROMCACHE */
+
+/* for fopencookie() */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "archdep.h"
+#include "lib.h"
+#include "log.h"
+#include "romcache.h"
+#include "types.h"
+
+#ifdef DEBUGROMCACHE
+#define DBG(x)  log_debug x
+#else
+#define DBG(x)
+#endif
+
+/* System ROMs and cartridge images are read again on every machine reset,
+   model change, romset switch and cartridge re-attach. The cache below maps
+   each file once and hands out the mapping on later requests, as long as the
+   size, modification time and inode of the file are unchanged.
+
+   Streams returned by romcache_fopen() read directly from the mapping, so a
+   mapping must stay alive for as long as such a stream is open. Each entry
+   counts its open streams, and an entry that is dropped while it has some
+   (because the file changed, was invalidated or got evicted) is retired and
+   unmapped when the last of them is closed. Eviction never touches the most
+   recently used entries, so a file is still mapped right after it was
+   looked up. */
+
+/* limits before least recently used entries get evicted */
+#define ROMCACHE_MAX_BYTES      (64 * 1024 * 1024)
+#define ROMCACHE_MAX_ENTRIES    256
+
+/* number of most recently used entries that are never evicted */
+#define ROMCACHE_KEEP_RECENT    4
+
+typedef struct romcache_entry_s {
+    char *path;
+    archdep_file_stamp_t stamp;
+    void *data;
+    size_t size;
+    unsigned long last_use;
+    unsigned int users;         /* streams reading from the mapping */
+    int retired;
+    struct romcache_entry_s *next;
+} romcache_entry_t;
+
+static romcache_entry_t *romcache_list = NULL;
+static romcache_entry_t *romcache_retired = NULL;
+
+static unsigned long romcache_clock = 0;
+static size_t romcache_bytes = 0;
+static unsigned int romcache_entries = 0;
+
+static unsigned int romcache_hits = 0;
+static unsigned int romcache_misses = 0;
+
+static log_t romcache_log = LOG_ERR;
+
+
+static void romcache_entry_free(romcache_entry_t *entry)
+{
+    archdep_file_unmap(entry->data, entry->size);
+    lib_free(entry->path);
+    lib_free(entry);
+}
+
+/* Remove an entry from the list. The mapping is kept on the retired list
+   while streams are still reading from it. */
+static void romcache_entry_remove(romcache_entry_t *entry)
+{
+    romcache_entry_t **p;
+
+    for (p = &romcache_list; *p != NULL; p = &(*p)->next) {
+        if (*p == entry) {
+            *p = entry->next;
+            break;
+        }
+    }
+    romcache_bytes -= entry->size;
+    romcache_entries--;
+
+    if (entry->users > 0) {
+        entry->retired = 1;
+        entry->next = romcache_retired;
+        romcache_retired = entry;
+    } else {
+        romcache_entry_free(entry);
+    }
+}
+
+/* Called when a stream on the entry gets closed */
+static void romcache_entry_release(romcache_entry_t *entry)
+{
+    romcache_entry_t **p;
+
+    if (--entry->users > 0 || !entry->retired) {
+        return;
+    }
+    for (p = &romcache_retired; *p != NULL; p = &(*p)->next) {
+        if (*p == entry) {
+            *p = entry->next;
+            break;
+        }
+    }
+    DBG(("romcache: releasing retired `%s'", entry->path));
+    romcache_entry_free(entry);
+}
+
+static romcache_entry_t *romcache_find(const char *path)
+{
+    romcache_entry_t *entry;
+
+    for (entry = romcache_list; entry != NULL; entry = entry->next) {
+        if (strcmp(entry->path, path) == 0) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void romcache_evict(void)
+{
+    while (romcache_entries > ROMCACHE_KEEP_RECENT
+           && (romcache_bytes > ROMCACHE_MAX_BYTES
+               || romcache_entries > ROMCACHE_MAX_ENTRIES)) {
+        romcache_entry_t *entry;
+        romcache_entry_t *oldest = NULL;
+
+        for (entry = romcache_list; entry != NULL; entry = entry->next) {
+            if (entry->last_use + ROMCACHE_KEEP_RECENT <= romcache_clock
+                && (oldest == NULL || entry->last_use < oldest->last_use)) {
+                oldest = entry;
+            }
+        }
+        if (oldest == NULL) {
+            break;
+        }
+        DBG(("romcache: evicting `%s'", oldest->path));
+        romcache_entry_remove(oldest);
+    }
+}
+
+static romcache_entry_t *romcache_lookup(const char *path)
+{
+    romcache_entry_t *entry;
+    archdep_file_stamp_t stamp;
+
+    if (romcache_log == LOG_ERR) {
+        romcache_log = log_open("ROMCache");
+    }
+
+    entry = romcache_find(path);
+
+    if (!archdep_file_stamp(path, &stamp)) {
+        if (entry != NULL) {
+            romcache_entry_remove(entry);
+        }
+        return NULL;
+    }
+
+    if (entry != NULL) {
+        if (archdep_file_stamp_equal(&entry->stamp, &stamp)) {
+            romcache_hits++;
+            entry->last_use = ++romcache_clock;
+            DBG(("romcache: hit `%s'", path));
+            return entry;
+        }
+        DBG(("romcache: `%s' changed on disk", path));
+        romcache_entry_remove(entry);
+    }
+
+    romcache_misses++;
+
+    entry = lib_calloc(1, sizeof *entry);
+    entry->data = archdep_file_map(path, &entry->size);
+    if (entry->data == NULL) {
+        lib_free(entry);
+        return NULL;
+    }
+    entry->path = lib_strdup(path);
+    entry->stamp = stamp;
+    entry->last_use = ++romcache_clock;
+    entry->next = romcache_list;
+    romcache_list = entry;
+    romcache_bytes += entry->size;
+    romcache_entries++;
+
+    DBG(("romcache: mapped `%s' (%lu bytes)", path, (unsigned long)entry->size));
+
+    romcache_evict();
+    return entry;
+}
+
+
+/** \brief  Get the contents of a file from the cache
+ *
+ * The returned data is read-only. It stays valid until the next call into
+ * the cache, which may unmap it.
+ *
+ * \param[in]   path    path of the file
+ * \param[out]  size    size of the file in bytes
+ *
+ * \return  file contents or NULL if the file could not be mapped
+ */
+const uint8_t *romcache_get(const char *path, size_t *size)
+{
+    romcache_entry_t *entry = romcache_lookup(path);
+
+    if (entry == NULL) {
+        return NULL;
+    }
+    *size = entry->size;
+    return entry->data;
+}
+
+
+#ifdef HAVE_FOPENCOOKIE
+/* A stream reading from a mapping, it keeps the entry in use until it
+   is closed. */
+typedef struct romcache_stream_s {
+    romcache_entry_t *entry;
+    size_t pos;
+} romcache_stream_t;
+
+static ssize_t romcache_stream_read(void *cookie, char *buf, size_t size)
+{
+    romcache_stream_t *stream = cookie;
+    size_t left = stream->entry->size - stream->pos;
+
+    if (size > left) {
+        size = left;
+    }
+    memcpy(buf, (const uint8_t *)stream->entry->data + stream->pos, size);
+    stream->pos += size;
+    return (ssize_t)size;
+}
+
+static int romcache_stream_seek(void *cookie, off64_t *offset, int whence)
+{
+    romcache_stream_t *stream = cookie;
+    off64_t pos;
+
+    switch (whence) {
+        case SEEK_SET:
+            pos = *offset;
+            break;
+        case SEEK_CUR:
+            pos = (off64_t)stream->pos + *offset;
+            break;
+        case SEEK_END:
+            pos = (off64_t)stream->entry->size + *offset;
+            break;
+        default:
+            return -1;
+    }
+    if (pos < 0 || pos > (off64_t)stream->entry->size) {
+        return -1;
+    }
+    stream->pos = (size_t)pos;
+    *offset = pos;
+    return 0;
+}
+
+static int romcache_stream_close(void *cookie)
+{
+    romcache_stream_t *stream = cookie;
+
+    romcache_entry_release(stream->entry);
+    lib_free(stream);
+    return 0;
+}
+#endif
+
+
+/** \brief  Open a file for reading through the cache
+ *
+ * Where the host has no fopencookie() or the file cannot be mapped, this is a
+ * plain fopen().
+ *
+ * \param[in]   path    path of the file
+ *
+ * \return  stream or NULL on error
+ */
+FILE *romcache_fopen(const char *path)
+{
+#ifdef HAVE_FOPENCOOKIE
+    romcache_entry_t *entry = romcache_lookup(path);
+
+    if (entry != NULL) {
+        cookie_io_functions_t io = {
+            romcache_stream_read, NULL, romcache_stream_seek, romcache_stream_close
+        };
+        romcache_stream_t *stream = lib_malloc(sizeof *stream);
+        FILE *fd;
+
+        stream->entry = entry;
+        stream->pos = 0;
+        fd = fopencookie(stream, "r", io);
+        if (fd != NULL) {
+            entry->users++;
+            return fd;
+        }
+        lib_free(stream);
+    }
+#endif
+    return fopen(path, MODE_READ);
+}
+
+
+/** \brief  Drop a file from the cache
+ *
+ * Must be called before a file that might be cached gets written to.
+ *
+ * \param[in]   path    path of the file
+ */
+void romcache_invalidate(const char *path)
+{
+    romcache_entry_t *entry = romcache_find(path);
+
+    if (entry != NULL) {
+        DBG(("romcache: invalidating `%s'", path));
+        romcache_entry_remove(entry);
+    }
+}
+
+
+/** \brief  Get number of cache hits and misses
+ *
+ * \param[out]  hits    number of requests served from a valid mapping
+ * \param[out]  misses  number of requests that had to map the file
+ */
+void romcache_get_stats(unsigned int *hits, unsigned int *misses)
+{
+    *hits = romcache_hits;
+    *misses = romcache_misses;
+}
+
+
+/** \brief  Release all mappings
+ */
+void romcache_shutdown(void)
+{
+    romcache_entry_t *entry;
+
+    if (romcache_hits > 0 || romcache_misses > 0) {
+        log_message(romcache_log, "%u hits, %u misses, %u files (%lu bytes) cached.",
+                    romcache_hits, romcache_misses, romcache_entries,
+                    (unsigned long)romcache_bytes);
+    }
+
+    while (romcache_list != NULL) {
+        entry = romcache_list;
+        romcache_list = entry->next;
+        romcache_entry_free(entry);
+    }
+    /* streams still open at this point are never read again */
+    while (romcache_retired != NULL) {
+        entry = romcache_retired;
+        romcache_retired = entry->next;
+        romcache_entry_free(entry);
+    }
+    romcache_bytes = 0;
+    romcache_entries = 0;
+}
@@ -0,0 +1,38 @@
+/*
+ * romcache.h - Process wide cache of memory mapped ROM and cartridge images.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+#ifndef VICE_ROMCACHE_H
+#define VICE_ROMCACHE_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#include "types.h"
+
+const uint8_t *romcache_get(const char *path, size_t *size);
+FILE *romcache_fopen(const char *path);
+void romcache_invalidate(const char *path);
+void romcache_get_stats(unsigned int *hits, unsigned int *misses);
+void romcache_shutdown(void);
+
+#endif
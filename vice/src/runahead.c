@@ -0,0 +1,240 @@
+/*
+ * runahead.c - Hide input latency by showing frames emulated in advance.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * Most programs look at the keyboard and joysticks once per frame, so a key
+ * press shows on screen a frame or two after it happened. With run-ahead,
+ * every frame ends by saving the machine state to memory and emulating the
+ * next `RunAheadFrames' frames without sound, without syncing to the host
+ * and without drawing anything but the last one. Then the saved state is
+ * loaded again, with the latest input put back on top of it, and the real
+ * next frame is run with sound but without being shown.
+ *
+ * The look-ahead frames are thrown away, so the guest never notices; the
+ * cost is that of emulating them plus one snapshot save and load per frame.
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+
+#include "archdep.h"
+#include "cmdline.h"
+#include "interrupt.h"
+#include "joystick.h"
+#include "keyboard.h"
+#include "lib.h"
+#include "log.h"
+#include "machine.h"
+#include "network.h"
+#include "resources.h"
+#include "runahead.h"
+#include "snapshot.h"
+#include "sound.h"
+#include "types.h"
+#include "vice-event.h"
+#include "vsync.h"
+
+static int runahead_frames = 0;
+
+/* 0 while a real frame runs, n while the n-th look-ahead frame runs */
+static int runahead_phase = 0;
+
+/* number of look-ahead frames of the current round */
+static int runahead_depth = 0;
+
+/* set if saving or loading failed, run-ahead stays off from then on */
+static int runahead_failed = 0;
+
+static snapshot_memory_t *runahead_state = NULL;
+
+/* measurements */
+static unsigned long runahead_rounds;
+static tick_t runahead_round_start;
+static uint64_t runahead_round_ticks, runahead_save_ticks, runahead_load_ticks;
+
+static void runahead_log_stats(void)
+{
+    double ms = 1000.0 / (double)tick_per_second();
+
+    if (runahead_rounds == 0) {
+        return;
+    }
+    log_message(LOG_DEFAULT, "%s run-ahead: %lu frames, %.3f ms per frame for "
+                "look-ahead (snapshot save %.3f ms, load %.3f ms, %lu bytes).",
+                machine_get_name(), runahead_rounds,
+                (double)runahead_round_ticks * ms / runahead_rounds,
+                (double)runahead_save_ticks * ms / runahead_rounds,
+                (double)runahead_load_ticks * ms / runahead_rounds,
+                (unsigned long)snapshot_memory_size(runahead_state));
+    runahead_rounds = 0;
+    runahead_round_ticks = runahead_save_ticks = runahead_load_ticks = 0;
+}
+
+static int set_runahead_frames(int val, void *param)
+{
+    if (val < 0 || val > RUNAHEAD_FRAMES_MAX) {
+        return -1;
+    }
+    /* The VDC is not part of the x128 snapshot, so loading the state back
+       would leave the 80 column screen as the look-ahead frames left it.  */
+    if (val > 0 && machine_class == VICE_MACHINE_C128) {
+        log_error(LOG_DEFAULT, "run-ahead: not available on the C128, the VDC is not saved in snapshots.");
+        return -1;
+    }
+    if (val == 0) {
+        runahead_log_stats();
+    }
+    runahead_frames = val;
+    runahead_failed = 0;
+
+    return 0;
+}
+
+static const resource_int_t resources_int[] = {
+    { "RunAheadFrames", 0, RES_EVENT_NO, NULL,
+      &runahead_frames, set_runahead_frames, NULL },
+    RESOURCE_INT_LIST_END
+};
+
+int runahead_resources_init(void)
+{
+    return resources_register_int(resources_int);
+}
+
+static const cmdline_option_t cmdline_options[] =
+{
+    { "-runahead", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
+      NULL, NULL, "RunAheadFrames", NULL,
+      "<frames>", "Show the screen <frames> frames ahead of the emulation to hide input lag (0: off)" },
+    CMDLINE_LIST_END
+};
+
+int runahead_cmdline_options_init(void)
+{
+    return cmdline_register_options(cmdline_options);
+}
+
+void runahead_shutdown(void)
+{
+    runahead_log_stats();
+    snapshot_memory_free(runahead_state);
+    runahead_state = NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Anything that records or shares the input needs to see every frame once
+   and in order.  */
+static int runahead_possible(void)
+{
+    return runahead_frames > 0
+           && !runahead_failed
+           && !vsync_get_warp_mode()
+           && !network_connected()
+           && !event_record_active()
+           && !event_playback_active();
+}
+
+static void runahead_save_trap(uint16_t addr, void *data)
+{
+    tick_t start = tick_now();
+    int ret;
+
+    if (runahead_state == NULL) {
+        runahead_state = snapshot_memory_new();
+    }
+    snapshot_memory_select(runahead_state);
+    ret = machine_write_snapshot("", 0, 0, 0);
+    snapshot_memory_select(NULL);
+
+    if (ret < 0) {
+        log_error(LOG_DEFAULT, "run-ahead: cannot save the machine state, disabled.");
+        runahead_failed = 1;
+        return;
+    }
+
+    runahead_save_ticks += tick_now_delta(start);
+    runahead_round_start = start;
+
+    sound_set_runahead_mode(1);
+    runahead_depth = runahead_frames;
+    runahead_phase = 1;
+}
+
+static void runahead_load_trap(uint16_t addr, void *data)
+{
+    tick_t start = tick_now();
+    int ret;
+
+    sound_set_runahead_mode(0);
+
+    snapshot_memory_select(runahead_state);
+    ret = machine_read_snapshot("", 0);
+    snapshot_memory_select(NULL);
+
+    runahead_phase = 0;
+
+    if (ret < 0) {
+        log_error(LOG_DEFAULT, "run-ahead: cannot load the machine state, disabled.");
+        runahead_failed = 1;
+        return;
+    }
+
+    /* input that arrived during the look-ahead frames must not get lost */
+    keyboard_resync_latch();
+    joystick_resync_latch();
+
+    runahead_load_ticks += tick_now_delta(start);
+    runahead_round_ticks += tick_now_delta(runahead_round_start);
+    runahead_rounds++;
+}
+
+/* Called at the end of every frame.  */
+void runahead_vsync(void)
+{
+    if (runahead_phase == 0) {
+        if (runahead_possible()) {
+            interrupt_maincpu_trigger_trap(runahead_save_trap, NULL);
+        }
+    } else if (runahead_phase < runahead_depth) {
+        runahead_phase++;
+    } else {
+        interrupt_maincpu_trigger_trap(runahead_load_trap, NULL);
+    }
+}
+
+int runahead_is_ahead(void)
+{
+    return runahead_phase > 0;
+}
+
+/* Only the last look-ahead frame is shown; the real frames are not, unless
+   run-ahead is off.  */
+int runahead_should_skip_frame(void)
+{
+    if (runahead_phase > 0) {
+        return runahead_phase != runahead_depth;
+    }
+    return runahead_possible();
+}
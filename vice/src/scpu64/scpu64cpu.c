@@ -32,6 +32,8 @@
 #include "interrupt.h"
 #include "6510core.h"
 #include "alarm.h"
+#include "initcmdline.h"
+#include "log.h"
 #include "main65816cpu.h"
 #include "mem.h"
 #include "scpu64mem.h"
@@ -74,6 +76,11 @@ alarm_context_t *maincpu_alarm_context = NULL;
 int maincpu_ba_low_flags = 0;
 static CLOCK maincpu_ba_low_start = 0;
 
+#ifdef USE_PERFSTATS
+/* Number of 65816 cycles executed, for the -limitcycles report */
+static uint64_t scpu64_cpu_cycles = 0;
+#endif
+
 CLOCK scpu64_get_half_cycle(void)
 {
     if (scpu64_fastmode) {
@@ -124,6 +131,9 @@ static inline void scpu64_maincpu_inc(void)
 
 static inline void scpu64_clock_inc(int write)
 {
+#ifdef USE_PERFSTATS
+    scpu64_cpu_cycles++;
+#endif
     if (scpu64_fastmode) {
         maincpu_accu += maincpu_diff;
         if (maincpu_accu > 20000000) {
@@ -354,6 +364,8 @@ static inline void store_long(uint32_t addr, uint8_t value)
 {
     if (addr & ~0xffff) {
         mem_store2(addr, value);
+    } else if (scpu64_fastmode && mem_write_fast_tab[addr >> 8] != NULL) {
+        mem_write_fast_tab[addr >> 8][addr] = value;
     } else {
         (*_mem_write_tab_ptr[addr >> 8])((uint16_t)addr, value);
     }
@@ -368,6 +380,8 @@ static inline uint8_t load_long(uint32_t addr)
 
     if ((addr) & ~0xffff) {
         tmp = mem_read2(addr);
+    } else if (scpu64_fastmode && mem_read_fast_tab[addr >> 8] != NULL) {
+        tmp = mem_read_fast_tab[addr >> 8][addr];
     } else {
         tmp = (*_mem_read_tab_ptr[(addr) >> 8])((uint16_t)addr);
     }
@@ -375,6 +389,18 @@ static inline uint8_t load_long(uint32_t addr)
     return tmp;
 }
 
+#ifdef USE_PERFSTATS
+static void scpu64_limitcycles_report(void)
+{
+    double seconds = initcmdline_limitcycles_seconds();
+
+    if (seconds > 0.0) {
+        log_message(LOG_DEFAULT, "%"PRIu64" 65816 cycles: effective %.2f MHz.",
+                    scpu64_cpu_cycles, (double)scpu64_cpu_cycles / seconds / 1000000.0);
+    }
+}
+#endif
+
 int scpu64_snapshot_write_cpu_state(snapshot_module_t *m)
 {
     return SMW_B(m, scpu64_fastmode) < 0
@@ -400,6 +426,10 @@ int scpu64_snapshot_read_cpu_state(snapshot_module_t *m)
 
 #define CLK_INC(clock) scpu64_clock_inc(0)
 
+#ifdef USE_PERFSTATS
+#define CPU_ADDITIONAL_LIMIT_REPORT() scpu64_limitcycles_report()
+#endif
+
 #define CPU_ADDITIONAL_RESET() (buffer_finish = maincpu_clk, buffer_finish_half = 0, maincpu_accu = 0, maincpu_diff = (CLOCK)machine_get_cycles_per_second())
 
 #define FETCH_PARAM(addr) ((((int)(addr)) < bank_limit) ? (check_ba(), scpu64_clock_inc(0), bank_base[addr]) : LOAD_PBR(addr))
@@ -121,6 +121,11 @@ static uint32_t mem_read_limit_tab[NUM_CONFIGS][0x101];
 static store_func_ptr_t mem_write_tab_watch[0x101];
 static read_func_ptr_t mem_read_tab_watch[0x101];
 
+/* Direct pointers for the bank 0 pages of the current configuration that
+   are plain SRAM, see mem_update_fast_tabs().  */
+uint8_t *mem_read_fast_tab[0x100];
+uint8_t *mem_write_fast_tab[0x100];
+
 /* Current mirror config */
 static int mirror;
 
@@ -188,6 +193,8 @@ static void store_watch(uint16_t addr, uint8_t value)
     mem_write_tab[mirror][mem_config][addr >> 8](addr, value);
 }
 
+static void mem_update_fast_tabs(void);
+
 void mem_toggle_watchpoints(int flag, void *context)
 {
     if (flag) {
@@ -198,6 +205,7 @@ void mem_toggle_watchpoints(int flag, void *context)
         _mem_write_tab_ptr = mem_write_tab[mirror][mem_config];
     }
     watchpoints_active = flag;
+    mem_update_fast_tabs();
 }
 
 /* ------------------------------------------------------------------------- */
@@ -224,6 +232,7 @@ void mem_pla_config_changed(void)
     _mem_read_base_tab_ptr = mem_read_base_tab[mem_config];
     mem_read_limit_tab_ptr = mem_read_limit_tab[mem_config];
 
+    mem_update_fast_tabs();
     maincpu_resync_limits();
 }
 
@@ -1361,6 +1370,40 @@ void mem_initialize_memory(void)
     cartridge_init_config();
 }
 
+/* Collect the pages that the CPU can access without calling the read or
+   write function. These are the pages handled by the plain SRAM functions,
+   whose only side effect is the BA check in 1MHz mode, so the CPU must
+   only use the tables in fast mode. Pages mirrored to the C64 RAM keep
+   their store function, which updates both copies and stretches the
+   clock. Nothing is cached while watchpoints are active.  */
+static void mem_update_fast_tabs(void)
+{
+    int i;
+
+    for (i = 0; i < 0x100; i++) {
+        read_func_ptr_t rf = mem_read_tab[mem_config][i];
+        store_func_ptr_t wf = mem_write_tab[mirror][mem_config][i];
+
+        if (watchpoints_active) {
+            mem_read_fast_tab[i] = NULL;
+            mem_write_fast_tab[i] = NULL;
+            continue;
+        }
+
+        if (rf == ram_read) {
+            mem_read_fast_tab[i] = mem_sram;
+        } else if (rf == ram1_read) {
+            mem_read_fast_tab[i] = mem_sram + 0x10000;
+        } else if (rf == scpu64_kernalshadow_read) {
+            mem_read_fast_tab[i] = mem_sram + 0x8000;
+        } else {
+            mem_read_fast_tab[i] = NULL;
+        }
+
+        mem_write_fast_tab[i] = (wf == ram_store) ? mem_sram : NULL;
+    }
+}
+
 void mem_mmu_translate(unsigned int addr, uint8_t **base, int *start, int *limit)
 {
     uint8_t *p;
@@ -1443,6 +1486,7 @@ void mem_set_mirroring(int new_mirroring)
     if (_mem_write_tab_ptr != mem_write_tab_watch) {
         _mem_write_tab_ptr = mem_write_tab[mirror][mem_config];
     }
+    mem_update_fast_tabs();
 }
 
 void mem_set_simm(int config)
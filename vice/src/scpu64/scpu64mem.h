@@ -136,6 +136,11 @@ uint8_t read_bank_io(uint16_t addr);
 void mem_store2(uint32_t addr, uint8_t value);
 uint8_t mem_read2(uint32_t addr);
 
+/* Bank 0 pages that may be accessed directly in fast mode, NULL otherwise.
+   The pointers are to be indexed with the full 16 bit address.  */
+extern uint8_t *mem_read_fast_tab[0x100];
+extern uint8_t *mem_write_fast_tab[0x100];
+
 void scpu64_mem_init(void);
 
 void scpu64_hardware_reset(void);
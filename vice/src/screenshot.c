@@ -278,6 +278,13 @@ int screenshot_is_recording(void)
     return (recording_driver == NULL ? 0 : 1);
 }
 
+/* Is a recording with the named driver running, as opposed to any recording? */
+int screenshot_is_recording_with(const char *drvname)
+{
+    return recording_driver != NULL
+           && recording_driver == gfxoutput_get_driver(drvname);
+}
+
 void screenshot_prepare_reopen(void)
 {
     reopen = (screenshot_is_recording() ? 1 : 0);
@@ -130,6 +130,7 @@ int screenshot_save(const char *drvname, const char *filename, struct video_canv
 int screenshot_record(void);
 void screenshot_stop_recording(void);
 int screenshot_is_recording(void);
+int screenshot_is_recording_with(const char *drvname);
 void screenshot_prepare_reopen(void);
 void screenshot_try_reopen(void);
 
@@ -39,6 +39,7 @@
 #include "serial-trap.h"
 #include "serial.h"
 #include "types.h"
+#include "vsync.h"
 
 #ifdef DEBUG_SERIAL
 #include "log.h"
@@ -136,6 +137,8 @@ int serial_trap_attention(void)
 
     iecdata = mem_read(((uint8_t)(BSOUR))); /* BSOUR - character for serial bus */
 
+    vsync_idle_io_activity();
+
     if ((iecdata == UNLISTEN) || (iecdata == UNTALK)) {
         /* transfer ends */
         DBG(("serial_trap_attention unlisten/untalk for device %d", ActiveDevice));
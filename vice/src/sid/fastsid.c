@@ -675,19 +675,16 @@ inline static void setup_voice(voice_t *pv)
     pv->gateflip = 0;
 }
 
-static int16_t fastsid_calculate_single_sample(sound_t *psid, int i)
+/* Advance all three voices by one sample and mix them. The register
+   state does not change while a batch of samples is rendered, so
+   setup_sid() and setup_voice() are called by the caller once per batch.
+   filter and has3 are constant in each of the specialised loops below,
+   which lets the compiler drop the unused paths. */
+static inline int16_t fastsid_next_sample(sound_t *psid, voice_t *v0, voice_t *v1, voice_t *v2,
+                                          const int filter, const int has3)
 {
     uint32_t o0, o1, o2;
     int dosync1, dosync2;
-    voice_t *v0, *v1, *v2;
-
-    setup_sid(psid);
-    v0 = &psid->v[0];
-    setup_voice(v0);
-    v1 = &psid->v[1];
-    setup_voice(v1);
-    v2 = &psid->v[2];
-    setup_voice(v2);
 
     /* addfptrs, noise & hard sync test */
     dosync1 = 0;
@@ -744,13 +741,13 @@ static int16_t fastsid_calculate_single_sample(sound_t *psid, int i)
     if (o1) {
         o1 *= doosc(v1);
     }
-    if (psid->has3 && o2) {
+    if (has3 && o2) {
         o2 *= doosc(v2);
     } else {
         o2 = 0;
     }
     /* sample */
-    if (psid->emulatefilter) {
+    if (filter) {
         v0->filtIO = ampMod1x8[(o0 >> 22)];
         dofilter(v0);
         o0 = ((uint32_t)(v0->filtIO) + 0x80) << (7 + 15);
@@ -765,22 +762,51 @@ static int16_t fastsid_calculate_single_sample(sound_t *psid, int i)
     return (int16_t)(((int32_t)((o0 + o1 + o2) >> 20) - 0x600) * psid->vol);
 }
 
+#define FASTSID_RENDER_LOOP(filter, has3)                                   \
+    for (i = 0; i < n; i++) {                                               \
+        out[i * interleave] = fastsid_next_sample(psid, v0, v1, v2,         \
+                                                  filter, has3);            \
+    }
+
+/* Render n samples for one SID into out. */
+static void fastsid_render(sound_t *psid, int16_t *out, int n, int interleave)
+{
+    int i;
+    voice_t *v0 = &psid->v[0];
+    voice_t *v1 = &psid->v[1];
+    voice_t *v2 = &psid->v[2];
+
+    setup_sid(psid);
+    setup_voice(v0);
+    setup_voice(v1);
+    setup_voice(v2);
+
+    if (psid->emulatefilter) {
+        if (psid->has3) {
+            FASTSID_RENDER_LOOP(1, 1);
+        } else {
+            FASTSID_RENDER_LOOP(1, 0);
+        }
+    } else {
+        if (psid->has3) {
+            FASTSID_RENDER_LOOP(0, 1);
+        } else {
+            FASTSID_RENDER_LOOP(0, 0);
+        }
+    }
+}
+
 static int fastsid_calculate_samples(sound_t *psid, int16_t *pbuf, int nr,
                                      int interleave, CLOCK *delta_t)
 {
-    int i;
     int16_t *tmp_buf;
 
     if (psid->factor == 1000) {
-        for (i = 0; i < nr; i++) {
-            pbuf[i * interleave] = fastsid_calculate_single_sample(psid, i);
-        }
+        fastsid_render(psid, pbuf, nr, interleave);
         return nr;
     }
     tmp_buf = getbuf(2 * nr * psid->factor / 1000);
-    for (i = 0; i < (nr * psid->factor / 1000); i++) {
-        tmp_buf[i * interleave] = fastsid_calculate_single_sample(psid, i);
-    }
+    fastsid_render(psid, tmp_buf, nr * psid->factor / 1000, interleave);
     memcpy(pbuf, tmp_buf, 2 * nr);
     return nr;
 }
@@ -228,6 +228,33 @@ fail:
     return -1;
 }
 
+/* Reopening the sound device for a memory snapshot is only needed when the
+   settings were changed since it was taken.  */
+static int sid_snapshot_config_changed(int sids, int sound, int engine, int model)
+{
+    int cur_sids, cur_sound, cur_engine, cur_model;
+
+    if (0
+        || resources_get_int("SidStereo", &cur_sids) < 0
+        || resources_get_int("Sound", &cur_sound) < 0
+        || resources_get_int("SidEngine", &cur_engine) < 0
+        || resources_get_int("SidModel", &cur_model) < 0) {
+        return 1;
+    }
+    return sids != cur_sids || sound != cur_sound || engine != cur_engine
+           || (model >= 0 && model != cur_model);
+}
+
+static int sid_snapshot_address_changed(int sidnr, int sid_address)
+{
+    int cur_address;
+
+    if (resources_get_int_sprintf("Sid%dAddressStart", &cur_address, sidnr + 1) < 0) {
+        return 1;
+    }
+    return sid_address != cur_address;
+}
+
 static int sid_snapshot_read_module_simple(snapshot_t *s, int sidnr)
 {
     uint8_t major_version, minor_version;
@@ -236,6 +263,7 @@ static int sid_snapshot_read_module_simple(snapshot_t *s, int sidnr)
     const char *snap_module_name_simple = NULL;
     int sids = 0;
     int sid_address;
+    int model;
 
     switch (sidnr) {
         default:
@@ -279,45 +307,57 @@ static int sid_snapshot_read_module_simple(snapshot_t *s, int sidnr)
 
     /* Handle 1.3+ snapshots differently */
     if (!snapshot_version_is_smaller(major_version, minor_version, 1, 3)) {
+        int reconfigure;
+
         if (sidnr == 0) {
             if (SMR_B_INT(m, &sids) < 0) {
                 goto fail;
             }
-            resources_set_int("SidStereo", sids);
             if (0
                 || SMR_B(m, &tmp[0]) < 0
                 || SMR_B(m, &tmp[1]) < 0) {
                 goto fail;
             }
-            screenshot_prepare_reopen();
-            sound_close();
-            screenshot_try_reopen();
-            resources_set_int("Sound", (int)tmp[0]);
-
-            intended_sid_engine = tmp[1];
-            set_sid_engine_with_fallback(tmp[1]);
-
+            model = -1;
             if (!snapshot_version_is_smaller(major_version, minor_version, 1, 4)) {
-                if (0
-                    || SMR_B(m, &tmp[0]) < 0) {
+                if (SMR_B_INT(m, &model) < 0) {
                     goto fail;
                 }
-                resources_set_int("SidModel", (int)tmp[0]);
+            }
+            reconfigure = !snapshot_is_memory(s)
+                          || sid_snapshot_config_changed(sids, tmp[0], tmp[1], model);
+            if (reconfigure) {
+                resources_set_int("SidStereo", sids);
+                screenshot_prepare_reopen();
+                sound_close();
+                screenshot_try_reopen();
+                resources_set_int("Sound", (int)tmp[0]);
+
+                intended_sid_engine = tmp[1];
+                set_sid_engine_with_fallback(tmp[1]);
+
+                if (model >= 0) {
+                    resources_set_int("SidModel", model);
+                }
             }
         } else {
             if (SMR_W_INT(m, &sid_address) < 0) {
                 goto fail;
             }
-        }
-        if (sidnr >= 1) {
-            resources_set_int("Sid2AddressStart", sid_address);
-            resources_set_int_sprintf("Sid%dAddressStart", sid_address, sidnr + 1);
+            reconfigure = !snapshot_is_memory(s)
+                          || sid_snapshot_address_changed(sidnr, sid_address);
+            if (reconfigure) {
+                resources_set_int("Sid2AddressStart", sid_address);
+                resources_set_int_sprintf("Sid%dAddressStart", sid_address, sidnr + 1);
+            }
         }
         if (SMR_BA(m, tmp + 2, 32) < 0) {
             goto fail;
         }
         memcpy(sid_get_siddata(sidnr), &tmp[2], 32);
-        sound_open();
+        if (reconfigure) {
+            sound_open();
+        }
         return snapshot_module_close(m);
     }
 
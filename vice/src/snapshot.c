@@ -67,10 +67,26 @@ static const char snapshot_version_magic_string[] = "VICE Version\032";
 #define SNAPSHOT_MAGIC_LEN              19
 #define SNAPSHOT_VERSION_MAGIC_LEN      13
 
-struct snapshot_module_s {
-    /* File descriptor.  */
+/* A snapshot is either a file or a memory buffer.  */
+typedef struct snapshot_stream_s {
+    /* File descriptor, NULL for memory snapshots.  */
     FILE *file;
 
+    /* Buffer and position for memory snapshots.  */
+    snapshot_memory_t *mem;
+    size_t pos;
+} snapshot_stream_t;
+
+struct snapshot_memory_s {
+    uint8_t *data;
+    size_t size;
+    size_t alloc;
+};
+
+struct snapshot_module_s {
+    /* Stream of the snapshot.  */
+    snapshot_stream_t *file;
+
     /* Flag: are we writing it?  */
     int write_mode;
 
@@ -85,8 +101,8 @@ struct snapshot_module_s {
 };
 
 struct snapshot_s {
-    /* File descriptor.  */
-    FILE *file;
+    /* Stream of the snapshot.  */
+    snapshot_stream_t *file;
 
     /* Offset of the first module.  */
     long first_module_offset;
@@ -95,12 +111,120 @@ struct snapshot_s {
     int write_mode;
 };
 
+/* Memory buffer used by snapshot_create() and snapshot_open() instead of the
+   named file, see snapshot_memory_select().  */
+static snapshot_memory_t *memory_target = NULL;
+
 /* ------------------------------------------------------------------------- */
 
-static int snapshot_write_byte(FILE *f, uint8_t data)
+static int stream_putc(snapshot_stream_t *f, uint8_t c)
+{
+    snapshot_memory_t *mem = f->mem;
+
+    if (mem == NULL) {
+        return fputc(c, f->file);
+    }
+
+    if (f->pos >= mem->alloc) {
+        mem->alloc = mem->alloc ? mem->alloc * 2 : 0x10000;
+        mem->data = lib_realloc(mem->data, mem->alloc);
+    }
+    mem->data[f->pos++] = c;
+    if (f->pos > mem->size) {
+        mem->size = f->pos;
+    }
+    return c;
+}
+
+static int stream_getc(snapshot_stream_t *f)
+{
+    if (f->mem == NULL) {
+        return fgetc(f->file);
+    }
+
+    if (f->pos >= f->mem->size) {
+        return EOF;
+    }
+    return f->mem->data[f->pos++];
+}
+
+/* Like fwrite() with a single item: returns 1 on success.  */
+static size_t stream_write(snapshot_stream_t *f, const void *data, size_t num)
+{
+    snapshot_memory_t *mem = f->mem;
+
+    if (mem == NULL) {
+        return fwrite(data, num, 1, f->file);
+    }
+
+    if (f->pos + num > mem->alloc) {
+        if (mem->alloc == 0) {
+            mem->alloc = 0x10000;
+        }
+        while (f->pos + num > mem->alloc) {
+            mem->alloc *= 2;
+        }
+        mem->data = lib_realloc(mem->data, mem->alloc);
+    }
+    memcpy(mem->data + f->pos, data, num);
+    f->pos += num;
+    if (f->pos > mem->size) {
+        mem->size = f->pos;
+    }
+    return 1;
+}
+
+static size_t stream_read(snapshot_stream_t *f, void *data, size_t num)
+{
+    if (f->mem == NULL) {
+        return fread(data, num, 1, f->file);
+    }
+
+    if (f->pos + num > f->mem->size) {
+        f->pos = f->mem->size;
+        return 0;
+    }
+    memcpy(data, f->mem->data + f->pos, num);
+    f->pos += num;
+    return 1;
+}
+
+static long stream_tell(snapshot_stream_t *f)
+{
+    if (f->mem == NULL) {
+        return ftell(f->file);
+    }
+    return (long)f->pos;
+}
+
+static int stream_seek(snapshot_stream_t *f, long offset)
 {
-    current_fpos = ftell(f);
-    if (fputc(data, f) == EOF) {
+    if (f->mem == NULL) {
+        return fseek(f->file, offset, SEEK_SET);
+    }
+    if (offset < 0) {
+        return -1;
+    }
+    f->pos = (size_t)offset;
+    return 0;
+}
+
+static snapshot_stream_t *stream_new(FILE *file)
+{
+    snapshot_stream_t *f = lib_malloc(sizeof(snapshot_stream_t));
+
+    f->file = file;
+    f->mem = file ? NULL : memory_target;
+    f->pos = 0;
+    return f;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int snapshot_write_byte(snapshot_stream_t *f, uint8_t data)
+{
+    current_fpos = stream_tell(f);
+    if (stream_putc(f, data) == EOF) {
         snapshot_error = SNAPSHOT_WRITE_EOF_ERROR;
         return -1;
     }
@@ -108,9 +232,9 @@ static int snapshot_write_byte(FILE *f, uint8_t data)
     return 0;
 }
 
-static int snapshot_write_word(FILE *f, uint16_t data)
+static int snapshot_write_word(snapshot_stream_t *f, uint16_t data)
 {
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     if (snapshot_write_byte(f, (uint8_t)(data & 0xff)) < 0
         || snapshot_write_byte(f, (uint8_t)(data >> 8)) < 0) {
         return -1;
@@ -119,9 +243,9 @@ static int snapshot_write_word(FILE *f, uint16_t data)
     return 0;
 }
 
-static int snapshot_write_dword(FILE *f, uint32_t data)
+static int snapshot_write_dword(snapshot_stream_t *f, uint32_t data)
 {
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     if (snapshot_write_word(f, (uint16_t)(data & 0xffff)) < 0
         || snapshot_write_word(f, (uint16_t)(data >> 16)) < 0) {
         return -1;
@@ -130,9 +254,9 @@ static int snapshot_write_dword(FILE *f, uint32_t data)
     return 0;
 }
 
-static int snapshot_write_qword(FILE *f, uint64_t data)
+static int snapshot_write_qword(snapshot_stream_t *f, uint64_t data)
 {
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     if (snapshot_write_dword(f, (uint32_t)(data & 0xffffffff)) < 0
         || snapshot_write_dword(f, (uint32_t)(data >> 32)) < 0) {
         return -1;
@@ -141,12 +265,12 @@ static int snapshot_write_qword(FILE *f, uint64_t data)
     return 0;
 }
 
-static int snapshot_write_double(FILE *f, double data)
+static int snapshot_write_double(snapshot_stream_t *f, double data)
 {
     uint8_t *byte_data = (uint8_t *)&data;
     int i;
 
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     for (i = 0; i < sizeof(double); i++) {
         if (snapshot_write_byte(f, byte_data[i]) < 0) {
             return -1;
@@ -155,13 +279,13 @@ static int snapshot_write_double(FILE *f, double data)
     return 0;
 }
 
-static int snapshot_write_padded_string(FILE *f, const char *s, uint8_t pad_char,
+static int snapshot_write_padded_string(snapshot_stream_t *f, const char *s, uint8_t pad_char,
                                         int len)
 {
     int i, found_zero;
     uint8_t c;
 
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     for (i = found_zero = 0; i < len; i++) {
         if (!found_zero && s[i] == 0) {
             found_zero = 1;
@@ -175,10 +299,10 @@ static int snapshot_write_padded_string(FILE *f, const char *s, uint8_t pad_char
     return 0;
 }
 
-static int snapshot_write_byte_array(FILE *f, const uint8_t *data, unsigned int num)
+static int snapshot_write_byte_array(snapshot_stream_t *f, const uint8_t *data, unsigned int num)
 {
-    current_fpos = ftell(f);
-    if (num > 0 && fwrite(data, (size_t)num, 1, f) < 1) {
+    current_fpos = stream_tell(f);
+    if (num > 0 && stream_write(f, data, (size_t)num) < 1) {
         snapshot_error = SNAPSHOT_WRITE_BYTE_ARRAY_ERROR;
         return -1;
     }
@@ -186,11 +310,11 @@ static int snapshot_write_byte_array(FILE *f, const uint8_t *data, unsigned int
     return 0;
 }
 
-static int snapshot_write_word_array(FILE *f, const uint16_t *data, unsigned int num)
+static int snapshot_write_word_array(snapshot_stream_t *f, const uint16_t *data, unsigned int num)
 {
     unsigned int i;
 
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     for (i = 0; i < num; i++) {
         if (snapshot_write_word(f, data[i]) < 0) {
             return -1;
@@ -200,11 +324,11 @@ static int snapshot_write_word_array(FILE *f, const uint16_t *data, unsigned int
     return 0;
 }
 
-static int snapshot_write_dword_array(FILE *f, const uint32_t *data, unsigned int num)
+static int snapshot_write_dword_array(snapshot_stream_t *f, const uint32_t *data, unsigned int num)
 {
     unsigned int i;
 
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     for (i = 0; i < num; i++) {
         if (snapshot_write_dword(f, data[i]) < 0) {
             return -1;
@@ -215,13 +339,13 @@ static int snapshot_write_dword_array(FILE *f, const uint32_t *data, unsigned in
 }
 
 
-static int snapshot_write_string(FILE *f, const char *s)
+static int snapshot_write_string(snapshot_stream_t *f, const char *s)
 {
     size_t len, i;
 
     len = s ? (strlen(s) + 1) : 0;      /* length includes nullbyte */
 
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     if (snapshot_write_word(f, (uint16_t)len) < 0) {
         return -1;
     }
@@ -235,12 +359,12 @@ static int snapshot_write_string(FILE *f, const char *s)
     return (int)(len + sizeof(uint16_t));
 }
 
-static int snapshot_read_byte(FILE *f, uint8_t *b_return)
+static int snapshot_read_byte(snapshot_stream_t *f, uint8_t *b_return)
 {
     int c;
 
-    current_fpos = ftell(f);
-    c = fgetc(f);
+    current_fpos = stream_tell(f);
+    c = stream_getc(f);
     if (c == EOF) {
         snapshot_error = SNAPSHOT_READ_EOF_ERROR;
         return -1;
@@ -249,11 +373,11 @@ static int snapshot_read_byte(FILE *f, uint8_t *b_return)
     return 0;
 }
 
-static int snapshot_read_word(FILE *f, uint16_t *w_return)
+static int snapshot_read_word(snapshot_stream_t *f, uint16_t *w_return)
 {
     uint8_t lo, hi;
 
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     if (snapshot_read_byte(f, &lo) < 0 || snapshot_read_byte(f, &hi) < 0) {
         return -1;
     }
@@ -262,11 +386,11 @@ static int snapshot_read_word(FILE *f, uint16_t *w_return)
     return 0;
 }
 
-static int snapshot_read_dword(FILE *f, uint32_t *dw_return)
+static int snapshot_read_dword(snapshot_stream_t *f, uint32_t *dw_return)
 {
     uint16_t lo, hi;
 
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     if (snapshot_read_word(f, &lo) < 0 || snapshot_read_word(f, &hi) < 0) {
         return -1;
     }
@@ -275,11 +399,11 @@ static int snapshot_read_dword(FILE *f, uint32_t *dw_return)
     return 0;
 }
 
-static int snapshot_read_qword(FILE *f, uint64_t *qw_return)
+static int snapshot_read_qword(snapshot_stream_t *f, uint64_t *qw_return)
 {
     uint32_t lo, hi;
 
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     if (snapshot_read_dword(f, &lo) < 0 || snapshot_read_dword(f, &hi) < 0) {
         return -1;
     }
@@ -288,16 +412,16 @@ static int snapshot_read_qword(FILE *f, uint64_t *qw_return)
     return 0;
 }
 
-static int snapshot_read_double(FILE *f, double *d_return)
+static int snapshot_read_double(snapshot_stream_t *f, double *d_return)
 {
     int i;
     int c;
     double val;
     uint8_t *byte_val = (uint8_t *)&val;
 
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     for (i = 0; i < sizeof(double); i++) {
-        c = fgetc(f);
+        c = stream_getc(f);
         if (c == EOF) {
             snapshot_error = SNAPSHOT_READ_EOF_ERROR;
             return -1;
@@ -308,10 +432,10 @@ static int snapshot_read_double(FILE *f, double *d_return)
     return 0;
 }
 
-static int snapshot_read_byte_array(FILE *f, uint8_t *b_return, unsigned int num)
+static int snapshot_read_byte_array(snapshot_stream_t *f, uint8_t *b_return, unsigned int num)
 {
-    current_fpos = ftell(f);
-    if (num > 0 && fread(b_return, (size_t)num, 1, f) < 1) {
+    current_fpos = stream_tell(f);
+    if (num > 0 && stream_read(f, b_return, (size_t)num) < 1) {
         snapshot_error = SNAPSHOT_READ_BYTE_ARRAY_ERROR;
         return -1;
     }
@@ -319,11 +443,11 @@ static int snapshot_read_byte_array(FILE *f, uint8_t *b_return, unsigned int num
     return 0;
 }
 
-static int snapshot_read_word_array(FILE *f, uint16_t *w_return, unsigned int num)
+static int snapshot_read_word_array(snapshot_stream_t *f, uint16_t *w_return, unsigned int num)
 {
     unsigned int i;
 
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     for (i = 0; i < num; i++) {
         if (snapshot_read_word(f, w_return + i) < 0) {
             return -1;
@@ -333,11 +457,11 @@ static int snapshot_read_word_array(FILE *f, uint16_t *w_return, unsigned int nu
     return 0;
 }
 
-static int snapshot_read_dword_array(FILE *f, uint32_t *dw_return, unsigned int num)
+static int snapshot_read_dword_array(snapshot_stream_t *f, uint32_t *dw_return, unsigned int num)
 {
     unsigned int i;
 
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     for (i = 0; i < num; i++) {
         if (snapshot_read_dword(f, dw_return + i) < 0) {
             return -1;
@@ -347,7 +471,7 @@ static int snapshot_read_dword_array(FILE *f, uint32_t *dw_return, unsigned int
     return 0;
 }
 
-static int snapshot_read_string(FILE *f, char **s)
+static int snapshot_read_string(snapshot_stream_t *f, char **s)
 {
     int i, len;
     uint16_t w;
@@ -357,7 +481,7 @@ static int snapshot_read_string(FILE *f, char **s)
     lib_free(*s);
     *s = NULL;      /* don't leave a bogus pointer */
 
-    current_fpos = ftell(f);
+    current_fpos = stream_tell(f);
     if (snapshot_read_word(f, &w) < 0) {
         return -1;
     }
@@ -488,8 +612,8 @@ int snapshot_module_write_string(snapshot_module_t *m, const char *s)
 
 int snapshot_module_read_byte(snapshot_module_t *m, uint8_t *b_return)
 {
-    current_fpos = ftell(m->file);
-    if (ftell(m->file) + sizeof(uint8_t) > m->offset + m->size) {
+    current_fpos = stream_tell(m->file);
+    if (stream_tell(m->file) + sizeof(uint8_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -499,8 +623,8 @@ int snapshot_module_read_byte(snapshot_module_t *m, uint8_t *b_return)
 
 int snapshot_module_read_word(snapshot_module_t *m, uint16_t *w_return)
 {
-    current_fpos = ftell(m->file);
-    if (ftell(m->file) + sizeof(uint16_t) > m->offset + m->size) {
+    current_fpos = stream_tell(m->file);
+    if (stream_tell(m->file) + sizeof(uint16_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -510,8 +634,8 @@ int snapshot_module_read_word(snapshot_module_t *m, uint16_t *w_return)
 
 int snapshot_module_read_dword(snapshot_module_t *m, uint32_t *dw_return)
 {
-    current_fpos = ftell(m->file);
-    if (ftell(m->file) + sizeof(uint32_t) > m->offset + m->size) {
+    current_fpos = stream_tell(m->file);
+    if (stream_tell(m->file) + sizeof(uint32_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -521,8 +645,8 @@ int snapshot_module_read_dword(snapshot_module_t *m, uint32_t *dw_return)
 
 int snapshot_module_read_qword(snapshot_module_t *m, uint64_t *qw_return)
 {
-    current_fpos = ftell(m->file);
-    if (ftell(m->file) + sizeof(uint64_t) > m->offset + m->size) {
+    current_fpos = stream_tell(m->file);
+    if (stream_tell(m->file) + sizeof(uint64_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -532,8 +656,8 @@ int snapshot_module_read_qword(snapshot_module_t *m, uint64_t *qw_return)
 
 int snapshot_module_read_double(snapshot_module_t *m, double *db_return)
 {
-    current_fpos = ftell(m->file);
-    if (ftell(m->file) + sizeof(double) > m->offset + m->size) {
+    current_fpos = stream_tell(m->file);
+    if (stream_tell(m->file) + sizeof(double) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -543,8 +667,8 @@ int snapshot_module_read_double(snapshot_module_t *m, double *db_return)
 
 int snapshot_module_read_byte_array(snapshot_module_t *m, uint8_t *b_return, unsigned int num)
 {
-    current_fpos = ftell(m->file);
-    if ((long)(ftell(m->file) + num) > (long)(m->offset + m->size)) {
+    current_fpos = stream_tell(m->file);
+    if ((long)(stream_tell(m->file) + num) > (long)(m->offset + m->size)) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -554,7 +678,7 @@ int snapshot_module_read_byte_array(snapshot_module_t *m, uint8_t *b_return, uns
 
 int snapshot_module_read_word_array(snapshot_module_t *m, uint16_t *w_return, unsigned int num)
 {
-    if ((long)(ftell(m->file) + num * sizeof(uint16_t)) > (long)(m->offset + m->size)) {
+    if ((long)(stream_tell(m->file) + num * sizeof(uint16_t)) > (long)(m->offset + m->size)) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -564,8 +688,8 @@ int snapshot_module_read_word_array(snapshot_module_t *m, uint16_t *w_return, un
 
 int snapshot_module_read_dword_array(snapshot_module_t *m, uint32_t *dw_return, unsigned int num)
 {
-    current_fpos = ftell(m->file);
-    if ((long)(ftell(m->file) + num * sizeof(uint32_t)) > (long)(m->offset + m->size)) {
+    current_fpos = stream_tell(m->file);
+    if ((long)(stream_tell(m->file) + num * sizeof(uint32_t)) > (long)(m->offset + m->size)) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -575,8 +699,8 @@ int snapshot_module_read_dword_array(snapshot_module_t *m, uint32_t *dw_return,
 
 int snapshot_module_read_string(snapshot_module_t *m, char **charp_return)
 {
-    current_fpos = ftell(m->file);
-    if (ftell(m->file) + sizeof(uint16_t) > m->offset + m->size) {
+    current_fpos = stream_tell(m->file);
+    if (stream_tell(m->file) + sizeof(uint16_t) > m->offset + m->size) {
         snapshot_error = SNAPSHOT_READ_OUT_OF_BOUNDS_ERROR;
         return -1;
     }
@@ -682,7 +806,7 @@ snapshot_module_t *snapshot_module_create(snapshot_t *s, const char *name, uint8
 
     m = lib_malloc(sizeof(snapshot_module_t));
     m->file = s->file;
-    m->offset = ftell(s->file);
+    m->offset = stream_tell(s->file);
     if (m->offset == -1) {
         snapshot_error = SNAPSHOT_ILLEGAL_OFFSET_ERROR;
         lib_free(m);
@@ -697,8 +821,8 @@ snapshot_module_t *snapshot_module_create(snapshot_t *s, const char *name, uint8
         return NULL;
     }
 
-    m->size = (uint32_t)(ftell(s->file) - m->offset);
-    m->size_offset = ftell(s->file) - sizeof(uint32_t);
+    m->size = (uint32_t)(stream_tell(s->file) - m->offset);
+    m->size_offset = stream_tell(s->file) - sizeof(uint32_t);
 
     return m;
 }
@@ -711,7 +835,7 @@ snapshot_module_t *snapshot_module_open(snapshot_t *s, const char *name, uint8_t
 
     current_module = (char *)name;
 
-    if (fseek(s->file, s->first_module_offset, SEEK_SET) < 0) {
+    if (stream_seek(s->file, s->first_module_offset) < 0) {
         snapshot_error = SNAPSHOT_FIRST_MODULE_NOT_FOUND_ERROR;
         DBG(("snapshot_module_open error: name: '%s' NOT found\n", name));
         return NULL;
@@ -744,13 +868,13 @@ snapshot_module_t *snapshot_module_open(snapshot_t *s, const char *name, uint8_t
         }
 
         m->offset += m->size;
-        if (fseek(s->file, m->offset, SEEK_SET) < 0) {
+        if (stream_seek(s->file, m->offset) < 0) {
             snapshot_error = SNAPSHOT_MODULE_NOT_FOUND_ERROR;
             goto fail;
         }
     }
 
-    m->size_offset = ftell(s->file) - sizeof(uint32_t);
+    m->size_offset = stream_tell(s->file) - sizeof(uint32_t);
 #if 0
     /* HACK: if any of the errors *this* function can produce is still pending
              in snapshot_error, clear it out - else we might fail for no reason
@@ -766,7 +890,7 @@ snapshot_module_t *snapshot_module_open(snapshot_t *s, const char *name, uint8_t
     return m;
 
 fail:
-    fseek(s->file, s->first_module_offset, SEEK_SET);
+    stream_seek(s->file, s->first_module_offset);
     lib_free(m);
     DBG(("snapshot_module_open error: name: '%s' NOT found\n", name));
     return NULL;
@@ -777,7 +901,7 @@ int snapshot_module_close(snapshot_module_t *m)
     DBG(("snapshot_module_close name: '%s'\n", current_module));
     /* Backpatch module size if writing.  */
     if (m->write_mode
-        && (fseek(m->file, m->size_offset, SEEK_SET) < 0
+        && (stream_seek(m->file, m->size_offset) < 0
             || snapshot_write_dword(m->file, m->size) < 0)) {
         snapshot_error = SNAPSHOT_MODULE_CLOSE_ERROR;
         DBG(("snapshot_module_close error\n"));
@@ -785,7 +909,7 @@ int snapshot_module_close(snapshot_module_t *m)
     }
 
     /* Skip module.  */
-    if (fseek(m->file, m->offset + m->size, SEEK_SET) < 0) {
+    if (stream_seek(m->file, m->offset + m->size) < 0) {
         snapshot_error = SNAPSHOT_MODULE_SKIP_ERROR;
         DBG(("snapshot_module_close error\n"));
         return -1;
@@ -800,17 +924,23 @@ int snapshot_module_close(snapshot_module_t *m)
 
 snapshot_t *snapshot_create(const char *filename, uint8_t major_version, uint8_t minor_version, const char *snapshot_machine_name)
 {
-    FILE *f;
+    FILE *file = NULL;
+    snapshot_stream_t *f;
     snapshot_t *s;
     unsigned char viceversion[4] = { VERSION_RC_NUMBER };
 
     current_filename = (char *)filename;
 
-    f = fopen(filename, MODE_WRITE);
-    if (f == NULL) {
-        snapshot_error = SNAPSHOT_CANNOT_CREATE_SNAPSHOT_ERROR;
-        return NULL;
+    if (memory_target != NULL) {
+        memory_target->size = 0;
+    } else {
+        file = fopen(filename, MODE_WRITE);
+        if (file == NULL) {
+            snapshot_error = SNAPSHOT_CANNOT_CREATE_SNAPSHOT_ERROR;
+            return NULL;
+        }
     }
+    f = stream_new(file);
 
     /* Magic string.  */
     if (snapshot_write_padded_string(f, snapshot_magic_string, (uint8_t)0, SNAPSHOT_MAGIC_LEN) < 0) {
@@ -852,14 +982,17 @@ snapshot_t *snapshot_create(const char *filename, uint8_t major_version, uint8_t
 
     s = lib_malloc(sizeof(snapshot_t));
     s->file = f;
-    s->first_module_offset = ftell(f);
+    s->first_module_offset = stream_tell(f);
     s->write_mode = 1;
 
     return s;
 
 fail:
-    fclose(f);
-    archdep_remove(filename);
+    lib_free(f);
+    if (file != NULL) {
+        fclose(file);
+        archdep_remove(filename);
+    }
     return NULL;
 }
 
@@ -869,21 +1002,25 @@ static uint32_t snapshot_vicerevision;
 
 snapshot_t *snapshot_open(const char *filename, uint8_t *major_version_return, uint8_t *minor_version_return, const char *snapshot_machine_name)
 {
-    FILE *f;
+    FILE *file = NULL;
+    snapshot_stream_t *f;
     char magic[SNAPSHOT_MAGIC_LEN];
     snapshot_t *s = NULL;
     int machine_name_len;
-    size_t offs;
+    long offs;
 
     current_machine_name = (char *)snapshot_machine_name;
     current_filename = (char *)filename;
     current_module = NULL;
 
-    f = zfile_fopen(filename, MODE_READ);
-    if (f == NULL) {
-        snapshot_error = SNAPSHOT_CANNOT_OPEN_FOR_READ_ERROR;
-        return NULL;
+    if (memory_target == NULL) {
+        file = zfile_fopen(filename, MODE_READ);
+        if (file == NULL) {
+            snapshot_error = SNAPSHOT_CANNOT_OPEN_FOR_READ_ERROR;
+            return NULL;
+        }
     }
+    f = stream_new(file);
 
     /* Magic string.  */
     if (snapshot_read_byte_array(f, (uint8_t *)magic, SNAPSHOT_MAGIC_LEN) < 0
@@ -917,12 +1054,12 @@ snapshot_t *snapshot_open(const char *filename, uint8_t *major_version_return, u
     /* VICE version and revision */
     memset(snapshot_viceversion, 0, 4);
     snapshot_vicerevision = 0;
-    offs = ftell(f);
+    offs = stream_tell(f);
 
     if (snapshot_read_byte_array(f, (uint8_t *)magic, SNAPSHOT_VERSION_MAGIC_LEN) < 0
         || memcmp(magic, snapshot_version_magic_string, SNAPSHOT_VERSION_MAGIC_LEN) != 0) {
         /* old snapshots do not contain VICE version */
-        fseek(f, offs, SEEK_SET);
+        stream_seek(f, offs);
         log_warning(LOG_DEFAULT, "attempting to load pre 2.4.30 snapshot");
     } else {
         /* actually read the version */
@@ -938,14 +1075,20 @@ snapshot_t *snapshot_open(const char *filename, uint8_t *major_version_return, u
 
     s = lib_malloc(sizeof(snapshot_t));
     s->file = f;
-    s->first_module_offset = ftell(f);
+    s->first_module_offset = stream_tell(f);
     s->write_mode = 0;
 
-    vsync_suspend_speed_eval();
+    /* memory snapshots are taken while running, don't disturb the speed */
+    if (file != NULL) {
+        vsync_suspend_speed_eval();
+    }
     return s;
 
 fail:
-    fclose(f);
+    lib_free(f);
+    if (file != NULL) {
+        zfile_fclose(file);
+    }
     return NULL;
 }
 
@@ -953,15 +1096,17 @@ int snapshot_close(snapshot_t *s)
 {
     int retval;
 
-    if (!s->write_mode) {
-        if (zfile_fclose(s->file) == EOF) {
+    if (s->file->file == NULL) {
+        retval = 0;
+    } else if (!s->write_mode) {
+        if (zfile_fclose(s->file->file) == EOF) {
             snapshot_error = SNAPSHOT_READ_CLOSE_EOF_ERROR;
             retval = -1;
         } else {
             retval = 0;
         }
     } else {
-        if (fclose(s->file) == EOF) {
+        if (fclose(s->file->file) == EOF) {
             snapshot_error = SNAPSHOT_WRITE_CLOSE_EOF_ERROR;
             retval = -1;
         } else {
@@ -969,10 +1114,51 @@ int snapshot_close(snapshot_t *s)
         }
     }
 
+    lib_free(s->file);
     lib_free(s);
     return retval;
 }
 
+/* ------------------------------------------------------------------------- */
+
+snapshot_memory_t *snapshot_memory_new(void)
+{
+    return lib_calloc(1, sizeof(snapshot_memory_t));
+}
+
+void snapshot_memory_free(snapshot_memory_t *mem)
+{
+    if (mem == NULL) {
+        return;
+    }
+    if (memory_target == mem) {
+        memory_target = NULL;
+    }
+    lib_free(mem->data);
+    lib_free(mem);
+}
+
+size_t snapshot_memory_size(snapshot_memory_t *mem)
+{
+    return mem->size;
+}
+
+/* The buffer keeps its allocation between snapshots, so taking one every
+   frame does not go through the allocator once it has grown to size.  */
+void snapshot_memory_select(snapshot_memory_t *mem)
+{
+    memory_target = mem;
+}
+
+/* A memory snapshot is read back by the same session that wrote it, with
+   the same settings, so modules can skip reapplying their configuration.  */
+int snapshot_is_memory(snapshot_t *s)
+{
+    return s->file->mem != NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
 static void display_error_with_vice_version(char *text, char *filename)
 {
     char *vmessage = lib_malloc(0x100);
@@ -41,6 +41,7 @@
 #endif
 
 #include "archdep.h"
+#include "benchmark.h"
 #include "cmdline.h"
 #include "debug.h"
 #include "fixpoint.h"
@@ -303,6 +304,8 @@ static int volume;
 static int amp;
 static int fragment_size;
 static int output_option;
+static int dc_filter_enabled;
+static int low_latency_enabled;
 
 /* divisors for fragment size calculation */
 static const int fragment_divisor[] = {
@@ -434,6 +437,23 @@ static int set_fragment_size(int val, void *param)
     return 0;
 }
 
+static int set_low_latency_enabled(int val, void *param)
+{
+    val = val ? 1 : 0;
+
+    if (low_latency_enabled != val) {
+        low_latency_enabled = val;
+        sound_playdev_reopen = TRUE;
+    }
+    return 0;
+}
+
+static int set_dc_filter_enabled(int val, void *param)
+{
+    dc_filter_enabled = val ? 1 : 0;
+    return 0;
+}
+
 static int set_volume(int val, void *param)
 {
     volume = val;
@@ -479,6 +499,10 @@ static const resource_int_t resources_int[] = {
       (void *)&volume, set_volume, NULL },
     { "SoundOutput", ARCHDEP_SOUND_OUTPUT_MODE, RES_EVENT_NO, NULL,
       (void *)&output_option, set_output_option, NULL },
+    { "SoundDCFilter", 0, RES_EVENT_NO, NULL,
+      (void *)&dc_filter_enabled, set_dc_filter_enabled, NULL },
+    { "SoundLowLatency", 0, RES_EVENT_NO, NULL,
+      (void *)&low_latency_enabled, set_low_latency_enabled, NULL },
     RESOURCE_INT_LIST_END
 };
 
@@ -534,6 +558,18 @@ static const cmdline_option_t cmdline_options[] =
     { "-soundvolume", SET_RESOURCE, CMDLINE_ATTRIB_NEED_ARGS,
       NULL, NULL, "SoundVolume", NULL,
       "<Volume>", "Specify the sound volume (0..100)" },
+    { "-sounddcfilter", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "SoundDCFilter", (resource_value_t)1,
+      NULL, "Remove DC offset from the sound output" },
+    { "+sounddcfilter", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "SoundDCFilter", (resource_value_t)0,
+      NULL, "Do not remove DC offset from the sound output" },
+    { "-soundlowlatency", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "SoundLowLatency", (resource_value_t)1,
+      NULL, "Enable low latency sound output with dynamic resampling" },
+    { "+soundlowlatency", SET_RESOURCE, CMDLINE_ATTRIB_NONE,
+      NULL, NULL, "SoundLowLatency", (resource_value_t)0,
+      NULL, "Disable low latency sound output" },
     CMDLINE_LIST_END
 };
 
@@ -658,6 +694,9 @@ static double speed_percent;
 /* Flag: Is warp mode enabled?  */
 static int warp_mode_enabled;
 
+/* Flag: Are we running look-ahead frames whose sound is thrown away?  */
+static int runahead_mode_enabled;
+
 typedef struct {
     /* Number of sound output channels */
     int sound_output_channels;
@@ -710,6 +749,33 @@ typedef struct {
     /* is the device suspended? */
     int issuspended;
     int16_t lastsample[SOUND_CHANNELS_MAX];
+
+    /* DC filter state: last input and output sample per channel */
+    float dc_in[SOUND_CHANNELS_MAX];
+    float dc_out[SOUND_CHANNELS_MAX];
+
+#ifdef USE_PERFSTATS
+    /* time spent in the mix stage and number of samples it processed */
+    tick_t mix_ticks;
+    uint64_t mix_samples;
+#endif
+
+    /* low latency mode: the output is resampled by rs_ratio (input frames
+       per output frame) to keep the device buffer half full */
+    int low_latency;
+    double rs_ratio;
+    double rs_pos;
+    double rs_integral;
+    int16_t rs_last[SOUND_CHANNELS_MAX];
+    int16_t *rs_buffer;
+
+    /* sample rate the playback device was opened with */
+    int speed;
+
+    /* measured output latency in usec and number of device underruns */
+    int latency_us;
+    int underruns;
+    int underrun_active;
 } snddata_t;
 
 static snddata_t snddata;
@@ -798,25 +864,26 @@ static void fill_buffer(int size, int rise)
     int c, i;
     int16_t *p;
     double factor;
+    int channels = snddata.sound_output_channels;
 
-    p = realloc_buffer(size * sizeof(int16_t) * snddata.sound_output_channels);
+    p = realloc_buffer(size * sizeof(int16_t) * channels);
     if (!p) {
         return;
     }
 
-    for (c = 0; c < snddata.sound_output_channels; c++) {
-        for (i = 0; i < size; i++) {
-            if (rise < 0) {
-                factor = (double)(size - i) / size;
+    for (i = 0; i < size; i++) {
+        if (rise < 0) {
+            factor = (double)(size - i) / size;
+        } else {
+            if (rise > 0) {
+                factor = (double)i / size;
             } else {
-                if (rise > 0) {
-                    factor = (double)i / size;
-                } else {
-                    factor = 1.0;
-                }
+                factor = 1.0;
             }
+        }
 
-            p[i * snddata.sound_output_channels + c] = (int16_t)(snddata.lastsample[c] * factor);
+        for (c = 0; c < channels; c++) {
+            p[i * channels + c] = (int16_t)(snddata.lastsample[c] * factor);
         }
     }
 
@@ -950,6 +1017,9 @@ int sound_open(void)
     /* Calculate buffer size in seconds. */
     bufsize = ((buffer_size < 1 || buffer_size > 1000)
                ? SOUND_SAMPLE_BUFFER_SIZE : buffer_size) / 1000.0;
+    if (low_latency_enabled && bufsize > SOUND_LOW_LATENCY_BUFFER_SIZE / 1000.0) {
+        bufsize = SOUND_LOW_LATENCY_BUFFER_SIZE / 1000.0;
+    }
     speed = (sample_rate < 8000 || sample_rate > 96000)
             ? SOUND_SAMPLE_RATE : sample_rate;
 
@@ -983,7 +1053,7 @@ int sound_open(void)
      *       small as possible, as that will allow the whole system to catch up
      *       faster and compensate errors better. */
     fragsize = speed / ((rfsh_per_sec < 1.0) ? 1 : ((int)rfsh_per_sec))
-               / fragment_divisor[fragment_size];
+               / fragment_divisor[low_latency_enabled ? SOUND_FRAGMENT_VERY_SMALL : fragment_size];
     if (pdev) {
         if (channels <= pdev->max_channels) {
             fragsize *= channels;
@@ -1029,7 +1099,29 @@ int sound_open(void)
 
         for (c = 0; c < snddata.sound_output_channels; c++) {
             snddata.lastsample[c] = 0;
+            snddata.dc_in[c] = 0.0f;
+            snddata.dc_out[c] = 0.0f;
+        }
+#ifdef USE_PERFSTATS
+        snddata.mix_ticks = 0;
+        snddata.mix_samples = 0;
+#endif
+
+        snddata.low_latency = low_latency_enabled;
+        snddata.rs_ratio = 1.0;
+        snddata.rs_pos = -1.0;
+        snddata.rs_integral = 0.0;
+        for (c = 0; c < SOUND_CHANNELS_MAX; c++) {
+            snddata.rs_last[c] = 0;
+        }
+        lib_free(snddata.rs_buffer);
+        snddata.rs_buffer = NULL;
+        if (snddata.low_latency) {
+            snddata.rs_buffer = lib_malloc(snddata.bufsize * snddata.sound_output_channels * sizeof(int16_t));
         }
+        snddata.latency_us = 0;
+        snddata.underruns = 0;
+        snddata.underrun_active = 0;
 
         log_message(sound_log,
                     "Opened device `%s', speed %dHz, fragment size %.2fms, buffer size %.2fms%s",
@@ -1039,12 +1131,15 @@ int sound_open(void)
                     (1000.0 * snddata.bufsize / speed),
                     snddata.sound_output_channels > 1 ? ", stereo" : "");
         sample_rate = speed;
+        snddata.speed = speed;
 
         if (sid_open() != 0 || sid_init() != 0) {
             return 1;
         }
 
-        sound_is_timing_source = pdev->is_timing_source ? TRUE : FALSE;
+        /* In low latency mode the output follows the device clock by
+           resampling, so the host timer paces the emulation instead. */
+        sound_is_timing_source = (pdev->is_timing_source && !snddata.low_latency) ? TRUE : FALSE;
         sid_state_changed = FALSE;
 
         /* Fill up the sound hardware buffer. */
@@ -1128,6 +1223,21 @@ static void sounddev_close(const sound_device_t **dev)
 /* close sid */
 void sound_close(void)
 {
+#ifdef USE_PERFSTATS
+    if (snddata.mix_samples > 0) {
+        log_message(sound_log, "Mix stage: %.1f ns per sample over %"PRIu64" samples, fragment size %d.",
+                    (double)snddata.mix_ticks * 1.0e9 / tick_per_second() / snddata.mix_samples,
+                    snddata.mix_samples, snddata.fragsize);
+        snddata.mix_samples = 0;
+        snddata.mix_ticks = 0;
+    }
+#endif
+
+    if (snddata.low_latency && snddata.playdev) {
+        log_message(sound_log, "Low latency output: %.2fms latency, %d underruns.",
+                    snddata.latency_us / 1000.0, snddata.underruns);
+    }
+
     sounddev_close(&snddata.playdev);
     sounddev_close(&snddata.recdev);
     sid_close();
@@ -1140,6 +1250,8 @@ void sound_close(void)
     lib_free(snddata.buffer);
     snddata.buffer = NULL;
     snddata.bufsize = 0;
+    lib_free(snddata.rs_buffer);
+    snddata.rs_buffer = NULL;
 
     if (temp_buffer) {
         lib_free(temp_buffer);
@@ -1152,6 +1264,100 @@ void sound_close(void)
     vsync_suspend_speed_eval();
 }
 
+/* Post-process freshly generated samples in one pass over the buffer:
+   master volume and the optional DC filter, see sound_mix_samples(). */
+static void sound_mix_stage(int16_t *buf, int nr, int channels)
+{
+#ifdef USE_PERFSTATS
+    tick_t start = tick_now();
+#endif
+
+    sound_mix_samples(buf, nr * channels, channels, amp, dc_filter_enabled,
+                      snddata.dc_in, snddata.dc_out);
+
+#ifdef USE_PERFSTATS
+    snddata.mix_ticks += tick_now_delta(start);
+    snddata.mix_samples += (uint64_t)(nr * channels);
+#endif
+}
+
+/* Linear interpolation resampler for the low latency mode. Resamples the
+   nr frames at buf in place by snddata.rs_ratio and returns the number of
+   frames produced, at most room. rs_pos is the read position relative to
+   the start of the chunk; -1 refers to the last frame of the previous one. */
+static int sound_resample(int16_t *buf, int nr, int room)
+{
+    int channels = snddata.sound_output_channels;
+    int16_t *dst = snddata.rs_buffer;
+    double pos = snddata.rs_pos;
+    int out = 0;
+    int c, i, a, b;
+
+    while (pos < nr - 1 && out < room) {
+        i = (pos < 0.0) ? -1 : (int)pos;
+        for (c = 0; c < channels; c++) {
+            a = (i < 0) ? snddata.rs_last[c] : buf[i * channels + c];
+            b = buf[(i + 1) * channels + c];
+            dst[out * channels + c] = (int16_t)(a + (b - a) * (pos - i));
+        }
+        out++;
+        pos += snddata.rs_ratio;
+    }
+
+    for (c = 0; c < channels; c++) {
+        snddata.rs_last[c] = buf[(nr - 1) * channels + c];
+    }
+    /* If the buffer ran full the rest of the chunk is dropped. */
+    snddata.rs_pos = (pos - nr < -1.0) ? -1.0 : pos - nr;
+
+    memcpy(buf, dst, out * channels * sizeof(int16_t));
+    return out;
+}
+
+/* Gains of the fill level controller, and the largest deviation of the
+   resampling ratio from 1. */
+#define RESAMPLE_KP         0.002
+#define RESAMPLE_KI         0.00002
+#define RESAMPLE_MAX_ADJUST 0.005
+
+/* Measure the device buffer fill level and steer the resampling ratio
+   towards keeping it half full. Also counts underruns. */
+static void sound_track_device_clock(void)
+{
+    int total = snddata.fragsize * snddata.fragnr;
+    int fill, queued;
+    double error, ratio;
+
+    fill = total - snddata.playdev->bufferspace();
+    if (fill <= 0) {
+        if (!snddata.underrun_active) {
+            snddata.underruns++;
+            snddata.underrun_active = 1;
+        }
+    } else {
+        snddata.underrun_active = 0;
+    }
+
+    queued = fill + snddata.bufptr;
+    snddata.latency_us = (int)((double)queued * 1000000.0 / snddata.speed);
+
+    error = (double)(queued - total / 2) / total;
+    snddata.rs_integral += RESAMPLE_KI * error;
+    if (snddata.rs_integral > RESAMPLE_MAX_ADJUST) {
+        snddata.rs_integral = RESAMPLE_MAX_ADJUST;
+    } else if (snddata.rs_integral < -RESAMPLE_MAX_ADJUST) {
+        snddata.rs_integral = -RESAMPLE_MAX_ADJUST;
+    }
+
+    ratio = RESAMPLE_KP * error + snddata.rs_integral;
+    if (ratio > RESAMPLE_MAX_ADJUST) {
+        ratio = RESAMPLE_MAX_ADJUST;
+    } else if (ratio < -RESAMPLE_MAX_ADJUST) {
+        ratio = -RESAMPLE_MAX_ADJUST;
+    }
+    snddata.rs_ratio = 1.0 + ratio;
+}
+
 /* run sid */
 static int sound_run_sound(void)
 {
@@ -1163,6 +1369,7 @@ static int sound_run_sound(void)
     int i;
     CLOCK delta_t = 0;
     int16_t *bufferptr;
+    int benchmark_prev;
 
     if (!playback_enabled) {
         return 1;
@@ -1175,6 +1382,8 @@ static int sound_run_sound(void)
         }
     }
 
+    benchmark_prev = benchmark_enter(BENCHMARK_SID);
+
     /* Handling of cycle based sound engines. */
     if (cycle_based) {
         delta_t = maincpu_clk - snddata.lastclk;
@@ -1185,7 +1394,7 @@ static int sound_run_sound(void)
                                              snddata.sound_output_channels,
                                              snddata.sound_chip_channels,
                                              &delta_t);
-        if (delta_t && !archdep_is_exiting()) {
+        if (delta_t && !archdep_is_exiting() && !runahead_mode_enabled) {
 #if 0
             sound_error_log_only("Sound buffer overflow (cycle based)");
             return -1;
@@ -1206,6 +1415,7 @@ static int sound_run_sound(void)
          nr = (int)((SOUNDCLK_CONSTANT(maincpu_clk) - snddata.fclk)
                     / snddata.clkstep);
          if (!nr) {
+             benchmark_leave(benchmark_prev);
              return 0;
          }
          if (nr > snddata.bufsize - snddata.bufptr) {
@@ -1221,19 +1431,24 @@ static int sound_run_sound(void)
          snddata.fclk += nr * snddata.clkstep;
      }
 
-     if (amp < 4096) {
-         if (amp) {
-             for (i = 0; i < (nr * snddata.sound_output_channels); i++) {
-                 bufferptr[i] = bufferptr[i] * amp / 4096;
-             }
-         } else {
-             memset(bufferptr, 0, nr * snddata.sound_output_channels * sizeof(int16_t));
+    /* the chips are kept running, but the samples are not kept */
+    if (runahead_mode_enabled) {
+        snddata.lastclk = maincpu_clk;
+        benchmark_leave(benchmark_prev);
+        return 0;
+    }
+
+     if (nr > 0) {
+         sound_mix_stage(bufferptr, nr, snddata.sound_output_channels);
+         if (snddata.low_latency) {
+             nr = sound_resample(bufferptr, nr, snddata.bufsize - snddata.bufptr);
          }
      }
 
     snddata.bufptr += nr;
     snddata.lastclk = maincpu_clk;
 
+    benchmark_leave(benchmark_prev);
     return 0;
 }
 
@@ -1257,6 +1472,7 @@ void sound_reset(void)
 bool sound_flush(void)
 {
     int c, i, nr, space;
+    int benchmark_prev;
     char *state;
 
     if (!playback_enabled) {
@@ -1295,6 +1511,9 @@ bool sound_flush(void)
         snddata.bufptr = 0;
         goto done;
     }
+    if (runahead_mode_enabled) {
+        goto done;
+    }
     sound_resume();
 
     if (snddata.playdev->flush) {
@@ -1307,6 +1526,10 @@ bool sound_flush(void)
         }
     }
 
+    if (snddata.low_latency && snddata.playdev->bufferspace) {
+        sound_track_device_clock();
+    }
+
     /* Calculate the number of samples to flush - whole fragments. */
     nr = snddata.bufptr - snddata.bufptr % snddata.fragsize;
     if (!nr) {
@@ -1336,6 +1559,8 @@ bool sound_flush(void)
                 nr = space;
             }
 
+            /* a blocking write is where the device makes us wait */
+            benchmark_prev = benchmark_enter(BENCHMARK_IDLE);
             mainlock_yield_begin();
 
             /* Flush buffer, all channels are already mixed into it. */
@@ -1343,6 +1568,7 @@ bool sound_flush(void)
                 sound_error("write to sound device failed.");
 
                 mainlock_yield_end();
+                benchmark_leave(benchmark_prev);
                 goto done;
             }
 
@@ -1351,12 +1577,14 @@ bool sound_flush(void)
                     sound_error("write to sound device failed.");
 
                     mainlock_yield_end();
+                    benchmark_leave(benchmark_prev);
                     goto done;
                 }
             }
 
             /* Successful write to audio device, exit loop. */
             mainlock_yield_end();
+            benchmark_leave(benchmark_prev);
             break;
         }
 
@@ -1372,11 +1600,10 @@ bool sound_flush(void)
 
     for (c = 0; c < snddata.sound_output_channels; c++) {
         snddata.lastsample[c] = snddata.buffer[(nr - 1) * snddata.sound_output_channels + c];
-        for (i = 0; i < snddata.bufptr; i++) {
-            snddata.buffer[i * snddata.sound_output_channels + c] =
-                snddata.buffer[(i + nr) * snddata.sound_output_channels + c];
-        }
     }
+    memmove(snddata.buffer,
+            snddata.buffer + nr * snddata.sound_output_channels,
+            snddata.bufptr * snddata.sound_output_channels * sizeof(int16_t));
 
 done:
 
@@ -1568,6 +1795,25 @@ void sound_set_warp_mode(int value)
     }
 }
 
+/* Look-ahead frames are undone by loading a snapshot, which takes the sound
+   chips back as well. Only the sample clocks need to be put back here, and
+   that has to happen before the chips are read back, which may already run
+   the sound.  */
+void sound_set_runahead_mode(int value)
+{
+    static soundclk_t runahead_fclk;
+    static CLOCK runahead_lastclk;
+
+    if (value) {
+        runahead_fclk = snddata.fclk;
+        runahead_lastclk = snddata.lastclk;
+    } else if (runahead_mode_enabled) {
+        snddata.fclk = runahead_fclk;
+        snddata.lastclk = runahead_lastclk;
+    }
+    runahead_mode_enabled = value;
+}
+
 void sound_snapshot_prepare(void)
 {
     /* Update lastclk.  */
@@ -1629,6 +1875,14 @@ int sound_dac_calculate_samples(sound_dac_t *dac, int16_t *pbuf, int value, int
     return nr;
 }
 
+/* Output latency in msec and number of device underruns, both only
+   measured in low latency mode. Used by vsync.c for the UI metrics. */
+void sound_get_latency_metrics(double *latency_ms, int *underruns)
+{
+    *latency_ms = snddata.latency_us / 1000.0;
+    *underruns = snddata.underruns;
+}
+
 /* recording related functions, equivalent to screenshot_... */
 void sound_stop_recording(void)
 {
@@ -31,6 +31,7 @@
 #include "vice.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include "types.h"
 
@@ -83,6 +84,9 @@
 #define SOUND_FRAGMENT_SIZE SOUND_FRAGMENT_MEDIUM
 #endif
 
+/* Buffer size in msec used by the low latency mode */
+#define SOUND_LOW_LATENCY_BUFFER_SIZE 8
+
 #define SOUND_CHANNELS_MAX 2
 
 /** \brief  Maximum number of SIDs supported by the emulation.
@@ -184,25 +188,64 @@ typedef struct sound_desc_s {
     int device_type;
 } sound_desc_t;
 
+/* Signals of the same sign are added with their product / 32768 pulled
+   back towards zero, others simply add up. Written without early returns
+   so loops mixing whole buffers can be vectorised. */
 static inline int16_t sound_audio_mix(int ch1, int ch2)
 {
-    if (ch1 == 0) {
-        return (int16_t)ch2;
-    }
+    int prod = ch1 * ch2;
+    int sum = ch1 + ch2;
 
-    if (ch2 == 0) {
-        return (int16_t)ch1;
+    if (prod > 0) {
+        sum += (ch1 > 0) ? -(prod / 32768) : (prod / 32768);
     }
+    return (int16_t)sum;
+}
 
-    if ((ch1 > 0 && ch2 < 0) || (ch1 < 0 && ch2 > 0)) {
-        return (int16_t)(ch1 + ch2);
+/* The mix stage of sound.c: scale the n samples at buf by amp / 4096 (the
+   master volume), then, if dc_filter is set, remove the DC offset of each
+   of the interleaved channels with a one pole high pass and clip back to
+   16 bit. dc_in and dc_out hold the filter state, one value per channel.
+   The volume loop has no data dependent branches so the compiler can
+   vectorise it. Kept here, like sound_audio_mix(), so that it can be timed
+   on its own (see testprogs/mixbench.c). */
+static inline void sound_mix_samples(int16_t *buf, int n, int channels, int amp,
+                                     int dc_filter, float *dc_in, float *dc_out)
+{
+    int i, c;
+
+    if (amp < 4096) {
+        if (amp) {
+            for (i = 0; i < n; i++) {
+                buf[i] = (int16_t)(buf[i] * amp / 4096);
+            }
+        } else {
+            memset(buf, 0, n * sizeof(int16_t));
+        }
     }
 
-    if (ch1 > 0) {
-        return (int16_t)((ch1 + ch2) - (ch1 * ch2 / 32768));
+    if (dc_filter) {
+        for (c = 0; c < channels; c++) {
+            float x1 = dc_in[c];
+            float y = dc_out[c];
+
+            for (i = c; i < n; i += channels) {
+                float x = (float)buf[i];
+
+                y = x - x1 + 0.995f * y;
+                x1 = x;
+                if (y > 32767.0f) {
+                    buf[i] = 32767;
+                } else if (y < -32768.0f) {
+                    buf[i] = -32768;
+                } else {
+                    buf[i] = (int16_t)y;
+                }
+            }
+            dc_in[c] = x1;
+            dc_out[c] = y;
+        }
     }
-
-    return (int16_t)-((-(ch1) + -(ch2)) - (-(ch1) * -(ch2) / 32768));
 }
 
 sound_desc_t *sound_get_valid_devices(int type, int sort);
@@ -217,6 +260,7 @@ int sound_open(void);
 void sound_close(void);
 void sound_set_relative_speed(int value);
 void sound_set_warp_mode(int value);
+void sound_set_runahead_mode(int value);
 void sound_set_machine_parameter(long clock_rate, long ticks_per_frame);
 void sound_snapshot_prepare(void);
 void sound_snapshot_finish(void);
@@ -268,6 +312,8 @@ const char *sound_device_name(unsigned int num);
 
 sound_t *sound_get_psid(unsigned int channel);
 
+void sound_get_latency_metrics(double *latency_ms, int *underruns);
+
 /* This structure is used by sound producing chips/devices */
 typedef struct sound_chip_s {
     /* sound chip open function */
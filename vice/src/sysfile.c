@@ -36,6 +36,7 @@
 #include "lib.h"
 #include "log.h"
 #include "resources.h"
+#include "romcache.h"
 #include "sysfile.h"
 #include "util.h"
 
@@ -215,6 +216,17 @@ int sysfile_locate(const char *name, const char *subpath, char **complete_path_r
 
 /* ------------------------------------------------------------------------- */
 
+/* Locate a system file like `sysfile_open', but only return the malloced
+   complete path, or NULL if the file was not found.  */
+static char *sysfile_find(const char *name, const char *subpath)
+{
+    if (name == NULL || *name == '\0') {
+        log_error(LOG_DEFAULT, "Missing name for system file.");
+        return NULL;
+    }
+    return findpath(name, expanded_system_path, subpath, ARCHDEP_ACCESS_R_OK);
+}
+
 /*
  * If minsize >= 0, and the file is smaller than maxsize, load the data
  * into the end of the memory range.
@@ -222,15 +234,14 @@ int sysfile_locate(const char *name, const char *subpath, char **complete_path_r
  */
 int sysfile_load(const char *name, const char *subpath, uint8_t *dest, int minsize, int maxsize)
 {
-    FILE *fp = NULL;
+    const uint8_t *data;
     size_t rsize = 0;
-    off_t tmpsize;
     char *complete_path = NULL;
     int load_at_end;
 
-    fp = sysfile_open(name, subpath, &complete_path, MODE_READ);
+    complete_path = sysfile_find(name, subpath);
 
-    if (fp == NULL) {
+    if (complete_path == NULL) {
         /* Try to open the file from the current directory. */
         const char working_dir_prefix[3] = {
             '.', ARCHDEP_DIR_SEP_CHR, '\0'
@@ -238,23 +249,24 @@ int sysfile_load(const char *name, const char *subpath, uint8_t *dest, int minsi
         char *local_name = NULL;
 
         local_name = util_concat(working_dir_prefix, name, NULL);
-        fp = sysfile_open((const char *)local_name, subpath, &complete_path, MODE_READ);
+        complete_path = sysfile_find((const char *)local_name, subpath);
         lib_free(local_name);
         local_name = NULL;
 
-        if (fp == NULL) {
+        if (complete_path == NULL) {
             goto fail;
         }
     }
 
     log_message(LOG_DEFAULT, "Loading system file `%s'.", complete_path);
 
-    tmpsize = archdep_file_size(fp);
-    if (tmpsize < 0) {
-        log_message(LOG_DEFAULT, "Failed to determine size of '%s'.", complete_path);
+    /* The file contents come from the ROM cache, so reloading the same ROMs
+       on reset or model changes does not hit the disk again.  */
+    data = romcache_get(complete_path, &rsize);
+    if (data == NULL) {
+        log_message(LOG_DEFAULT, "Failed to read '%s'.", complete_path);
         goto fail;
     }
-    rsize = (size_t)tmpsize;
     if (minsize < 0) {
         minsize = -minsize;
         load_at_end = 0;
@@ -270,9 +282,7 @@ int sysfile_load(const char *name, const char *subpath, uint8_t *dest, int minsi
         log_warning(LOG_DEFAULT,
                     "ROM `%s': two bytes too large - removing assumed "
                     "start address.", complete_path);
-        if (fread((char *)dest, 1, 2, fp) < 2) {
-            goto fail;
-        }
+        data += 2;
         rsize -= 2;
     }
     if (load_at_end && rsize < ((size_t)maxsize)) {
@@ -282,11 +292,8 @@ int sysfile_load(const char *name, const char *subpath, uint8_t *dest, int minsi
                     complete_path);
         rsize = maxsize;
     }
-    if ((rsize = fread((char *)dest, 1, rsize, fp)) < ((size_t)minsize)) {
-        goto fail;
-    }
+    memcpy(dest, data, rsize);
 
-    fclose(fp);
     lib_free(complete_path);
     return (int)rsize;  /* return ok */
 
@@ -0,0 +1,369 @@
+/*
+ * blockbench.c - Time and check the block device layer of the hard disk images.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * ATA, SCSI and SD card images are accessed through core/blockdev.c. This
+ * program writes a 64 MiB scratch image and reads and writes single 512
+ * byte sectors, in order and at random, in five ways:
+ *
+ *   unbuffered  fseeko() and fread()/fwrite() per sector on an unbuffered
+ *               stream, as the SCSI code did before
+ *   buffered    the same on a stream with the stdio buffer, as ATA did
+ *   blockdev    blockdev_open(), through the cache
+ *   mapped      blockdev_open() with BLOCKDEV_MAP, reads only
+ *   wrapped     blockdev_wrap() on a stream, as the CMD HD shares the
+ *               stream of its DHD image; not cached
+ *
+ * and prints the sectors per second of each. The image is fresh in the
+ * page cache, so this is the cost of the path, not of the disk.
+ *
+ * It then checks the data: a mix of unaligned reads and writes through the
+ * cache against a copy in memory, and once more in the file after
+ * blockdev_close(); and that a wrapped device sees what the owner of the
+ * stream wrote and the other way round.
+ *
+ * blockdev.c is included directly, it only needs the lib_* allocators and
+ * the archdep file functions, which are built with it.
+ *
+ *   blockbench [scratch file]
+ */
+
+#include "../core/blockdev.c"
+
+#include <stdlib.h>
+#include <time.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* The few emulator functions blockdev.c needs */
+
+void *lib_malloc(size_t size)
+{
+    void *p = malloc(size);
+
+    if (p == NULL) {
+        abort();
+    }
+    return p;
+}
+
+void *lib_calloc(size_t nmemb, size_t size)
+{
+    void *p = calloc(nmemb, size);
+
+    if (p == NULL) {
+        abort();
+    }
+    return p;
+}
+
+void lib_free(void *ptr)
+{
+    free(ptr);
+}
+
+/* ------------------------------------------------------------------------- */
+
+#define TEST_IMAGE_SIZE     (64 * 1024 * 1024)
+#define TEST_SECTOR         512
+#define TEST_SECTORS        (TEST_IMAGE_SIZE / TEST_SECTOR)
+#define TEST_OPS            200000
+#define TEST_MIXED_OPS      20000
+#define TEST_MIXED_MAX      3000    /* longest unaligned access */
+
+enum {
+    WAY_UNBUFFERED,
+    WAY_BUFFERED,
+    WAY_BLOCKDEV,
+    WAY_MAPPED,
+    WAY_WRAPPED,
+    WAY_NUM
+};
+
+static const char * const way_names[WAY_NUM] = {
+    "unbuffered", "buffered", "blockdev", "mapped", "wrapped"
+};
+
+static const char *image_name = "blockbench.tmp";
+
+/* Small LCG, so that the run does not depend on the C library */
+static uint32_t test_seed;
+
+static uint32_t test_rand(void)
+{
+    test_seed = test_seed * 1103515245u + 12345u;
+    return test_seed >> 8;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint8_t pattern(size_t i)
+{
+    return (uint8_t)(i * 7 + (i >> 9));
+}
+
+/* Write the scratch image, and keep a copy in shadow if given */
+static void create_image(uint8_t *shadow)
+{
+    static uint8_t block[0x10000];
+    FILE *fd;
+    size_t i, j;
+
+    fd = fopen(image_name, MODE_WRITE);
+    if (fd == NULL) {
+        perror(image_name);
+        exit(1);
+    }
+    for (i = 0; i < TEST_IMAGE_SIZE; i += sizeof(block)) {
+        for (j = 0; j < sizeof(block); j++) {
+            block[j] = pattern(i + j);
+        }
+        if (fwrite(block, 1, sizeof(block), fd) != sizeof(block)) {
+            perror(image_name);
+            exit(1);
+        }
+        if (shadow != NULL) {
+            memcpy(shadow + i, block, sizeof(block));
+        }
+    }
+    if (fclose(fd) != 0) {
+        perror(image_name);
+        exit(1);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+typedef struct target_s {
+    FILE *fd;
+    blockdev_t *dev;
+} target_t;
+
+static void target_open(target_t *t, int way, int writing)
+{
+    t->fd = NULL;
+    t->dev = NULL;
+
+    switch (way) {
+        case WAY_UNBUFFERED:
+        case WAY_BUFFERED:
+        case WAY_WRAPPED:
+            t->fd = fopen(image_name, writing || way == WAY_WRAPPED ? MODE_READ_WRITE : MODE_READ);
+            if (t->fd == NULL) {
+                break;
+            }
+            if (way == WAY_UNBUFFERED) {
+                setbuf(t->fd, NULL);
+            } else if (way == WAY_WRAPPED) {
+                t->dev = blockdev_wrap(t->fd);
+            }
+            break;
+        case WAY_BLOCKDEV:
+            t->dev = blockdev_open(image_name, writing ? BLOCKDEV_READ_WRITE : BLOCKDEV_READ);
+            break;
+        case WAY_MAPPED:
+            t->dev = blockdev_open(image_name, BLOCKDEV_READ | BLOCKDEV_MAP);
+            break;
+    }
+    if (t->fd == NULL && t->dev == NULL) {
+        perror(image_name);
+        exit(1);
+    }
+}
+
+static int target_access(target_t *t, int writing, off_t offset, uint8_t *buf, size_t len)
+{
+    if (t->dev != NULL) {
+        return writing ? blockdev_write(t->dev, offset, buf, len)
+                       : blockdev_read(t->dev, offset, buf, len);
+    }
+    if (archdep_fseeko(t->fd, offset, SEEK_SET) < 0) {
+        return -1;
+    }
+    if (writing) {
+        return fwrite(buf, 1, len, t->fd) == len ? 0 : -1;
+    }
+    return fread(buf, 1, len, t->fd) == len ? 0 : -1;
+}
+
+/* The time includes the close, which writes back what is still cached */
+static void target_close(target_t *t)
+{
+    if (t->dev != NULL) {
+        blockdev_close(t->dev);
+    }
+    if (t->fd != NULL) {
+        fclose(t->fd);
+    }
+}
+
+/* Sectors per second of TEST_OPS single sector accesses */
+static double time_way(int way, int writing, int random)
+{
+    target_t t;
+    uint8_t buf[TEST_SECTOR];
+    off_t sector;
+    double start;
+    long i;
+
+    memset(buf, 0x5a, sizeof(buf));
+    test_seed = 1;
+    start = now();
+    target_open(&t, way, writing);
+    for (i = 0; i < TEST_OPS; i++) {
+        sector = random ? (off_t)(test_rand() % TEST_SECTORS) : (off_t)(i % TEST_SECTORS);
+        if (target_access(&t, writing, sector * TEST_SECTOR, buf, sizeof(buf)) < 0) {
+            fprintf(stderr, "%s: access to sector %ld failed\n", way_names[way], (long)sector);
+            exit(1);
+        }
+    }
+    target_close(&t);
+    return TEST_OPS / (now() - start);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Unaligned reads and writes through the cache must match the shadow copy,
+   and so must the file after the cache was written back */
+static int check_mixed(uint8_t *shadow)
+{
+    static uint8_t buf[TEST_MIXED_MAX];
+    uint8_t *file;
+    target_t t;
+    off_t offset;
+    size_t len, j;
+    FILE *fd;
+    int failed = 0;
+    long i;
+
+    create_image(shadow);
+    target_open(&t, WAY_BLOCKDEV, 1);
+    test_seed = 2;
+    for (i = 0; i < TEST_MIXED_OPS && !failed; i++) {
+        offset = (off_t)(test_rand() % (TEST_IMAGE_SIZE - TEST_MIXED_MAX));
+        len = 1 + test_rand() % TEST_MIXED_MAX;
+        if (test_rand() & 1) {
+            for (j = 0; j < len; j++) {
+                buf[j] = (uint8_t)test_rand();
+            }
+            memcpy(shadow + offset, buf, len);
+            failed = target_access(&t, 1, offset, buf, len) < 0;
+        } else {
+            failed = target_access(&t, 0, offset, buf, len) < 0
+                     || memcmp(shadow + offset, buf, len) != 0;
+        }
+    }
+    target_close(&t);
+    if (failed) {
+        printf("mixed access through the cache: MISMATCH after %ld accesses\n", i);
+        return 1;
+    }
+
+    file = lib_malloc(TEST_IMAGE_SIZE);
+    fd = fopen(image_name, MODE_READ);
+    failed = fd == NULL
+             || fread(file, 1, TEST_IMAGE_SIZE, fd) != TEST_IMAGE_SIZE
+             || memcmp(file, shadow, TEST_IMAGE_SIZE) != 0;
+    if (fd != NULL) {
+        fclose(fd);
+    }
+    lib_free(file);
+    printf("mixed access through the cache: %s\n", failed ? "MISMATCH in the file" : "ok");
+    return failed;
+}
+
+/* The owner of a wrapped stream and the device must see each other's
+   writes at once */
+static int check_wrapped(void)
+{
+    uint8_t buf[TEST_SECTOR], data[TEST_SECTOR];
+    target_t t;
+    int failed;
+
+    create_image(NULL);
+    target_open(&t, WAY_WRAPPED, 1);
+
+    /* read through the device first, so a cache would hold the sector */
+    failed = blockdev_read(t.dev, 10 * TEST_SECTOR, buf, sizeof(buf)) < 0;
+
+    /* the owner writes the sector, the device must read the new data */
+    memset(data, 0xa5, sizeof(data));
+    failed |= archdep_fseeko(t.fd, 10 * TEST_SECTOR, SEEK_SET) < 0
+              || fwrite(data, 1, sizeof(data), t.fd) != sizeof(data)
+              || fflush(t.fd) != 0;
+    failed |= blockdev_read(t.dev, 10 * TEST_SECTOR, buf, sizeof(buf)) < 0
+              || memcmp(buf, data, sizeof(buf)) != 0;
+
+    /* the device writes, the owner must read the new data */
+    memset(data, 0x3c, sizeof(data));
+    failed |= blockdev_write(t.dev, 20 * TEST_SECTOR, data, sizeof(data)) < 0;
+    failed |= archdep_fseeko(t.fd, 20 * TEST_SECTOR, SEEK_SET) < 0
+              || fread(buf, 1, sizeof(buf), t.fd) != sizeof(buf)
+              || memcmp(buf, data, sizeof(buf)) != 0;
+
+    target_close(&t);
+    printf("wrapped stream shared with its owner: %s\n", failed ? "MISMATCH" : "ok");
+    return failed;
+}
+
+/* ------------------------------------------------------------------------- */
+
+int main(int argc, char **argv)
+{
+    uint8_t *shadow;
+    int failed = 0;
+    int way;
+
+    if (argc > 1) {
+        image_name = argv[1];
+    }
+
+    create_image(NULL);
+    printf("%d single sector accesses on a %d MiB image, Msectors/s\n",
+           TEST_OPS, TEST_IMAGE_SIZE >> 20);
+    printf("              seq read  rand read  seq write  rand write\n");
+    for (way = 0; way < WAY_NUM; way++) {
+        printf("%-12s  %8.2f  %9.2f", way_names[way],
+               time_way(way, 0, 0) / 1e6, time_way(way, 0, 1) / 1e6);
+        if (way == WAY_MAPPED) {
+            printf("  %9s  %10s\n", "-", "-");
+        } else {
+            printf("  %9.2f  %10.2f\n",
+                   time_way(way, 1, 0) / 1e6, time_way(way, 1, 1) / 1e6);
+        }
+    }
+
+    shadow = lib_malloc(TEST_IMAGE_SIZE);
+    failed |= check_mixed(shadow);
+    lib_free(shadow);
+    failed |= check_wrapped();
+
+    remove(image_name);
+    return failed;
+}
@@ -0,0 +1,117 @@
+#!/bin/sh
+#
+# cpubench.sh - Run the CPU-bound benchmark programs in an emulator.
+#
+# This file is part of VICE, the Versatile Commodore Emulator.
+# See README for copyright notice.
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation; either version 2 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+#  02111-1307  USA.
+#
+# usage: cpubench.sh emulator machine|program.prg [cycles [emulator options]]
+#
+#   machine  c64 (for x64, x64sc and xscpu64), vic20 (xvic), plus4
+#            (xplus4) or superpet (xpet, the 6809 of the SuperPET)
+#   cycles   emulated cycles per run, default 20000000
+#
+# Runs each cpubench-<machine>-*.prg ("make cpubench") from the directory
+# of this script, or just the given program, such as z80test.prg, in warp
+# mode, once for the given number of cycles and once for twice as many,
+# three times each. For superpet the cpubench-superpet-*.bin ROMs take the
+# place of the $F000 ROM and start from the reset vector of the 6809
+# instead of being autostarted; they need no disk drive, so drive 8 is
+# switched off. The difference between the best times of the two is the
+# time the emulator needed for the second half, without the startup, the
+# autostart and the shutdown, so the cycles per second printed are those
+# of the running program alone. Needs the date of GNU coreutils for %N.
+
+if [ $# -lt 2 ]; then
+    echo "usage: $0 emulator machine|program.prg [cycles [emulator options]]" >&2
+    exit 1
+fi
+
+dir=`dirname "$0"`
+emu=$1
+machine=$2
+cycles=${3:-20000000}
+if [ $# -gt 2 ]; then
+    shift 3
+else
+    shift 2
+fi
+
+# best of three wall clock times of one run, in milliseconds
+best_time()
+{
+    run_prg=$1
+    run_cycles=$2
+    shift 2
+    best=
+    for i in 1 2 3; do
+        start=`date +%s%N`
+        if [ "$machine" = superpet ]; then
+            "$emu" -default -sounddev dummy -warp -model SuperPET -cpu6809 \
+                -6809romF "$run_prg" -drive8type 0 -limitcycles $run_cycles \
+                "$@" >/dev/null 2>&1
+        else
+            "$emu" -default -sounddev dummy -warp -autostart "$run_prg" \
+                -limitcycles $run_cycles "$@" >/dev/null 2>&1
+        fi
+        end=`date +%s%N`
+        t=$(( (end - start) / 1000000 ))
+        if [ -z "$best" ] || [ $t -lt $best ]; then
+            best=$t
+        fi
+    done
+    echo $best
+}
+
+case $machine in
+    *.prg)
+        programs=`basename $machine .prg`
+        ;;
+    superpet)
+        programs="ops sieve crc"
+        ;;
+    *)
+        programs="basic ops sieve crc rle"
+        ;;
+esac
+
+for program in $programs; do
+    case $machine in
+        *.prg)
+            prg=$machine
+            ;;
+        superpet)
+            prg=$dir/cpubench-superpet-$program.bin
+            ;;
+        *)
+            prg=$dir/cpubench-$machine-$program.prg
+            ;;
+    esac
+    if [ ! -f $prg ]; then
+        echo "$prg not found, run \"make\" first" >&2
+        exit 1
+    fi
+    t1=`best_time $prg $cycles "$@"`
+    t2=`best_time $prg $(( cycles * 2 )) "$@"`
+    if [ $t2 -le $t1 ]; then
+        echo "$program: runs too short to measure, use more cycles" >&2
+        exit 1
+    fi
+    awk -v p=$program -v c=$cycles -v t=$(( t2 - t1 )) \
+        'BEGIN { printf "%-6s %7.2f Mcycles/s\n", p ":", c / t / 1000 }'
+done
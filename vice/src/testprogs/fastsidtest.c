@@ -0,0 +1,235 @@
+/*
+ * fastsidtest.c - Compare batched and per-sample fastsid rendering.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * fastsid_render() sets up the SID and voice state once per call and then
+ * runs one of the specialised FASTSID_RENDER_LOOP() loops. The engine used
+ * to do the setup before every sample instead, and tested the filter and
+ * voice 3 flags at run time. This program feeds the same random register
+ * writes to two SIDs, renders one of them in batches of up to 512 samples
+ * through fastsid_render() and the other one sample at a time the old way,
+ * and checks that the output is bit-identical. It does so with and without
+ * filters, for both SID models.
+ *
+ * The engine is included directly, so its static functions can be called.
+ * It is built even when the emulators were configured without FastSID.
+ */
+
+#ifndef HAVE_FASTSID
+#define HAVE_FASTSID
+#endif
+
+#include "../sid/fastsid.c"
+
+#include <time.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* The few emulator functions fastsid.c needs */
+
+CLOCK maincpu_clk = 0;
+
+static int test_filters;
+static int test_model;
+
+void *lib_calloc(size_t nmemb, size_t size)
+{
+    void *p = calloc(nmemb, size);
+
+    if (p == NULL) {
+        abort();
+    }
+    return p;
+}
+
+void lib_free(void *ptr)
+{
+    free(ptr);
+}
+
+char *lib_strdup(const char *str)
+{
+    char *p = lib_calloc(strlen(str) + 1, 1);
+
+    strcpy(p, str);
+    return p;
+}
+
+int resources_get_int(const char *name, int *value_return)
+{
+    if (strcmp(name, "SidFilters") == 0) {
+        *value_return = test_filters;
+        return 0;
+    }
+    if (strcmp(name, "SidModel") == 0) {
+        *value_return = test_model;
+        return 0;
+    }
+    return -1;
+}
+
+long sound_sample_position(void)
+{
+    return 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
+#define TEST_SPEED          44100
+#define TEST_CYCLES_PER_SEC 985248
+#define TEST_SAMPLES        (4 * 1024 * 1024)
+#define TEST_MAX_BATCH      512
+
+/* Small LCG, so that the run does not depend on the C library */
+static uint32_t test_seed;
+
+static uint32_t test_rand(void)
+{
+    test_seed = test_seed * 1103515245u + 12345u;
+    return test_seed >> 16;
+}
+
+/* Store a random value in a random register. Gate, test and sync bits
+   and the filter routing are toggled often enough to cover all loops. */
+static void random_store(sound_t *batched, sound_t *single)
+{
+    uint16_t addr = (uint16_t)(test_rand() % 25);
+    uint8_t value = (uint8_t)test_rand();
+
+    fastsid_store(batched, addr, value);
+    fastsid_store(single, addr, value);
+}
+
+static sound_t *open_sid(void)
+{
+    uint8_t regs[32];
+    sound_t *psid;
+
+    memset(regs, 0, sizeof(regs));
+    psid = fastsid_open(regs);
+    if (!fastsid_init(psid, TEST_SPEED, TEST_CYCLES_PER_SEC, 1000)) {
+        fprintf(stderr, "fastsid_init() failed\n");
+        exit(1);
+    }
+    return psid;
+}
+
+/* The per-sample path: set up the state and render one sample with the
+   filter and voice 3 flags passed at run time, as the engine did before
+   FASTSID_RENDER_LOOP() was introduced. */
+static void render_single(sound_t *psid, int16_t *out)
+{
+    setup_sid(psid);
+    setup_voice(&psid->v[0]);
+    setup_voice(&psid->v[1]);
+    setup_voice(&psid->v[2]);
+
+    *out = fastsid_next_sample(psid, &psid->v[0], &psid->v[1], &psid->v[2],
+                               psid->emulatefilter, psid->has3);
+}
+
+/* Render TEST_SAMPLES samples both ways and compare. Returns 0 if the
+   output matches. */
+static int run_test(int filters, int model)
+{
+    sound_t *batched;
+    sound_t *single;
+    int16_t *out_batched;
+    int16_t *out_single;
+    clock_t batched_clock = 0;
+    clock_t single_clock = 0;
+    clock_t start;
+    int pos = 0;
+    int i;
+
+    test_filters = filters;
+    test_model = model;
+    test_seed = 1;
+
+    batched = open_sid();
+    single = open_sid();
+    out_batched = lib_calloc(TEST_SAMPLES, sizeof(int16_t));
+    out_single = lib_calloc(TEST_SAMPLES, sizeof(int16_t));
+
+    while (pos < TEST_SAMPLES) {
+        int n = 1 + (int)(test_rand() % TEST_MAX_BATCH);
+        int writes = (int)(test_rand() % 4);
+
+        if (n > TEST_SAMPLES - pos) {
+            n = TEST_SAMPLES - pos;
+        }
+        while (writes-- > 0) {
+            random_store(batched, single);
+        }
+
+        start = clock();
+        fastsid_render(batched, out_batched + pos, n, 1);
+        batched_clock += clock() - start;
+
+        start = clock();
+        for (i = 0; i < n; i++) {
+            render_single(single, out_single + pos + i);
+        }
+        single_clock += clock() - start;
+
+        pos += n;
+    }
+
+    for (i = 0; i < TEST_SAMPLES; i++) {
+        if (out_batched[i] != out_single[i]) {
+            break;
+        }
+    }
+
+    printf("filters %s, %s: ", filters ? "on " : "off", model ? "8580" : "6581");
+    if (i < TEST_SAMPLES) {
+        printf("MISMATCH at sample %d (batched %d, per-sample %d)\n",
+               i, out_batched[i], out_single[i]);
+    } else {
+        printf("ok, batched %.1f Msamples/s, per-sample %.1f Msamples/s\n",
+               TEST_SAMPLES / 1e6 / ((double)batched_clock / CLOCKS_PER_SEC + 1e-9),
+               TEST_SAMPLES / 1e6 / ((double)single_clock / CLOCKS_PER_SEC + 1e-9));
+    }
+
+    lib_free(out_batched);
+    lib_free(out_single);
+    fastsid_close(batched);
+    fastsid_close(single);
+
+    return i < TEST_SAMPLES;
+}
+
+int main(void)
+{
+    int failed = 0;
+    int filters;
+    int model;
+
+    for (filters = 0; filters < 2; filters++) {
+        for (model = 0; model < 2; model++) {
+            failed |= run_test(filters, model);
+        }
+    }
+
+    return failed ? 1 : 0;
+}
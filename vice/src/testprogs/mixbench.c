@@ -0,0 +1,233 @@
+/*
+ * mixbench.c - Time the sound post-processing at different fragment sizes.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * After the sound chips have rendered a fragment, sound.c and the drive
+ * and datasette sound mix further sources into it with sound_audio_mix(),
+ * sound_run_sound() applies the master volume and sound_flush() moves the
+ * part that was not written to the start of the buffer. This program runs
+ * that pipeline on random samples, once the way it was done before the mix
+ * stage (the old sound_audio_mix() with its early returns, the volume loop
+ * in sound_run_sound() and a strided copy per channel) and once through the
+ * functions in sound.h and a memmove(), and checks that both give the same
+ * samples. The DC filter has no old counterpart; it is timed on top of the
+ * new pipeline.
+ *
+ * For each fragment size, in sample frames, and for mono and stereo the
+ * best of five runs is printed in nanoseconds per sample.
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sound.h"
+#include "types.h"
+
+/* ------------------------------------------------------------------------- */
+
+/* sound_audio_mix() as it was before the mix stage */
+static inline int16_t old_audio_mix(int ch1, int ch2)
+{
+    if (ch1 == 0) {
+        return (int16_t)ch2;
+    }
+
+    if (ch2 == 0) {
+        return (int16_t)ch1;
+    }
+
+    if ((ch1 > 0 && ch2 < 0) || (ch1 < 0 && ch2 > 0)) {
+        return (int16_t)(ch1 + ch2);
+    }
+
+    if (ch1 > 0) {
+        return (int16_t)((ch1 + ch2) - (ch1 * ch2 / 32768));
+    }
+
+    return (int16_t)-((-(ch1) + -(ch2)) - (-(ch1) * -(ch2) / 32768));
+}
+
+/* ------------------------------------------------------------------------- */
+
+#define TEST_AMP        2048    /* volume 50% */
+#define TEST_SAMPLES    (8 * 1000 * 1000)
+
+/* Small LCG, so that the run does not depend on the C library */
+static uint32_t test_seed;
+
+static uint32_t test_rand(void)
+{
+    test_seed = test_seed * 1103515245u + 12345u;
+    return test_seed >> 16;
+}
+
+static int16_t *chip;       /* what the sound chips rendered */
+static int16_t *extra;      /* a second source, e.g. drive sound */
+static int16_t *buf;
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* One fragment of frames * channels samples, followed by half a fragment
+   that is left over for the next one. */
+static void run_old(int frames, int channels)
+{
+    int n = frames * channels;
+    int left = frames / 2;
+    int i, c;
+
+    for (i = 0; i < n; i++) {
+        buf[i] = old_audio_mix(buf[i], extra[i]);
+    }
+    for (i = 0; i < n; i++) {
+        buf[i] = buf[i] * TEST_AMP / 4096;
+    }
+    for (c = 0; c < channels; c++) {
+        for (i = 0; i < left; i++) {
+            buf[i * channels + c] = buf[(i + frames) * channels + c];
+        }
+    }
+}
+
+static void run_new(int frames, int channels, int dc_filter, float *dc_in, float *dc_out)
+{
+    int n = frames * channels;
+    int left = frames / 2;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        buf[i] = sound_audio_mix(buf[i], extra[i]);
+    }
+    sound_mix_samples(buf, n, channels, TEST_AMP, dc_filter, dc_in, dc_out);
+    memmove(buf, buf + n, left * channels * sizeof(int16_t));
+}
+
+/* 0 = old, 1 = new, 2 = new with the DC filter. Returns the time per
+   sample of the best run. */
+static double time_pipeline(int way, int frames, int channels)
+{
+    int n = frames * channels;
+    long rounds = TEST_SAMPLES / n;
+    double best = 0.0;
+    float dc_in[2], dc_out[2];
+    int run;
+    long r;
+
+    for (run = 0; run < 5; run++) {
+        double start;
+
+        memset(dc_in, 0, sizeof(dc_in));
+        memset(dc_out, 0, sizeof(dc_out));
+        start = now();
+        for (r = 0; r < rounds; r++) {
+            memcpy(buf, chip, (n + n / 2) * sizeof(int16_t));
+            if (way == 0) {
+                run_old(frames, channels);
+            } else {
+                run_new(frames, channels, way == 2, dc_in, dc_out);
+            }
+        }
+        start = now() - start;
+        if (run == 0 || start < best) {
+            best = start;
+        }
+    }
+    return best * 1e9 / ((double)rounds * n);
+}
+
+/* Both ways must leave the same samples */
+static int check(int frames, int channels)
+{
+    int n = frames * channels;
+    int16_t *old_buf = malloc((n + n / 2) * sizeof(int16_t));
+    float dc_in[2] = { 0.0f, 0.0f };
+    float dc_out[2] = { 0.0f, 0.0f };
+    int same;
+
+    memcpy(buf, chip, (n + n / 2) * sizeof(int16_t));
+    run_old(frames, channels);
+    memcpy(old_buf, buf, (n + n / 2) * sizeof(int16_t));
+
+    memcpy(buf, chip, (n + n / 2) * sizeof(int16_t));
+    run_new(frames, channels, 0, dc_in, dc_out);
+
+    same = memcmp(old_buf, buf, (n + n / 2) * sizeof(int16_t)) == 0;
+    free(old_buf);
+    return same;
+}
+
+int main(int argc, char **argv)
+{
+    static const int fragment_frames[] = { 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    int max = 4096 * 2 * 2;
+    int failed = 0;
+    size_t f;
+    int channels;
+    int i;
+
+    chip = malloc(max * sizeof(int16_t));
+    extra = malloc(max * sizeof(int16_t));
+    buf = malloc(max * sizeof(int16_t));
+    if (chip == NULL || extra == NULL || buf == NULL) {
+        return 1;
+    }
+
+    /* chip output all over the range, the extra source quiet half of the
+       time like the drive sound between head steps */
+    test_seed = 1;
+    for (i = 0; i < max; i++) {
+        chip[i] = (int16_t)test_rand();
+        extra[i] = (test_rand() & 0x100) ? (int16_t)(test_rand() >> 2) - 4096 : 0;
+    }
+
+    printf("frames  ch   old ns   new ns   +dc ns   (per sample)\n");
+    for (channels = 1; channels <= 2; channels++) {
+        for (f = 0; f < sizeof(fragment_frames) / sizeof(fragment_frames[0]); f++) {
+            int frames = fragment_frames[f];
+
+            if (!check(frames, channels)) {
+                printf("%6d  %2d   MISMATCH between old and new pipeline\n", frames, channels);
+                failed = 1;
+                continue;
+            }
+            printf("%6d  %2d  %7.2f  %7.2f  %7.2f\n", frames, channels,
+                   time_pipeline(0, frames, channels),
+                   time_pipeline(1, frames, channels),
+                   time_pipeline(2, frames, channels));
+        }
+    }
+
+    free(chip);
+    free(extra);
+    free(buf);
+    return failed;
+}
@@ -0,0 +1,334 @@
+/*
+ * mk6809bench.c - Write the CPU-bound benchmark ROMs for the SuperPET 6809.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * Writes a 4 KiB image for the $F000 ROM of the SuperPET 6809, in place of
+ * the Waterloo one, with one of three programs that keep the 6809 busy and
+ * never return:
+ *
+ *   ops     a mix of addressing modes (direct, extended, indexed with
+ *           auto increment, 5, 8 and 16 bit offsets, accumulator offset,
+ *           extended indirect) with MUL, DAA, the stack and a subroutine,
+ *           summed up in a 16 bit checksum
+ *   sieve   a sieve of Eratosthenes over 2048 bytes of RAM at $1000
+ *   crc     a bitwise CRC-16 (CCITT) of the 8 KiB of Waterloo ROM at $A000
+ *
+ * The reset vector points to the program, all other vectors to an RTI,
+ * and the program runs with interrupts masked, as the 6809 comes out of
+ * reset. Each program counts its passes in the top left character of the
+ * screen and shows the high and low byte of its result next to it, which
+ * must not change between builds: the checksum for ops, the number of
+ * primes below 2048 ($01 $35) for sieve and the CRC for crc.
+ *
+ *   mk6809bench sieve cpubench-superpet-sieve.bin
+ *   xpet -model SuperPET -cpu6809 -6809romF cpubench-superpet-sieve.bin
+ *
+ * cpubench.sh runs them in an emulator and prints the emulated cycles per
+ * second.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ROM_ORG     0xf000
+#define ROM_SIZE    0x1000
+
+#define SCREEN      0x8000
+
+/* ------------------------------------------------------------------------- */
+
+static unsigned char rom[ROM_SIZE];
+static unsigned int rom_len;
+
+static void emit(unsigned int value)
+{
+    /* leave room for the RTI and the vectors */
+    if (rom_len >= ROM_SIZE - 0x11) {
+        fprintf(stderr, "program too long\n");
+        exit(1);
+    }
+    rom[rom_len++] = (unsigned char)value;
+}
+
+static unsigned int here(void)
+{
+    return ROM_ORG + rom_len;
+}
+
+/* values above $ff are written high byte first: the opcodes with a $10 or
+   $11 prefix, or an indexed opcode with its postbyte */
+static void op(unsigned int opcode)
+{
+    if (opcode > 0xff) {
+        emit(opcode >> 8);
+    }
+    emit(opcode & 0xff);
+}
+
+static void op8(unsigned int opcode, unsigned int value)
+{
+    op(opcode);
+    emit(value & 0xff);
+}
+
+static void op16(unsigned int opcode, unsigned int value)
+{
+    op(opcode);
+    emit((value >> 8) & 0xff);
+    emit(value & 0xff);
+}
+
+/* branch back to an address taken with here() */
+static void branch(unsigned int opcode, unsigned int target)
+{
+    int offset = (int)target - (int)(here() + 2);
+
+    if (offset < -128) {
+        fprintf(stderr, "branch out of range\n");
+        exit(1);
+    }
+    op8(opcode, (unsigned int)offset);
+}
+
+/* forward branch, returns the position that land() patches */
+static unsigned int branch_forward(unsigned int opcode)
+{
+    op8(opcode, 0);
+    return rom_len - 1;
+}
+
+static void land(unsigned int pos)
+{
+    unsigned int offset = rom_len - (pos + 1);
+
+    if (offset > 127) {
+        fprintf(stderr, "branch out of range\n");
+        exit(1);
+    }
+    rom[pos] = (unsigned char)offset;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Set up the stack and clear the screen, which holds whatever was in RAM
+   since the 6809 starts before the 6502 editor ROM ran */
+static void start(void)
+{
+    unsigned int clear;
+
+    op16(0x10ce, 0x7f00);       /* lds #$7f00 */
+    op16(0x8e, SCREEN);         /* ldx #screen */
+    op16(0xcc, 0x2020);         /* ldd #$2020 */
+    clear = here();
+    op8(0xed, 0x81);            /* std ,x++ */
+    op16(0x8c, SCREEN + 0x800); /* cmpx #screen + $800 */
+    branch(0x26, clear);        /* bne clear */
+}
+
+static void write_sieve(void)
+{
+    unsigned int pass, fill, outer, inner;
+    unsigned int to_next, to_next2;
+
+    start();
+    pass = here();
+    /* set all 2048 flags */
+    op16(0x8e, 0x1000);         /* ldx #$1000 */
+    op8(0x86, 0x01);            /* lda #1 */
+    fill = here();
+    op8(0xa7, 0x80);            /* sta ,x+ */
+    op16(0x8c, 0x1800);         /* cmpx #$1800 */
+    branch(0x26, fill);         /* bne fill */
+    op16(0x108e, 0x0002);       /* ldy #2 */
+    op16(0xce, 0x0000);         /* ldu #0 */
+    outer = here();
+    /* x = flags + i; skip i if it is crossed out, else count it */
+    op16(0x8e, 0x1000);         /* ldx #$1000 */
+    op8(0x1f, 0x20);            /* tfr y,d */
+    op8(0x30, 0x8b);            /* leax d,x */
+    op8(0xa6, 0x84);            /* lda ,x */
+    to_next = branch_forward(0x27); /* beq next */
+    op8(0x33, 0x41);            /* leau 1,u */
+    op8(0x1f, 0x20);            /* tfr y,d */
+    /* cross out x + i, x + 2i, ... */
+    inner = here();
+    op8(0x30, 0x8b);            /* leax d,x */
+    op16(0x8c, 0x1800);         /* cmpx #$1800 */
+    to_next2 = branch_forward(0x24); /* bhs next */
+    op8(0x6f, 0x84);            /* clr ,x */
+    branch(0x20, inner);        /* bra inner */
+    /* next: i++ */
+    land(to_next);
+    land(to_next2);
+    op8(0x31, 0x21);            /* leay 1,y */
+    op16(0x108c, 0x0800);       /* cmpy #$0800 */
+    branch(0x25, outer);        /* blo outer */
+    op16(0xff, SCREEN + 1);     /* stu screen + 1 */
+    op16(0x7c, SCREEN);         /* inc screen */
+    op16(0x7e, pass);           /* jmp pass */
+}
+
+static void write_crc(void)
+{
+    unsigned int pass, byte, bit, to_nox;
+
+    start();
+    pass = here();
+    op16(0x8e, 0xa000);         /* ldx #$a000 */
+    op16(0xcc, 0xffff);         /* ldd #$ffff */
+    byte = here();
+    op8(0xa8, 0x80);            /* eora ,x+ */
+    op16(0x108e, 0x0008);       /* ldy #8 */
+    bit = here();
+    op(0x58);                   /* aslb */
+    op(0x49);                   /* rola */
+    to_nox = branch_forward(0x24); /* bcc nox */
+    op8(0x88, 0x10);            /* eora #$10 */
+    op8(0xc8, 0x21);            /* eorb #$21 */
+    land(to_nox);
+    op8(0x31, 0x3f);            /* leay -1,y */
+    branch(0x26, bit);          /* bne bit */
+    op16(0x8c, 0xc000);         /* cmpx #$c000 */
+    branch(0x26, byte);         /* bne byte */
+    op16(0xfd, SCREEN + 1);     /* std screen + 1 */
+    op16(0x7c, SCREEN);         /* inc screen */
+    op16(0x7e, pass);           /* jmp pass */
+}
+
+static void write_ops(void)
+{
+    unsigned int pass, fill, loop, to_sub;
+
+    start();
+    pass = here();
+    /* every pass starts from the same buffer, so the sum is the same */
+    op16(0x8e, 0x2000);         /* ldx #$2000 */
+    op(0x5f);                   /* clrb */
+    fill = here();
+    op8(0xe7, 0x80);            /* stb ,x+ */
+    op(0x5c);                   /* incb */
+    op16(0x8c, 0x2200);         /* cmpx #$2200 */
+    branch(0x26, fill);         /* bne fill */
+    op16(0xce, 0x2000);         /* ldu #$2000 */
+    op16(0x8e, 0x2000);         /* ldx #$2000 */
+    op8(0x9f, 0x14);            /* stx <$14 */
+    op8(0x0f, 0x10);            /* clr <$10 */
+    op8(0x0f, 0x11);            /* clr <$11 */
+    op16(0x108e, 0x0100);       /* ldy #256 */
+    loop = here();
+    op8(0xa6, 0x80);            /* lda ,x+ */
+    op8(0xab, 0x45);            /* adda 5,u */
+    op8(0x97, 0x12);            /* sta <$12 */
+    op8(0xc6, 0x37);            /* ldb #$37 */
+    op(0x3d);                   /* mul */
+    op8(0xd3, 0x10);            /* addd <$10 */
+    op8(0xdd, 0x10);            /* std <$10 */
+    op8(0x96, 0x12);            /* lda <$12 */
+    op8(0x8b, 0x19);            /* adda #$19 */
+    op(0x19);                   /* daa */
+    op16(0xa8c9, 0x0100);       /* eora $100,u */
+    op16(0xa7c9, 0x0100);       /* sta $100,u */
+    op8(0x34, 0x06);            /* pshs d */
+    op(0x1d);                   /* sex */
+    op8(0xe6, 0x61);            /* ldb 1,s */
+    op(0x58);                   /* aslb */
+    op(0x46);                   /* rora */
+    op8(0x35, 0x06);            /* puls d */
+    op16(0xb4, 0x2080);         /* anda $2080 */
+    op8(0xe888, 0x40);          /* eorb $40,x */
+    op8(0xe4, 0x86);            /* andb a,x */
+    to_sub = branch_forward(0x8d); /* bsr sub */
+    op8(0x31, 0x3f);            /* leay -1,y */
+    branch(0x26, loop);         /* bne loop */
+    op8(0xdc, 0x10);            /* ldd <$10 */
+    op16(0xfd, SCREEN + 1);     /* std screen + 1 */
+    op16(0x7c, SCREEN);         /* inc screen */
+    op16(0x7e, pass);           /* jmp pass */
+    /* sub: add the word the pointer at $14 points to, bump a byte */
+    land(to_sub);
+    op16(0xec9f, 0x0014);       /* ldd [$0014] */
+    op8(0xd3, 0x10);            /* addd <$10 */
+    op8(0xdd, 0x10);            /* std <$10 */
+    op16(0x6cc9, 0x01ff);       /* inc $1ff,u */
+    op(0x39);                   /* rts */
+}
+
+/* ------------------------------------------------------------------------- */
+
+static const struct {
+    const char *name;
+    void (*write)(void);
+} programs[] = {
+    { "ops", write_ops },
+    { "sieve", write_sieve },
+    { "crc", write_crc }
+};
+
+int main(int argc, char **argv)
+{
+    unsigned int rti = ROM_SIZE - 0x11;
+    unsigned int vector;
+    size_t i;
+    FILE *f;
+
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s program file\n"
+                "program is ops, sieve or crc\n", argv[0]);
+        return 1;
+    }
+
+    memset(rom, 0xff, sizeof(rom));
+    rom_len = 0;
+    for (i = 0; i < sizeof(programs) / sizeof(programs[0]); i++) {
+        if (strcmp(argv[1], programs[i].name) == 0) {
+            programs[i].write();
+            break;
+        }
+    }
+    if (i == sizeof(programs) / sizeof(programs[0])) {
+        fprintf(stderr, "unknown program %s\n", argv[1]);
+        return 1;
+    }
+
+    /* RTI at $ffef, SWI3 to NMI there too, reset to the program */
+    rom[rti] = 0x3b;
+    for (vector = 0xfff2; vector < 0xfffe; vector += 2) {
+        rom[vector - ROM_ORG] = (ROM_ORG + rti) >> 8;
+        rom[vector - ROM_ORG + 1] = (ROM_ORG + rti) & 0xff;
+    }
+    rom[0xfffe - ROM_ORG] = ROM_ORG >> 8;
+    rom[0xffff - ROM_ORG] = ROM_ORG & 0xff;
+
+    f = fopen(argv[2], "wb");
+    if (f == NULL) {
+        perror(argv[2]);
+        return 1;
+    }
+    if (fwrite(rom, 1, sizeof(rom), f) != sizeof(rom)
+        || fclose(f) != 0) {
+        perror(argv[2]);
+        return 1;
+    }
+    return 0;
+}
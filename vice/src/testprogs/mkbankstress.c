@@ -0,0 +1,105 @@
+/*
+ * mkbankstress.c - Write the C64 bank switching stress program.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * bankstress.prg switches the processor port through four memory
+ * configurations over and over, and copies one byte from each of them to
+ * RAM. It never returns; run it for a fixed number of cycles:
+ *
+ *   x64sc -default -sounddev dummy -warp -autostart bankstress.prg
+ *         -limitcycles 40000000 -exitscreenshot shot.png
+ *
+ * After the first 256 rounds $4000-$43ff holds the BASIC ROM, the RAM
+ * under the KERNAL, the character ROM and the RAM under the I/O area, so
+ * the copy can be checked with the monitor. Every round also does a JSR,
+ * which exercises the stack pages.
+ *
+ * The program is small enough that it is kept here as bytes:
+ *
+ *   0801  BASIC line "10 SYS2064"
+ *   0810  78          sei
+ *   0811  a2 00       ldx #$00
+ *   0813  a9 37       lda #$37        ; BASIC, I/O, KERNAL
+ *   0815  85 01       sta $01
+ *   0817  bd 00 a0    lda $a000,x
+ *   081a  9d 00 40    sta $4000,x
+ *   081d  a9 35       lda #$35        ; RAM, I/O, RAM
+ *   081f  85 01       sta $01
+ *   0821  bd 00 e0    lda $e000,x
+ *   0824  9d 00 41    sta $4100,x
+ *   0827  a9 33       lda #$33        ; BASIC, CHARGEN, KERNAL
+ *   0829  85 01       sta $01
+ *   082b  bd 00 d0    lda $d000,x
+ *   082e  9d 00 42    sta $4200,x
+ *   0831  a9 34       lda #$34        ; all RAM
+ *   0833  85 01       sta $01
+ *   0835  bd 00 d0    lda $d000,x
+ *   0838  9d 00 43    sta $4300,x
+ *   083b  20 45 08    jsr $0845
+ *   083e  e8          inx
+ *   083f  4c 13 08    jmp $0813
+ *   0842  ea ea ea    nop, nop, nop
+ *   0845  60          rts
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static const unsigned char bankstress[] = {
+    /* load address */
+    0x01, 0x08,
+    /* 10 SYS2064 */
+    0x0b, 0x08, 0x0a, 0x00, 0x9e, '2', '0', '6', '4', 0x00, 0x00, 0x00,
+    /* padding up to $0810 */
+    0x00, 0x00, 0x00,
+    /* $0810 */
+    0x78,
+    0xa2, 0x00,
+    0xa9, 0x37, 0x85, 0x01, 0xbd, 0x00, 0xa0, 0x9d, 0x00, 0x40,
+    0xa9, 0x35, 0x85, 0x01, 0xbd, 0x00, 0xe0, 0x9d, 0x00, 0x41,
+    0xa9, 0x33, 0x85, 0x01, 0xbd, 0x00, 0xd0, 0x9d, 0x00, 0x42,
+    0xa9, 0x34, 0x85, 0x01, 0xbd, 0x00, 0xd0, 0x9d, 0x00, 0x43,
+    0x20, 0x45, 0x08,
+    0xe8,
+    0x4c, 0x13, 0x08,
+    0xea, 0xea, 0xea,
+    0x60
+};
+
+int main(int argc, char **argv)
+{
+    const char *name = argc > 1 ? argv[1] : "bankstress.prg";
+    FILE *f;
+
+    f = fopen(name, "wb");
+    if (f == NULL) {
+        perror(name);
+        return 1;
+    }
+    if (fwrite(bankstress, 1, sizeof(bankstress), f) != sizeof(bankstress)
+        || fclose(f) != 0) {
+        perror(name);
+        return 1;
+    }
+    return 0;
+}
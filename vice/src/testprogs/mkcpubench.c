@@ -0,0 +1,533 @@
+/*
+ * mkcpubench.c - Write the CPU-bound benchmark programs.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * Writes one of five programs that keep the 6502 busy and never return,
+ * for the C64, the unexpanded VIC-20 or the Plus/4:
+ *
+ *   basic   a BASIC loop over SQR, SIN and LOG, so most of the time is
+ *           spent in the floating point routines of the BASIC ROM
+ *   ops     a mix of the legal opcodes in all addressing modes, including
+ *           decimal mode, the stack and read-modify-write on RAM, summed
+ *           up in a 16 bit checksum (in the spirit of the Lorenz tests,
+ *           without checking each result)
+ *   sieve   a sieve of Eratosthenes over 2048 bytes of RAM: indirect
+ *           indexed stores, 16 bit adds and compares
+ *   crc     a bitwise CRC-16 (CCITT) of 8 KiB of the BASIC ROM: shifts,
+ *           rotates, EOR and short branches
+ *   rle     a run length compressor over 1 KiB of the BASIC ROM into RAM
+ *
+ * Each program counts its passes in a character at the top of the screen.
+ * ops, crc and rle also show the low and high byte of the checksum, CRC or
+ * output length of a pass next to it, which must not change between
+ * builds. The pass count at a given cycle can, since autostart does not
+ * always finish at the same cycle. The machine code runs with interrupts off and
+ * uses only relative branches apart from the JMP back to the start of a
+ * pass, so the code is the same for all three machines except for the
+ * buffer, ROM and screen addresses.
+ *
+ *   mkcpubench c64-sieve cpubench-c64-sieve.prg
+ *
+ * cpubench.sh runs the programs in an emulator and prints the emulated
+ * cycles per second.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct bench_machine_s {
+    const char *name;
+    unsigned int load;          /* start of BASIC */
+    unsigned int screen;
+    unsigned int rom;           /* 8 KiB of BASIC ROM for crc */
+    unsigned int buffer;        /* 2 KiB of free RAM for sieve */
+} bench_machine_t;
+
+static const bench_machine_t machines[] = {
+    { "c64",   0x0801, 0x0400, 0xa000, 0x2000 },
+    { "vic20", 0x1001, 0x1e00, 0xc000, 0x1400 },
+    { "plus4", 0x1001, 0x0c00, 0x8000, 0x2000 }
+};
+
+/* ------------------------------------------------------------------------- */
+
+/* The program, without the load address */
+static unsigned char prg[0x400];
+static unsigned int prg_len;
+static unsigned int prg_org;
+
+static void emit(unsigned int value)
+{
+    if (prg_len >= sizeof(prg)) {
+        fprintf(stderr, "program too long\n");
+        exit(1);
+    }
+    prg[prg_len++] = (unsigned char)value;
+}
+
+static unsigned int here(void)
+{
+    return prg_org + prg_len;
+}
+
+static void op(unsigned int opcode)
+{
+    emit(opcode);
+}
+
+static void op8(unsigned int opcode, unsigned int value)
+{
+    emit(opcode);
+    emit(value & 0xff);
+}
+
+static void op16(unsigned int opcode, unsigned int addr)
+{
+    emit(opcode);
+    emit(addr & 0xff);
+    emit(addr >> 8);
+}
+
+/* branch back to an address taken with here() */
+static void branch(unsigned int opcode, unsigned int target)
+{
+    int offset = (int)target - (int)(here() + 2);
+
+    if (offset < -128) {
+        fprintf(stderr, "branch out of range\n");
+        exit(1);
+    }
+    op8(opcode, (unsigned int)offset);
+}
+
+/* forward branch, returns the position that land() patches */
+static unsigned int branch_forward(unsigned int opcode)
+{
+    op8(opcode, 0);
+    return prg_len - 1;
+}
+
+static void land(unsigned int pos)
+{
+    unsigned int offset = prg_len - (pos + 1);
+
+    if (offset > 127) {
+        fprintf(stderr, "branch out of range\n");
+        exit(1);
+    }
+    prg[pos] = (unsigned char)offset;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Just the BASIC V2 keywords the programs use; BASIC 3.5 has the same
+   tokens for them. */
+static const struct {
+    const char *keyword;
+    unsigned int token;
+} keywords[] = {
+    { "FOR", 0x81 }, { "NEXT", 0x82 }, { "GOTO", 0x89 }, { "POKE", 0x97 },
+    { "SYS", 0x9e }, { "TO", 0xa4 }, { "+", 0xaa }, { "*", 0xac },
+    { "/", 0xad }, { "AND", 0xaf }, { "=", 0xb2 }, { "SQR", 0xba },
+    { "LOG", 0xbc }, { "SIN", 0xbf }, { "PEEK", 0xc2 }
+};
+
+static void basic_line(unsigned int number, const char *text)
+{
+    unsigned int link = prg_len;
+    size_t i;
+
+    emit(0);
+    emit(0);
+    emit(number & 0xff);
+    emit(number >> 8);
+    while (*text != 0) {
+        for (i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+            size_t len = strlen(keywords[i].keyword);
+
+            if (strncmp(text, keywords[i].keyword, len) == 0) {
+                emit(keywords[i].token);
+                text += len;
+                break;
+            }
+        }
+        if (i == sizeof(keywords) / sizeof(keywords[0])) {
+            emit((unsigned char)*text++);
+        }
+    }
+    emit(0);
+    prg[link] = here() & 0xff;
+    prg[link + 1] = here() >> 8;
+}
+
+static void basic_end(void)
+{
+    emit(0);
+    emit(0);
+}
+
+/* "10 SYS<start>" in front of the machine code, which follows directly */
+static void sys_stub(void)
+{
+    char text[16];
+
+    /* the line is 12 bytes long for a four digit address */
+    sprintf(text, "SYS%u", prg_org + 12);
+    basic_line(10, text);
+    basic_end();
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void write_basic(const bench_machine_t *m)
+{
+    char text[64];
+
+    sprintf(text, "S=%u", m->screen);
+    basic_line(10, text);
+    basic_line(20, "FORA=1TO100:B=SQR(A)*SIN(A)/LOG(A+1):NEXT");
+    basic_line(30, "POKES,PEEK(S)+1AND255:GOTO20");
+    basic_end();
+}
+
+static void write_sieve(const bench_machine_t *m)
+{
+    unsigned int buf = m->buffer >> 8;
+    unsigned int pass, fill, outer, inner;
+    unsigned int to_next, to_next2, to_chk;
+
+    sys_stub();
+    op(0x78);                   /* sei */
+    pass = here();
+    /* set all 2048 flags */
+    op8(0xa9, 0x00);            /* lda #0 */
+    op8(0x85, 0xfb);            /* sta $fb */
+    op8(0xa9, buf);             /* lda #>buffer */
+    op8(0x85, 0xfc);            /* sta $fc */
+    op8(0xa2, 0x08);            /* ldx #8 */
+    op8(0xa9, 0x01);            /* lda #1 */
+    op8(0xa0, 0x00);            /* ldy #0 */
+    fill = here();
+    op8(0x91, 0xfb);            /* sta ($fb),y */
+    op(0xc8);                   /* iny */
+    branch(0xd0, fill);         /* bne fill */
+    op8(0xe6, 0xfc);            /* inc $fc */
+    op(0xca);                   /* dex */
+    branch(0xd0, fill);         /* bne fill */
+    /* i = 2 */
+    op8(0xa9, 0x02);            /* lda #2 */
+    op8(0x85, 0xfd);            /* sta $fd */
+    op8(0xa9, 0x00);            /* lda #0 */
+    op8(0x85, 0xfe);            /* sta $fe */
+    outer = here();
+    /* p = buffer + i; skip i if it is crossed out */
+    op8(0xa5, 0xfd);            /* lda $fd */
+    op8(0x85, 0xfb);            /* sta $fb */
+    op8(0xa5, 0xfe);            /* lda $fe */
+    op(0x18);                   /* clc */
+    op8(0x69, buf);             /* adc #>buffer */
+    op8(0x85, 0xfc);            /* sta $fc */
+    op8(0xb1, 0xfb);            /* lda ($fb),y */
+    to_next = branch_forward(0xf0); /* beq next */
+    /* cross out p + i, p + 2i, ... */
+    inner = here();
+    op(0x18);                   /* clc */
+    op8(0xa5, 0xfb);            /* lda $fb */
+    op8(0x65, 0xfd);            /* adc $fd */
+    op8(0x85, 0xfb);            /* sta $fb */
+    op8(0xa5, 0xfc);            /* lda $fc */
+    op8(0x65, 0xfe);            /* adc $fe */
+    op8(0x85, 0xfc);            /* sta $fc */
+    op8(0xc9, buf + 8);         /* cmp #>buffer + 8 */
+    to_next2 = branch_forward(0xb0); /* bcs next */
+    op8(0xa9, 0x00);            /* lda #0 */
+    op8(0x91, 0xfb);            /* sta ($fb),y */
+    branch(0xf0, inner);        /* beq inner */
+    /* next: i++ */
+    land(to_next);
+    land(to_next2);
+    op8(0xe6, 0xfd);            /* inc $fd */
+    to_chk = branch_forward(0xd0); /* bne chk */
+    op8(0xe6, 0xfe);            /* inc $fe */
+    land(to_chk);
+    op8(0xa5, 0xfe);            /* lda $fe */
+    op8(0xc9, 0x08);            /* cmp #8 */
+    branch(0x90, outer);        /* bcc outer */
+    op16(0xee, m->screen);      /* inc screen */
+    op16(0x4c, pass);           /* jmp pass */
+}
+
+static void write_crc(const bench_machine_t *m)
+{
+    unsigned int pass, byte, bit, to_nox;
+
+    sys_stub();
+    op(0x78);                   /* sei */
+    pass = here();
+    op8(0xa9, 0x00);            /* lda #0 */
+    op8(0x85, 0xfb);            /* sta $fb */
+    op8(0xa9, m->rom >> 8);     /* lda #>rom */
+    op8(0x85, 0xfc);            /* sta $fc */
+    op8(0xa9, 0x20);            /* lda #32 */
+    op8(0x85, 0xf7);            /* sta $f7 */
+    op8(0xa9, 0xff);            /* lda #$ff */
+    op8(0x85, 0xfd);            /* sta $fd */
+    op8(0x85, 0xfe);            /* sta $fe */
+    op8(0xa0, 0x00);            /* ldy #0 */
+    byte = here();
+    op8(0xb1, 0xfb);            /* lda ($fb),y */
+    op8(0x45, 0xfe);            /* eor $fe */
+    op8(0x85, 0xfe);            /* sta $fe */
+    op8(0xa2, 0x08);            /* ldx #8 */
+    bit = here();
+    op8(0x06, 0xfd);            /* asl $fd */
+    op8(0x26, 0xfe);            /* rol $fe */
+    to_nox = branch_forward(0x90); /* bcc nox */
+    op8(0xa5, 0xfe);            /* lda $fe */
+    op8(0x49, 0x10);            /* eor #$10 */
+    op8(0x85, 0xfe);            /* sta $fe */
+    op8(0xa5, 0xfd);            /* lda $fd */
+    op8(0x49, 0x21);            /* eor #$21 */
+    op8(0x85, 0xfd);            /* sta $fd */
+    land(to_nox);
+    op(0xca);                   /* dex */
+    branch(0xd0, bit);          /* bne bit */
+    op(0xc8);                   /* iny */
+    branch(0xd0, byte);         /* bne byte */
+    op8(0xe6, 0xfc);            /* inc $fc */
+    op8(0xc6, 0xf7);            /* dec $f7 */
+    branch(0xd0, byte);         /* bne byte */
+    op16(0xee, m->screen);      /* inc screen */
+    op8(0xa5, 0xfd);            /* lda $fd */
+    op16(0x8d, m->screen + 1);  /* sta screen + 1 */
+    op8(0xa5, 0xfe);            /* lda $fe */
+    op16(0x8d, m->screen + 2);  /* sta screen + 2 */
+    op16(0x4c, pass);           /* jmp pass */
+}
+
+static void write_ops(const bench_machine_t *m)
+{
+    unsigned int buf = m->buffer;
+    unsigned int pass, fill, loop;
+
+    sys_stub();
+    op(0x78);                   /* sei */
+    pass = here();
+    /* every pass starts from the same buffer, so the sum is the same */
+    op8(0xa2, 0x00);            /* ldx #0 */
+    fill = here();
+    op(0x8a);                   /* txa */
+    op16(0x9d, buf);            /* sta buffer,x */
+    op16(0x9d, buf + 0x100);    /* sta buffer + $100,x */
+    op(0xe8);                   /* inx */
+    branch(0xd0, fill);         /* bne fill */
+    op8(0xa9, buf & 0xff);      /* lda #<buffer */
+    op8(0x85, 0xfb);            /* sta $fb */
+    op8(0xa9, buf >> 8);        /* lda #>buffer */
+    op8(0x85, 0xfc);            /* sta $fc */
+    op8(0xa9, 0x00);            /* lda #0 */
+    op8(0x85, 0xf8);            /* sta $f8 */
+    op8(0x85, 0xf9);            /* sta $f9 */
+    op(0x18);                   /* clc */
+    loop = here();
+    op(0x8a);                   /* txa */
+    op8(0x85, 0xfa);            /* sta $fa */
+    op8(0x65, 0xfa);            /* adc $fa */
+    op16(0x5d, buf);            /* eor buffer,x */
+    op16(0x9d, buf);            /* sta buffer,x */
+    op8(0xa4, 0xfa);            /* ldy $fa */
+    op16(0x39, buf + 0x80);     /* and buffer + $80,y */
+    op8(0xe9, 0x37);            /* sbc #$37 */
+    op(0xf8);                   /* sed */
+    op8(0x69, 0x19);            /* adc #$19 */
+    op8(0xe5, 0xfa);            /* sbc $fa */
+    op(0xd8);                   /* cld */
+    op(0x2a);                   /* rol a */
+    op8(0x66, 0xfa);            /* ror $fa */
+    op8(0x06, 0xfa);            /* asl $fa */
+    op(0x4a);                   /* lsr a */
+    op8(0x24, 0xfa);            /* bit $fa */
+    op(0x08);                   /* php */
+    op16(0xfe, buf);            /* inc buffer,x */
+    op16(0xde, buf + 0x100);    /* dec buffer + $100,x */
+    op(0x28);                   /* plp */
+    op8(0x11, 0xfb);            /* ora ($fb),y */
+    op8(0x86, 0xf7);            /* stx $f7 */
+    op8(0xa2, 0x00);            /* ldx #0 */
+    op8(0xc1, 0xfb);            /* cmp ($fb,x) */
+    op8(0xa6, 0xf7);            /* ldx $f7 */
+    op(0xa8);                   /* tay */
+    op8(0xc0, 0x80);            /* cpy #$80 */
+    op(0x2a);                   /* rol a */
+    op(0x48);                   /* pha */
+    op(0x68);                   /* pla */
+    op(0x18);                   /* clc */
+    op8(0x65, 0xf8);            /* adc $f8 */
+    op8(0x85, 0xf8);            /* sta $f8 */
+    op8(0xa9, 0x00);            /* lda #0 */
+    op8(0x65, 0xf9);            /* adc $f9 */
+    op8(0x85, 0xf9);            /* sta $f9 */
+    op(0xe8);                   /* inx */
+    branch(0xd0, loop);         /* bne loop */
+    op16(0xee, m->screen);      /* inc screen */
+    op8(0xa5, 0xf8);            /* lda $f8 */
+    op16(0x8d, m->screen + 1);  /* sta screen + 1 */
+    op8(0xa5, 0xf9);            /* lda $f9 */
+    op16(0x8d, m->screen + 2);  /* sta screen + 2 */
+    op16(0x4c, pass);           /* jmp pass */
+}
+
+static void write_rle(const bench_machine_t *m)
+{
+    unsigned int pass, next;
+    unsigned int to_same, to_done, to_flush, to_flush2, to_no_carry;
+
+    sys_stub();
+    op(0x78);                   /* sei */
+    pass = here();
+    op8(0xa9, 0x00);            /* lda #0 */
+    op8(0x85, 0xfb);            /* sta $fb */
+    op8(0x85, 0xfd);            /* sta $fd */
+    op8(0xa9, m->rom >> 8);     /* lda #>rom */
+    op8(0x85, 0xfc);            /* sta $fc */
+    op8(0xa9, m->buffer >> 8);  /* lda #>buffer */
+    op8(0x85, 0xfe);            /* sta $fe */
+    op8(0xa9, 0x04);            /* lda #4 */
+    op8(0x85, 0xf7);            /* sta $f7 */
+    op8(0xa0, 0x00);            /* ldy #0 */
+    op8(0xb1, 0xfb);            /* lda ($fb),y */
+    op8(0x85, 0xf8);            /* sta $f8 */
+    op8(0xa2, 0x01);            /* ldx #1 */
+    /* next byte of the input */
+    next = here();
+    op8(0xe6, 0xfb);            /* inc $fb */
+    to_same = branch_forward(0xd0); /* bne same_page */
+    op8(0xe6, 0xfc);            /* inc $fc */
+    op8(0xc6, 0xf7);            /* dec $f7 */
+    to_done = branch_forward(0xf0); /* beq done */
+    land(to_same);
+    op8(0xb1, 0xfb);            /* lda ($fb),y */
+    op8(0xc5, 0xf8);            /* cmp $f8 */
+    to_flush = branch_forward(0xd0); /* bne flush */
+    op8(0xe0, 0xff);            /* cpx #$ff */
+    to_flush2 = branch_forward(0xf0); /* beq flush */
+    op(0xe8);                   /* inx */
+    branch(0xd0, next);         /* bne next */
+    /* write the run as count and byte, start a new one with A */
+    land(to_flush);
+    land(to_flush2);
+    op(0x48);                   /* pha */
+    op(0x8a);                   /* txa */
+    op8(0x91, 0xfd);            /* sta ($fd),y */
+    op8(0xa5, 0xf8);            /* lda $f8 */
+    op(0xc8);                   /* iny */
+    op8(0x91, 0xfd);            /* sta ($fd),y */
+    op(0x88);                   /* dey */
+    op(0x18);                   /* clc */
+    op8(0xa5, 0xfd);            /* lda $fd */
+    op8(0x69, 0x02);            /* adc #2 */
+    op8(0x85, 0xfd);            /* sta $fd */
+    to_no_carry = branch_forward(0x90); /* bcc no_carry */
+    op8(0xe6, 0xfe);            /* inc $fe */
+    land(to_no_carry);
+    op(0x68);                   /* pla */
+    op8(0x85, 0xf8);            /* sta $f8 */
+    op8(0xa2, 0x01);            /* ldx #1 */
+    branch(0xd0, next);         /* bne next */
+    /* done: show the length of the output */
+    land(to_done);
+    op16(0xee, m->screen);      /* inc screen */
+    op8(0xa5, 0xfd);            /* lda $fd */
+    op16(0x8d, m->screen + 1);  /* sta screen + 1 */
+    op8(0xa5, 0xfe);            /* lda $fe */
+    op16(0x8d, m->screen + 2);  /* sta screen + 2 */
+    op16(0x4c, pass);           /* jmp pass */
+}
+
+/* ------------------------------------------------------------------------- */
+
+static const struct {
+    const char *name;
+    void (*write)(const bench_machine_t *m);
+} programs[] = {
+    { "basic", write_basic },
+    { "ops", write_ops },
+    { "sieve", write_sieve },
+    { "crc", write_crc },
+    { "rle", write_rle }
+};
+
+int main(int argc, char **argv)
+{
+    const bench_machine_t *m = NULL;
+    const char *program;
+    size_t i;
+    FILE *f;
+
+    if (argc != 3 || (program = strchr(argv[1], '-')) == NULL) {
+        fprintf(stderr, "usage: %s machine-program file\n"
+                "machine is c64, vic20 or plus4, program is basic, ops, sieve, crc or rle\n",
+                argv[0]);
+        return 1;
+    }
+    program++;
+
+    for (i = 0; i < sizeof(machines) / sizeof(machines[0]); i++) {
+        if (strncmp(argv[1], machines[i].name, strlen(machines[i].name)) == 0
+            && argv[1][strlen(machines[i].name)] == '-') {
+            m = &machines[i];
+        }
+    }
+    if (m == NULL) {
+        fprintf(stderr, "unknown machine in %s\n", argv[1]);
+        return 1;
+    }
+
+    prg_org = m->load;
+    prg_len = 0;
+    for (i = 0; i < sizeof(programs) / sizeof(programs[0]); i++) {
+        if (strcmp(program, programs[i].name) == 0) {
+            programs[i].write(m);
+            break;
+        }
+    }
+    if (i == sizeof(programs) / sizeof(programs[0])) {
+        fprintf(stderr, "unknown program %s\n", program);
+        return 1;
+    }
+
+    f = fopen(argv[2], "wb");
+    if (f == NULL) {
+        perror(argv[2]);
+        return 1;
+    }
+    if (fputc(m->load & 0xff, f) == EOF
+        || fputc(m->load >> 8, f) == EOF
+        || fwrite(prg, 1, prg_len, f) != prg_len
+        || fclose(f) != 0) {
+        perror(argv[2]);
+        return 1;
+    }
+    return 0;
+}
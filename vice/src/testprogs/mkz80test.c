@@ -0,0 +1,611 @@
+/*
+ * mkz80test.c - Write a Z80 instruction exerciser for the C128.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * Writes a C128 program in the spirit of zexdoc. The 8502 part puts a JP
+ * to the Z80 code at $ffee, where the Z80 continues when it is switched on,
+ * and hands the bus to the Z80 through $d505.
+ *
+ * For each instruction in the table below the Z80 fills the memory operand,
+ * IY, IX, HL, DE, BC and AF with pseudo random values (a 16 bit xorshift
+ * that starts from the same seed on every pass), points HL or IX/IY at the
+ * memory operand where the instruction uses one, runs the instruction and
+ * feeds the memory operand and all registers afterwards into a CRC-16
+ * (CCITT). Only the documented flags go into the CRC. This covers the
+ * unprefixed, CB, DD, ED, FD and DDCB/FDCB opcodes, read-modify-write on
+ * RAM and the indexed addressing, both through the opcode fetch and through
+ * data reads.
+ *
+ * When all instructions are done the Z80 hands the bus back. The 8502
+ * shows one CRC per instruction, in the order of the table, from the
+ * second line of the 40 column screen and counts the passes in the top
+ * left character. The CRCs must be the same for every build; unlike
+ * zexdoc the program has no list of the values of a real Z80, so it
+ * compares builds, not an emulator against the hardware.
+ *
+ *   mkz80test z80test.prg
+ *   x128 -autostart z80test.prg -limitcycles 40000000 -exitscreenshotvicii z80test.png
+ *
+ * A pass takes about 25 million cycles. "cpubench.sh x128 z80test.prg"
+ * prints the emulated cycles per second while it runs.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOAD_ADDR   0x1c01      /* start of BASIC 7.0 */
+#define SCREEN      0x0400
+
+/* Z80 data, above the program */
+#define STATE       0x2800      /* memop, IY, IX, HL, DE, BC, AF */
+#define STATE_LEN   14
+#define DONE        0x2810      /* set by the Z80 when a pass is done */
+#define SPSAVE      0x2812
+#define TPTR        0x2814
+#define CPTR        0x2816
+#define ITER        0x2818
+#define TFLAGS      0x2819
+#define TMASK       0x281a
+#define CRC         0x281c
+#define CRCS        0x2900
+#define Z80_STACK   0x3000
+
+#define ITERATIONS  64
+
+/* how the instruction uses memory */
+#define T_HL        0x01        /* HL points to the memory operand */
+#define T_IXIY      0x02        /* IX and IY point to it, minus 1 */
+
+#define FLAGS_DOC   0xd7        /* S Z H P/V N C */
+
+typedef struct z80_test_s {
+    unsigned char flags;
+    unsigned char insn[4];      /* padded with NOPs */
+} z80_test_t;
+
+static const z80_test_t tests[] = {
+    /* 8 bit arithmetic and logic with a register, (HL), (IX+1) and n */
+    { 0,      { 0x80, 0, 0, 0 } },          /* add a,b */
+    { T_HL,   { 0x86, 0, 0, 0 } },          /* add a,(hl) */
+    { T_IXIY, { 0xdd, 0x86, 0x01, 0 } },    /* add a,(ix+1) */
+    { 0,      { 0xc6, 0x5a, 0, 0 } },       /* add a,$5a */
+    { 0,      { 0x87, 0, 0, 0 } },          /* add a,a */
+    { 0,      { 0x89, 0, 0, 0 } },          /* adc a,c */
+    { T_HL,   { 0x8e, 0, 0, 0 } },          /* adc a,(hl) */
+    { T_IXIY, { 0xfd, 0x8e, 0x01, 0 } },    /* adc a,(iy+1) */
+    { 0,      { 0xce, 0xa5, 0, 0 } },       /* adc a,$a5 */
+    { 0,      { 0x92, 0, 0, 0 } },          /* sub d */
+    { T_HL,   { 0x96, 0, 0, 0 } },          /* sub (hl) */
+    { T_IXIY, { 0xdd, 0x96, 0x01, 0 } },    /* sub (ix+1) */
+    { 0,      { 0xd6, 0x5a, 0, 0 } },       /* sub $5a */
+    { 0,      { 0x9b, 0, 0, 0 } },          /* sbc a,e */
+    { T_HL,   { 0x9e, 0, 0, 0 } },          /* sbc a,(hl) */
+    { T_IXIY, { 0xfd, 0x9e, 0x01, 0 } },    /* sbc a,(iy+1) */
+    { 0,      { 0xde, 0xa5, 0, 0 } },       /* sbc a,$a5 */
+    { 0,      { 0xa4, 0, 0, 0 } },          /* and h */
+    { T_HL,   { 0xa6, 0, 0, 0 } },          /* and (hl) */
+    { T_IXIY, { 0xdd, 0xa6, 0x01, 0 } },    /* and (ix+1) */
+    { 0,      { 0xe6, 0x5a, 0, 0 } },       /* and $5a */
+    { 0,      { 0xad, 0, 0, 0 } },          /* xor l */
+    { T_HL,   { 0xae, 0, 0, 0 } },          /* xor (hl) */
+    { T_IXIY, { 0xfd, 0xae, 0x01, 0 } },    /* xor (iy+1) */
+    { 0,      { 0xee, 0xa5, 0, 0 } },       /* xor $a5 */
+    { 0,      { 0xb0, 0, 0, 0 } },          /* or b */
+    { T_HL,   { 0xb6, 0, 0, 0 } },          /* or (hl) */
+    { T_IXIY, { 0xdd, 0xb6, 0x01, 0 } },    /* or (ix+1) */
+    { 0,      { 0xf6, 0x5a, 0, 0 } },       /* or $5a */
+    { 0,      { 0xb9, 0, 0, 0 } },          /* cp c */
+    { T_HL,   { 0xbe, 0, 0, 0 } },          /* cp (hl) */
+    { T_IXIY, { 0xfd, 0xbe, 0x01, 0 } },    /* cp (iy+1) */
+    { 0,      { 0xfe, 0xa5, 0, 0 } },       /* cp $a5 */
+    { 0,      { 0xdd, 0x84, 0, 0 } },       /* add a,ixh */
+    /* 8 bit increment and decrement */
+    { 0,      { 0x3c, 0, 0, 0 } },          /* inc a */
+    { 0,      { 0x3d, 0, 0, 0 } },          /* dec a */
+    { 0,      { 0x24, 0, 0, 0 } },          /* inc h */
+    { 0,      { 0x2d, 0, 0, 0 } },          /* dec l */
+    { T_HL,   { 0x34, 0, 0, 0 } },          /* inc (hl) */
+    { T_IXIY, { 0xdd, 0x35, 0x01, 0 } },    /* dec (ix+1) */
+    /* 16 bit arithmetic */
+    { 0,      { 0x09, 0, 0, 0 } },          /* add hl,bc */
+    { 0,      { 0x29, 0, 0, 0 } },          /* add hl,hl */
+    { 0,      { 0xed, 0x5a, 0, 0 } },       /* adc hl,de */
+    { 0,      { 0xed, 0x42, 0, 0 } },       /* sbc hl,bc */
+    { 0,      { 0xdd, 0x19, 0, 0 } },       /* add ix,de */
+    { 0,      { 0xfd, 0x09, 0, 0 } },       /* add iy,bc */
+    { 0,      { 0x13, 0, 0, 0 } },          /* inc de */
+    { 0,      { 0x0b, 0, 0, 0 } },          /* dec bc */
+    /* accumulator rotates and misc */
+    { 0,      { 0x07, 0, 0, 0 } },          /* rlca */
+    { 0,      { 0x0f, 0, 0, 0 } },          /* rrca */
+    { 0,      { 0x17, 0, 0, 0 } },          /* rla */
+    { 0,      { 0x1f, 0, 0, 0 } },          /* rra */
+    { 0,      { 0x27, 0, 0, 0 } },          /* daa */
+    { 0,      { 0x2f, 0, 0, 0 } },          /* cpl */
+    { 0,      { 0x37, 0, 0, 0 } },          /* scf */
+    { 0,      { 0x3f, 0, 0, 0 } },          /* ccf */
+    { 0,      { 0xed, 0x44, 0, 0 } },       /* neg */
+    /* CB shifts and rotates */
+    { 0,      { 0xcb, 0x00, 0, 0 } },       /* rlc b */
+    { 0,      { 0xcb, 0x09, 0, 0 } },       /* rrc c */
+    { 0,      { 0xcb, 0x12, 0, 0 } },       /* rl d */
+    { 0,      { 0xcb, 0x1b, 0, 0 } },       /* rr e */
+    { 0,      { 0xcb, 0x24, 0, 0 } },       /* sla h */
+    { 0,      { 0xcb, 0x2d, 0, 0 } },       /* sra l */
+    { 0,      { 0xcb, 0x3f, 0, 0 } },       /* srl a */
+    { T_HL,   { 0xcb, 0x06, 0, 0 } },       /* rlc (hl) */
+    { T_HL,   { 0xcb, 0x1e, 0, 0 } },       /* rr (hl) */
+    { T_IXIY, { 0xdd, 0xcb, 0x01, 0x16 } }, /* rl (ix+1) */
+    { T_IXIY, { 0xfd, 0xcb, 0x01, 0x2e } }, /* sra (iy+1) */
+    /* bit, set and res */
+    { 0,      { 0xcb, 0x5f, 0, 0 } },       /* bit 3,a */
+    { T_HL,   { 0xcb, 0x7e, 0, 0 } },       /* bit 7,(hl) */
+    { T_IXIY, { 0xdd, 0xcb, 0x01, 0x46 } }, /* bit 0,(ix+1) */
+    { 0,      { 0xcb, 0xe8, 0, 0 } },       /* set 5,b */
+    { T_HL,   { 0xcb, 0x96, 0, 0 } },       /* res 2,(hl) */
+    { T_IXIY, { 0xfd, 0xcb, 0x01, 0xfe } }, /* set 7,(iy+1) */
+    /* decimal rotates */
+    { T_HL,   { 0xed, 0x67, 0, 0 } },       /* rrd */
+    { T_HL,   { 0xed, 0x6f, 0, 0 } },       /* rld */
+    /* loads */
+    { T_IXIY, { 0xdd, 0x7e, 0x01, 0 } },    /* ld a,(ix+1) */
+    { T_IXIY, { 0xfd, 0x70, 0x01, 0 } },    /* ld (iy+1),b */
+    { T_HL,   { 0x5e, 0, 0, 0 } },          /* ld e,(hl) */
+    { T_HL,   { 0x71, 0, 0, 0 } },          /* ld (hl),c */
+    { 0,      { 0xeb, 0, 0, 0 } }           /* ex de,hl */
+};
+
+#define NUM_TESTS   (sizeof(tests) / sizeof(tests[0]))
+
+/* ------------------------------------------------------------------------- */
+
+/* The program, without the load address */
+static unsigned char prg[0x1000];
+static unsigned int prg_len;
+static unsigned int prg_org;
+
+static void emit(unsigned int value)
+{
+    if (prg_len >= sizeof(prg)) {
+        fprintf(stderr, "program too long\n");
+        exit(1);
+    }
+    prg[prg_len++] = (unsigned char)value;
+}
+
+static unsigned int here(void)
+{
+    return prg_org + prg_len;
+}
+
+static void op(unsigned int opcode)
+{
+    emit(opcode);
+}
+
+static void op8(unsigned int opcode, unsigned int value)
+{
+    emit(opcode);
+    emit(value & 0xff);
+}
+
+static void op16(unsigned int opcode, unsigned int addr)
+{
+    emit(opcode);
+    emit(addr & 0xff);
+    emit(addr >> 8);
+}
+
+/* Z80 opcodes with a prefix byte */
+static void pop16(unsigned int prefix, unsigned int opcode, unsigned int addr)
+{
+    emit(prefix);
+    op16(opcode, addr);
+}
+
+/* 16 bit operand that is not known yet, returns the position for patch() */
+static unsigned int op16_forward(unsigned int opcode)
+{
+    op16(opcode, 0);
+    return prg_len - 2;
+}
+
+static void patch(unsigned int pos, unsigned int addr)
+{
+    prg[pos] = addr & 0xff;
+    prg[pos + 1] = addr >> 8;
+}
+
+/* relative branch back to an address taken with here(), for both CPUs */
+static void branch(unsigned int opcode, unsigned int target)
+{
+    int offset = (int)target - (int)(here() + 2);
+
+    if (offset < -128) {
+        fprintf(stderr, "branch out of range\n");
+        exit(1);
+    }
+    op8(opcode, (unsigned int)offset);
+}
+
+/* forward branch, returns the position that land() patches */
+static unsigned int branch_forward(unsigned int opcode)
+{
+    op8(opcode, 0);
+    return prg_len - 1;
+}
+
+static void land(unsigned int pos)
+{
+    unsigned int offset = prg_len - (pos + 1);
+
+    if (offset > 127) {
+        fprintf(stderr, "branch out of range\n");
+        exit(1);
+    }
+    prg[pos] = (unsigned char)offset;
+}
+
+/* "10 SYS<start>" in front of the machine code, which follows directly */
+static void sys_stub(void)
+{
+    char text[16];
+    size_t i;
+
+    /* the line is 10 bytes long for a four digit address */
+    emit((prg_org + 10) & 0xff);
+    emit((prg_org + 10) >> 8);
+    emit(10);
+    emit(0);
+    emit(0x9e);                 /* SYS */
+    sprintf(text, "%u", prg_org + 12);
+    for (i = 0; text[i] != 0; i++) {
+        emit((unsigned char)text[i]);
+    }
+    emit(0);
+    emit(0);
+    emit(0);
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* The 8502 side; returns the position of the Z80 entry address */
+static unsigned int write_8502(void)
+{
+    unsigned int cls, entry, pass, sw, crcl, hexout1, hexout2, nib;
+    unsigned int to_letter, to_store, to_nc;
+
+    sys_stub();
+    op(0x78);                   /* sei */
+    op8(0xa2, 0x00);            /* ldx #0 */
+    op8(0xa9, 0x20);            /* lda #' ' */
+    cls = here();
+    op16(0x9d, SCREEN);         /* sta screen,x */
+    op16(0x9d, SCREEN + 0x100); /* sta screen + $100,x */
+    op16(0x9d, SCREEN + 0x200); /* sta screen + $200,x */
+    op16(0x9d, SCREEN + 0x300); /* sta screen + $300,x */
+    op(0xe8);                   /* inx */
+    branch(0xd0, cls);          /* bne cls */
+    op8(0xa9, 0x3e);            /* lda #$3e */
+    op16(0x8d, 0xff00);         /* sta $ff00: RAM bank 0 and I/O */
+    op8(0xa9, 0xc3);            /* lda #$c3 */
+    op16(0x8d, 0xffee);         /* sta $ffee: jp entry */
+    entry = prg_len + 1;
+    op8(0xa9, 0);               /* lda #<entry */
+    op16(0x8d, 0xffef);         /* sta $ffef */
+    op8(0xa9, 0);               /* lda #>entry */
+    op16(0x8d, 0xfff0);         /* sta $fff0 */
+    pass = here();
+    op8(0xa9, 0x00);            /* lda #0 */
+    op16(0x8d, DONE);           /* sta done */
+    /* the first switch can end in the Z80 boot code, switch until the
+       Z80 says that it has done a pass */
+    sw = here();
+    op8(0xa9, 0xb0);            /* lda #$b0 */
+    op16(0x8d, 0xd505);         /* sta $d505: Z80 on */
+    op(0xea);                   /* nop */
+    op16(0xad, DONE);           /* lda done */
+    branch(0xf0, sw);           /* beq sw */
+    /* show the CRCs, eight to a line */
+    op8(0xa9, (SCREEN + 40) & 0xff);    /* lda #<screen + 40 */
+    op8(0x85, 0xfb);            /* sta $fb */
+    op8(0xa9, (SCREEN + 40) >> 8);      /* lda #>screen + 40 */
+    op8(0x85, 0xfc);            /* sta $fc */
+    op8(0xa2, 0x00);            /* ldx #0 */
+    crcl = here();
+    op8(0xa0, 0x00);            /* ldy #0 */
+    op16(0xbd, CRCS + 1);       /* lda crcs + 1,x */
+    hexout1 = op16_forward(0x20);       /* jsr hexout */
+    op16(0xbd, CRCS);           /* lda crcs,x */
+    hexout2 = op16_forward(0x20);       /* jsr hexout */
+    op(0x18);                   /* clc */
+    op8(0xa5, 0xfb);            /* lda $fb */
+    op8(0x69, 0x05);            /* adc #5 */
+    op8(0x85, 0xfb);            /* sta $fb */
+    to_nc = branch_forward(0x90);       /* bcc nc */
+    op8(0xe6, 0xfc);            /* inc $fc */
+    land(to_nc);
+    op(0xe8);                   /* inx */
+    op(0xe8);                   /* inx */
+    op8(0xe0, NUM_TESTS * 2);   /* cpx #tests * 2 */
+    branch(0xd0, crcl);         /* bne crcl */
+    op16(0xee, SCREEN);         /* inc screen */
+    op16(0x4c, pass);           /* jmp pass */
+
+    /* hexout: two screen code digits of A at ($fb),y */
+    patch(hexout1, here());
+    patch(hexout2, here());
+    op(0x48);                   /* pha */
+    op(0x4a);                   /* lsr a */
+    op(0x4a);                   /* lsr a */
+    op(0x4a);                   /* lsr a */
+    op(0x4a);                   /* lsr a */
+    nib = op16_forward(0x20);   /* jsr nib */
+    op(0x68);                   /* pla */
+    op8(0x29, 0x0f);            /* and #$0f */
+    patch(nib, here());
+    op8(0xc9, 0x0a);            /* cmp #10 */
+    to_letter = branch_forward(0xb0);   /* bcs letter */
+    op8(0x09, 0x30);            /* ora #$30 */
+    to_store = branch_forward(0x90);    /* bcc store */
+    land(to_letter);
+    op8(0xe9, 0x09);            /* sbc #9 */
+    land(to_store);
+    op8(0x91, 0xfb);            /* sta ($fb),y */
+    op(0xc8);                   /* iny */
+    op(0x60);                   /* rts */
+
+    return entry;
+}
+
+/* The Z80 side; returns its entry address */
+static unsigned int write_z80(void)
+{
+    unsigned int xrnd, fill, fl, run, insn, crc, cb, cbit, to_nox;
+    unsigned int entry, start, tests_addr, nexttest, to_done, iter;
+    unsigned int to_nohl, to_noix;
+    size_t i;
+
+    /* 16 bit xorshift, returns the next value in HL */
+    xrnd = here();
+    op16(0x21, 0x0001);         /* ld hl,seed */
+    op(0x7c);                   /* ld a,h */
+    op(0x1f);                   /* rra */
+    op(0x7d);                   /* ld a,l */
+    op(0x1f);                   /* rra */
+    op(0xac);                   /* xor h */
+    op(0x67);                   /* ld h,a */
+    op(0x7d);                   /* ld a,l */
+    op(0x1f);                   /* rra */
+    op(0x7c);                   /* ld a,h */
+    op(0x1f);                   /* rra */
+    op(0xad);                   /* xor l */
+    op(0x6f);                   /* ld l,a */
+    op(0xac);                   /* xor h */
+    op(0x67);                   /* ld h,a */
+    op16(0x22, xrnd + 1);       /* ld (seed),hl */
+    op(0xc9);                   /* ret */
+
+    /* fill: random memory operand and registers */
+    fill = here();
+    op16(0x11, STATE);          /* ld de,state */
+    op8(0x06, STATE_LEN / 2);   /* ld b,7 */
+    fl = here();
+    op(0xc5);                   /* push bc */
+    op(0xd5);                   /* push de */
+    op16(0xcd, xrnd);           /* call xrnd */
+    op(0xd1);                   /* pop de */
+    op(0xeb);                   /* ex de,hl */
+    op(0x73);                   /* ld (hl),e */
+    op(0x23);                   /* inc hl */
+    op(0x72);                   /* ld (hl),d */
+    op(0x23);                   /* inc hl */
+    op(0xeb);                   /* ex de,hl */
+    op(0xc1);                   /* pop bc */
+    branch(0x10, fl);           /* djnz fl */
+    op(0xc9);                   /* ret */
+
+    /* run: load the registers, run the instruction, save the registers */
+    run = here();
+    pop16(0xed, 0x73, SPSAVE);  /* ld (spsave),sp */
+    op16(0x31, STATE + 2);      /* ld sp,state + 2 */
+    op(0xfd);                   /* pop iy */
+    op(0xe1);
+    op(0xdd);                   /* pop ix */
+    op(0xe1);
+    op(0xe1);                   /* pop hl */
+    op(0xd1);                   /* pop de */
+    op(0xc1);                   /* pop bc */
+    op(0xf1);                   /* pop af */
+    pop16(0xed, 0x7b, SPSAVE);  /* ld sp,(spsave) */
+    insn = here();
+    for (i = 0; i < 4; i++) {
+        op(0x00);               /* the instruction */
+    }
+    op16(0x31, STATE + STATE_LEN);      /* ld sp,state + 14 */
+    op(0xf5);                   /* push af */
+    op(0xc5);                   /* push bc */
+    op(0xd5);                   /* push de */
+    op(0xe5);                   /* push hl */
+    op(0xdd);                   /* push ix */
+    op(0xe5);
+    op(0xfd);                   /* push iy */
+    op(0xe5);
+    pop16(0xed, 0x7b, SPSAVE);  /* ld sp,(spsave) */
+    op(0xc9);                   /* ret */
+
+    /* crc: CRC-16 of the state */
+    crc = here();
+    op16(0x21, STATE);          /* ld hl,state */
+    op8(0x06, STATE_LEN);       /* ld b,14 */
+    pop16(0xed, 0x5b, CRC);     /* ld de,(crc) */
+    cb = here();
+    op(0x7e);                   /* ld a,(hl) */
+    op(0xaa);                   /* xor d */
+    op(0x57);                   /* ld d,a */
+    op8(0x0e, 0x08);            /* ld c,8 */
+    cbit = here();
+    op8(0xcb, 0x23);            /* sla e */
+    op8(0xcb, 0x12);            /* rl d */
+    to_nox = branch_forward(0x30);      /* jr nc,nox */
+    op(0x7a);                   /* ld a,d */
+    op8(0xee, 0x10);            /* xor $10 */
+    op(0x57);                   /* ld d,a */
+    op(0x7b);                   /* ld a,e */
+    op8(0xee, 0x21);            /* xor $21 */
+    op(0x5f);                   /* ld e,a */
+    land(to_nox);
+    op(0x0d);                   /* dec c */
+    branch(0x20, cbit);         /* jr nz,cbit */
+    op(0x23);                   /* inc hl */
+    branch(0x10, cb);           /* djnz cb */
+    pop16(0xed, 0x53, CRC);     /* ld (crc),de */
+    op(0xc9);                   /* ret */
+
+    /* entry, from the jp at $ffee */
+    entry = here();
+    op(0xf3);                   /* di */
+    op16(0x31, Z80_STACK);      /* ld sp,stack */
+    start = here();
+    op16(0x21, 0x0001);         /* ld hl,1 */
+    op16(0x22, xrnd + 1);       /* ld (seed),hl */
+    tests_addr = op16_forward(0x21);    /* ld hl,tests */
+    op16(0x22, TPTR);           /* ld (tptr),hl */
+    op16(0x21, CRCS);           /* ld hl,crcs */
+    op16(0x22, CPTR);           /* ld (cptr),hl */
+    nexttest = here();
+    op16(0x2a, TPTR);           /* ld hl,(tptr) */
+    op(0x7e);                   /* ld a,(hl) */
+    op(0xb7);                   /* or a */
+    to_done = op16_forward(0xca);       /* jp z,done */
+    op16(0x32, ITER);           /* ld (iter),a */
+    op(0x23);                   /* inc hl */
+    op(0x7e);                   /* ld a,(hl) */
+    op16(0x32, TFLAGS);         /* ld (tflags),a */
+    op(0x23);                   /* inc hl */
+    op(0x7e);                   /* ld a,(hl) */
+    op16(0x32, TMASK);          /* ld (tmask),a */
+    op(0x23);                   /* inc hl */
+    op16(0x11, insn);           /* ld de,insn */
+    op16(0x01, 0x0004);         /* ld bc,4 */
+    op8(0xed, 0xb0);            /* ldir */
+    op16(0x22, TPTR);           /* ld (tptr),hl */
+    op16(0x21, 0xffff);         /* ld hl,$ffff */
+    op16(0x22, CRC);            /* ld (crc),hl */
+    iter = here();
+    op16(0xcd, fill);           /* call fill */
+    op16(0x3a, TFLAGS);         /* ld a,(tflags) */
+    op(0x0f);                   /* rrca */
+    to_nohl = branch_forward(0x30);     /* jr nc,nohl */
+    op16(0x21, STATE);          /* ld hl,state */
+    op16(0x22, STATE + 6);      /* ld (state + 6),hl */
+    land(to_nohl);
+    op(0x0f);                   /* rrca */
+    to_noix = branch_forward(0x30);     /* jr nc,noix */
+    op16(0x21, STATE - 1);      /* ld hl,state - 1 */
+    op16(0x22, STATE + 4);      /* ld (state + 4),hl */
+    op16(0x22, STATE + 2);      /* ld (state + 2),hl */
+    land(to_noix);
+    op16(0xcd, run);            /* call run */
+    op16(0x3a, TMASK);          /* ld a,(tmask) */
+    op(0x47);                   /* ld b,a */
+    op16(0x3a, STATE + 12);     /* ld a,(state + 12) */
+    op(0xa0);                   /* and b */
+    op16(0x32, STATE + 12);     /* ld (state + 12),a */
+    op16(0xcd, crc);            /* call crc */
+    op16(0x21, ITER);           /* ld hl,iter */
+    op(0x35);                   /* dec (hl) */
+    branch(0x20, iter);         /* jr nz,iter */
+    op16(0x2a, CRC);            /* ld hl,(crc) */
+    op(0xeb);                   /* ex de,hl */
+    op16(0x2a, CPTR);           /* ld hl,(cptr) */
+    op(0x73);                   /* ld (hl),e */
+    op(0x23);                   /* inc hl */
+    op(0x72);                   /* ld (hl),d */
+    op(0x23);                   /* inc hl */
+    op16(0x22, CPTR);           /* ld (cptr),hl */
+    op16(0xc3, nexttest);       /* jp nexttest */
+
+    /* done: hand the bus back to the 8502, start over when switched on */
+    patch(to_done, here());
+    op8(0x3e, 0x01);            /* ld a,1 */
+    op16(0x32, DONE);           /* ld (done),a */
+    op16(0x01, 0xd505);         /* ld bc,$d505 */
+    op8(0x3e, 0xb1);            /* ld a,$b1 */
+    op8(0xed, 0x79);            /* out (c),a */
+    op(0x00);                   /* nop */
+    op16(0xc3, start);          /* jp start */
+
+    /* iterations, flags, flag mask and instruction of each test */
+    patch(tests_addr, here());
+    for (i = 0; i < NUM_TESTS; i++) {
+        emit(ITERATIONS);
+        emit(tests[i].flags);
+        emit(FLAGS_DOC);
+        emit(tests[i].insn[0]);
+        emit(tests[i].insn[1]);
+        emit(tests[i].insn[2]);
+        emit(tests[i].insn[3]);
+    }
+    emit(0);
+
+    return entry;
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int entry_pos, entry;
+    FILE *f;
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s file\n", argv[0]);
+        return 1;
+    }
+
+    prg_org = LOAD_ADDR;
+    prg_len = 0;
+    entry_pos = write_8502();
+    entry = write_z80();
+    prg[entry_pos] = entry & 0xff;
+    prg[entry_pos + 5] = entry >> 8;
+    if (here() > STATE) {
+        fprintf(stderr, "program overlaps the data\n");
+        return 1;
+    }
+
+    f = fopen(argv[1], "wb");
+    if (f == NULL) {
+        perror(argv[1]);
+        return 1;
+    }
+    fputc(LOAD_ADDR & 0xff, f);
+    fputc(LOAD_ADDR >> 8, f);
+    if (fwrite(prg, 1, prg_len, f) != prg_len) {
+        perror(argv[1]);
+        fclose(f);
+        return 1;
+    }
+    fclose(f);
+    return 0;
+}
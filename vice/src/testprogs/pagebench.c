@@ -0,0 +1,272 @@
+/*
+ * pagebench.c - Time CPU memory accesses through function tables and
+ *               through page descriptors.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * The x64sc CPU used to call the read or store function of a page for
+ * every access. It now looks at the page descriptor (mem_page_t) first and
+ * accesses plain RAM and ROM through its base pointer. The emulator as a
+ * whole spends most of its time in the VIC-II, so the difference is hard
+ * to see there. This program times the two ways of accessing memory on
+ * their own, with the access mix of bankstress.prg (see mkbankstress.c):
+ * per round a read from BASIC ROM, RAM under the KERNAL, the character ROM
+ * and RAM under I/O, each in its own memory configuration, a store of the
+ * byte, and a push and pull on the stack.
+ *
+ * The tables are built the way c64memsc.c builds them for the eight
+ * configurations without a cartridge. The number printed is the best of
+ * five runs, in nanoseconds per access.
+ */
+
+#include "vice.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "c64/c64mem.h"
+#include "types.h"
+
+/* ------------------------------------------------------------------------- */
+
+#define NUM_CONFIGS     8
+#define NUM_PAGES       0x101
+
+static uint8_t ram[0x10000];
+static uint8_t basic_rom[0x2000];
+static uint8_t kernal_rom[0x2000];
+static uint8_t chargen_rom[0x1000];
+static uint8_t io[0x1000];
+
+static uint8_t bench_ram_read(uint16_t addr)
+{
+    return ram[addr];
+}
+
+static void bench_ram_store(uint16_t addr, uint8_t value)
+{
+    ram[addr] = value;
+}
+
+static uint8_t bench_basic_read(uint16_t addr)
+{
+    return basic_rom[addr & 0x1fff];
+}
+
+static uint8_t bench_kernal_read(uint16_t addr)
+{
+    return kernal_rom[addr & 0x1fff];
+}
+
+static uint8_t bench_chargen_read(uint16_t addr)
+{
+    return chargen_rom[addr & 0x0fff];
+}
+
+static uint8_t bench_io_read(uint16_t addr)
+{
+    return io[addr & 0x0fff];
+}
+
+static void bench_io_store(uint16_t addr, uint8_t value)
+{
+    io[addr & 0x0fff] = value;
+}
+
+/* The tables are not static, so that the compiler cannot see which
+   functions they hold and call them directly.  */
+
+/* the old way: one function per page and configuration */
+read_func_ptr_t read_tab[NUM_CONFIGS][NUM_PAGES];
+store_func_ptr_t store_tab[NUM_CONFIGS][NUM_PAGES];
+read_func_ptr_t *read_tab_ptr;
+store_func_ptr_t *store_tab_ptr;
+
+/* the new way */
+mem_page_t page_tab[NUM_CONFIGS][NUM_PAGES] VICE_ATTR_ALIGNED(64);
+mem_page_t *page_tab_ptr;
+
+static void tables_init(void)
+{
+    int config, page;
+
+    memset(page_tab, 0, sizeof(page_tab));
+
+    for (config = 0; config < NUM_CONFIGS; config++) {
+        for (page = 0; page < NUM_PAGES; page++) {
+            mem_page_t *p = &page_tab[config][page];
+            read_func_ptr_t read = bench_ram_read;
+            store_func_ptr_t store = bench_ram_store;
+            uint8_t *read_base = ram;
+            uint8_t *store_base = ram;
+
+            if (page >= 0xa0 && page < 0xc0 && (config & 3) == 3) {
+                read = bench_basic_read;
+                read_base = basic_rom - 0xa000;
+            }
+            if (page >= 0xe0 && page < 0x100 && (config & 2)) {
+                read = bench_kernal_read;
+                read_base = kernal_rom - 0xe000;
+            }
+            if (page >= 0xd0 && page < 0xe0 && (config & 3)) {
+                if (config & 4) {
+                    read = bench_io_read;
+                    store = bench_io_store;
+                    read_base = NULL;
+                    store_base = NULL;
+                } else {
+                    read = bench_chargen_read;
+                    read_base = chargen_rom - 0xd000;
+                }
+            }
+
+            read_tab[config][page] = read;
+            store_tab[config][page] = store;
+            p->read = read;
+            p->store = store;
+            p->read_base = read_base;
+            p->store_base = store_base;
+        }
+    }
+}
+
+/* same as mem_page_read() and mem_page_store() in mainc64cpu.c */
+inline static uint8_t page_read(unsigned int addr)
+{
+    const mem_page_t *page = &page_tab_ptr[addr >> 8];
+
+    if (page->read_base != NULL) {
+        return page->read_base[addr];
+    }
+    return page->read((uint16_t)addr);
+}
+
+inline static void page_store(unsigned int addr, uint8_t value)
+{
+    const mem_page_t *page = &page_tab_ptr[addr >> 8];
+
+    if (page->store_base != NULL) {
+        page->store_base[addr] = value;
+    } else {
+        page->store((uint16_t)addr, value);
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* $01 = $37, $35, $33, $34 */
+static const int round_config[4] = { 7, 5, 3, 4 };
+static const unsigned int round_source[4] = { 0xa000, 0xe000, 0xd000, 0xd000 };
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Returns the time of one run. The sum of the bytes read must not depend on
+   the way they were read.  */
+static double run(int descriptors, long rounds, unsigned int *sum)
+{
+    double start = now();
+    unsigned int x = 0;
+    long i;
+
+    for (i = 0; i < rounds; i++) {
+        int k = (int)(i & 3);
+        unsigned int src = round_source[k] + (x & 0xff);
+        unsigned int dst = 0x4000 + k * 0x100 + (x & 0xff);
+        unsigned int sp = 0x1ff - (unsigned int)(i & 0x3f);
+        uint8_t value;
+
+        if (descriptors) {
+            page_tab_ptr = page_tab[round_config[k]];
+            value = page_read(src);
+            page_store(dst, value);
+            page_store(sp, value);
+            value += page_read(sp);
+        } else {
+            read_tab_ptr = read_tab[round_config[k]];
+            store_tab_ptr = store_tab[round_config[k]];
+            value = read_tab_ptr[src >> 8]((uint16_t)src);
+            store_tab_ptr[dst >> 8]((uint16_t)dst, value);
+            store_tab_ptr[sp >> 8]((uint16_t)sp, value);
+            value += read_tab_ptr[sp >> 8]((uint16_t)sp);
+        }
+        *sum += value;
+        if (k == 3) {
+            x++;
+        }
+    }
+    return now() - start;
+}
+
+int main(int argc, char **argv)
+{
+    long rounds = argc > 1 ? atol(argv[1]) : 20000000;
+    unsigned int sum[2];
+    int descriptors;
+    int i;
+
+    if (rounds <= 0) {
+        fprintf(stderr, "usage: %s [rounds]\n", argv[0]);
+        return 1;
+    }
+
+    for (i = 0; i < 0x2000; i++) {
+        basic_rom[i] = (uint8_t)(i * 3);
+        kernal_rom[i] = (uint8_t)(i * 5);
+    }
+    for (i = 0; i < 0x1000; i++) {
+        chargen_rom[i] = (uint8_t)(i * 7);
+    }
+    tables_init();
+
+    for (descriptors = 0; descriptors < 2; descriptors++) {
+        double best = 0.0;
+
+        for (i = 0; i < 5; i++) {
+            double t;
+
+            sum[descriptors] = 0;
+            t = run(descriptors, rounds, &sum[descriptors]);
+
+            if (i == 0 || t < best) {
+                best = t;
+            }
+        }
+        /* four accesses per round */
+        printf("%-16s %.2f ns per access\n",
+               descriptors ? "descriptors:" : "function tables:",
+               best * 1e9 / ((double)rounds * 4));
+    }
+
+    if (sum[0] != sum[1]) {
+        printf("MISMATCH: the two ways read different bytes\n");
+        return 1;
+    }
+    return 0;
+}
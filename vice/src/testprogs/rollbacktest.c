@@ -0,0 +1,392 @@
+/*
+ * rollbacktest.c - Run the netplay rollback over a simulated link.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/*
+ * Two peers, a server and a client, each drive a small deterministic
+ * machine through rollback.c, the same way network.c drives the real one
+ * through the snapshot module. Their input is sent over a simulated link
+ * that delays every packet by a fixed latency plus a random jitter, both in
+ * frames, and keeps the packets in order like TCP does. The state summary
+ * of the newest final frame travels with every packet and is checked by the
+ * receiver.
+ *
+ * After the run the state of both machines is compared with a reference
+ * machine fed the same input without any delay. The rollback statistics
+ * show how much work the latency and jitter cost: the share of frames run
+ * with predicted input, the number of rollbacks, the frames run again per
+ * frame and the stalls when the window was used up.
+ *
+ * rollback.c is included directly, it only needs the lib_* allocators.
+ */
+
+#include "../rollback.c"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* ------------------------------------------------------------------------- */
+
+/* The few emulator functions rollback.c needs */
+
+void *lib_malloc(size_t size)
+{
+    void *p = malloc(size);
+
+    if (p == NULL) {
+        abort();
+    }
+    return p;
+}
+
+void *lib_calloc(size_t nmemb, size_t size)
+{
+    void *p = calloc(nmemb, size);
+
+    if (p == NULL) {
+        abort();
+    }
+    return p;
+}
+
+void lib_free(void *ptr)
+{
+    free(ptr);
+}
+
+/* ------------------------------------------------------------------------- */
+
+#define TEST_FRAMES     3000
+#define TEST_WORK       500     /* steps of the machine per frame */
+
+/* Small LCG, so that the run does not depend on the C library */
+static uint32_t test_seed;
+
+static uint32_t test_rand(void)
+{
+    test_seed = test_seed * 1103515245u + 12345u;
+    return test_seed >> 16;
+}
+
+/* The machine: one word of state and the held key of each side. An empty
+   input keeps the key held, like a joystick that was not touched. */
+typedef struct machine_s {
+    uint32_t state;
+    uint8_t key[2];
+} machine_t;
+
+static void machine_run_frame(machine_t *m)
+{
+    int i;
+
+    for (i = 0; i < TEST_WORK; i++) {
+        m->state = m->state * 1103515245u + 12345u + m->key[0] * 7u + m->key[1] * 13u;
+    }
+}
+
+typedef struct peer_s {
+    machine_t machine;
+    machine_t *slot;
+    rollback_t *rb;
+} peer_t;
+
+static int peer_save(void *context, unsigned int slot, uint32_t *sync)
+{
+    peer_t *peer = context;
+
+    peer->slot[slot] = peer->machine;
+    sync[0] = peer->machine.state;
+    sync[1] = peer->machine.key[0];
+    sync[2] = peer->machine.key[1];
+    sync[3] = 0;
+    sync[4] = 0;
+    return 0;
+}
+
+static int peer_load(void *context, unsigned int slot)
+{
+    peer_t *peer = context;
+
+    peer->machine = peer->slot[slot];
+    return 0;
+}
+
+static void peer_apply(void *context,
+                       const uint8_t *server, size_t server_len,
+                       const uint8_t *client, size_t client_len)
+{
+    peer_t *peer = context;
+
+    if (server_len > 0) {
+        peer->machine.key[0] = server[0];
+    }
+    if (client_len > 0) {
+        peer->machine.key[1] = client[0];
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* The link. Time is counted in frames of the local clock. */
+
+typedef struct packet_s {
+    unsigned int due;
+    unsigned int frame;
+    uint8_t input;
+    size_t len;
+    int have_sync;
+    unsigned int sync_frame;
+    uint32_t sync[ROLLBACK_SYNC_WORDS];
+    struct packet_s *next;
+} packet_t;
+
+static packet_t *link_queue[2];
+static unsigned int link_latency;
+static unsigned int link_jitter;
+
+static void link_send(int to, unsigned int now, rollback_t *rb,
+                      unsigned int frame, const uint8_t *input, size_t len)
+{
+    packet_t *p = lib_calloc(1, sizeof(packet_t));
+    packet_t **tail;
+    unsigned int due = now + link_latency;
+
+    if (link_jitter > 0) {
+        due += test_rand() % (link_jitter + 1);
+    }
+
+    p->frame = frame;
+    p->len = len;
+    if (len > 0) {
+        p->input = input[0];
+    }
+    p->have_sync = rollback_get_sync(rb, &p->sync_frame, p->sync) == 0;
+
+    /* a packet never overtakes an earlier one */
+    for (tail = &link_queue[to]; *tail != NULL; tail = &(*tail)->next) {
+        if ((*tail)->due > due) {
+            due = (*tail)->due;
+        }
+    }
+    p->due = due;
+    *tail = p;
+}
+
+/* Hand the packets that arrived by now to the peer. Returns -1 on error or
+   when the peer is out of sync. */
+static int link_receive(int to, unsigned int now, rollback_t *rb)
+{
+    packet_t *p;
+
+    while (link_queue[to] != NULL && link_queue[to]->due <= now) {
+        p = link_queue[to];
+        link_queue[to] = p->next;
+        if (rollback_add_remote_input(rb, p->frame, &p->input, p->len) < 0
+            || (p->have_sync && rollback_check_sync(rb, p->sync_frame, p->sync) < 0)) {
+            lib_free(p);
+            return -1;
+        }
+        lib_free(p);
+    }
+    return 0;
+}
+
+static void link_clear(void)
+{
+    packet_t *p;
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        while (link_queue[i] != NULL) {
+            p = link_queue[i];
+            link_queue[i] = p->next;
+            lib_free(p);
+        }
+    }
+}
+
+/* ------------------------------------------------------------------------- */
+
+static uint8_t input_value[2][TEST_FRAMES];
+static size_t input_len[2][TEST_FRAMES];
+
+/* Run the frames that are due on one peer. Returns -1 on error. */
+static int peer_tick(peer_t *peer, int side, unsigned int now)
+{
+    unsigned int frame;
+
+    if (rollback_must_wait(peer->rb)) {
+        return 0;
+    }
+
+    if (!rollback_is_resimulating(peer->rb)) {
+        frame = rollback_get_frame(peer->rb);
+        if (frame >= TEST_FRAMES) {
+            return 0;
+        }
+        /* press a new key every few frames */
+        if (test_rand() % 6 == 0) {
+            input_value[side][frame] = (uint8_t)test_rand();
+            input_len[side][frame] = 1;
+        }
+        if (rollback_add_local_input(peer->rb, &input_value[side][frame], input_len[side][frame]) < 0) {
+            return -1;
+        }
+        link_send(!side, now, peer->rb, frame, &input_value[side][frame], input_len[side][frame]);
+    }
+
+    /* a rollback runs all frames up to the live one at once */
+    do {
+        if (rollback_frame(peer->rb) < 0) {
+            return -1;
+        }
+        machine_run_frame(&peer->machine);
+    } while (rollback_is_resimulating(peer->rb));
+
+    return 0;
+}
+
+static int peer_done(peer_t *peer)
+{
+    return rollback_get_frame(peer->rb) >= TEST_FRAMES
+           && !rollback_is_resimulating(peer->rb);
+}
+
+/* Returns 0 if both peers end up in the state of the reference machine. */
+static int run_test(unsigned int window, unsigned int latency, unsigned int jitter)
+{
+    peer_t peer[2];
+    rollback_ops_t ops;
+    rollback_stats_t stats;
+    machine_t ref;
+    unsigned int now;
+    clock_t start;
+    double elapsed;
+    int failed = 0;
+    int i;
+
+    link_latency = latency;
+    link_jitter = jitter;
+    test_seed = 1;
+    memset(input_value, 0, sizeof(input_value));
+    memset(input_len, 0, sizeof(input_len));
+    memset(peer, 0, sizeof(peer));
+
+    ops.save = peer_save;
+    ops.load = peer_load;
+    ops.apply = peer_apply;
+    for (i = 0; i < 2; i++) {
+        ops.context = &peer[i];
+        peer[i].rb = rollback_new(window, i == 0, &ops);
+        if (peer[i].rb == NULL) {
+            fprintf(stderr, "window %u out of range\n", window);
+            exit(1);
+        }
+        peer[i].slot = lib_calloc(rollback_get_slots(peer[i].rb), sizeof(machine_t));
+    }
+
+    start = clock();
+    for (now = 0; !failed; now++) {
+        if (now > 100 * TEST_FRAMES) {
+            printf("  peers stuck at frames %u and %u\n",
+                   rollback_get_frame(peer[0].rb), rollback_get_frame(peer[1].rb));
+            failed = 1;
+            break;
+        }
+        for (i = 0; i < 2; i++) {
+            if (link_receive(i, now, peer[i].rb) < 0
+                || peer_tick(&peer[i], i, now) < 0) {
+                printf("  error or desync on peer %d at frame %u\n",
+                       i, rollback_get_frame(peer[i].rb));
+                failed = 1;
+                break;
+            }
+        }
+        if (peer_done(&peer[0]) && peer_done(&peer[1])
+            && link_queue[0] == NULL && link_queue[1] == NULL) {
+            break;
+        }
+    }
+    elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    memset(&ref, 0, sizeof(ref));
+    for (i = 0; i < TEST_FRAMES; i++) {
+        if (input_len[0][i] > 0) {
+            ref.key[0] = input_value[0][i];
+        }
+        if (input_len[1][i] > 0) {
+            ref.key[1] = input_value[1][i];
+        }
+        machine_run_frame(&ref);
+    }
+
+    printf("window %2u, latency %2u, jitter %2u: %.3fs\n", window, latency, jitter, elapsed);
+    for (i = 0; i < 2; i++) {
+        int same = memcmp(&peer[i].machine, &ref, sizeof(ref)) == 0;
+
+        rollback_get_stats(peer[i].rb, &stats);
+        printf("  %s: %s, %u frames, %u predicted, %u rollbacks, "
+               "%.2f resimulated per frame, max depth %u, %u stalls\n",
+               i == 0 ? "server" : "client", same ? "ok" : "MISMATCH",
+               stats.frames, stats.predicted, stats.rollbacks,
+               stats.frames ? (double)stats.resimulated / stats.frames : 0.0,
+               stats.max_depth, stats.stalls);
+        if (!same) {
+            failed = 1;
+        }
+        rollback_free(peer[i].rb);
+        lib_free(peer[i].slot);
+    }
+    link_clear();
+
+    return failed;
+}
+
+int main(int argc, char **argv)
+{
+    static const unsigned int cases[][3] = {
+        /* window, latency, jitter */
+        { 1, 0, 0 },
+        { 4, 2, 0 },
+        { 8, 2, 4 },
+        { 8, 6, 6 },
+        { 4, 8, 0 },
+        { ROLLBACK_WINDOW_MAX, 10, 10 }
+    };
+    int failed = 0;
+    size_t i;
+
+    if (argc == 4) {
+        return run_test((unsigned int)atoi(argv[1]), (unsigned int)atoi(argv[2]),
+                        (unsigned int)atoi(argv[3]));
+    }
+    if (argc != 1) {
+        fprintf(stderr, "usage: %s [window latency jitter]\n", argv[0]);
+        return 1;
+    }
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        failed |= run_test(cases[i][0], cases[i][1], cases[i][2]);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,745 @@
+/*
+ * vcaptool.c - Inspect, extract and compare VICE lossless captures.
+ *
+ * This file is part of VICE, the Versatile Commodore Emulator.
+ * See README for copyright notice.
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA
+ *  02111-1307  USA.
+ *
+ */
+
+/* Reads the files written by the VCAP gfxoutput driver, see
+   src/gfxoutputdrv/vcapdrv.h for the layout. */
+
+#include "vice.h"
+
+#include "version.h"
+
+#ifdef USE_SVN_REVISION
+# include "svnversion.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "vcapdrv.h"
+
+typedef struct vcap_index_s {
+    long frame_offset;
+    long palette_offset;
+    int type;
+} vcap_index_t;
+
+typedef struct vcap_file_s {
+    FILE *fd;
+    const char *name;
+    unsigned int width;
+    unsigned int height;
+    unsigned long cycles_per_frame;
+    unsigned long cycles_per_second;
+    unsigned long audio_rate;
+    unsigned int audio_channels;
+    unsigned int keyframe_interval;
+    char machine[VCAP_MACHINE_NAME_LEN + 1];
+    int closed;
+
+    vcap_index_t *index;
+    unsigned int frames;
+
+    /* decoder state */
+    uint8_t *frame;         /* palette indices of frame `current' */
+    uint8_t *delta;
+    uint8_t *chunk;
+    size_t chunk_size;
+    long current;
+    uint8_t palette[256 * 3];
+    long palette_offset;
+} vcap_file_t;
+
+static unsigned int le_word(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static unsigned long le_dword(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+static uint64_t le_qword(const uint8_t *p)
+{
+    return le_dword(p) | ((uint64_t)le_dword(p + 4) << 32);
+}
+
+static void le_put_word(uint8_t *p, unsigned int v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+}
+
+static void le_put_dword(uint8_t *p, unsigned long v)
+{
+    le_put_word(p, v & 0xffff);
+    le_put_word(p + 2, (v >> 16) & 0xffff);
+}
+
+static void *xrealloc(void *p, size_t size)
+{
+    p = realloc(p, size);
+    if (p == NULL) {
+        fprintf(stderr, "vcaptool: out of memory\n");
+        exit(2);
+    }
+    return p;
+}
+
+/* ------------------------------------------------------------------------- */
+
+/* Read the chunk header at `offset', return the payload size or -1. */
+static long vcap_chunk_at(vcap_file_t *vf, long offset, char *id)
+{
+    uint8_t buf[VCAP_CHUNK_HEADER_SIZE];
+
+    if (fseek(vf->fd, offset, SEEK_SET) != 0
+        || fread(buf, sizeof(buf), 1, vf->fd) != 1) {
+        return -1;
+    }
+    memcpy(id, buf, 4);
+    id[4] = 0;
+    return (long)le_dword(buf + 4);
+}
+
+/* Read the payload of the chunk at `offset' into vf->chunk. */
+static long vcap_read_chunk(vcap_file_t *vf, long offset, const char *want)
+{
+    char id[5];
+    long size = vcap_chunk_at(vf, offset, id);
+
+    if (size < 0 || strcmp(id, want) != 0) {
+        return -1;
+    }
+    if ((size_t)size > vf->chunk_size) {
+        vf->chunk = xrealloc(vf->chunk, (size_t)size);
+        vf->chunk_size = (size_t)size;
+    }
+    if (size > 0 && fread(vf->chunk, (size_t)size, 1, vf->fd) != 1) {
+        return -1;
+    }
+    return size;
+}
+
+static void vcap_index_add(vcap_file_t *vf, unsigned int *alloc, long frame_offset,
+                           long palette_offset, int type)
+{
+    if (vf->frames == *alloc) {
+        *alloc = *alloc ? *alloc * 2 : 1024;
+        vf->index = xrealloc(vf->index, *alloc * sizeof(vcap_index_t));
+    }
+    vf->index[vf->frames].frame_offset = frame_offset;
+    vf->index[vf->frames].palette_offset = palette_offset;
+    vf->index[vf->frames].type = type;
+    vf->frames++;
+}
+
+static int vcap_load_index(vcap_file_t *vf, long index_offset, unsigned int frames)
+{
+    unsigned int i;
+    unsigned int alloc = 0;
+    const uint8_t *entry;
+    long size = vcap_read_chunk(vf, index_offset, VCAP_CHUNK_INDEX);
+
+    if (size < 4 || le_dword(vf->chunk) != frames
+        || (unsigned long)size < 4 + (unsigned long)frames * VCAP_INDEX_ENTRY_SIZE) {
+        return -1;
+    }
+
+    for (i = 0; i < frames; i++) {
+        entry = vf->chunk + 4 + i * VCAP_INDEX_ENTRY_SIZE;
+        vcap_index_add(vf, &alloc, (long)le_qword(entry), (long)le_qword(entry + 8),
+                       (int)le_dword(entry + 16));
+    }
+    return 0;
+}
+
+/* Rebuild the index of a capture that was not closed properly. */
+static void vcap_scan_index(vcap_file_t *vf)
+{
+    char id[5];
+    long offset = VCAP_HEADER_SIZE;
+    long palette = 0;
+    long size;
+    unsigned int alloc = 0;
+    int type;
+
+    vf->frames = 0;
+    while ((size = vcap_chunk_at(vf, offset, id)) >= 0) {
+        if (strcmp(id, VCAP_CHUNK_PALETTE) == 0) {
+            palette = offset;
+        } else if (strcmp(id, VCAP_CHUNK_FRAME) == 0) {
+            uint8_t buf[5];
+            if (fread(buf, sizeof(buf), 1, vf->fd) != 1) {
+                break;
+            }
+            type = buf[4];
+            vcap_index_add(vf, &alloc, offset, palette, type);
+        }
+        offset += VCAP_CHUNK_HEADER_SIZE + size;
+    }
+}
+
+static vcap_file_t *vcap_open(const char *name)
+{
+    uint8_t hdr[VCAP_HEADER_SIZE];
+    vcap_file_t *vf;
+    long index_offset;
+    unsigned int frames;
+
+    vf = xrealloc(NULL, sizeof(vcap_file_t));
+    memset(vf, 0, sizeof(vcap_file_t));
+    vf->name = name;
+    vf->fd = fopen(name, "rb");
+    if (vf->fd == NULL) {
+        fprintf(stderr, "vcaptool: cannot open `%s'\n", name);
+        free(vf);
+        return NULL;
+    }
+
+    if (fread(hdr, sizeof(hdr), 1, vf->fd) != 1
+        || memcmp(hdr, VCAP_MAGIC, VCAP_MAGIC_LEN) != 0
+        || le_word(hdr + 8) != VCAP_VERSION) {
+        fprintf(stderr, "vcaptool: `%s' is not a VCAP capture\n", name);
+        fclose(vf->fd);
+        free(vf);
+        return NULL;
+    }
+
+    vf->width = le_word(hdr + 12);
+    vf->height = le_word(hdr + 14);
+    vf->cycles_per_frame = le_dword(hdr + 16);
+    vf->cycles_per_second = le_dword(hdr + 20);
+    vf->audio_rate = le_dword(hdr + 24);
+    vf->audio_channels = le_word(hdr + 28);
+    vf->keyframe_interval = le_word(hdr + 30);
+    frames = (unsigned int)le_dword(hdr + 32);
+    index_offset = (long)le_qword(hdr + 40);
+    memcpy(vf->machine, hdr + 48, VCAP_MACHINE_NAME_LEN);
+    vf->machine[VCAP_MACHINE_NAME_LEN] = 0;
+
+    vf->closed = index_offset != 0 && vcap_load_index(vf, index_offset, frames) == 0;
+    if (!vf->closed) {
+        fprintf(stderr, "vcaptool: `%s' has no valid index, scanning\n", name);
+        vcap_scan_index(vf);
+    }
+
+    vf->frame = xrealloc(NULL, (size_t)vf->width * vf->height);
+    vf->delta = xrealloc(NULL, (size_t)vf->width * vf->height);
+    vf->current = -1;
+    vf->palette_offset = -1;
+
+    return vf;
+}
+
+static void vcap_close(vcap_file_t *vf)
+{
+    fclose(vf->fd);
+    free(vf->index);
+    free(vf->frame);
+    free(vf->delta);
+    free(vf->chunk);
+    free(vf);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int vcap_rle_decode(const uint8_t *src, size_t len, uint8_t *dst, size_t size)
+{
+    size_t in = 0;
+    size_t out = 0;
+    size_t n;
+    uint8_t c;
+
+    while (in < len) {
+        c = src[in++];
+        if (c < 0x80) {
+            n = (size_t)c + 1;
+            if (in + n > len || out + n > size) {
+                return -1;
+            }
+            memcpy(dst + out, src + in, n);
+            in += n;
+        } else {
+            if (c == VCAP_RLE_LONG_RUN) {
+                if (in + 2 > len) {
+                    return -1;
+                }
+                n = le_word(src + in);
+                in += 2;
+            } else {
+                n = (size_t)(c - 0x80) + VCAP_RLE_RUN_MIN;
+            }
+            if (in + 1 > len || out + n > size) {
+                return -1;
+            }
+            memset(dst + out, src[in++], n);
+        }
+        out += n;
+    }
+    return out == size ? 0 : -1;
+}
+
+static int vcap_load_palette(vcap_file_t *vf, long offset)
+{
+    long size;
+    unsigned int entries;
+
+    if (offset == vf->palette_offset) {
+        return 0;
+    }
+    size = vcap_read_chunk(vf, offset, VCAP_CHUNK_PALETTE);
+    if (size < 2) {
+        return -1;
+    }
+    entries = le_word(vf->chunk);
+    if (entries > 256 || (unsigned long)size < 2 + entries * 3UL) {
+        return -1;
+    }
+    memset(vf->palette, 0, sizeof(vf->palette));
+    memcpy(vf->palette, vf->chunk + 2, entries * 3);
+    vf->palette_offset = offset;
+    return 0;
+}
+
+static int vcap_decode_frame(vcap_file_t *vf, unsigned int n)
+{
+    size_t size = (size_t)vf->width * vf->height;
+    size_t i;
+    long len = vcap_read_chunk(vf, vf->index[n].frame_offset, VCAP_CHUNK_FRAME);
+
+    if (len < 5) {
+        return -1;
+    }
+
+    if (vf->chunk[4] == VCAP_FRAME_KEY) {
+        if (vcap_rle_decode(vf->chunk + 5, (size_t)len - 5, vf->frame, size) < 0) {
+            return -1;
+        }
+    } else {
+        if (vf->current != (long)n - 1
+            || vcap_rle_decode(vf->chunk + 5, (size_t)len - 5, vf->delta, size) < 0) {
+            return -1;
+        }
+        for (i = 0; i < size; i++) {
+            vf->frame[i] ^= vf->delta[i];
+        }
+    }
+    vf->current = n;
+    return 0;
+}
+
+/* Make frame `n' the current frame, decoding from the nearest keyframe if
+   it does not directly follow the current one. */
+static int vcap_seek_frame(vcap_file_t *vf, unsigned int n)
+{
+    unsigned int i;
+
+    if (n >= vf->frames) {
+        return -1;
+    }
+    if ((long)n != vf->current) {
+        if ((long)n == vf->current + 1 && vf->current >= 0) {
+            i = n;
+        } else {
+            for (i = n; i > 0 && vf->index[i].type != VCAP_FRAME_KEY; i--) {
+            }
+            if (vf->current >= (long)i && vf->current < (long)n) {
+                /* continuing from the current frame is cheaper */
+                i = (unsigned int)vf->current + 1;
+            }
+        }
+        for (; i <= n; i++) {
+            if (vcap_decode_frame(vf, i) < 0) {
+                fprintf(stderr, "vcaptool: `%s': frame %u is corrupt\n", vf->name, i);
+                vf->current = -1;
+                return -1;
+            }
+        }
+    }
+    return vcap_load_palette(vf, vf->index[n].palette_offset);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static int cmd_info(vcap_file_t *vf)
+{
+    unsigned int i;
+    unsigned int keys = 0;
+
+    for (i = 0; i < vf->frames; i++) {
+        if (vf->index[i].type == VCAP_FRAME_KEY) {
+            keys++;
+        }
+    }
+
+    printf("File:      %s%s\n", vf->name, vf->closed ? "" : " (not closed)");
+    printf("Machine:   %s\n", vf->machine);
+    printf("Frame:     %ux%u\n", vf->width, vf->height);
+    printf("Frames:    %u (%u keyframes, interval %u)\n",
+           vf->frames, keys, vf->keyframe_interval);
+    if (vf->cycles_per_frame) {
+        printf("Rate:      %.4f frames/s\n",
+               (double)vf->cycles_per_second / (double)vf->cycles_per_frame);
+    }
+    if (vf->audio_rate) {
+        printf("Audio:     %lu Hz, %u channel(s)\n", vf->audio_rate, vf->audio_channels);
+    } else {
+        printf("Audio:     none\n");
+    }
+    return 0;
+}
+
+static int write_ppm(vcap_file_t *vf, const char *name)
+{
+    FILE *fd;
+    size_t i;
+    size_t size = (size_t)vf->width * vf->height;
+
+    fd = fopen(name, "wb");
+    if (fd == NULL) {
+        fprintf(stderr, "vcaptool: cannot create `%s'\n", name);
+        return -1;
+    }
+    fprintf(fd, "P6\012%u %u\012255\012", vf->width, vf->height);
+    for (i = 0; i < size; i++) {
+        fwrite(&vf->palette[vf->frame[i] * 3], 3, 1, fd);
+    }
+    if (fclose(fd) != 0) {
+        fprintf(stderr, "vcaptool: error writing `%s'\n", name);
+        return -1;
+    }
+    return 0;
+}
+
+static int cmd_extract(vcap_file_t *vf, unsigned int first, unsigned int last,
+                       const char *prefix)
+{
+    unsigned int i;
+    char *name;
+
+    if (last >= vf->frames) {
+        last = vf->frames ? vf->frames - 1 : 0;
+    }
+    name = xrealloc(NULL, strlen(prefix) + 16);
+
+    for (i = first; i <= last && i < vf->frames; i++) {
+        sprintf(name, "%s%06u.ppm", prefix, i);
+        if (vcap_seek_frame(vf, i) < 0 || write_ppm(vf, name) < 0) {
+            free(name);
+            return 1;
+        }
+    }
+    free(name);
+    return 0;
+}
+
+/* Iterates over the audio samples of a capture, in file order. */
+typedef struct audio_cursor_s {
+    vcap_file_t *vf;
+    long offset;
+    uint8_t *data;
+    size_t len;
+    size_t pos;
+} audio_cursor_t;
+
+/* Return the next chunk of audio bytes in cur->data, or 0 at the end. */
+static size_t audio_next(audio_cursor_t *cur)
+{
+    char id[5];
+    long size;
+
+    while ((size = vcap_chunk_at(cur->vf, cur->offset, id)) >= 0) {
+        long offset = cur->offset;
+        cur->offset += VCAP_CHUNK_HEADER_SIZE + size;
+        if (strcmp(id, VCAP_CHUNK_AUDIO) == 0 && size > 0) {
+            if (vcap_read_chunk(cur->vf, offset, VCAP_CHUNK_AUDIO) != size) {
+                break;
+            }
+            cur->data = cur->vf->chunk;
+            cur->len = (size_t)size;
+            cur->pos = 0;
+            return cur->len;
+        }
+        if (strcmp(id, VCAP_CHUNK_INDEX) == 0) {
+            break;
+        }
+    }
+    cur->len = 0;
+    cur->pos = 0;
+    return 0;
+}
+
+static int cmd_audio(vcap_file_t *vf, const char *name)
+{
+    audio_cursor_t cur;
+    uint8_t hdr[44];
+    unsigned long total = 0;
+    FILE *fd;
+
+    if (vf->audio_rate == 0 || vf->audio_channels == 0) {
+        fprintf(stderr, "vcaptool: `%s' has no audio\n", vf->name);
+        return 1;
+    }
+
+    fd = fopen(name, "wb");
+    if (fd == NULL) {
+        fprintf(stderr, "vcaptool: cannot create `%s'\n", name);
+        return 1;
+    }
+
+    /* header is written again when the size is known */
+    memset(hdr, 0, sizeof(hdr));
+    fwrite(hdr, sizeof(hdr), 1, fd);
+
+    memset(&cur, 0, sizeof(cur));
+    cur.vf = vf;
+    cur.offset = VCAP_HEADER_SIZE;
+    while (audio_next(&cur) > 0) {
+        fwrite(cur.data, cur.len, 1, fd);
+        total += (unsigned long)cur.len;
+    }
+
+    memcpy(hdr, "RIFF", 4);
+    le_put_dword(hdr + 4, total + 36);
+    memcpy(hdr + 8, "WAVEfmt ", 8);
+    le_put_dword(hdr + 16, 16);
+    le_put_word(hdr + 20, 1);
+    le_put_word(hdr + 22, vf->audio_channels);
+    le_put_dword(hdr + 24, vf->audio_rate);
+    le_put_dword(hdr + 28, vf->audio_rate * vf->audio_channels * 2);
+    le_put_word(hdr + 32, vf->audio_channels * 2);
+    le_put_word(hdr + 34, 16);
+    memcpy(hdr + 36, "data", 4);
+    le_put_dword(hdr + 40, total);
+    fseek(fd, 0, SEEK_SET);
+    fwrite(hdr, sizeof(hdr), 1, fd);
+
+    if (fclose(fd) != 0) {
+        fprintf(stderr, "vcaptool: error writing `%s'\n", name);
+        return 1;
+    }
+    printf("%lu samples written to `%s'.\n",
+           total / (2 * vf->audio_channels), name);
+    return 0;
+}
+
+/* Copy up to `n' bytes of audio into `buf', return the number copied. */
+static size_t audio_read(audio_cursor_t *cur, uint8_t *buf, size_t n)
+{
+    size_t got = 0;
+    size_t m;
+
+    while (got < n) {
+        if (cur->pos == cur->len && audio_next(cur) == 0) {
+            break;
+        }
+        m = cur->len - cur->pos;
+        if (m > n - got) {
+            m = n - got;
+        }
+        memcpy(buf + got, cur->data + cur->pos, m);
+        cur->pos += m;
+        got += m;
+    }
+    return got;
+}
+
+/* Compare the audio of two captures, return the number of differing
+   samples (not counting extra samples at the end of the longer one). */
+static unsigned long compare_audio(vcap_file_t *a, vcap_file_t *b, long *first,
+                                   unsigned long *len_a, unsigned long *len_b)
+{
+    audio_cursor_t ca, cb;
+    uint8_t buf_a[4096];
+    uint8_t buf_b[4096];
+    unsigned long pos = 0;
+    unsigned long diffs = 0;
+    size_t na, nb, n, i;
+
+    memset(&ca, 0, sizeof(ca));
+    memset(&cb, 0, sizeof(cb));
+    ca.vf = a;
+    cb.vf = b;
+    ca.offset = VCAP_HEADER_SIZE;
+    cb.offset = VCAP_HEADER_SIZE;
+    *first = -1;
+    *len_a = 0;
+    *len_b = 0;
+
+    do {
+        na = audio_read(&ca, buf_a, sizeof(buf_a));
+        nb = audio_read(&cb, buf_b, sizeof(buf_b));
+        *len_a += (unsigned long)na / 2;
+        *len_b += (unsigned long)nb / 2;
+        n = na < nb ? na : nb;
+        for (i = 0; i + 1 < n; i += 2) {
+            if (buf_a[i] != buf_b[i] || buf_a[i + 1] != buf_b[i + 1]) {
+                if (*first < 0) {
+                    *first = (long)(pos + i / 2);
+                }
+                diffs++;
+            }
+        }
+        pos += (unsigned long)n / 2;
+    } while (na > 0 || nb > 0);
+
+    return diffs;
+}
+
+static int cmd_compare(vcap_file_t *a, vcap_file_t *b)
+{
+    unsigned int i;
+    unsigned int frames = a->frames < b->frames ? a->frames : b->frames;
+    unsigned int differing = 0;
+    long first_diff = -1;
+    unsigned long first_pixels = 0;
+    size_t size, p;
+    unsigned long pixels;
+    unsigned long audio_diffs, audio_a, audio_b;
+    long audio_first;
+    int result = 0;
+
+    if (a->width != b->width || a->height != b->height) {
+        printf("Frame size differs: %ux%u vs %ux%u\n",
+               a->width, a->height, b->width, b->height);
+        return 1;
+    }
+    size = (size_t)a->width * a->height;
+
+    for (i = 0; i < frames; i++) {
+        if (vcap_seek_frame(a, i) < 0 || vcap_seek_frame(b, i) < 0) {
+            return 2;
+        }
+        pixels = 0;
+        for (p = 0; p < size; p++) {
+            if (memcmp(&a->palette[a->frame[p] * 3], &b->palette[b->frame[p] * 3], 3) != 0) {
+                pixels++;
+            }
+        }
+        if (pixels > 0) {
+            if (first_diff < 0) {
+                first_diff = i;
+                first_pixels = pixels;
+            }
+            differing++;
+        }
+    }
+
+    if (a->frames != b->frames) {
+        printf("Frame count differs: %u vs %u\n", a->frames, b->frames);
+        result = 1;
+    }
+    if (differing > 0) {
+        printf("%u of %u frames differ, first is frame %ld (%lu pixels)\n",
+               differing, frames, first_diff, first_pixels);
+        result = 1;
+    } else {
+        printf("All %u frames are identical\n", frames);
+    }
+
+    if (a->audio_rate != b->audio_rate || a->audio_channels != b->audio_channels) {
+        printf("Audio format differs: %lu Hz/%u vs %lu Hz/%u\n",
+               a->audio_rate, a->audio_channels, b->audio_rate, b->audio_channels);
+        return 1;
+    }
+    audio_diffs = compare_audio(a, b, &audio_first, &audio_a, &audio_b);
+    if (audio_a != audio_b) {
+        printf("Audio length differs: %lu vs %lu samples\n", audio_a, audio_b);
+        result = 1;
+    }
+    if (audio_diffs > 0) {
+        printf("%lu audio samples differ, first is sample %ld\n",
+               audio_diffs, audio_first);
+        result = 1;
+    } else {
+        printf("All %lu audio samples are identical\n",
+               audio_a < audio_b ? audio_a : audio_b);
+    }
+
+    return result;
+}
+
+/* ------------------------------------------------------------------------- */
+
+static void usage(const char *progname)
+{
+#ifdef USE_SVN_REVISION
+    printf("%s (VICE %s SVN r%d) -- VICE lossless capture utility.\n",
+           progname, VERSION, VICE_SVN_REV_NUMBER);
+#else
+    printf("%s (VICE %s) -- VICE lossless capture utility.\n",
+           progname, VERSION);
+#endif
+    printf("\nUsage:\n"
+           "  %s info <capture>\n"
+           "  %s extract <capture> <first> [<last>] <prefix>\n"
+           "      write frames as <prefix>NNNNNN.ppm\n"
+           "  %s audio <capture> <file.wav>\n"
+           "  %s compare <capture> <capture>\n"
+           "      exit code is 0 if the captures are identical, 1 otherwise\n",
+           progname, progname, progname, progname);
+}
+
+int main(int argc, char **argv)
+{
+    vcap_file_t *vf;
+    vcap_file_t *vf2;
+    int result;
+
+    if (argc < 3) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    vf = vcap_open(argv[2]);
+    if (vf == NULL) {
+        return 2;
+    }
+
+    if (strcmp(argv[1], "info") == 0 && argc == 3) {
+        result = cmd_info(vf);
+    } else if (strcmp(argv[1], "extract") == 0 && (argc == 5 || argc == 6)) {
+        unsigned int first = (unsigned int)strtoul(argv[3], NULL, 10);
+        unsigned int last = argc == 6 ? (unsigned int)strtoul(argv[4], NULL, 10) : first;
+        result = cmd_extract(vf, first, last, argv[argc - 1]);
+    } else if (strcmp(argv[1], "audio") == 0 && argc == 4) {
+        result = cmd_audio(vf, argv[3]);
+    } else if (strcmp(argv[1], "compare") == 0 && argc == 4) {
+        vf2 = vcap_open(argv[3]);
+        if (vf2 == NULL) {
+            vcap_close(vf);
+            return 2;
+        }
+        result = cmd_compare(vf, vf2);
+        vcap_close(vf2);
+    } else {
+        usage(argv[0]);
+        result = 2;
+    }
+
+    vcap_close(vf);
+    return result;
+}
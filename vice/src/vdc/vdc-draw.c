@@ -254,6 +254,165 @@ static void calculate_draw_masks(void)
 }
 
 
+/*-----------------------------------------------------------------------*/
+
+/* A text line that would come out the same as the last time it was drawn is
+   left alone, the draw buffer still holds it. Whether it would is decided
+   once per raster line from where the character row it shows was fetched,
+   whether that part of VDC RAM has been written since (see
+   vdc_ram_fetch_row()), the character set and everything else
+   draw_std_text() looks at. Most 80 column software changes a few rows per
+   frame, if any, so most lines are not rendered again.
+
+   A line is only reused if the text renderer was also the one that drew it
+   the last time it was emulated, anything else may have drawn over it.  */
+
+/* lines beyond this are always rendered */
+#define VDC_TEXT_LINES  VDC_SCREEN_HEIGHT
+
+typedef struct text_line_key_s {
+    uint8_t *draw_ptr;
+    unsigned int ycounter;
+    unsigned int cols;
+    unsigned int charwidth;
+    unsigned int border_width;
+    unsigned int xsmooth;
+    unsigned int chargen_adr;
+    unsigned int bytes_per_char;
+    unsigned int charset_generation;
+    unsigned int screen_adr;    /* where the row was fetched from */
+    unsigned int attribute_adr;
+    unsigned int count;
+    unsigned int cursor;        /* column of the visible cursor, 0xffff if none */
+    int attribute_blink;
+    int address_mask;
+    uint8_t regs[9];            /* R10, R11, R22-R26, R28 and R29 */
+} text_line_key_t;
+
+typedef struct text_line_s {
+    text_line_key_t key;
+    int drawn;                  /* drawn as text since the line started */
+    int drawn_before;           /* drawn as text the last time */
+    unsigned int fetch;         /* row fetch the line was drawn from */
+} text_line_t;
+
+static text_line_t text_lines[VDC_TEXT_LINES];
+
+/* character set the charset pages are watched for */
+static int charset_watched = 0;
+static unsigned int charset_watched_adr;
+static unsigned int charset_watched_size;
+static uint8_t charset_watched_map;
+static int charset_watched_mask;
+
+void vdc_draw_line_start(void)
+{
+    if (vdc.raster.current_line < VDC_TEXT_LINES) {
+        text_line_t *line = &text_lines[vdc.raster.current_line];
+
+        line->drawn_before = line->drawn;
+        line->drawn = 0;
+    }
+}
+
+/* Forget about the lines drawn so far, for when the draw buffer may have
+   been cleared or the frame counter starts over.  */
+void vdc_draw_invalidate(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < VDC_TEXT_LINES; i++) {
+        text_lines[i].drawn = 0;
+        text_lines[i].drawn_before = 0;
+    }
+    charset_watched = 0;
+}
+
+static void text_line_watch_charset(void)
+{
+    /* both sets, plus the rows below the character height */
+    unsigned int size = 0x200 * vdc.bytes_per_char + 0x100;
+    uint8_t map = vdc.regs[28] & 0x10;
+
+    if (!charset_watched
+        || charset_watched_adr != vdc.chargen_adr
+        || charset_watched_size != size
+        || charset_watched_map != map
+        || charset_watched_mask != vdc.vdc_address_mask) {
+        vdc_ram_watch_charset((uint16_t)vdc.chargen_adr, size);
+        charset_watched = 1;
+        charset_watched_adr = vdc.chargen_adr;
+        charset_watched_size = size;
+        charset_watched_map = map;
+        charset_watched_mask = vdc.vdc_address_mask;
+    }
+}
+
+/* Returns 1 if the current line can be left as it is, otherwise remembers
+   what it is drawn from and returns 0.  */
+static int text_line_unchanged(unsigned int cpos)
+{
+    const vdc_row_fetch_t *source = &vdc.bufsource[vdc.attrbufdraw >> 8];
+    text_line_t *line;
+    text_line_key_t key;
+    unsigned int cols = vdc.screen_text_cols;
+    int same;
+
+    /* all the characters have to come from the one fetch, and past 82
+       bytes the buffer is filled in a different order */
+    if (vdc.raster.current_line >= VDC_TEXT_LINES
+        || source->fetch == 0 || cols >= source->count || source->count > 82) {
+        return 0;
+    }
+    line = &text_lines[vdc.raster.current_line];
+
+    text_line_watch_charset();
+
+    /* padding has to compare equal too */
+    memset(&key, 0, sizeof(key));
+    key.draw_ptr = vdc.raster.draw_buffer_ptr;
+    key.ycounter = vdc.raster.ycounter;
+    key.cols = cols;
+    key.charwidth = vdc.charwidth;
+    key.border_width = vdc.border_width;
+    key.xsmooth = vdc.xsmooth;
+    key.chargen_adr = vdc.chargen_adr;
+    key.bytes_per_char = vdc.bytes_per_char;
+    key.charset_generation = vdc.charset_generation;
+    key.screen_adr = source->screen_adr;
+    key.attribute_adr = source->attribute_adr;
+    key.count = source->count;
+    key.cursor = 0xffff;
+    if (cpos < cols && ((vdc.frame_counter | 1) & crsrblink[(vdc.regs[10] >> 5) & 3])) {
+        key.cursor = cpos;
+    }
+    key.attribute_blink = vdc.attribute_blink;
+    key.address_mask = vdc.vdc_address_mask;
+    key.regs[0] = vdc.regs[10];
+    key.regs[1] = vdc.regs[11];
+    key.regs[2] = vdc.regs[22];
+    key.regs[3] = vdc.regs[23];
+    key.regs[4] = vdc.regs[24];
+    key.regs[5] = vdc.regs[25];
+    key.regs[6] = vdc.regs[26];
+    key.regs[7] = vdc.regs[28];
+    key.regs[8] = vdc.regs[29];
+
+    same = line->drawn_before
+           && memcmp(&key, &line->key, sizeof(key)) == 0
+           && !vdc_ram_written_since((uint16_t)key.screen_adr, cols, line->fetch)
+           && !vdc_ram_written_since((uint16_t)key.attribute_adr, cols, line->fetch);
+
+    if (!same) {
+        line->key = key;
+    }
+    /* when nothing was written in between, both fetches read the same */
+    line->fetch = source->fetch;
+    line->drawn = 1;
+
+    return same;
+}
+
 /*-----------------------------------------------------------------------*/
 
 inline static uint8_t get_attr_char_data(uint8_t c, uint8_t a, int l, uint8_t *char_mem,
@@ -689,6 +848,10 @@ static void draw_std_text(void)
     screen_ptr = &vdc.scrnbuf[vdc.attrbufdraw];
     char_index = vdc.chargen_adr + vdc.raster.ycounter;
 
+    if (text_line_unchanged(cpos)) {
+        return;
+    }
+
     calculate_draw_masks();
 
     /* Now actually render everything */
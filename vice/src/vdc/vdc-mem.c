@@ -80,7 +80,6 @@ static void vdc_write_data(void)
 static void vdc_perform_fillcopy(void)
 {
     int ptr, ptr2;
-    int i;
     int blklen;
 
     /* Word count, # of bytes to copy */
@@ -92,10 +91,7 @@ static void vdc_perform_fillcopy(void)
     if (vdc.regs[24] & 0x80) { /* COPY flag */
         /* Block start address.  */
         ptr2 = (vdc.regs[32] << 8) + vdc.regs[33];
-        for (i = 0; i < blklen; i++) {
-            vdc_ram_store((ptr + i),
-                vdc_ram_read(ptr2 + i));
-        }
+        vdc_ram_copy((uint16_t)ptr, (uint16_t)ptr2, blklen);
         ptr2 += blklen;
         vdc.regs[31] = vdc_ram_read(ptr2 - 1);
         vdc.regs[32] = (ptr2 >> 8) & 0xff;
@@ -107,9 +103,7 @@ static void vdc_perform_fillcopy(void)
         log_message(vdc.log, "Fill mem %04i, len %03i, data %02x",
                     ptr, blklen, vdc.regs[31]);
 #endif
-        for (i = 0; i < blklen; i++) {
-            vdc_ram_store((ptr + i), vdc.regs[31]);
-        }
+        vdc_ram_fill((uint16_t)ptr, vdc.regs[31], blklen);
         /* Set the clock for when the vdc status will be clear after this operation */
         vdc_status_clear_clock = maincpu_clk + (blklen*66/100);
     }
@@ -609,22 +603,146 @@ static uint16_t vdc_64k_to_16k_map(uint16_t address)
     return new_address;
 }
 
-uint8_t vdc_ram_read(uint16_t addr)
+/* offset into vdc.ram of a VDC address, depending on the RAM chip type */
+inline static unsigned int vdc_ram_offset(uint16_t addr)
 {
     /* Use 16KB memory map when the RAM chip type register #28 bit 4 is 0 for 4416 chips */
     if (!(vdc.regs[28] & 0x10)) {
-        return vdc.ram[vdc_64k_to_16k_map(addr & vdc.vdc_address_mask)];
+        return vdc_64k_to_16k_map(addr & vdc.vdc_address_mask);
     }
     /* otherwise return the default linear memory layout for the 4464 chip setting */
-    return vdc.ram[addr & vdc.vdc_address_mask];
+    return addr & vdc.vdc_address_mask;
+}
+
+uint8_t vdc_ram_read(uint16_t addr)
+{
+    return vdc.ram[vdc_ram_offset(addr)];
+}
+
+/* Note a write to `count' bytes from `offset' on, which stay within one
+   page of `ram'.  */
+inline static void vdc_ram_note_write(unsigned int offset, unsigned int count)
+{
+    unsigned int block;
+
+    for (block = offset >> VDC_RAM_BLOCK_SHIFT;
+         block <= (offset + count - 1) >> VDC_RAM_BLOCK_SHIFT; block++) {
+        vdc.ram_written[block] = vdc.ram_fetches;
+    }
+    if (vdc.charset_page[offset >> 8]) {
+        vdc.charset_generation++;
+    }
 }
 
 void vdc_ram_store(uint16_t addr, uint8_t value)
 {   /* as above but for storing to VDC ram with appropriate address translation*/
-    if (!(vdc.regs[28] & 0x10)) {
-        vdc.ram[vdc_64k_to_16k_map(addr & vdc.vdc_address_mask)] = value;
-    } else
-    vdc.ram[addr & vdc.vdc_address_mask] = value;
+    unsigned int offset = vdc_ram_offset(addr);
+
+    vdc.ram[offset] = value;
+    vdc_ram_note_write(offset, 1);
+}
+
+/* The address translation leaves the low byte alone, so the bytes up to the
+   end of a page of VDC addresses are also next to each other in `ram'. The
+   block operations below go a page at a time.  */
+
+void vdc_ram_fill(uint16_t addr, uint8_t value, unsigned int count)
+{
+    while (count > 0) {
+        unsigned int offset = vdc_ram_offset(addr);
+        unsigned int n = 0x100 - (addr & 0xff);
+
+        if (n > count) {
+            n = count;
+        }
+        memset(&vdc.ram[offset], value, n);
+        vdc_ram_note_write(offset, n);
+        addr = (uint16_t)(addr + n);
+        count -= n;
+    }
+}
+
+/* Copies byte by byte in ascending order, like the VDC, so a destination
+   just above the source repeats the bytes in between.  */
+void vdc_ram_copy(uint16_t dest, uint16_t src, unsigned int count)
+{
+    while (count > 0) {
+        unsigned int dest_offset = vdc_ram_offset(dest);
+        unsigned int src_offset = vdc_ram_offset(src);
+        unsigned int n = 0x100 - (dest & 0xff);
+        unsigned int i;
+
+        if (n > 0x100 - (src & 0xff)) {
+            n = 0x100 - (src & 0xff);
+        }
+        if (n > count) {
+            n = count;
+        }
+        if (dest_offset > src_offset && dest_offset < src_offset + n) {
+            for (i = 0; i < n; i++) {
+                vdc.ram[dest_offset + i] = vdc.ram[src_offset + i];
+            }
+        } else {
+            memmove(&vdc.ram[dest_offset], &vdc.ram[src_offset], n);
+        }
+        vdc_ram_note_write(dest_offset, n);
+        dest = (uint16_t)(dest + n);
+        src = (uint16_t)(src + n);
+        count -= n;
+    }
+}
+
+/* Keep an eye on the character set the text renderer uses, so it can tell
+   when the definitions change. Goes by page, with the same mapping of the
+   addresses as the accesses themselves.  */
+void vdc_ram_watch_charset(uint16_t addr, unsigned int size)
+{
+    unsigned int i;
+
+    memset(vdc.charset_page, 0, sizeof(vdc.charset_page));
+    for (i = 0; i < size; i += 0x100) {
+        vdc.charset_page[vdc_ram_offset((uint16_t)(addr + i)) >> 8] = 1;
+    }
+    vdc.charset_generation++;
+}
+
+/* Called right before a character row is read into one half of the
+   character and attribute buffers, `buf' being 0 or 0x100 like
+   `vdc.scrnbufdraw'. Writes that come later than this are noted with the
+   new fetch count.  */
+void vdc_ram_fetch_row(unsigned int buf, unsigned int screen_adr,
+                       unsigned int attribute_adr, unsigned int count)
+{
+    vdc_row_fetch_t *source = &vdc.bufsource[buf >> 8];
+
+    if (++vdc.ram_fetches == 0) {
+        /* after a couple of days of warp, start counting over */
+        memset(vdc.ram_written, 0, sizeof(vdc.ram_written));
+        memset(vdc.bufsource, 0, sizeof(vdc.bufsource));
+        vdc_draw_invalidate();
+        vdc.ram_fetches = 1;
+    }
+    source->screen_adr = screen_adr & 0xffff;
+    source->attribute_adr = attribute_adr & 0xffff;
+    source->count = count;
+    source->fetch = vdc.ram_fetches;
+}
+
+/* Returns 1 if any of the `size' bytes from VDC address `addr' on may have
+   been written since the given row fetch, going by block.  */
+int vdc_ram_written_since(uint16_t addr, unsigned int size, unsigned int fetch)
+{
+    unsigned int i = 0;
+
+    while (i < size) {
+        uint16_t a = (uint16_t)(addr + i);
+
+        if (vdc.ram_written[vdc_ram_offset(a) >> VDC_RAM_BLOCK_SHIFT] >= fetch) {
+            return 1;
+        }
+        i += VDC_RAM_BLOCK_SIZE - (a & (VDC_RAM_BLOCK_SIZE - 1));
+    }
+    return 0;
 }
 
 
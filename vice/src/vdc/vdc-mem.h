@@ -37,6 +37,12 @@ uint8_t vdc_peek(uint16_t addr);
 
 void vdc_ram_store(uint16_t addr, uint8_t value);
 uint8_t vdc_ram_read(uint16_t addr);
+void vdc_ram_fill(uint16_t addr, uint8_t value, unsigned int count);
+void vdc_ram_copy(uint16_t dest, uint16_t src, unsigned int count);
+void vdc_ram_watch_charset(uint16_t addr, unsigned int size);
+void vdc_ram_fetch_row(unsigned int buf, unsigned int screen_adr,
+                       unsigned int attribute_adr, unsigned int count);
+int vdc_ram_written_since(uint16_t addr, unsigned int size, unsigned int fetch);
 
 int vdc_dump(void);
 
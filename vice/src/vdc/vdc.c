@@ -154,6 +154,9 @@ printf("LD: %03i FD: %03i\n", last_displayed_line, first_displayed_line);
     raster->geometry->pixel_aspect_ratio = vdc_get_pixel_aspect();
     raster->geometry->char_pixel_width = vdc.charwidth;
     raster->viewport->crt_type = vdc_get_crt_type();
+
+    /* the draw buffer may have been cleared */
+    vdc_draw_invalidate();
 }
 
 static void vdc_invalidate_cache(raster_t *raster, unsigned int screen_height)
@@ -321,6 +324,7 @@ void vdc_reset(void)
     }
 
     vdc.frame_counter = 0;
+    vdc_draw_invalidate();
     vdc.screen_text_cols = VDC_SCREEN_MAX_TEXTCOLS;
     vdc.xsmooth = 7;
     vdc.regs[0] = 126;
@@ -368,6 +372,9 @@ void vdc_powerup(void)
         vdc.ram[i] = v;
         v ^= 0xff;
     }
+    /* the buffers no longer hold what is in RAM */
+    memset(vdc.bufsource, 0, sizeof(vdc.bufsource));
+    vdc_draw_invalidate();
     memset(vdc.regs, 0, sizeof(vdc.regs));
     vdc.mem_counter = 0;
     vdc.mem_counter_inc = 0;
@@ -542,6 +549,8 @@ static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data)
                         vdc.draw_active = 0;
                     }
                     /* Directly fill the active draw buffers for the first row of the next screen */
+                    vdc_ram_fetch_row(vdc.attrbufdraw, vdc.screen_adr + vdc.mem_counter,
+                                      vdc.attribute_adr + vdc.mem_counter, vdc.mem_counter_inc + 1);
                     for (i = 0, j = 0; i <= vdc.mem_counter_inc; i++, j++) {
                         if (j == 82) {
                             j = 41;
@@ -706,6 +715,8 @@ static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data)
             vdc.draw_active = 0;
         }
         /* Directly fill the active draw buffers for the first row of the next screen */
+        vdc_ram_fetch_row(vdc.attrbufdraw, vdc.screen_adr + vdc.mem_counter,
+                          vdc.attribute_adr + vdc.mem_counter, vdc.mem_counter_inc + 1);
         for (i = 0, j = 0; i <= vdc.mem_counter_inc; i++, j++) {
             if (j == 82) {
                 j = 41;
@@ -827,6 +838,10 @@ static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data)
 
     /* fill the non-draw buffers for the next character row during the start of the current one */
     if ((vdc.draw_counter_y | vdc.interlaced) == vdc.interlaced) {
+        vdc_ram_fetch_row(vdc.attrbufdraw ^ 0x100,
+                          vdc.screen_adr + vdc.mem_counter + vdc.mem_counter_inc + vdc.regs[27],
+                          vdc.attribute_adr + vdc.mem_counter + vdc.mem_counter_inc + vdc.regs[27],
+                          vdc.mem_counter_inc + 1);
         for (i = 0, j = 0 ; i <= vdc.mem_counter_inc; i++, j++) {
             if (j == 82) {
                 j = 41;
@@ -842,6 +857,7 @@ static void vdc_raster_draw_alarm_handler(CLOCK offset, void *data)
         (vdc.attribute_adr + vdc.mem_counter) & vdc.vdc_address_mask, (vdc.screen_adr + vdc.bitmap_counter) & vdc.vdc_address_mask, vdc.frame_counter); */
 
     /* actually draw the current raster line */
+    vdc_draw_line_start();
     raster_line_emulate(&vdc.raster);
 
 
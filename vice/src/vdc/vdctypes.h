@@ -64,6 +64,18 @@
 #define VDC_REVERSE_ATTR            0x40
 #define VDC_ALTCHARSET_ATTR         0x80
 
+/* VDC RAM writes are recorded per block of this many bytes */
+#define VDC_RAM_BLOCK_SHIFT         6
+#define VDC_RAM_BLOCK_SIZE          (1 << VDC_RAM_BLOCK_SHIFT)
+
+/* Where one half of the character and attribute buffers was filled from */
+typedef struct vdc_row_fetch_s {
+    unsigned int screen_adr;
+    unsigned int attribute_adr;
+    unsigned int count;
+    unsigned int fetch;     /* `vdc.ram_fetches' at the time, 0 if unknown */
+} vdc_row_fetch_t;
+
 /* Available video modes. */
 enum vdc_video_mode_s {
     VDC_TEXT_MODE,
@@ -187,6 +199,16 @@ struct vdc_s {
     /* Internal VDC video memory */
     uint8_t ram[0x10000];
 
+    /* Pages of `ram' that hold the character set the text renderer used
+       last, and a counter that goes up whenever one of them is written.  */
+    uint8_t charset_page[0x100];
+    unsigned int charset_generation;
+
+    /* Row fetches so far, and for every block of `ram' how many there had
+       been when it was last written.  */
+    unsigned int ram_fetches;
+    unsigned int ram_written[0x10000 >> VDC_RAM_BLOCK_SHIFT];
+
     /* used to record the value of the cpu clock at the start of a raster line */
     CLOCK vdc_line_start;
     /* based on blacky_stardust calculations, calculating current_x_pixel should be like:
@@ -253,6 +275,7 @@ struct vdc_s {
     unsigned int scrnbufdraw;
     uint8_t attrbuf[0x200];
     unsigned int attrbufdraw;
+    vdc_row_fetch_t bufsource[2];
 };
 typedef struct vdc_s vdc_t;
 
@@ -117,7 +117,10 @@ int vic_snapshot_read_module(snapshot_t *s)
     uint8_t major_version, minor_version;
     uint8_t b;
 
-    sound_close();
+    /* the sound device is still set up right for a state taken moments ago */
+    if (!snapshot_is_memory(s)) {
+        sound_close();
+    }
 
     m = snapshot_module_open(s, snap_module_name,
                              &major_version, &minor_version);
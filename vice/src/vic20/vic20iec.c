@@ -40,6 +40,7 @@
 #include "types.h"
 #include "via.h"
 #include "vic20iec.h"
+#include "vsync.h"
 #include "drive/iec/cmdhd.h"
 
 /* FIXME: this code should be a wrapper to the functions in src/iecbus/iecbus.c
@@ -158,6 +159,7 @@ void iec_pa_write(uint8_t data)
 
     /* Signal ATN interrupt to the drives.  */
     if ((cpu_atn == 0) && (data & 128)) {
+        vsync_idle_io_activity();
         for (i = 0; i < NUM_DISK_UNITS; i++) {
             diskunit_context_t *unit = diskunit_context[i];
 
@@ -82,6 +82,7 @@ int event_record_start(void);
 int event_record_stop(void);
 int event_playback_start(void);
 int event_playback_stop(void);
+int event_playback_seek(unsigned int second);
 int event_record_active(void);
 int event_playback_active(void);
 int event_record_set_milestone(void);
@@ -143,6 +143,13 @@
 #define VICE_ATTR_RESPRINTF
 #endif
 
+/* alignment of static tables, e.g. to keep an entry within a cache line */
+#if defined(__GNUC__)
+#define VICE_ATTR_ALIGNED(n) __attribute__((aligned(n)))
+#else
+#define VICE_ATTR_ALIGNED(n)
+#endif
+
 /* M_PI is non-standard, so in order for -std=c99 to work we define it here */
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -34,6 +34,7 @@
 #include <string.h>
 
 #include "alarm.h"
+#include "benchmark.h"
 #include "debug.h"
 #include "c64cart.h"
 #include "c64cartmem.h"
@@ -522,6 +523,7 @@ phi2noultimax:
 void vicii_fetch_alarm_handler(CLOCK offset, void *data)
 {
     CLOCK last_opcode_first_write_clk, last_opcode_last_write_clk;
+    int benchmark_prev = benchmark_enter(BENCHMARK_VICII);
 
     /* This kludgy thing is used to emulate the behavior of the 6510 when BA
        goes low.  When BA goes low, every read access stops the processor
@@ -596,6 +598,8 @@ void vicii_fetch_alarm_handler(CLOCK offset, void *data)
             break;
         }
     }
+
+    benchmark_leave(benchmark_prev);
 }
 
 void vicii_fetch_init(void)
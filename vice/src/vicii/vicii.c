@@ -51,6 +51,7 @@
 #include "videoarch.h"
 
 #include "alarm.h"
+#include "benchmark.h"
 #include "c64.h"
 #include "cartridge.h"
 #include "c64cart.h"
@@ -1194,6 +1195,7 @@ void vicii_raster_draw_alarm_handler(CLOCK offset, void *data)
     uint8_t prev_sprite_sprite_collisions;
     uint8_t prev_sprite_background_collisions;
     int in_visible_area;
+    int benchmark_prev = benchmark_enter(BENCHMARK_VICII);
 
     prev_sprite_sprite_collisions = vicii.sprite_sprite_collisions;
     prev_sprite_background_collisions = vicii.sprite_background_collisions;
@@ -1377,6 +1379,8 @@ void vicii_raster_draw_alarm_handler(CLOCK offset, void *data)
     vicii.last_emulate_line_clk += vicii.cycles_per_line;
     vicii.draw_clk = vicii.last_emulate_line_clk + vicii.draw_cycle;
     alarm_set(vicii.raster_draw_alarm, vicii.draw_clk);
+
+    benchmark_leave(benchmark_prev);
 }
 
 void vicii_set_canvas_refresh(int enable)
@@ -33,6 +33,7 @@
 
 #include <string.h>
 
+#include "benchmark.h"
 #include "debug.h"
 #include "lib.h"
 #include "log.h"
@@ -376,6 +377,11 @@ int vicii_cycle(void)
     int ba_low = 0;
     int can_sprite_sprite, can_sprite_background;
     int vsp_may_crash;
+#ifdef USE_PERFSTATS
+    /* four marks per cycle cost about 3% even when only the sampler looks
+       at them, so they are left out unless perfstats is enabled */
+    int benchmark_prev = benchmark_enter(BENCHMARK_VICII);
+#endif
 
     /*VICII_DEBUG_CYCLE(("cycle: line %i, clk %i", vicii.raster_line, vicii.raster_cycle));*/
 
@@ -408,7 +414,13 @@ int vicii_cycle(void)
     can_sprite_background = (vicii.sprite_background_collisions == 0);
 
     /* Draw one cycle of pixels */
+#ifdef USE_PERFSTATS
+    benchmark_enter(BENCHMARK_RENDER);
+#endif
     vicii_draw_cycle();
+#ifdef USE_PERFSTATS
+    benchmark_leave(BENCHMARK_VICII);
+#endif
 
     /* clear any collision registers as initiated by $d01e or $d01f reads */
     switch (vicii.clear_collisions) {
@@ -612,6 +624,9 @@ int vicii_cycle(void)
         vicii_trigger_light_pen_internal(0);
     }
 
+#ifdef USE_PERFSTATS
+    benchmark_leave(benchmark_prev);
+#endif
     return ba_low;
 }
 
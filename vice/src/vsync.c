@@ -50,6 +50,7 @@
 #endif
 
 #include "archdep.h"
+#include "benchmark.h"
 #include "cmdline.h"
 #include "debug.h"
 #include "joystick.h"
@@ -63,7 +64,9 @@
 #include "monitor_binary.h"
 #endif
 #include "network.h"
+#include "perfstats.h"
 #include "resources.h"
+#include "runahead.h"
 #include "sound.h"
 #include "types.h"
 #include "videoarch.h"
@@ -79,6 +82,9 @@
 /* public metrics, updated every vsync */
 static double vsync_metric_cpu_percent;
 static double vsync_metric_emulated_fps;
+static double vsync_metric_idle_percent;
+static double vsync_metric_sound_latency_ms;
+static int vsync_metric_sound_underruns;
 static int    vsync_metric_warp_enabled;
 
 #ifdef USE_VICE_THREAD
@@ -369,12 +375,105 @@ void vsync_reset_hook(void)
     vsync_suspend_speed_eval();
 }
 
-void vsyncarch_get_metrics(double *cpu_percent, double *emulated_fps, int *is_warp_enabled)
+/* ------------------------------------------------------------------------- */
+
+/* A frame is considered idle when the main program spent it in a loop of at
+   most this many bytes, at the same place as in the frame before. */
+#define IDLE_WINDOW_BYTES 32
+
+/* Number of consecutive idle frames before host synchronisation is done in
+   larger bursts. */
+#define IDLE_COALESCE_FRAMES 25
+
+/* Interval between host synchronisations while idle (normally 2ms) */
+#define IDLE_SYNC_INTERVAL_US (20 * 1000)
+
+static int idle_frame_streak;
+
+#ifdef FEATURE_IDLEDETECT
+vsync_idle_window_t vsync_idle_window = { UINT_MAX, 0, UINT_MAX, 0 };
+
+static unsigned int idle_last_lo = UINT_MAX;
+static unsigned int idle_last_hi = 0;
+
+/* Set by vsync_idle_io_activity() during the frame */
+static bool idle_io_active = false;
+
+static void idle_window_reset(void)
+{
+    vsync_idle_window.main_lo = UINT_MAX;
+    vsync_idle_window.main_hi = 0;
+    vsync_idle_window.any_lo = UINT_MAX;
+    vsync_idle_window.any_hi = 0;
+}
+#endif
+
+void vsync_idle_io_activity(void)
+{
+#ifdef FEATURE_IDLEDETECT
+    idle_io_active = true;
+#endif
+}
+
+/* Evaluate the PC range collected by the CPU during the frame that just
+   ended. Returns true if the guest was sitting in an idle loop. */
+static bool idle_frame_end(void)
+{
+#ifdef FEATURE_IDLEDETECT
+    unsigned int lo;
+    unsigned int hi;
+    bool idle;
+
+    if (vsync_idle_window.main_lo <= vsync_idle_window.main_hi) {
+        /* some code ran with interrupts enabled, an IRQ handler doesn't count */
+        lo = vsync_idle_window.main_lo;
+        hi = vsync_idle_window.main_hi;
+    } else {
+        /* interrupts masked all frame long, e.g. SEI / JMP * */
+        lo = vsync_idle_window.any_lo;
+        hi = vsync_idle_window.any_hi;
+    }
+
+    idle = lo <= hi
+           && hi - lo < IDLE_WINDOW_BYTES
+           && lo == idle_last_lo
+           && hi == idle_last_hi
+           && kbdbuf_queue_is_empty()
+           && !idle_io_active;
+
+    idle_last_lo = lo;
+    idle_last_hi = hi;
+    idle_window_reset();
+    idle_io_active = false;
+
+    if (!idle) {
+        idle_frame_streak = 0;
+    } else if (idle_frame_streak < IDLE_COALESCE_FRAMES) {
+        idle_frame_streak++;
+    }
+
+    return idle;
+#else
+    return false;
+#endif
+}
+
+void vsyncarch_get_metrics(double *cpu_percent, double *emulated_fps, double *idle_percent,
+                           double *sound_latency_ms, int *sound_underruns, int *is_warp_enabled)
 {
     METRIC_LOCK();
 
     *cpu_percent = vsync_metric_cpu_percent;
     *emulated_fps = vsync_metric_emulated_fps;
+    if (idle_percent != NULL) {
+        *idle_percent = vsync_metric_idle_percent;
+    }
+    if (sound_latency_ms != NULL) {
+        *sound_latency_ms = vsync_metric_sound_latency_ms;
+    }
+    if (sound_underruns != NULL) {
+        *sound_underruns = vsync_metric_sound_underruns;
+    }
     *is_warp_enabled = vsync_metric_warp_enabled;
 
     METRIC_UNLOCK();
@@ -400,6 +499,10 @@ static CLOCK last_clock;
 static CLOCK clock_deltas[MEASUREMENT_FRAME_WINDOW];
 static uint64_t cumulative_clock_delta;
 
+/* For measuring the share of frames spent in an idle loop */
+static bool idle_frames[MEASUREMENT_FRAME_WINDOW];
+static int cumulative_idle_frames;
+
 static void reset_performance_metrics(tick_t frame_tick)
 {
     /*
@@ -415,9 +518,12 @@ static void reset_performance_metrics(tick_t frame_tick)
 
     cumulative_tick_delta = 0;
     cumulative_clock_delta = 0;
+    cumulative_idle_frames = 0;
 
     METRIC_LOCK();
 
+    vsync_metric_idle_percent = 0.0;
+
     /* The final smoothing function requires that we initialise the public metrics. */
     if (timer_speed > 0) {
         vsync_metric_emulated_fps = (double)timer_speed * refresh_frequency / 100.0;
@@ -430,7 +536,7 @@ static void reset_performance_metrics(tick_t frame_tick)
     METRIC_UNLOCK();
 }
 
-static void update_performance_metrics(tick_t frame_tick)
+static void update_performance_metrics(tick_t frame_tick, bool frame_idle)
 {
     /* how many seconds of wallclock time the measurement window covers */
     double frame_timespan_seconds;
@@ -438,6 +544,10 @@ static void update_performance_metrics(tick_t frame_tick)
     /* how many emulated seconds of cpu time have been emulated */
     double clock_delta_seconds;
 
+    /* sound output latency, measured by the sound code */
+    double sound_latency_ms;
+    int sound_underruns;
+
     CLOCK main_cpu_clock = maincpu_clk;
 
     if (metrics_reset) {
@@ -450,6 +560,7 @@ static void update_performance_metrics(tick_t frame_tick)
         /* Remove the oldest measurement */
         cumulative_tick_delta -= tick_deltas[next_measurement_index];
         cumulative_clock_delta -= clock_deltas[next_measurement_index];
+        cumulative_idle_frames -= idle_frames[next_measurement_index];
     } else {
         measurement_count++;
     }
@@ -457,9 +568,11 @@ static void update_performance_metrics(tick_t frame_tick)
     /* Add this frame's measurement */
     tick_deltas[next_measurement_index] = frame_tick - last_tick;
     clock_deltas[next_measurement_index] = main_cpu_clock - last_clock;
+    idle_frames[next_measurement_index] = frame_idle;
 
     cumulative_tick_delta += tick_deltas[next_measurement_index];
     cumulative_clock_delta += clock_deltas[next_measurement_index];
+    cumulative_idle_frames += idle_frames[next_measurement_index];
 
     last_tick = frame_tick;
     last_clock = main_cpu_clock;
@@ -468,11 +581,16 @@ static void update_performance_metrics(tick_t frame_tick)
     frame_timespan_seconds = (double)cumulative_tick_delta / tick_per_second();
     clock_delta_seconds = (double)cumulative_clock_delta / cycles_per_sec;
 
+    sound_get_latency_metrics(&sound_latency_ms, &sound_underruns);
+
     METRIC_LOCK();
 
     /* smooth and make public */
     vsync_metric_cpu_percent  = (MEASUREMENT_SMOOTH_FACTOR * vsync_metric_cpu_percent)  + (1.0 - MEASUREMENT_SMOOTH_FACTOR) * (clock_delta_seconds / frame_timespan_seconds * 100.0);
     vsync_metric_emulated_fps = (MEASUREMENT_SMOOTH_FACTOR * vsync_metric_emulated_fps) + (1.0 - MEASUREMENT_SMOOTH_FACTOR) * ((double)measurement_count / frame_timespan_seconds);
+    vsync_metric_idle_percent = (MEASUREMENT_SMOOTH_FACTOR * vsync_metric_idle_percent) + (1.0 - MEASUREMENT_SMOOTH_FACTOR) * ((double)cumulative_idle_frames / measurement_count * 100.0);
+    vsync_metric_sound_latency_ms = sound_latency_ms;
+    vsync_metric_sound_underruns = sound_underruns;
     vsync_metric_warp_enabled = warp_enabled;
 
     /* printf("%.3f seconds - %0.3f%% cpu, %.3f fps (CLOCK delta: %u)\n", frame_timespan_seconds, vsync_metric_cpu_percent, vsync_metric_emulated_fps, clock_deltas[next_measurement_index]); fflush(stdout); */
@@ -487,9 +605,9 @@ static void update_performance_metrics(tick_t frame_tick)
 
 void vsync_do_end_of_line(void)
 {
-    const int microseconds_between_sync = 2 * 1000;
+    int microseconds_between_sync = 2 * 1000;
 
-    tick_t tick_between_sync = tick_per_second() / (1000000 / microseconds_between_sync);
+    tick_t tick_between_sync;
     tick_t tick_now;
     tick_t tick_delta;
     tick_t ticks_until_target;
@@ -513,9 +631,34 @@ void vsync_do_end_of_line(void)
         return;
     }
 
+    /*
+     * Look-ahead frames run flat out and are not part of the emulated time
+     * line, leave the sync state alone until the real frame continues.
+     */
+    if (runahead_is_ahead()) {
+        static tick_t runahead_yield_tick;
+
+        sound_flush();
+        tick_now = tick_now_after(runahead_yield_tick);
+        if (tick_now - runahead_yield_tick >= tick_per_second() / 500) {
+            mainlock_yield();
+            runahead_yield_tick = tick_now;
+        }
+        return;
+    }
+
     /* deal with any accumulated sound immediately */
     tick_based_sync_timing = sound_flush();
 
+    /*
+     * While the guest is spinning in an idle loop there is no point waking
+     * up every couple of milliseconds, sync (and sleep) in larger bursts.
+     */
+    if (idle_frame_streak >= IDLE_COALESCE_FRAMES) {
+        microseconds_between_sync = IDLE_SYNC_INTERVAL_US;
+    }
+    tick_between_sync = tick_per_second() / (1000000 / microseconds_between_sync);
+
     tick_now = tick_now_after(last_sync_tick);
 
     if (sync_reset) {
@@ -574,7 +717,10 @@ void vsync_do_end_of_line(void)
 
                 /* If we can't rely on the audio device for timing, slow down here. */
                 if (tick_based_sync_timing) {
+                    int benchmark_prev = benchmark_enter(BENCHMARK_IDLE);
+
                     mainlock_yield_and_sleep(ticks_until_target);
+                    benchmark_leave(benchmark_prev);
                 }
             } else if ((tick_t)0 - ticks_until_target > tick_per_second()) {
                 /* We are more than a second behind, reset sync and accept that we're not running at full speed. */
@@ -625,6 +771,15 @@ bool vsync_should_skip_frame(struct video_canvas_s *canvas)
         return true;
     }
 
+    if (runahead_should_skip_frame()) {
+        return true;
+    }
+
+    /* a benchmark must not depend on how fast the host is */
+    if (benchmark_is_running()) {
+        return benchmark_should_skip_frame();
+    }
+
     /*
      * Limit rendering fps if we're in warp mode.
      * It's ugly enough for dqh to weep but makes warp faster.
@@ -661,6 +816,20 @@ void vsync_do_vsync(struct video_canvas_s *c)
 
     tick_t now;
     tick_t network_hook_time = 0;
+    bool frame_idle;
+    int benchmark_prev;
+
+    /* look-ahead frames are undone, they must not have side effects */
+    if (runahead_is_ahead()) {
+        runahead_vsync();
+        return;
+    }
+
+    benchmark_prev = benchmark_enter(BENCHMARK_OTHER);
+    benchmark_vsync();
+    perfstats_frame();
+
+    frame_idle = idle_frame_end();
 
     monitor_vsync_hook();
 
@@ -693,7 +862,7 @@ void vsync_do_vsync(struct video_canvas_s *c)
 #endif
 
     now = tick_now_after(last_vsync);
-    update_performance_metrics(now);
+    update_performance_metrics(now, frame_idle);
 
     vsyncarch_postsync();
 
@@ -707,4 +876,8 @@ void vsync_do_vsync(struct video_canvas_s *c)
     kbdbuf_flush();
 
     last_vsync = now;
+
+    runahead_vsync();
+
+    benchmark_leave(benchmark_prev);
 }
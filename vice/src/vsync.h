@@ -41,6 +41,52 @@ typedef struct vsync_callback {
 
 struct video_canvas_s;
 
+/* Idle loop detection.
+
+   The main CPU reports the program counter after every opcode through
+   VSYNC_IDLE_TRACK(); vsync_do_vsync() looks at the address range that was
+   covered during the frame and resets it. Opcodes executed with interrupts
+   masked are kept apart, so that a regular IRQ handler does not hide an idle
+   loop in the main program. The detection is off by default; without
+   FEATURE_IDLEDETECT (configure --enable-idledetect) the macro expands to
+   nothing and no frame is ever considered idle. */
+typedef struct vsync_idle_window_s {
+    unsigned int main_lo;   /* range of PCs seen with interrupts enabled */
+    unsigned int main_hi;
+    unsigned int any_lo;    /* range of all PCs seen */
+    unsigned int any_hi;
+} vsync_idle_window_t;
+
+#ifdef FEATURE_IDLEDETECT
+extern vsync_idle_window_t vsync_idle_window;
+
+#define VSYNC_IDLE_TRACK(pc, irq_masked)                \
+    do {                                                \
+        unsigned int idle_pc_ = (unsigned int)(pc);     \
+        if (idle_pc_ < vsync_idle_window.any_lo) {      \
+            vsync_idle_window.any_lo = idle_pc_;        \
+        }                                               \
+        if (idle_pc_ > vsync_idle_window.any_hi) {      \
+            vsync_idle_window.any_hi = idle_pc_;        \
+        }                                               \
+        if (!(irq_masked)) {                            \
+            if (idle_pc_ < vsync_idle_window.main_lo) { \
+                vsync_idle_window.main_lo = idle_pc_;   \
+            }                                           \
+            if (idle_pc_ > vsync_idle_window.main_hi) { \
+                vsync_idle_window.main_hi = idle_pc_;   \
+            }                                           \
+        }                                               \
+    } while (0)
+#else
+#define VSYNC_IDLE_TRACK(pc, irq_masked) do { } while (0)
+#endif
+
+/* Called by the drive, tape and serial bus emulation while they are busy.
+   A guest that waits for them in a short loop is not idle, and the frame
+   is not counted as such. */
+void vsync_idle_io_activity(void);
+
 void vsync_suspend_speed_eval(void);
 void vsync_reset_hook(void);
 int vsync_resources_init(void);
@@ -33,8 +33,12 @@ struct video_canvas_s;
 
 typedef void (*void_hook_t)(void);
 
-/* current performance metrics */
-void vsyncarch_get_metrics(double *cpu_percent, double *emulated_fps, int *warp_enabled);
+/* current performance metrics, idle_percent is the share of recent frames
+   the main CPU spent in a detected idle loop, sound_latency_ms and
+   sound_underruns are only measured with SoundLowLatency. The idle and
+   sound pointers may be NULL. */
+void vsyncarch_get_metrics(double *cpu_percent, double *emulated_fps, double *idle_percent,
+                           double *sound_latency_ms, int *sound_underruns, int *warp_enabled);
 
 /* this is called before vsync_do_vsync does the synchroniation */
 void vsyncarch_presync(void);
@@ -71,10 +71,13 @@ static void z80core_reset(void)
 
 #define opcode_t uint32_t
 
+/* The including file may provide a faster way to fetch the opcode bytes */
+#ifndef FETCH_OPCODE
 #define FETCH_OPCODE(o) ((o) = (LOAD(z80_reg_pc)               \
                                 | (LOAD(z80_reg_pc + 1) << 8)  \
                                 | (LOAD(z80_reg_pc + 2) << 16) \
                                 | (LOAD(z80_reg_pc + 3) << 24)))
+#endif
 
 #define p0 (opcode & 0xff)
 #define p1 ((opcode >> 8) & 0xff)
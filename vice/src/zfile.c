@@ -100,6 +100,13 @@ static zfile_t *zfile_list = NULL;
 
 static log_t zlog = LOG_ERR;
 
+/* Extraction cache state, see zfile_cache_get_dir().  */
+static char *zfile_cache_dir = NULL;
+static int zfile_cache_disabled = 0;
+
+static unsigned int zfile_cache_hits = 0;
+static unsigned int zfile_cache_misses = 0;
+
 /* ------------------------------------------------------------------------- */
 
 static int zinit_done = 0;
@@ -187,6 +194,13 @@ static void zfile_list_add(const char *tmp_name,
 
 void zfile_shutdown(void)
 {
+    if (zfile_cache_hits > 0 || zfile_cache_misses > 0) {
+        log_message(zlog, "Extraction cache: %u hits, %u misses.",
+                    zfile_cache_hits, zfile_cache_misses);
+    }
+    lib_free(zfile_cache_dir);
+    zfile_cache_dir = NULL;
+
     zfile_list_destroy();
 }
 
@@ -744,6 +758,247 @@ static char *try_uncompress_lynx(const char *name, int write_mode)
     return tmp_name;
 }
 
+#ifdef HAVE_ZLIB
+/* In-process extraction of zip archives, which are by far the most common
+   archives for images. Archives that use features not handled here (zip64,
+   encryption, compression methods other than deflate, zipcode sets) are left
+   to unzip.  */
+
+/* Archives larger than this are left to unzip.  */
+#define ZIP_MAX_ARCHIVE_SIZE    (64 * 1024 * 1024)
+
+#define ZIP_LOCAL_HEADER_SIG    0x04034b50
+#define ZIP_CENTRAL_HEADER_SIG  0x02014b50
+#define ZIP_END_HEADER_SIG      0x06054b50
+
+#define ZIP_LOCAL_HEADER_SIZE   30
+#define ZIP_CENTRAL_HEADER_SIZE 46
+#define ZIP_END_HEADER_SIZE     22
+
+#define ZIP_METHOD_STORED       0
+#define ZIP_METHOD_DEFLATED     8
+
+#define ZIP_FLAG_ENCRYPTED      0x0001
+
+/* Uncompress `csize' bytes at `src' into `fddest', using method `method'.
+   Returns 0 on success, -1 on error.  */
+static int zip_extract_member(const uint8_t *src, size_t csize, size_t usize,
+                              uint32_t crc, int method, FILE *fddest)
+{
+    z_stream zs;
+    uint8_t buf[16384];
+    uLong crc_out = crc32(0L, Z_NULL, 0);
+    size_t total = 0;
+    int ret;
+
+    if (method == ZIP_METHOD_STORED) {
+        if (csize != usize || fwrite(src, 1, csize, fddest) != csize) {
+            return -1;
+        }
+        return crc32(crc_out, src, (uInt)csize) == crc ? 0 : -1;
+    }
+
+    memset(&zs, 0, sizeof zs);
+    /* raw deflate data, no zlib header */
+    if (inflateInit2(&zs, -MAX_WBITS) != Z_OK) {
+        return -1;
+    }
+    zs.next_in = (Bytef *)src;
+    zs.avail_in = (uInt)csize;
+
+    do {
+        size_t len;
+
+        zs.next_out = buf;
+        zs.avail_out = sizeof buf;
+        ret = inflate(&zs, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END) {
+            inflateEnd(&zs);
+            return -1;
+        }
+        len = sizeof buf - zs.avail_out;
+        if (len > 0) {
+            if (fwrite(buf, 1, len, fddest) != len) {
+                inflateEnd(&zs);
+                return -1;
+            }
+            crc_out = crc32(crc_out, buf, (uInt)len);
+            total += len;
+        }
+        /* no progress and no end of stream: truncated data */
+        if (ret == Z_OK && len == 0 && zs.avail_in == 0) {
+            inflateEnd(&zs);
+            return -1;
+        }
+    } while (ret != Z_STREAM_END);
+
+    inflateEnd(&zs);
+
+    if (total != usize || crc_out != crc) {
+        return -1;
+    }
+    return 0;
+}
+
+/* If `name' has a .zip extension, search the archive for the first file with
+   a proper extension and extract it using zlib. Return the name of the
+   temporary file; if the archive is valid but `write_mode' is non-zero,
+   return a zero-length string; if the archive cannot be handled here,
+   return NULL.  */
+static char *try_uncompress_zip(const char *name, int write_mode)
+{
+    FILE *fd;
+    FILE *fddest;
+    uint8_t *data;
+    char *member = NULL;
+    char *tmp_name = NULL;
+    off_t fsize;
+    size_t size;
+    size_t pos;
+    size_t eocd;
+    size_t l = strlen(name);
+    unsigned int entries;
+    unsigned int i;
+    int method = 0;
+    uint32_t crc = 0;
+    size_t csize = 0;
+    size_t usize = 0;
+    size_t offset = 0;
+
+    if (l <= 4 || util_strcasecmp(name + l - 4, ".zip") != 0) {
+        return NULL;
+    }
+
+    fd = fopen(name, MODE_READ);
+    if (fd == NULL) {
+        return NULL;
+    }
+    fsize = archdep_file_size(fd);
+    if (fsize < ZIP_END_HEADER_SIZE || fsize > ZIP_MAX_ARCHIVE_SIZE) {
+        fclose(fd);
+        return NULL;
+    }
+    size = (size_t)fsize;
+    data = lib_malloc(size);
+    if (fread(data, 1, size, fd) != size) {
+        fclose(fd);
+        lib_free(data);
+        return NULL;
+    }
+    fclose(fd);
+
+    /* Find the end of central directory record, which may be followed by a
+       comment of up to 64KiB.  */
+    eocd = size - ZIP_END_HEADER_SIZE;
+    while (util_le_buf_to_dword(data + eocd) != ZIP_END_HEADER_SIG) {
+        if (eocd == 0 || size - eocd > ZIP_END_HEADER_SIZE + 0xffff) {
+            ZDEBUG(("try_uncompress_zip: no central directory."));
+            lib_free(data);
+            return NULL;
+        }
+        eocd--;
+    }
+    entries = util_le_buf_to_word(data + eocd + 10);
+    pos = util_le_buf_to_dword(data + eocd + 16);
+
+    for (i = 0; i < entries; i++) {
+        size_t nlen;
+
+        if (pos + ZIP_CENTRAL_HEADER_SIZE > size
+                || util_le_buf_to_dword(data + pos) != ZIP_CENTRAL_HEADER_SIG) {
+            break;
+        }
+        nlen = util_le_buf_to_word(data + pos + 28);
+        if (pos + ZIP_CENTRAL_HEADER_SIZE + nlen > size) {
+            break;
+        }
+        member = lib_malloc(nlen + 1);
+        memcpy(member, data + pos + ZIP_CENTRAL_HEADER_SIZE, nlen);
+        member[nlen] = 0;
+
+        if (nlen > 0 && member[nlen - 1] != '/'
+                && is_valid_extension(member, nlen, 0)) {
+            if (util_le_buf_to_word(data + pos + 8) & ZIP_FLAG_ENCRYPTED) {
+                method = -1;
+            } else {
+                method = util_le_buf_to_word(data + pos + 10);
+            }
+            crc = util_le_buf_to_dword(data + pos + 16);
+            csize = util_le_buf_to_dword(data + pos + 20);
+            usize = util_le_buf_to_dword(data + pos + 24);
+            offset = util_le_buf_to_dword(data + pos + 42);
+            break;
+        }
+        lib_free(member);
+        member = NULL;
+        pos += ZIP_CENTRAL_HEADER_SIZE + nlen
+               + util_le_buf_to_word(data + pos + 30)
+               + util_le_buf_to_word(data + pos + 32);
+    }
+
+    if (member == NULL) {
+        ZDEBUG(("try_uncompress_zip: no valid file found."));
+        lib_free(data);
+        return NULL;
+    }
+
+    ZDEBUG(("try_uncompress_zip: found `%s'.", member));
+
+    /* zipcode sets consist of several files, leave those to unzip */
+    if (is_zipcode_name(member)
+            || (method != ZIP_METHOD_STORED && method != ZIP_METHOD_DEFLATED)
+            || csize == 0xffffffff || usize == 0xffffffff) {
+        ZDEBUG(("try_uncompress_zip: cannot handle `%s'.", member));
+        lib_free(member);
+        lib_free(data);
+        return NULL;
+    }
+    lib_free(member);
+
+    /* This is a valid ZIP file, but we cannot handle ZIP files in write
+       mode.  Return a null temporary file name to report this.  */
+    if (write_mode) {
+        lib_free(data);
+        return "";
+    }
+
+    if (offset + ZIP_LOCAL_HEADER_SIZE > size
+            || util_le_buf_to_dword(data + offset) != ZIP_LOCAL_HEADER_SIG) {
+        lib_free(data);
+        return NULL;
+    }
+    offset += ZIP_LOCAL_HEADER_SIZE
+              + util_le_buf_to_word(data + offset + 26)
+              + util_le_buf_to_word(data + offset + 28);
+    if (offset > size || csize > size - offset) {
+        lib_free(data);
+        return NULL;
+    }
+
+    fddest = archdep_mkstemp_fd(&tmp_name, MODE_WRITE);
+    if (fddest == NULL) {
+        lib_free(data);
+        return NULL;
+    }
+
+    if (zip_extract_member(data + offset, csize, usize, crc, method,
+                           fddest) < 0) {
+        log_error(zlog, "Could not extract `%s'.", name);
+        fclose(fddest);
+        archdep_remove(tmp_name);
+        lib_free(tmp_name);
+        lib_free(data);
+        return NULL;
+    }
+
+    fclose(fddest);
+    lib_free(data);
+
+    ZDEBUG(("try_uncompress_zip: extracted into `%s'.", tmp_name));
+    return tmp_name;
+}
+#endif
+
 struct valid_archives_s {
     const char *program;
     const char *listopts;
@@ -769,6 +1024,235 @@ static const valid_archives_t valid_archives[] = {
     { NULL, NULL, NULL, NULL, NULL }
 };
 
+/* ------------------------------------------------------------------------- */
+
+/* Extraction cache.
+
+   Images extracted from gzip and bzip2 files and from archives are kept in
+   the user's cache directory, under a name derived from a hash of the
+   compressed file. When the same file is opened for reading again (fliplists,
+   autostart, re-attaching), the cached image is opened directly instead of
+   decompressing or spawning an external program again.
+
+   The modification time of a cached image is updated on every hit, and the
+   least recently used images are removed once the cache grows larger than
+   ZFILE_CACHE_MAX_SIZE.  */
+
+#define ZFILE_CACHE_DIR         "zfile"
+#define ZFILE_CACHE_EXT         ".img"
+#define ZFILE_CACHE_MAX_SIZE    (256 * 1024 * 1024)
+
+/* Return non-zero if `name' looks like a file whose extracted contents are
+   worth caching.  */
+static int zfile_cache_candidate(const char *name)
+{
+    size_t l = strlen(name);
+    int i;
+
+    if (file_is_gzip(name)) {
+        return 1;
+    }
+    if (l >= 5 && util_strcasecmp(name + l - 4, ".bz2") == 0) {
+        return 1;
+    }
+    for (i = 0; valid_archives[i].program; i++) {
+        size_t len = strlen(valid_archives[i].extension);
+
+        if (l > len
+                && util_strcasecmp(name + l - len,
+                                   valid_archives[i].extension) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Return the cache directory, creating it if needed, or NULL if there is no
+   usable cache directory.  */
+static const char *zfile_cache_get_dir(void)
+{
+    if (zfile_cache_dir == NULL && !zfile_cache_disabled) {
+        archdep_create_user_cache_dir();
+        zfile_cache_dir = util_join_paths(archdep_user_cache_path(),
+                                          ZFILE_CACHE_DIR, NULL);
+        if (archdep_mkdir(zfile_cache_dir, ARCHDEP_MKDIR_RWXU) < 0
+                && archdep_access(zfile_cache_dir, ARCHDEP_ACCESS_W_OK) < 0) {
+            log_warning(zlog, "Cannot use `%s' for the extraction cache.",
+                        zfile_cache_dir);
+            lib_free(zfile_cache_dir);
+            zfile_cache_dir = NULL;
+            zfile_cache_disabled = 1;
+        }
+    }
+    return zfile_cache_dir;
+}
+
+/* Return the path of the cache entry for the contents of `name', which is a
+   64 bit FNV-1a hash and the size of the file.  */
+static char *zfile_cache_entry_name(const char *name)
+{
+    const char *dir;
+    FILE *fd;
+    uint8_t *buf;
+    uint64_t hash = UINT64_C(0xcbf29ce484222325);
+    uint64_t total = 0;
+    size_t len;
+    char *entry;
+    char *path;
+
+    dir = zfile_cache_get_dir();
+    if (dir == NULL) {
+        return NULL;
+    }
+
+    fd = fopen(name, MODE_READ);
+    if (fd == NULL) {
+        return NULL;
+    }
+    buf = lib_malloc(65536);
+    while ((len = fread(buf, 1, 65536, fd)) > 0) {
+        size_t i;
+
+        for (i = 0; i < len; i++) {
+            hash ^= buf[i];
+            hash *= UINT64_C(0x100000001b3);
+        }
+        total += len;
+    }
+    lib_free(buf);
+    if (ferror(fd)) {
+        fclose(fd);
+        return NULL;
+    }
+    fclose(fd);
+
+    entry = lib_msprintf("%08x%08x-%lx" ZFILE_CACHE_EXT,
+                         (unsigned int)(hash >> 32), (unsigned int)hash,
+                         (unsigned long)total);
+    path = util_join_paths(dir, entry, NULL);
+    lib_free(entry);
+    return path;
+}
+
+/* Remove the least recently used entries until the cache fits into
+   ZFILE_CACHE_MAX_SIZE.  The entry `keep' is never removed, even if it is
+   the oldest one or larger than the cache on its own.  */
+static void zfile_cache_evict(const char *keep)
+{
+    archdep_dir_t *dir;
+    const char *entry;
+    char **paths = NULL;
+    archdep_file_stamp_t *stamps = NULL;
+    int count = 0;
+    int i;
+    uint64_t total = 0;
+
+    dir = archdep_opendir(zfile_cache_dir, ARCHDEP_OPENDIR_NO_HIDDEN_FILES);
+    if (dir == NULL) {
+        return;
+    }
+
+    if (archdep_readdir_num_files(dir) > 0) {
+        paths = lib_malloc(sizeof *paths * (size_t)archdep_readdir_num_files(dir));
+        stamps = lib_malloc(sizeof *stamps * (size_t)archdep_readdir_num_files(dir));
+    }
+    for (i = 0; i < archdep_readdir_num_files(dir); i++) {
+        size_t l;
+
+        entry = archdep_readdir_get_file(dir, i);
+        l = strlen(entry);
+        if (l <= strlen(ZFILE_CACHE_EXT)
+                || strcmp(entry + l - strlen(ZFILE_CACHE_EXT), ZFILE_CACHE_EXT) != 0) {
+            continue;
+        }
+        paths[count] = util_join_paths(zfile_cache_dir, entry, NULL);
+        if (!archdep_file_stamp(paths[count], &stamps[count])) {
+            lib_free(paths[count]);
+            continue;
+        }
+        total += stamps[count].size;
+        if (strcmp(paths[count], keep) == 0) {
+            /* counts towards the total, but is not a candidate */
+            lib_free(paths[count]);
+            continue;
+        }
+        count++;
+    }
+    archdep_closedir(dir);
+
+    while (total > ZFILE_CACHE_MAX_SIZE) {
+        int oldest = -1;
+
+        for (i = 0; i < count; i++) {
+            if (paths[i] != NULL
+                    && (oldest < 0
+                        || stamps[i].mtime_ns < stamps[oldest].mtime_ns)) {
+                oldest = i;
+            }
+        }
+        if (oldest < 0) {
+            break;
+        }
+        ZDEBUG(("zfile_cache_evict: removing `%s'.", paths[oldest]));
+        archdep_remove(paths[oldest]);
+        total -= stamps[oldest].size;
+        lib_free(paths[oldest]);
+        paths[oldest] = NULL;
+    }
+
+    for (i = 0; i < count; i++) {
+        lib_free(paths[i]);
+    }
+    lib_free(paths);
+    lib_free(stamps);
+}
+
+/* Move the extracted image `tmp_name' into the cache as `entry'. Returns 0
+   on success, in which case `tmp_name' no longer exists.  */
+static int zfile_cache_store(const char *tmp_name, const char *entry)
+{
+    char *part_name;
+    FILE *fdsrc;
+    FILE *fddest;
+    char buf[16384];
+    size_t len;
+    int ok = 1;
+
+    if (archdep_rename(tmp_name, entry) == 0) {
+        zfile_cache_evict(entry);
+        return 0;
+    }
+
+    /* temporary directory is on another file system: copy, then rename so
+       other instances never see a partially written entry */
+    part_name = util_concat(entry, ".part", NULL);
+    fdsrc = fopen(tmp_name, MODE_READ);
+    fddest = fopen(part_name, MODE_WRITE);
+    if (fdsrc == NULL || fddest == NULL) {
+        ok = 0;
+    }
+    while (ok && (len = fread(buf, 1, sizeof buf, fdsrc)) > 0) {
+        if (fwrite(buf, 1, len, fddest) != len) {
+            ok = 0;
+        }
+    }
+    if (fdsrc != NULL) {
+        fclose(fdsrc);
+    }
+    if (fddest != NULL && fclose(fddest) != 0) {
+        ok = 0;
+    }
+    if (ok && archdep_rename(part_name, entry) == 0) {
+        archdep_remove(tmp_name);
+        lib_free(part_name);
+        zfile_cache_evict(entry);
+        return 0;
+    }
+    archdep_remove(part_name);
+    lib_free(part_name);
+    return -1;
+}
+
 /* Try to uncompress file `name' using the algorithms we know of.  If this is
    not possible, return `COMPR_NONE'.  Otherwise, uncompress the file into a
    temporary file, return the type of algorithm used and the name of the
@@ -781,6 +1265,12 @@ static enum compression_type try_uncompress(const char *name,
 {
     int i;
 
+#ifdef HAVE_ZLIB
+    if ((*tmp_name = try_uncompress_zip(name, write_mode)) != NULL) {
+        return COMPR_ARCHIVE;
+    }
+#endif
+
     for (i = 0; valid_archives[i].program; i++) {
         if ((*tmp_name = try_uncompress_archive(name, write_mode,
                                                 valid_archives[i].program,
@@ -1030,6 +1520,7 @@ static int zfile_compress(const char *src, const char *dest,
 FILE *zfile_fopen(const char *name, const char *mode)
 {
     char *tmp_name;
+    char *cache_name = NULL;
     FILE *stream;
     enum compression_type type;
     int write_mode = 0;
@@ -1052,8 +1543,28 @@ FILE *zfile_fopen(const char *name, const char *mode)
         return NULL;
     }
 
+    /* Files that are only read can be served from the extraction cache.  */
+    if (!write_mode && zfile_cache_candidate(name)) {
+        cache_name = zfile_cache_entry_name(name);
+        if (cache_name != NULL && util_file_exists(cache_name)) {
+            stream = fopen(cache_name, mode);
+            if (stream != NULL) {
+                ZDEBUG(("zfile_fopen: `%s' found in cache as `%s'.",
+                        name, cache_name));
+                archdep_file_touch(cache_name);
+                zfile_cache_hits++;
+                lib_free(cache_name);
+                /* the cached image is not a temporary file, so it must not
+                   be removed on close */
+                zfile_list_add(NULL, name, COMPR_NONE, write_mode, stream, NULL);
+                return stream;
+            }
+        }
+    }
+
     type = try_uncompress(name, &tmp_name, write_mode);
     if (type == COMPR_NONE) {
+        lib_free(cache_name);
         stream = fopen(name, mode);
         if (stream == NULL) {
             return NULL;
@@ -1061,10 +1572,27 @@ FILE *zfile_fopen(const char *name, const char *mode)
         zfile_list_add(NULL, name, type, write_mode, stream, NULL);
         return stream;
     } else if (*tmp_name == '\0') {
+        lib_free(cache_name);
         errno = EACCES;
         return NULL;
     }
 
+    if (cache_name != NULL
+            && (type == COMPR_GZIP || type == COMPR_BZIP || type == COMPR_ARCHIVE)) {
+        zfile_cache_misses++;
+        if (zfile_cache_store(tmp_name, cache_name) == 0) {
+            lib_free(tmp_name);
+            stream = fopen(cache_name, mode);
+            lib_free(cache_name);
+            if (stream == NULL) {
+                return NULL;
+            }
+            zfile_list_add(NULL, name, COMPR_NONE, write_mode, stream, NULL);
+            return stream;
+        }
+    }
+    lib_free(cache_name);
+
     /* Open the uncompressed version of the file.  */
     stream = fopen(tmp_name, mode);
     if (stream == NULL) {